@@ -32,44 +32,451 @@
  * POSSIBILITY OF SUCH DAMAGE.
  */
 
-/* Eta compute supports up to 2 slices per window */
-#define EI_CLASSIFIER_SLICES_PER_MODEL_WINDOW 2
+/* Audio is kept in a sliding history of one window, so 4 to 8 slices per window are fine */
+#define EI_CLASSIFIER_SLICES_PER_MODEL_WINDOW 4
 
 /* Include ----------------------------------------------------------------- */
 #include "ei_device_eta_ecm3532.h"
+#include "model-parameters/model_metadata.h"
+/* The exported model metadata is left as generated, the fixed-point build
+   switches the classifier to the quantized DSP blocks here */
+#if defined(CONFIG_EI_FIXED_POINT_DSP)
+#undef EI_CLASSIFIER_USE_QUANTIZED_DSP_BLOCK
+#define EI_CLASSIFIER_USE_QUANTIZED_DSP_BLOCK    1
+#endif
 #include "edge-impulse-sdk/classifier/ei_run_classifier.h"
 #include "edge-impulse-sdk/dsp/numpy.hpp"
 #include "ei_microphone.h"
 #include "ei_inertialsensor.h"
 #include "ei_camera.h"
 
+/*
+** Binary result records (AT+RUNIMPULSE=BIN), one per inference, all fields
+** little endian:
+**
+**   "EIRS" | version u8 | label count u8 | flags u8 | top label index u8 |
+**   sequence u32 | dsp us u32 | classification us u32 | anomaly us u32 |
+**   anomaly score f32 | label count x score u16 (value * 65535) |
+**   CRC-32 (IEEE 802.3) of everything after "EIRS" u32
+**
+** The records are fixed size for a model, see RESULT_RECORD_SIZE. Text
+** printed around them (prompts, errors) is left as is, decoders resync on
+** the magic and the CRC. Decoder: Tools/decode_results.py
+*/
+#define RESULT_RECORD_VERSION       1
+#define RESULT_RECORD_FLAG_ANOMALY  0x01
+#define RESULT_RECORD_HEADER_SIZE   28
+#define RESULT_RECORD_SIZE          (RESULT_RECORD_HEADER_SIZE + 2 * EI_CLASSIFIER_LABEL_COUNT + 4)
+
+/* Private variables ------------------------------------------------------- */
+static bool result_binary = false;
+static uint32_t result_sequence = 0;
+
+/**
+ * @brief      Select the result output format from the AT command argument
+ *
+ * @param[in]  format  "TEXT" or "BIN"
+ *
+ * @return     false if the format is unknown
+ */
+static bool set_result_format(const char *format)
+{
+    if (strcmp(format, "BIN") == 0 || strcmp(format, "bin") == 0) {
+        result_binary = true;
+    }
+    else if (strcmp(format, "TEXT") == 0 || strcmp(format, "text") == 0) {
+        result_binary = false;
+    }
+    else {
+        ei_printf("ERR: Unknown output format '%s', use TEXT or BIN\n", format);
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief      Before a run, reset the record sequence and, in binary mode,
+ *             announce the record size and the labels the scores refer to
+ */
+static void start_result_output(void)
+{
+    result_sequence = 0;
+
+    if (result_binary) {
+        ei_printf("Binary results: %d bytes per record, labels: ", RESULT_RECORD_SIZE);
+        for (size_t ix = 0; ix < EI_CLASSIFIER_LABEL_COUNT; ix++) {
+            ei_printf("%s%s", ix ? "," : "", ei_classifier_inferencing_categories[ix]);
+        }
+        ei_printf("\n");
+    }
+}
+
+static inline void put_u16(uint8_t *buf, uint16_t value)
+{
+    buf[0] = value & 0xff;
+    buf[1] = value >> 8;
+}
+
+static inline void put_u32(uint8_t *buf, uint32_t value)
+{
+    buf[0] = value & 0xff;
+    buf[1] = (value >> 8) & 0xff;
+    buf[2] = (value >> 16) & 0xff;
+    buf[3] = value >> 24;
+}
+
+/**
+ * @brief      CRC-32 (IEEE 802.3, reflected) over length bytes
+ */
+static uint32_t result_crc32(const uint8_t *data, size_t length)
+{
+    static const uint32_t crc_nibble[16] = {
+        0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC,
+        0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+        0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C,
+        0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C
+    };
+    uint32_t crc = 0xFFFFFFFF;
+
+    while (length--) {
+        crc ^= *(data++);
+        crc = (crc >> 4) ^ crc_nibble[crc & 0xf];
+        crc = (crc >> 4) ^ crc_nibble[crc & 0xf];
+    }
+
+    return crc ^ 0xFFFFFFFF;
+}
+
+/**
+ * @brief      Write the predictions of one inference as a binary record
+ *
+ * @param[in]  result  The inference result
+ */
+static void write_inference_record(const ei_impulse_result_t *result)
+{
+    uint8_t record[RESULT_RECORD_SIZE];
+    uint8_t top = 0;
+    uint32_t anomaly_bits = 0;
+
+    memcpy(record, "EIRS", 4);
+    record[4] = RESULT_RECORD_VERSION;
+    record[5] = EI_CLASSIFIER_LABEL_COUNT;
+    record[6] = 0;
+#if EI_CLASSIFIER_HAS_ANOMALY == 1
+    record[6] |= RESULT_RECORD_FLAG_ANOMALY;
+    memcpy(&anomaly_bits, &result->anomaly, sizeof(anomaly_bits));
+#endif
+    put_u32(&record[8], result_sequence++);
+    put_u32(&record[12], (uint32_t)result->timing.dsp_us);
+    put_u32(&record[16], (uint32_t)result->timing.classification_us);
+    put_u32(&record[20], (uint32_t)result->timing.anomaly_us);
+    put_u32(&record[24], anomaly_bits);
+
+    for (size_t ix = 0; ix < EI_CLASSIFIER_LABEL_COUNT; ix++) {
+        float value = result->classification[ix].value;
+        uint16_t score;
+
+        if (value > result->classification[top].value) {
+            top = ix;
+        }
+        if (!(value > 0.0f)) {
+            score = 0;
+        }
+        else if (value >= 1.0f) {
+            score = 0xffff;
+        }
+        else {
+            score = (uint16_t)(value * 65535.0f + 0.5f);
+        }
+        put_u16(&record[RESULT_RECORD_HEADER_SIZE + 2 * ix], score);
+    }
+    record[7] = top;
+
+    put_u32(&record[RESULT_RECORD_SIZE - 4], result_crc32(&record[4], RESULT_RECORD_SIZE - 8));
+
+    ei_write_string((char *)record, RESULT_RECORD_SIZE);
+}
+
+/**
+ * @brief      Print the predictions of one inference. The whole report is
+ *             formatted into one buffer with the integer float formatter and
+ *             written out in one go, instead of one stdio call per value.
+ *             In binary mode one result record is written instead
+ *
+ * @param[in]  result  The inference result
+ * @param[in]  debug   Also print the interpreter timing
+ */
+static void print_inference_result(const ei_impulse_result_t *result, bool debug)
+{
+    char buf[512];
+    size_t length = 0;
+
+    if (result_binary) {
+        write_inference_record(result);
+        return;
+    }
+
+    /* Make room for one more line, flushing what is buffered if needed */
+    auto reserve = [&](size_t needed) {
+        if (length + needed > sizeof(buf)) {
+            ei_write_string(buf, length);
+            length = 0;
+        }
+    };
+
+    length += snprintf(&buf[length], sizeof(buf) - length,
+        "Predictions (DSP: %d ms., Classification: %d ms., Anomaly: %d ms.): \n",
+        result->timing.dsp, result->timing.classification, result->timing.anomaly);
+    if (debug) {
+        length += snprintf(&buf[length], sizeof(buf) - length,
+            "Interpreter setup: %d us., invoke: %d us.\n",
+            (int)result->timing.setup_us, (int)result->timing.classification_us);
+    }
+
+    for (size_t ix = 0; ix < EI_CLASSIFIER_LABEL_COUNT; ix++) {
+        const char *label = result->classification[ix].label;
+        size_t label_length = strlen(label);
+        if (label_length > 64) {
+            label_length = 64;
+        }
+
+        reserve(4 + label_length + 3 + EI_FORMAT_FLOAT_MAX_SIZE + 2);
+        memcpy(&buf[length], "    ", 4);
+        length += 4;
+        memcpy(&buf[length], label, label_length);
+        length += label_length;
+        memcpy(&buf[length], ": \t", 3);
+        length += 3;
+        length += ei_format_float(&buf[length], sizeof(buf) - length, result->classification[ix].value, 5);
+        memcpy(&buf[length], "\r\n", 2);
+        length += 2;
+    }
+#if EI_CLASSIFIER_HAS_ANOMALY == 1
+    reserve(19 + EI_FORMAT_FLOAT_MAX_SIZE + 2);
+    memcpy(&buf[length], "    anomaly score: ", 19);
+    length += 19;
+    length += ei_format_float(&buf[length], sizeof(buf) - length, result->anomaly, 5);
+    memcpy(&buf[length], "\r\n", 2);
+    length += 2;
+#endif
+
+    ei_write_string(buf, length);
+}
+
+#if defined(CONFIG_EI_FIXED_POINT_DSP)
+/* DWT cycle counter, and the trace enable in the debug monitor control register */
+#define DEMCR                       (*(volatile uint32_t *)0xE000EDFC)
+#define DEMCR_TRCENA                (1 << 24)
+#define DWT_CTRL                    (*(volatile uint32_t *)0xE0001000)
+#define DWT_CYCCNT                  (*(volatile uint32_t *)0xE0001004)
+#define DWT_CTRL_CYCCNTENA          (1 << 0)
+
+#define DSP_BENCHMARK_RUNS          10
+
+/**
+ * @brief      Run the DSP blocks on one window of data in float and in fixed
+ *             point, and quantize their features to the int8 model input.
+ *             Prints the average cycles of both and how far apart they are
+ *
+ * @param      signal        The window as the float blocks get it
+ * @param      signal_i16    The same window as int16 samples
+ * @param[in]  sample_scale  Value of one int16 step in the float window
+ */
+__attribute__((unused)) static void benchmark_dsp_window(signal_t *signal, signal_i16_t *signal_i16, float sample_scale)
+{
+    static int8_t float_input[EI_CLASSIFIER_NN_INPUT_FRAME_SIZE];
+    static int8_t fixed_input[EI_CLASSIFIER_NN_INPUT_FRAME_SIZE];
+    uint32_t float_cycles = 0, fixed_cycles = 0;
+    uint32_t float_quantize_cycles = 0, fixed_quantize_cycles = 0;
+    uint32_t start;
+    int ret = EIDSP_OK;
+
+    ei_dsp_set_i16_sample_scale(sample_scale);
+    run_classifier_init();
+
+    ei::matrix_t float_features(1, EI_CLASSIFIER_NN_INPUT_FRAME_SIZE);
+    ei::matrix_i32_t fixed_features(1, EI_CLASSIFIER_NN_INPUT_FRAME_SIZE);
+    if (!float_features.buffer || !fixed_features.buffer) {
+        ei_printf("ERR: Out of memory\n");
+        return;
+    }
+
+    fixed_multiplier_t multiplier;
+    numpy::fixed_multiplier_init(
+        1.0f / (EI_CLASSIFIER_TFLITE_INPUT_SCALE * (float)(1L << EIDSP_I32_FEATURE_FRAC_BITS)), &multiplier);
+
+    DEMCR |= DEMCR_TRCENA;
+    DWT_CYCCNT = 0;
+    DWT_CTRL |= DWT_CTRL_CYCCNTENA;
+
+    for (int run = 0; run < DSP_BENCHMARK_RUNS && ret == EIDSP_OK; run++) {
+        size_t out_features_index = 0;
+
+        start = DWT_CYCCNT;
+        for (size_t ix = 0; ix < ei_dsp_blocks_size && ret == EIDSP_OK; ix++) {
+            ei_model_dsp_t block = ei_dsp_blocks[ix];
+            ei::matrix_t fm(1, block.n_output_features, float_features.buffer + out_features_index);
+            SignalWithAxes swa(signal, block.axes, block.axes_size);
+            ret = block.extract_fn(swa.get_signal(), &fm, block.config, EI_CLASSIFIER_FREQUENCY);
+            out_features_index += block.n_output_features;
+        }
+        float_cycles += DWT_CYCCNT - start;
+
+        out_features_index = 0;
+        start = DWT_CYCCNT;
+        for (size_t ix = 0; ix < ei_dsp_blocks_i16_size && ret == EIDSP_OK; ix++) {
+            ei_model_dsp_i16_t block = ei_dsp_blocks_i16[ix];
+            ei::matrix_i32_t fm(1, block.n_output_features, fixed_features.buffer + out_features_index);
+            SignalWithAxesI16 swa(signal_i16, block.axes, block.axes_size);
+            ret = block.extract_fn(swa.get_signal(), &fm, block.config, EI_CLASSIFIER_FREQUENCY);
+            out_features_index += block.n_output_features;
+        }
+        fixed_cycles += DWT_CYCCNT - start;
+
+        /* Same quantization as run_inference and run_inference_i16 */
+        start = DWT_CYCCNT;
+        for (size_t ix = 0; ix < EI_CLASSIFIER_NN_INPUT_FRAME_SIZE; ix++) {
+            float_input[ix] = static_cast<int8_t>(
+                round(float_features.buffer[ix] / EI_CLASSIFIER_TFLITE_INPUT_SCALE) + EI_CLASSIFIER_TFLITE_INPUT_ZEROPOINT);
+        }
+        float_quantize_cycles += DWT_CYCCNT - start;
+
+        start = DWT_CYCCNT;
+        numpy::quantize_i32_to_i8(&fixed_features, fixed_input, &multiplier, EI_CLASSIFIER_TFLITE_INPUT_ZEROPOINT);
+        fixed_quantize_cycles += DWT_CYCCNT - start;
+    }
+
+    if (ret != EIDSP_OK) {
+        ei_printf("ERR: Failed to run DSP process (%d)\n", ret);
+        return;
+    }
+
+    float max_error = 0.0f;
+    int input_differs = 0;
+    for (size_t ix = 0; ix < EI_CLASSIFIER_NN_INPUT_FRAME_SIZE; ix++) {
+        float error = fabsf((float)fixed_features.buffer[ix] / (float)(1L << EIDSP_I32_FEATURE_FRAC_BITS) -
+            float_features.buffer[ix]);
+        if (error > max_error) {
+            max_error = error;
+        }
+        if (float_input[ix] != fixed_input[ix]) {
+            input_differs++;
+        }
+    }
+
+    ei_printf("DSP blocks, cycles per window (average of %d):\n", DSP_BENCHMARK_RUNS);
+    ei_printf("    float: %lu, fixed point: %lu\n",
+        (unsigned long)(float_cycles / DSP_BENCHMARK_RUNS), (unsigned long)(fixed_cycles / DSP_BENCHMARK_RUNS));
+    ei_printf("Input quantization, cycles per window:\n");
+    ei_printf("    float: %lu, fixed point: %lu\n",
+        (unsigned long)(float_quantize_cycles / DSP_BENCHMARK_RUNS),
+        (unsigned long)(fixed_quantize_cycles / DSP_BENCHMARK_RUNS));
+    ei_printf("Largest feature difference: ");
+    ei_printf_float(max_error);
+    ei_printf("\nint8 inputs that differ: %d of %d\n", input_differs, EI_CLASSIFIER_NN_INPUT_FRAME_SIZE);
+}
+#endif
+
 #if defined(EI_CLASSIFIER_SENSOR) && EI_CLASSIFIER_SENSOR == EI_CLASSIFIER_SENSOR_ACCELEROMETER
 
 /* Private variables ------------------------------------------------------- */
 static float acc_buf[EI_CLASSIFIER_DSP_INPUT_FRAME_SIZE];
 static int acc_sample_count = 0;
+static float acc_slice_buf[EI_CLASSIFIER_SLICE_SIZE * EI_CLASSIFIER_RAW_SAMPLES_PER_FRAME];
+#if defined(CONFIG_EI_FIXED_POINT_DSP)
+/* The window as read from the sensor. Continuous inference keeps it as a
+   ring, acc_raw_head is the offset of the oldest value */
+static int16_t acc_raw_buf[EI_CLASSIFIER_DSP_INPUT_FRAME_SIZE];
+static size_t acc_raw_head = 0;
+#endif
 
 extern int base64_encode(const char *input, size_t input_size, char *output, size_t output_size);
 
 #if (CONFIG_AI_SENSOR_BOARD == 1)
 /**
- * @brief      Called by the inertial sensor module when a sample is received.
- *             Stores sample data in acc_buf
- * @param[in]  sample_buf  The sample buffer
- * @param[in]  byteLenght  The byte length
+ * @brief      Called by the inertial sensor module with a batch of samples.
+ *             Stores sample data in acc_buf until the window is full
+ * @param[in]  batch  The batch of converted samples
  *
- * @return     { description_of_the_return_value }
+ * @return     true when acc_buf holds a full window
  */
-static bool acc_data_callback(const void *sample_buf, uint32_t byteLength)
+static bool acc_data_callback(const ei_inertial_batch_t *batch)
 {
-    float *buffer = (float *)sample_buf;
-    for(uint32_t i = 0; i < (byteLength / sizeof(float)); i++) {
-        acc_buf[acc_sample_count + i] = buffer[i];
+    const float *sample = batch->samples;
+    for (uint32_t n = 0; n < batch->n_samples; n++) {
+        if (acc_sample_count >= EI_CLASSIFIER_DSP_INPUT_FRAME_SIZE) {
+            break;
+        }
+        memcpy(&acc_buf[acc_sample_count], sample, EI_CLASSIFIER_RAW_SAMPLES_PER_FRAME * sizeof(float));
+        acc_sample_count += EI_CLASSIFIER_RAW_SAMPLES_PER_FRAME;
+        sample += batch->stride;
     }
 
-    return true;
+    return (acc_sample_count >= EI_CLASSIFIER_DSP_INPUT_FRAME_SIZE);
 }
 
+#if defined(CONFIG_EI_FIXED_POINT_DSP)
+/**
+ * @brief      Called by the inertial sensor module with a batch of raw samples.
+ *             Stores sample data in acc_raw_buf until the window is full
+ * @param[in]  batch  The batch of raw samples
+ *
+ * @return     true when acc_raw_buf holds a full window
+ */
+static bool acc_raw_data_callback(const ei_inertial_batch_t *batch)
+{
+    const int16_t *sample = batch->raw_samples;
+    for (uint32_t n = 0; n < batch->n_samples; n++) {
+        if (acc_sample_count >= EI_CLASSIFIER_DSP_INPUT_FRAME_SIZE) {
+            break;
+        }
+        memcpy(&acc_raw_buf[acc_sample_count], sample, EI_CLASSIFIER_RAW_SAMPLES_PER_FRAME * sizeof(int16_t));
+        acc_sample_count += EI_CLASSIFIER_RAW_SAMPLES_PER_FRAME;
+        sample += batch->stride;
+    }
+
+    return (acc_sample_count >= EI_CLASSIFIER_DSP_INPUT_FRAME_SIZE);
+}
+
+/**
+ * @brief      Called by the inertial sensor module with a batch of raw samples.
+ *             Adds them to the window ring in acc_raw_buf
+ * @param[in]  batch  The batch of raw samples
+ *
+ * @return     true when a slice of new samples is in
+ */
+static bool acc_raw_slice_callback(const ei_inertial_batch_t *batch)
+{
+    const int16_t *sample = batch->raw_samples;
+    for (uint32_t n = 0; n < batch->n_samples; n++) {
+        memcpy(&acc_raw_buf[acc_raw_head], sample, EI_CLASSIFIER_RAW_SAMPLES_PER_FRAME * sizeof(int16_t));
+        acc_raw_head = (acc_raw_head + EI_CLASSIFIER_RAW_SAMPLES_PER_FRAME) % EI_CLASSIFIER_DSP_INPUT_FRAME_SIZE;
+        acc_sample_count += EI_CLASSIFIER_RAW_SAMPLES_PER_FRAME;
+        sample += batch->stride;
+    }
+
+    return (acc_sample_count >= (int)(EI_CLASSIFIER_SLICE_SIZE * EI_CLASSIFIER_RAW_SAMPLES_PER_FRAME));
+}
+
+/**
+ * @brief      Get data from the window ring, oldest sample first
+ */
+static int acc_raw_window_get_data(size_t offset, size_t length, int16_t *out_ptr)
+{
+    size_t ix = (acc_raw_head + offset) % EI_CLASSIFIER_DSP_INPUT_FRAME_SIZE;
+    size_t chunk = EI_CLASSIFIER_DSP_INPUT_FRAME_SIZE - ix;
+
+    if (chunk > length) {
+        chunk = length;
+    }
+    memcpy(out_ptr, &acc_raw_buf[ix], chunk * sizeof(int16_t));
+    memcpy(out_ptr + chunk, &acc_raw_buf[0], (length - chunk) * sizeof(int16_t));
+
+    return 0;
+}
+#endif
+
 /**
  * @brief      Sample data and run inferencing. Prints results to terminal
  *
@@ -91,9 +498,13 @@ void run_nn(bool debug) {
                   (1000.0f / static_cast<float>(EI_CLASSIFIER_INTERVAL_MS)));
     ei_printf("\tNo. of classes: %d\n", sizeof(ei_classifier_inferencing_categories) / sizeof(ei_classifier_inferencing_categories[0]));
 
+    start_result_output();
     ei_printf("Starting inferencing, press 'b' to break\n");
 
-    ei_inertial_sample_start(&acc_data_callback, EI_CLASSIFIER_INTERVAL_MS);
+#if defined(CONFIG_EI_FIXED_POINT_DSP)
+    /* DSP blocks get the samples as read from the sensor */
+    ei_dsp_set_i16_sample_scale(ei_inertial_sample_scale());
+#endif
 
     while (1) {
         ei_printf("Starting inferencing in 2 seconds...\n");
@@ -111,43 +522,50 @@ void run_nn(bool debug) {
 
         ei_printf("Sampling...\n");
 
-        /* Run sampler */
+        /* Run sampler, (re)start the sensor FIFO so the window is fresh */
         acc_sample_count = 0;
-        for(int i = 0; i < EI_CLASSIFIER_RAW_SAMPLE_COUNT; i++) {
-            ei_inertial_read_data();
-            acc_sample_count += EI_CLASSIFIER_RAW_SAMPLES_PER_FRAME;
-        }
+#if defined(CONFIG_EI_FIXED_POINT_DSP)
+        ei_inertial_raw_batch_start(&acc_raw_data_callback, EI_CLASSIFIER_INTERVAL_MS);
+#else
+        ei_inertial_batch_start(&acc_data_callback, EI_CLASSIFIER_INTERVAL_MS);
+#endif
+        while (ei_inertial_read_batch() == false) { };
+        ei_inertial_sample_stop();
 
         // Create a data structure to represent this window of data
+#if defined(CONFIG_EI_FIXED_POINT_DSP)
+        signal_i16_t signal;
+        int err = numpy::signal_from_buffer_i16(acc_raw_buf, EI_CLASSIFIER_DSP_INPUT_FRAME_SIZE, &signal);
+#else
         signal_t signal;
         int err = numpy::signal_from_buffer(acc_buf, EI_CLASSIFIER_DSP_INPUT_FRAME_SIZE, &signal);
+#endif
         if (err != 0) {
             ei_printf("ERR: signal_from_buffer failed (%d)\n", err);
         }
 
         // run the impulse: DSP, neural network and the Anomaly algorithm
         ei_impulse_result_t result = { 0 };
+#if defined(CONFIG_EI_FIXED_POINT_DSP)
+        EI_IMPULSE_ERROR ei_error = run_classifier_i16(&signal, &result, debug);
+#else
         EI_IMPULSE_ERROR ei_error = run_classifier(&signal, &result, debug);
+#endif
         if (ei_error != EI_IMPULSE_OK) {
             ei_printf("Failed to run impulse (%d)\n", ei_error);
             break;
         }
 
         // print the predictions
-        ei_printf("Predictions (DSP: %d ms., Classification: %d ms., Anomaly: %d ms.): \n",
-                  result.timing.dsp, result.timing.classification, result.timing.anomaly);
-        for (size_t ix = 0; ix < EI_CLASSIFIER_LABEL_COUNT; ix++) {
-            ei_printf("    %s: \t%f\r\n", result.classification[ix].label, result.classification[ix].value);
+        print_inference_result(&result, debug);
 
 #if (CONFIG_BLE_A31R118 == 1)
+        for (size_t ix = 0; ix < EI_CLASSIFIER_LABEL_COUNT; ix++) {
             if(result.classification[ix].value > 0.8 && prev_classification != ix) {
                 ei_printf_ble(result.classification[ix].label);
                 prev_classification = ix;
             }
-#endif
         }
-#if EI_CLASSIFIER_HAS_ANOMALY == 1
-        ei_printf("    anomaly score: %f\r\n", result.anomaly);
 #endif
         if(ei_user_invoke_stop()) {
             ei_printf("Inferencing stopped by user\r\n");
@@ -155,7 +573,146 @@ void run_nn(bool debug) {
             break;
         }
     }
+
+    run_classifier_deinit();
+}
+
+/**
+ * @brief      Called by the inertial sensor module when a sample is received.
+ *             Stores sample data in acc_slice_buf
+ * @param[in]  sample_buf  The sample buffer
+ * @param[in]  byteLenght  The byte length
+ *
+ * @return     true
+ */
+static bool acc_slice_data_callback(const void *sample_buf, uint32_t byteLength)
+{
+    memcpy(&acc_slice_buf[acc_sample_count], sample_buf, byteLength);
+
+    return true;
+}
+
+/**
+ * @brief      Sample data in slices and run inferencing over the latest window
+ *             every slice. Prints results to terminal
+ *
+ * @param[in]  debug  The debug
+ */
+void run_nn_continuous(bool debug)
+{
+    bool stop_inferencing = false;
+    /* Slices needed before the first window is complete */
+    int print_results = -((EI_CLASSIFIER_RAW_SAMPLE_COUNT + EI_CLASSIFIER_SLICE_SIZE - 1) / EI_CLASSIFIER_SLICE_SIZE);
+    // summary of inferencing settings (from model_metadata.h)
+    ei_printf("Inferencing settings:\n");
+    ei_printf("\tInterval: ");
+    ei_printf_float((float)EI_CLASSIFIER_INTERVAL_MS);
+    ei_printf("ms.\n");
+    ei_printf("\tFrame size: %d\n", EI_CLASSIFIER_DSP_INPUT_FRAME_SIZE);
+    ei_printf("\tSlice size: %d\n", EI_CLASSIFIER_SLICE_SIZE);
+    ei_printf("\tNo. of classes: %d\n", sizeof(ei_classifier_inferencing_categories) /
+                                            sizeof(ei_classifier_inferencing_categories[0]));
+
+    start_result_output();
+    ei_printf("Starting inferencing, press 'b' to break\n");
+
+#if defined(CONFIG_EI_FIXED_POINT_DSP)
+    ei_dsp_set_i16_sample_scale(ei_inertial_sample_scale());
+#endif
+    run_classifier_init();
+
+    /* The sensor FIFO keeps sampling while a slice is classified */
+#if defined(CONFIG_EI_FIXED_POINT_DSP)
+    memset(acc_raw_buf, 0, sizeof(acc_raw_buf));
+    acc_raw_head = 0;
+    ei_inertial_raw_batch_start(&acc_raw_slice_callback, EI_CLASSIFIER_INTERVAL_MS);
+#else
+    ei_inertial_sample_start(&acc_slice_data_callback, EI_CLASSIFIER_INTERVAL_MS);
+#endif
+
+    while (stop_inferencing == false) {
+
+#if defined(CONFIG_EI_FIXED_POINT_DSP)
+        /* Whole batches go into the window ring, then run on the latest window */
+        acc_sample_count = 0;
+        while (ei_inertial_read_batch() == false) { };
+
+        signal_i16_t signal;
+        signal.total_length = EI_CLASSIFIER_DSP_INPUT_FRAME_SIZE;
+        signal.get_data = &acc_raw_window_get_data;
+
+        ei_impulse_result_t result = {0};
+
+        EI_IMPULSE_ERROR r = run_classifier_i16(&signal, &result, debug);
+#else
+        for (acc_sample_count = 0; acc_sample_count < (int)(EI_CLASSIFIER_SLICE_SIZE * EI_CLASSIFIER_RAW_SAMPLES_PER_FRAME);
+             acc_sample_count += EI_CLASSIFIER_RAW_SAMPLES_PER_FRAME) {
+            ei_inertial_read_data();
+        }
+
+        signal_t signal;
+        int err = numpy::signal_from_buffer(acc_slice_buf, EI_CLASSIFIER_SLICE_SIZE * EI_CLASSIFIER_RAW_SAMPLES_PER_FRAME, &signal);
+        if (err != 0) {
+            ei_printf("ERR: signal_from_buffer failed (%d)\n", err);
+            break;
+        }
+
+        ei_impulse_result_t result = {0};
+
+        EI_IMPULSE_ERROR r = run_classifier_continuous(&signal, &result, debug, false);
+#endif
+        if (r != EI_IMPULSE_OK) {
+            ei_printf("ERR: Failed to run classifier (%d)\n", r);
+            break;
+        }
+
+        if (++print_results >= 0) {
+            // print the predictions
+            print_inference_result(&result, false);
+
+            print_results = 0;
+        }
+
+        if(ei_user_invoke_stop()) {
+            ei_printf("Inferencing stopped by user\r\n");
+            break;
+        }
+    }
+
+    ei_inertial_sample_stop();
+    EiDevice.set_state(eiStateIdle);
+    run_classifier_deinit();
 }
+
+#if defined(CONFIG_EI_FIXED_POINT_DSP)
+/**
+ * @brief      Sample one window and benchmark the DSP blocks on it
+ */
+static void benchmark_dsp(void)
+{
+    ei_printf("Sampling...\n");
+
+    acc_sample_count = 0;
+    ei_inertial_raw_batch_start(&acc_raw_data_callback, EI_CLASSIFIER_INTERVAL_MS);
+    while (ei_inertial_read_batch() == false) { };
+    ei_inertial_sample_stop();
+    EiDevice.set_state(eiStateIdle);
+
+    /* The float blocks get the window converted up front, as in run_nn */
+    float sample_scale = ei_inertial_sample_scale();
+    for (size_t ix = 0; ix < EI_CLASSIFIER_DSP_INPUT_FRAME_SIZE; ix++) {
+        acc_buf[ix] = (float)acc_raw_buf[ix] * sample_scale;
+    }
+
+    signal_t signal;
+    numpy::signal_from_buffer(acc_buf, EI_CLASSIFIER_DSP_INPUT_FRAME_SIZE, &signal);
+    signal_i16_t signal_i16;
+    numpy::signal_from_buffer_i16(acc_raw_buf, EI_CLASSIFIER_DSP_INPUT_FRAME_SIZE, &signal_i16);
+
+    benchmark_dsp_window(&signal, &signal_i16, sample_scale);
+}
+#endif
+
 #else
 void run_nn(bool debug) {
     ei_printf("Motion classification is not supported on Eta Compute AI Vision board\r\n");
@@ -182,13 +739,20 @@ void run_nn(bool debug) {
     ei_printf("\tSample length: %d ms.\n", EI_CLASSIFIER_RAW_SAMPLE_COUNT / 16);
     ei_printf("\tNo. of classes: %d\n", sizeof(ei_classifier_inferencing_categories) / sizeof(ei_classifier_inferencing_categories[0]));
 
-    if(ei_microphone_inference_start(EI_CLASSIFIER_RAW_SAMPLE_COUNT) == false) {
+    if(ei_microphone_inference_start(EI_CLASSIFIER_RAW_SAMPLE_COUNT, 1) == false) {
         ei_printf("ERR: Failed to setup audio sampling\r\n");
         return;
     }
 
+    start_result_output();
     ei_printf("Starting inferencing, press 'b' to break\n");
 
+#if defined(CONFIG_EI_FIXED_POINT_DSP)
+    /* DSP blocks get the q15 samples of the history, the float blocks see
+       them as arm_q15_to_float converts them */
+    ei_dsp_set_i16_sample_scale(1.0f / 32768.0f);
+#endif
+
     while (1) {
         ei_printf("Starting inferencing in 2 seconds...\n");
 
@@ -214,32 +778,36 @@ void run_nn(bool debug) {
 
         ei_printf("Recording done\n");
 
+#if defined(CONFIG_EI_FIXED_POINT_DSP)
+        signal_i16_t signal;
+        signal.total_length = EI_CLASSIFIER_RAW_SAMPLE_COUNT;
+        signal.get_data = &ei_microphone_audio_signal_get_data_i16;
+        ei_impulse_result_t result = { 0 };
+
+        EI_IMPULSE_ERROR r = run_classifier_i16(&signal, &result, debug);
+#else
         signal_t signal;
         signal.total_length = EI_CLASSIFIER_RAW_SAMPLE_COUNT;
         signal.get_data = &ei_microphone_audio_signal_get_data;
         ei_impulse_result_t result = { 0 };
 
         EI_IMPULSE_ERROR r = run_classifier(&signal, &result, debug);
+#endif
         if (r != EI_IMPULSE_OK) {
             ei_printf("ERR: Failed to run classifier (%d)\n", r);
             break;
         }
 
         // print the predictions
-        ei_printf("Predictions (DSP: %d ms., Classification: %d ms., Anomaly: %d ms.): \n",
-                  result.timing.dsp, result.timing.classification, result.timing.anomaly);
-        for (size_t ix = 0; ix < EI_CLASSIFIER_LABEL_COUNT; ix++) {
-            ei_printf("    %s: \t%f\r\n", result.classification[ix].label, result.classification[ix].value);
+        print_inference_result(&result, debug);
 
 #if (CONFIG_BLE_A31R118 == 1)
+        for (size_t ix = 0; ix < EI_CLASSIFIER_LABEL_COUNT; ix++) {
             if(result.classification[ix].value > 0.8 && prev_classification != ix) {
                 ei_printf_ble(result.classification[ix].label);
                 prev_classification = ix;
             }
-#endif
         }
-#if EI_CLASSIFIER_HAS_ANOMALY == 1
-        ei_printf("    anomaly score: %f\r\n", result.anomaly);
 #endif
 
         if(ei_user_invoke_stop()) {
@@ -249,6 +817,7 @@ void run_nn(bool debug) {
         }
     }
 
+    run_classifier_deinit();
     ei_microphone_inference_end();
 }
 
@@ -271,10 +840,14 @@ void run_nn_continuous(bool debug)
     ei_printf("\tNo. of classes: %d\n", sizeof(ei_classifier_inferencing_categories) /
                                             sizeof(ei_classifier_inferencing_categories[0]));
 
+    start_result_output();
     ei_printf("Starting inferencing, press 'b' to break\n");
 
     run_classifier_init();
-    ei_microphone_inference_start(EI_CLASSIFIER_SLICE_SIZE);
+    if (ei_microphone_inference_start(EI_CLASSIFIER_SLICE_SIZE, EI_CLASSIFIER_SLICES_PER_MODEL_WINDOW) == false) {
+        ei_printf("ERR: Failed to setup audio sampling\r\n");
+        return;
+    }
 
     while (stop_inferencing == false) {
 
@@ -297,18 +870,7 @@ void run_nn_continuous(bool debug)
 
         if (++print_results >= 0) {
             // print the predictions
-            ei_printf("Predictions (DSP: %d ms., Classification: %d ms., Anomaly: %d ms.): \n",
-                result.timing.dsp, result.timing.classification, result.timing.anomaly);
-            for (size_t ix = 0; ix < EI_CLASSIFIER_LABEL_COUNT; ix++) {
-                ei_printf("    %s: \t", result.classification[ix].label);
-                ei_printf_float(result.classification[ix].value);
-                ei_printf("\r\n");
-            }
-#if EI_CLASSIFIER_HAS_ANOMALY == 1
-            ei_printf("    anomaly score: ");
-            ei_printf_float(result.anomaly);
-            ei_printf("\r\n");
-#endif
+            print_inference_result(&result, false);
 
             print_results = 0;
         }
@@ -319,15 +881,77 @@ void run_nn_continuous(bool debug)
         }
     }
 
+    run_classifier_deinit();
     ei_microphone_inference_end();
+
+    if (debug) {
+        ei_microphone_print_ring_stats();
+    }
 }
 
+#if defined(CONFIG_EI_FIXED_POINT_DSP)
+/**
+ * @brief      Record one window and benchmark the DSP blocks on it
+ */
+static void benchmark_dsp(void)
+{
+    if (EI_CLASSIFIER_FREQUENCY != 16000) {
+        ei_printf("ERR: Frequency is %d but can only sample at 16000Hz\n", (int)EI_CLASSIFIER_FREQUENCY);
+        return;
+    }
+
+    if (ei_microphone_inference_start(EI_CLASSIFIER_RAW_SAMPLE_COUNT, 1) == false) {
+        ei_printf("ERR: Failed to setup audio sampling\r\n");
+        return;
+    }
+
+    ei_printf("Recording...\n");
+
+    ei_microphone_inference_reset_buffers();
+    if (ei_microphone_inference_record(false)) {
+        /* Both read the history, the float blocks through arm_q15_to_float */
+        signal_t signal;
+        signal.total_length = EI_CLASSIFIER_RAW_SAMPLE_COUNT;
+        signal.get_data = &ei_microphone_audio_signal_get_data;
+        signal_i16_t signal_i16;
+        signal_i16.total_length = EI_CLASSIFIER_RAW_SAMPLE_COUNT;
+        signal_i16.get_data = &ei_microphone_audio_signal_get_data_i16;
+
+        benchmark_dsp_window(&signal, &signal_i16, 1.0f / 32768.0f);
+    }
+    else {
+        ei_printf("ERR: Failed to record audio...\n");
+    }
+
+    ei_microphone_inference_end();
+}
+#endif
+
 #elif defined(EI_CLASSIFIER_SENSOR) && EI_CLASSIFIER_SENSOR == EI_CLASSIFIER_SENSOR_CAMERA
 
 extern int base64_encode(const char *input, size_t input_size, char *output, size_t output_size);
 
 #if (CONFIG_AI_VISION_BOARD == 1)
 
+#if EI_CLASSIFIER_TFLITE_INPUT_QUANTIZED == 1 && EI_CLASSIFIER_INFERENCING_ENGINE == EI_CLASSIFIER_TFLITE
+/**
+ * @brief      Called by the classifier to capture a frame and write it, cropped
+ *             and scaled row by row while it comes in, straight into the
+ *             quantized input tensor
+ *
+ * @return     0 if successful
+ */
+static int camera_fill_input(int8_t *input, size_t input_size, const int8_t *mono_lut, size_t channels)
+{
+    if (input_size != EI_CLASSIFIER_INPUT_WIDTH * EI_CLASSIFIER_INPUT_HEIGHT * channels) {
+        return -1;
+    }
+
+    return ei_camera_capture_to_lut(EI_CLASSIFIER_INPUT_WIDTH, EI_CLASSIFIER_INPUT_HEIGHT, input,
+        mono_lut, channels) ? 0 : -1;
+}
+#endif
+
 void run_nn(bool debug) {
 
     // static uint8_t image_buffer[EI_CLASSIFIER_INPUT_WIDTH * EI_CLASSIFIER_INPUT_HEIGHT];
@@ -350,6 +974,8 @@ void run_nn(bool debug) {
         return;
     }
 
+    start_result_output();
+
     while(stop_inferencing == false) {
         ei_printf("Starting inferencing in 2 seconds...\n");
 
@@ -364,7 +990,15 @@ void run_nn(bool debug) {
 
         ei_printf("Taking photo...\n");
 
-        if (ei_camera_capture((size_t)EI_CLASSIFIER_INPUT_WIDTH, (size_t)EI_CLASSIFIER_INPUT_HEIGHT, image_data) == false) {
+        // Without debug output the cropped image isn't needed, the classifier
+        // captures the frame and crops, scales and quantizes it into the input
+        // tensor as the rows come in instead
+        bool fill_input = false;
+#if EI_CLASSIFIER_TFLITE_INPUT_QUANTIZED == 1 && EI_CLASSIFIER_INFERENCING_ENGINE == EI_CLASSIFIER_TFLITE
+        fill_input = !debug && (can_run_classifier_image_quantized() == EI_IMPULSE_OK);
+#endif
+
+        if (!fill_input && ei_camera_capture((size_t)EI_CLASSIFIER_INPUT_WIDTH, (size_t)EI_CLASSIFIER_INPUT_HEIGHT, image_data) == false) {
             ei_printf("Failed to capture image\r\n");
             break;
         }
@@ -478,28 +1112,33 @@ void run_nn(bool debug) {
 
         // run the impulse: DSP, neural network and the Anomaly algorithm
         ei_impulse_result_t result = { 0 };
+        EI_IMPULSE_ERROR ei_error;
+
+#if EI_CLASSIFIER_TFLITE_INPUT_QUANTIZED == 1 && EI_CLASSIFIER_INFERENCING_ENGINE == EI_CLASSIFIER_TFLITE
+        if (fill_input) {
+            ei_error = run_classifier_image_mono_quantized(&camera_fill_input, &result, debug);
+        }
+        else
+#endif
+        {
+            ei_error = run_classifier(&signal, &result, debug);
+        }
 
-        EI_IMPULSE_ERROR ei_error = run_classifier(&signal, &result, debug);
         if (ei_error != EI_IMPULSE_OK) {
             ei_printf("Failed to run impulse (%d)\n", ei_error);
             break;
         }
 
         // print the predictions
-        ei_printf("Predictions (DSP: %d ms., Classification: %d ms., Anomaly: %d ms.): \n",
-                  result.timing.dsp, result.timing.classification, result.timing.anomaly);
-        for (size_t ix = 0; ix < EI_CLASSIFIER_LABEL_COUNT; ix++) {
-            ei_printf("    %s: \t%f\r\n", result.classification[ix].label, result.classification[ix].value);
+        print_inference_result(&result, debug);
 
 #if (CONFIG_BLE_A31R118 == 1)
+        for (size_t ix = 0; ix < EI_CLASSIFIER_LABEL_COUNT; ix++) {
             if(result.classification[ix].value > 0.8 && prev_classification != ix) {
                 ei_printf_ble(result.classification[ix].label);
                 prev_classification = ix;
             }
-#endif
         }
-#if EI_CLASSIFIER_HAS_ANOMALY == 1
-        ei_printf("    anomaly score: %f\r\n", result.anomaly);
 #endif
 
         if(ei_user_invoke_stop()) {
@@ -508,6 +1147,8 @@ void run_nn(bool debug) {
             break;
         }
     }
+
+    run_classifier_deinit();
 }
 
 #else
@@ -533,9 +1174,38 @@ void run_nn_debug(void) {
 
 void run_nn_continuous_normal()
 {
-#if defined(EI_CLASSIFIER_SENSOR) && EI_CLASSIFIER_SENSOR == EI_CLASSIFIER_SENSOR_MICROPHONE
+#if defined(EI_CLASSIFIER_SENSOR) && ((EI_CLASSIFIER_SENSOR == EI_CLASSIFIER_SENSOR_MICROPHONE) || \
+    (EI_CLASSIFIER_SENSOR == EI_CLASSIFIER_SENSOR_ACCELEROMETER && CONFIG_AI_SENSOR_BOARD == 1))
     run_nn_continuous(false);
 #else
     ei_printf("Error no continuous classification available for current model\r\n");
 #endif
 }
+
+#if defined(CONFIG_EI_FIXED_POINT_DSP)
+void run_dsp_benchmark(void)
+{
+#if defined(EI_CLASSIFIER_SENSOR) && ((EI_CLASSIFIER_SENSOR == EI_CLASSIFIER_SENSOR_MICROPHONE) || \
+    (EI_CLASSIFIER_SENSOR == EI_CLASSIFIER_SENSOR_ACCELEROMETER && CONFIG_AI_SENSOR_BOARD == 1))
+    benchmark_dsp();
+#else
+    ei_printf("Error no fixed-point DSP blocks available for current model\r\n");
+#endif
+}
+#endif
+
+void run_nn_format(char *format)
+{
+    if (set_result_format(format)) {
+        run_nn(false);
+        result_binary = false;
+    }
+}
+
+void run_nn_continuous_format(char *format)
+{
+    if (set_result_format(format)) {
+        run_nn_continuous_normal();
+        result_binary = false;
+    }
+}
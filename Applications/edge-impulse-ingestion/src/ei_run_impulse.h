@@ -39,5 +39,8 @@
 void run_nn_normal(void);
 void run_nn_debug(void);
 void run_nn_continuous_normal(void);
+void run_nn_format(char *format);
+void run_nn_continuous_format(char *format);
+void run_dsp_benchmark(void);
 
 #endif
\ No newline at end of file
@@ -44,6 +44,12 @@ extern "C" {
 
 #include "spi_flash.h"
 
+#if defined(CONFIG_EI_DSP_OFFLOAD)
+extern "C" {
+#include "executor_public.h"
+}
+#endif
+
 
 /* Private function prototypes --------------------------------------------- */
 static void init_ai_hardware(void);
@@ -55,6 +61,11 @@ int main(void)
 
     init_ai_hardware();
 
+#if defined(CONFIG_EI_DSP_OFFLOAD)
+    /* DSP blocks queue their FFTs through the executor */
+    ExecInit();
+#endif
+
 #if (CONFIG_BLE_A31R118 == 1)
     bleEnable();
     EtaCspTimerDelayMs(500);
@@ -91,6 +102,7 @@ int main(void)
 #if (CONFIG_AI_VISION_BOARD == 1)
     config_ctx.take_snapshot = &ei_camera_take_snapshot_encode_and_output;
     config_ctx.start_snapshot_stream = &ei_camera_start_snapshot_stream_encode_and_output;
+    config_ctx.start_snapshot_stream_format = &ei_camera_start_snapshot_stream_format;
 #endif
 
     EI_CONFIG_ERROR cr = ei_config_init(&config_ctx);
@@ -107,6 +119,13 @@ int main(void)
     ei_at_cmd_register("RUNIMPULSE", "Run the impulse", run_nn_normal);
     ei_at_cmd_register("RUNIMPULSEDEBUG", "Run the impulse with extra debug output", run_nn_debug);
     ei_at_cmd_register("RUNIMPULSECONT", "Run the impulse in continuous mode", run_nn_continuous_normal);
+    ei_at_cmd_register("RUNIMPULSE=", "Run the impulse, results as TEXT or BIN records (FORMAT)", run_nn_format);
+    ei_at_cmd_register("RUNIMPULSECONT=", "Run the impulse in continuous mode, results as TEXT or BIN records (FORMAT)",
+        run_nn_continuous_format);
+    ei_at_cmd_register("AUDIOSTATS", "Print the audio frame ring high-water mark of the last run", ei_microphone_print_ring_stats);
+#if defined(CONFIG_EI_FIXED_POINT_DSP)
+    ei_at_cmd_register("BENCHDSP", "Time the DSP blocks in float and in fixed point on one window", run_dsp_benchmark);
+#endif
     ei_printf("Type AT+HELP to see a list of commands.\r\n> ");
 
     /* Run the LEDs to indicate we're here */
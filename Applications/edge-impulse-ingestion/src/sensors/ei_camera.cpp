@@ -38,6 +38,9 @@
 
 #include "ei_camera.h"
 #include "gpio_hal.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include "semphr.h"
 #ifdef CONFIG_CAM_HM01B0
 #include "eta_devices_hm01b0.h"
 #elif defined CONFIG_CAM_HM0360
@@ -61,13 +64,65 @@ extern int base64_encode(const char *input, size_t input_size, char *output, siz
 
 #define DWORD_ALIGN_PTR(a)   ((a & 0x3) ?(((uintptr_t)a + 0x4) & ~(uintptr_t)0x3) : a)
 
+// Fixed point fraction used by the bilinear resize.
+// This needs to be < 16 or it won't fit. Cortex-M4 only has SIMD for signed multiplies
+#define FRAC_BITS 14
+#define FRAC_VAL (1<<FRAC_BITS)
+#define FRAC_MASK (FRAC_VAL - 1)
+
+// Snapshot stream transmit task, sends frame N while frame N + 1 is captured.
+// Same priority as the command line task, so it gets its time slices while the
+// capture waits for a frame. The deepest path (frame writer, TX queue) comes to
+// about 110 words by -fstack-usage, the stream prints the measured high-water mark.
+#define SNAPSHOT_TX_TASK_STACK  192
+#define SNAPSHOT_TX_TASK_PRIO   (tskIDLE_PRIORITY + 1)
+
+// Pixels per base64 chunk, a multiple of 3 so the chunks join up to one base64 string
+#define SNAPSHOT_B64_CHUNK      96
+// Bytes per binary frame write
+#define SNAPSHOT_BIN_CHUNK      128
+
+/*
+** Binary snapshot frames (raw and rle formats), all fields little endian:
+**
+**   "EIFR" | format u8 | 0 u8 | width u16 | height u16 | frame index u32 |
+**   payload length u32 | payload | CRC-32 (IEEE 802.3) of the payload u32
+**
+** The rle payload is PackBits: a header byte n < 128 is followed by n + 1
+** literal pixels, a header byte n > 128 by one pixel that repeats 257 - n times.
+*/
+#define SNAPSHOT_FRAME_HEADER_SIZE  18
+
+typedef struct {
+    const uint8_t *image;
+    size_t width;
+    size_t height;
+    ei_snapshot_format_t format;
+    uint32_t index;
+    bool print_oks;
+} snapshot_frame_t;
+
+typedef struct {
+    uint8_t buf[SNAPSHOT_BIN_CHUNK];
+    size_t len;
+    size_t total;
+    uint32_t crc;
+    bool count_only;
+} snapshot_sink_t;
+
 // static CameraClass cam;
 static bool is_initialised = false;
 
+static TaskHandle_t snapshot_tx_task_handle = NULL;
+static SemaphoreHandle_t snapshot_tx_done = NULL;
+static snapshot_frame_t snapshot_tx_frame;
+
 /*
-** @brief used to store the raw frame
+** @brief used to store the raw frame. The bilinear resize reads one pixel right
+**        and one row below the source pixel, so the last row is followed by
+**        one (zeroed) row of padding to keep those reads inside the buffer
 */
-static uint8_t ei_camera_frame_buffer[EI_CAMERA_RAW_FRAME_BUFFER_COLS * EI_CAMERA_RAW_FRAME_BUFFER_ROWS] __attribute__((aligned(32)));
+static uint8_t ei_camera_frame_buffer[(EI_CAMERA_RAW_FRAME_BUFFER_COLS * (EI_CAMERA_RAW_FRAME_BUFFER_ROWS + 1)) + 1] __attribute__((aligned(32)));
 
 /*
 ** @brief points to the output of the capture
@@ -77,9 +132,14 @@ static uint8_t *ei_camera_capture_out = NULL;
 //DEPRECATED
 static uint8_t *ei_camera_scaled = NULL;
 
+static bool capture_raw_frame(uint8_t *buf);
 static bool prepare_snapshot(size_t width, size_t height, bool use_max_baudrate);
 static bool take_snapshot(size_t width, size_t height, bool print_oks);
 static void finish_snapshot();
+static void snapshot_write_frame(const snapshot_frame_t *frame);
+static bool snapshot_tx_init(void);
+static void snapshot_tx_send(const snapshot_frame_t *frame);
+static void snapshot_tx_wait(void);
 //DEPRECATED
 static void resample_u8(uint8_t *source_buffer, int source_width, int source_height, uint8_t *target_buffer, int target_width, int target_height);
 
@@ -182,44 +242,303 @@ void ei_camera_deinit(void) {
 }
 
 /**
- * @brief      Capture, rescale and crop image
+ * @brief      Capture a raw frame into the frame buffer
+ *
+ * @retval     false if not initialised or the capture failed
+ */
+bool ei_camera_capture_frame(void)
+{
+    return capture_raw_frame(ei_camera_frame_buffer);
+}
+
+/**
+ * @brief      Capture a raw frame into buf
+ *
+ * @param[out] buf   EI_CAMERA_RAW_FRAME_BUFFER_COLS * EI_CAMERA_RAW_FRAME_BUFFER_ROWS pixels
+ *
+ * @retval     false if not initialised or the capture failed
+ */
+static bool capture_raw_frame(uint8_t *buf)
+{
+    if (!is_initialised) {
+        ei_printf("ERR: Camera is not initialized\r\n");
+        return false;
+    }
+
+    EiDevice.set_state(eiStateSampling);
+
+    int snapshot_response = 0;
+#ifdef CONFIG_CAM_HM01B0
+    snapshot_response = EtaDevicesHm01b0OneFrameReadBlocking(buf);
+#endif
+#ifdef CONFIG_CAM_HM0360
+    snapshot_response = EtaDevicesHm0360OneFrameReadBlocking(buf);
+#endif
+
+    // int snapshot_response = 0;//cam.grab(ei_camera_frame_buffer, 1000);
+    if (snapshot_response == 0) {
+        ei_printf("ERR: Failed to get snapshot (%d)\r\n", snapshot_response);
+        return false;
+    }
+
+    return true;
+}
+
+/*
+** @brief state of a crop, scale and lookup of the frame buffer, one output
+**        row at a time
+*/
+typedef struct {
+    uint32_t img_width;
+    uint32_t img_height;
+    uint32_t crop_col_start;
+    uint32_t crop_row_start;
+    uint32_t src_x_frac;
+    uint32_t src_y_frac;
+    bool do_resize;
+    int8_t *out_buf;
+    const int8_t *lut;
+    size_t channels;
+    uint32_t next_row;
+} camera_lut_job_t;
+
+static bool camera_lut_job_init(camera_lut_job_t *job, uint32_t img_width, uint32_t img_height,
+    int8_t *out_buf, const int8_t *lut, size_t channels)
+{
+    uint32_t resize_col_sz;
+    uint32_t resize_row_sz;
+    bool do_resize = false;
+
+    int res = calculate_resize_dimensions(
+        img_width,
+        img_height,
+        &resize_col_sz,
+        &resize_row_sz,
+        &do_resize);
+    if (res) {
+        ei_printf("ERR: Failed to calculate resize dimensions (%d)\r\n", res);
+        return false;
+    }
+
+    job->img_width = img_width;
+    job->img_height = img_height;
+    job->crop_col_start = (resize_col_sz - img_width) / 2;
+    job->crop_row_start = (resize_row_sz - img_height) / 2;
+    // same fixed point bilinear steps as resizeImage, only for the cropped area
+    job->src_x_frac = (EI_CAMERA_RAW_FRAME_BUFFER_COLS * FRAC_VAL) / resize_col_sz;
+    job->src_y_frac = (EI_CAMERA_RAW_FRAME_BUFFER_ROWS * FRAC_VAL) / resize_row_sz;
+    job->do_resize = do_resize;
+    job->out_buf = out_buf;
+    job->lut = lut;
+    job->channels = channels;
+    job->next_row = 0;
+
+    return true;
+}
+
+/**
+ * @brief      Last frame buffer row the output row y is computed from
+ */
+static inline uint32_t camera_lut_job_src_row(const camera_lut_job_t *job, uint32_t y)
+{
+    if (job->do_resize) {
+        // bilinear reads the row below as well, past the last row is padding
+        uint32_t ty = ((FRAC_VAL/2 + ((job->crop_row_start + y) * job->src_y_frac)) >> FRAC_BITS) + 1;
+        return (ty < EI_CAMERA_RAW_FRAME_BUFFER_ROWS) ? ty : EI_CAMERA_RAW_FRAME_BUFFER_ROWS - 1;
+    }
+
+    return job->crop_row_start + y;
+}
+
+/**
+ * @brief      Compute output rows until (not including) row end
+ */
+static void camera_lut_job_rows(camera_lut_job_t *job, uint32_t end)
+{
+    const int8_t *lut = job->lut;
+    const size_t channels = job->channels;
+    const uint32_t img_width = job->img_width;
+
+    for (uint32_t y = job->next_row; y < end; y++) {
+        int8_t *d = &job->out_buf[y * img_width * channels];
+
+        if (job->do_resize) {
+            const uint32_t src_x_frac = job->src_x_frac;
+            const uint32_t src_y_accum = FRAC_VAL/2 + ((job->crop_row_start + y) * job->src_y_frac);
+            const uint32_t ty = src_y_accum >> FRAC_BITS;
+            const uint32_t y_frac = src_y_accum & FRAC_MASK;
+            const uint32_t ny_frac = FRAC_VAL - y_frac;
+            const uint8_t *s = &ei_camera_frame_buffer[ty * EI_CAMERA_RAW_FRAME_BUFFER_COLS];
+            uint32_t src_x_accum = FRAC_VAL/2 + (job->crop_col_start * src_x_frac);
+
+            for (uint32_t x = 0; x < img_width; x++) {
+                const uint32_t tx = src_x_accum >> FRAC_BITS;
+                const uint32_t x_frac = src_x_accum & FRAC_MASK;
+                const uint32_t nx_frac = FRAC_VAL - x_frac;
+                src_x_accum += src_x_frac;
+
+                uint32_t p00 = s[tx], p10 = s[tx + 1];
+                uint32_t p01 = s[tx + EI_CAMERA_RAW_FRAME_BUFFER_COLS], p11 = s[tx + EI_CAMERA_RAW_FRAME_BUFFER_COLS + 1];
+                p00 = ((p00 * nx_frac) + (p10 * x_frac) + FRAC_VAL/2) >> FRAC_BITS; // top line
+                p01 = ((p01 * nx_frac) + (p11 * x_frac) + FRAC_VAL/2) >> FRAC_BITS; // bottom line
+                p00 = ((p00 * ny_frac) + (p01 * y_frac) + FRAC_VAL/2) >> FRAC_BITS; // combine top + bottom
+
+                const int8_t v = lut[(uint8_t)p00];
+                for (size_t c = 0; c < channels; c++) {
+                    *d++ = v;
+                }
+            }
+        }
+        else {
+            const uint8_t *s = &ei_camera_frame_buffer[(y + job->crop_row_start) * EI_CAMERA_RAW_FRAME_BUFFER_COLS + job->crop_col_start];
+
+            for (uint32_t x = 0; x < img_width; x++) {
+                const int8_t v = lut[s[x]];
+                for (size_t c = 0; c < channels; c++) {
+                    *d++ = v;
+                }
+            }
+        }
+    }
+
+    if (end > job->next_row) {
+        job->next_row = end;
+    }
+}
+
+/**
+ * @brief      Row consumer of the camera driver, computes every output row
+ *             whose source rows are in. Runs in the horizontal blanking.
+ */
+static void camera_lut_job_row_cb(uint32_t row, camera_lut_job_t *job)
+{
+    uint32_t end = job->next_row;
+
+    while ((end < job->img_height) && (camera_lut_job_src_row(job, end) <= row)) {
+        end++;
+    }
+    camera_lut_job_rows(job, end);
+}
+
+#ifdef CONFIG_CAM_HM01B0
+static void camera_lut_row_cb(uint32_t ui32Row, const int8_t *pi8Row, uint32_t ui32Cols, void *pvArg)
+{
+    camera_lut_job_row_cb(ui32Row, (camera_lut_job_t *)pvArg);
+}
+#endif
+#ifdef CONFIG_CAM_HM0360
+static void camera_lut_row_cb(uint32_t ui32Row, const uint8_t *pui8Row, uint32_t ui32Cols, void *pvArg)
+{
+    camera_lut_job_row_cb(ui32Row, (camera_lut_job_t *)pvArg);
+}
+#endif
+
+/**
+ * @brief      Rescale and crop the captured frame and map it through a lookup
+ *             table, in one pass. Gives the same result as ei_camera_capture
+ *             followed by the lookup on every output pixel, without the
+ *             intermediate resize buffer.
  *
  * @param[in]  img_width     width of output image
  * @param[in]  img_height    height of output image
- * @param[in]  out_buf       pointer to store output image, NULL may be used
- *                           when full resolution is expected.
+ * @param[out] out_buf       output, img_width * img_height * channels values
+ * @param[in]  lut           output value for every mono pixel value
+ * @param[in]  channels      number of times each output value is written
  *
- * @retval     false if not initialised, image captured, rescaled or cropped failed
+ * @retval     false if the resize dimensions could not be determined
  *
+ * @note       Expects a frame captured with ei_camera_capture_frame
  */
-bool ei_camera_capture(uint32_t img_width, uint32_t img_height, uint8_t *out_buf) {
-    bool do_resize = false;
-    bool do_crop = false;
+bool ei_camera_frame_to_lut(uint32_t img_width, uint32_t img_height, int8_t *out_buf,
+    const int8_t *lut, size_t channels)
+{
+    camera_lut_job_t job;
+
+    if (!camera_lut_job_init(&job, img_width, img_height, out_buf, lut, channels)) {
+        return false;
+    }
+
+    camera_lut_job_rows(&job, img_height);
+
+    EiDevice.set_state(eiStateIdle);
+
+    return true;
+}
+
+/**
+ * @brief      Capture a frame and crop, scale and map it through a lookup
+ *             table while it comes in. Every output row is computed in the
+ *             line blanking after its last source row, so the result is
+ *             ready with the end of the frame. Same result as
+ *             ei_camera_capture_frame followed by ei_camera_frame_to_lut.
+ *
+ * @param[in]  img_width     width of output image
+ * @param[in]  img_height    height of output image
+ * @param[out] out_buf       output, img_width * img_height * channels values
+ * @param[in]  lut           output value for every mono pixel value
+ * @param[in]  channels      number of times each output value is written
+ *
+ * @retval     false if not initialised or the capture failed
+ */
+bool ei_camera_capture_to_lut(uint32_t img_width, uint32_t img_height, int8_t *out_buf,
+    const int8_t *lut, size_t channels)
+{
+    camera_lut_job_t job;
+    uint32_t pixels = 0;
 
     if (!is_initialised) {
         ei_printf("ERR: Camera is not initialized\r\n");
         return false;
     }
 
-    if (!out_buf && img_width != EI_CAMERA_RAW_FRAME_BUFFER_COLS &&
-        img_height != EI_CAMERA_RAW_FRAME_BUFFER_ROWS) {
-        ei_printf("ERR: invalid parameters\r\n");
+    if (!camera_lut_job_init(&job, img_width, img_height, out_buf, lut, channels)) {
         return false;
     }
 
     EiDevice.set_state(eiStateSampling);
 
-    int snapshot_response = 0;
 #ifdef CONFIG_CAM_HM01B0
-    snapshot_response = EtaDevicesHm01b0OneFrameReadBlocking(ei_camera_frame_buffer);
+    pixels = EtaDevicesHm01b0FrameRowsRead((int8_t *)ei_camera_frame_buffer, &camera_lut_row_cb, &job);
 #endif
 #ifdef CONFIG_CAM_HM0360
-    snapshot_response = EtaDevicesHm0360OneFrameReadBlocking(ei_camera_frame_buffer);
+    pixels = EtaDevicesHm0360FrameRowsRead(ei_camera_frame_buffer, &camera_lut_row_cb, &job);
 #endif
 
-    // int snapshot_response = 0;//cam.grab(ei_camera_frame_buffer, 1000);
-    if (snapshot_response == 0) {
-        ei_printf("ERR: Failed to get snapshot (%d)\r\n", snapshot_response);
+    if (pixels == 0) {
+        ei_printf("ERR: Failed to get snapshot (%d)\r\n", (int)pixels);
+        return false;
+    }
+
+    // rows that only depend on the padding row
+    camera_lut_job_rows(&job, img_height);
+
+    EiDevice.set_state(eiStateIdle);
+
+    return true;
+}
+
+/**
+ * @brief      Capture, rescale and crop image
+ *
+ * @param[in]  img_width     width of output image
+ * @param[in]  img_height    height of output image
+ * @param[in]  out_buf       pointer to store output image, NULL may be used
+ *                           when full resolution is expected.
+ *
+ * @retval     false if not initialised, image captured, rescaled or cropped failed
+ *
+ */
+bool ei_camera_capture(uint32_t img_width, uint32_t img_height, uint8_t *out_buf) {
+    bool do_resize = false;
+    bool do_crop = false;
+
+    if (!out_buf && img_width != EI_CAMERA_RAW_FRAME_BUFFER_COLS &&
+        img_height != EI_CAMERA_RAW_FRAME_BUFFER_ROWS) {
+        ei_printf("ERR: invalid parameters\r\n");
+        return false;
+    }
+
+    if (ei_camera_capture_frame() == false) {
         return false;
     }
 
@@ -344,34 +663,123 @@ bool ei_camera_take_snapshot_encode_and_output(size_t width, size_t height, bool
  *
  */
 bool ei_camera_start_snapshot_stream_encode_and_output(size_t width, size_t height, bool use_max_baudrate)
+{
+    return ei_camera_start_snapshot_stream_format(width, height, use_max_baudrate, EI_SNAPSHOT_FORMAT_BASE64);
+}
+
+/**
+ * @brief      Starts a snapshot stream and outputs it to uart in the given
+ *             format. Frames are double buffered: frame N + 1 is captured
+ *             while a transmit task sends frame N. Prints the achieved
+ *             frame rate and the transmit task stack use when the stream is
+ *             stopped.
+ *
+ * @param[in]  width             width of output image
+ * @param[in]  height            height of output image
+ * @param[in]  use_max_baudrate  switch to the max baudrate while streaming
+ * @param[in]  format            base64 lines or binary (raw / rle) frames
+ *
+ * @retval     true if successful and/or terminated gracefully
+ *
+ * @note       Falls back to a single buffer (capture after send) when there
+ *             is no memory for the second one
+ */
+bool ei_camera_start_snapshot_stream_format(size_t width, size_t height, bool use_max_baudrate,
+    ei_snapshot_format_t format)
 {
     bool result = true;
+    bool full_frame = (width == EI_CAMERA_RAW_FRAME_BUFFER_COLS) &&
+        (height == EI_CAMERA_RAW_FRAME_BUFFER_ROWS);
+    void *frame_mem[2] = { NULL, NULL };
+    uint8_t *frame_buf[2] = { NULL, NULL };
+    uint32_t frames = 0;
 
     ei_printf("Starting snapshot stream...\r\n");
 
     if (!prepare_snapshot(width, height, use_max_baudrate))
         result = false;
 
+    if (result) {
+        // a full frame is sent straight from the raw frame buffer
+        if (full_frame) {
+            frame_buf[0] = ei_camera_frame_buffer;
+        }
+        else {
+            frame_mem[0] = ei_malloc(width * height + 4);
+            if (frame_mem[0] == NULL) {
+                ei_printf("failed to create snapshot_mem\r\n");
+                result = false;
+            }
+            frame_buf[0] = (uint8_t *)DWORD_ALIGN_PTR((uintptr_t)frame_mem[0]);
+        }
+    }
+
+    if (result) {
+        frame_mem[1] = snapshot_tx_init() ? ei_malloc(width * height + 4) : NULL;
+        frame_buf[1] = frame_mem[1] ? (uint8_t *)DWORD_ALIGN_PTR((uintptr_t)frame_mem[1]) : frame_buf[0];
+    }
+
+    uint64_t start_ms = ei_read_timer_ms();
+
     while (result) {
-        if (!take_snapshot(width, height, true)) {
-            result = false;
+        uint8_t *buf = frame_buf[frames & 1];
+
+        // single buffered, the previous frame has to be out first
+        if (frame_buf[0] == frame_buf[1]) {
+            snapshot_tx_wait();
         }
 
-        bool stopped_by_user = false;
+        if (full_frame) {
+            result = capture_raw_frame(buf);
+        }
+        else {
+            result = ei_camera_capture(width, height, buf);
+        }
 
-        if (ei_user_invoke_stop()) {
-            ei_printf("Inferencing stopped by user\r\n");
-            EiDevice.set_state(eiStateIdle);
+        if (!result) {
+            snapshot_tx_wait();
+            ei_printf("ERR: Failed to capture image\r\n");
             break;
         }
 
-        if (stopped_by_user) {
+        snapshot_frame_t frame;
+        frame.image = buf;
+        frame.width = width;
+        frame.height = height;
+        frame.format = format;
+        frame.index = frames;
+        frame.print_oks = true;
+
+        EiDevice.set_state(eiStateUploading);
+        snapshot_tx_send(&frame);
+        frames++;
+
+        if (ei_user_invoke_stop()) {
+            snapshot_tx_wait();
             ei_printf("Snapshot streaming stopped by user\r\n");
             EiDevice.set_state(eiStateIdle);
             break;
         }
     }
 
+    if (frames) {
+        uint32_t elapsed_ms = (uint32_t)(ei_read_timer_ms() - start_ms);
+        uint32_t fps_x100 = elapsed_ms ? (uint32_t)(((uint64_t)frames * 100000) / elapsed_ms) : 0;
+
+        ei_printf("Snapshot stream: %lu frames in %lu ms (%lu.%02lu fps)\r\n",
+            (unsigned long)frames, (unsigned long)elapsed_ms,
+            (unsigned long)(fps_x100 / 100), (unsigned long)(fps_x100 % 100));
+
+        if (snapshot_tx_task_handle != NULL) {
+            ei_printf("Snapshot TX stack: %lu of %u words used\r\n",
+                (unsigned long)(SNAPSHOT_TX_TASK_STACK - uxTaskGetStackHighWaterMark(snapshot_tx_task_handle)),
+                SNAPSHOT_TX_TASK_STACK);
+        }
+    }
+
+    ei_free(frame_mem[1]);
+    ei_free(frame_mem[0]);
+
     finish_snapshot();
 
     return result;
@@ -442,143 +850,268 @@ static bool take_snapshot(size_t width, size_t height, bool print_oks)
         return false;
     }
 
-    ei::signal_t signal;
-    signal.total_length = width * height;
-    signal.get_data = &ei_camera_cutout_get_data;
+    snapshot_frame_t frame;
+    frame.image = ei_camera_capture_out;
+    frame.width = width;
+    frame.height = height;
+    frame.format = EI_SNAPSHOT_FORMAT_BASE64;
+    frame.index = 0;
+    frame.print_oks = false;
 
-    size_t signal_chunk_size = 1024;
+    EiDevice.set_state(eiStateUploading);
+    snapshot_write_frame(&frame);
 
-    // loop through the signal
-    float *signal_buf = (float *)ei_malloc(signal_chunk_size * sizeof(float));
-    if (!signal_buf) {
-        ei_printf("ERR: Failed to allocate signal buffer\r\n");
-        ei_free(snapshot_mem);
-        return false;
+    ei_free(snapshot_mem);
+    EiDevice.set_state(eiStateIdle);
+
+    if (print_oks) {
+        ei_printf("OK\r\n");
     }
 
-    uint8_t *per_pixel_buffer = (uint8_t *)ei_malloc(513); // 171 x 3 pixels
-    if (!per_pixel_buffer) {
-        ei_free(signal_buf);
-        ei_free(snapshot_mem);
-        ei_printf("ERR: Failed to allocate per_pixel buffer\r\n");
-        return false;
+    return true;
+}
+
+/**
+ * @brief      Add one byte to the running CRC-32 (IEEE 802.3, reflected)
+ */
+static inline uint32_t snapshot_crc32_update(uint32_t crc, uint8_t data)
+{
+    static const uint32_t crc_nibble[16] = {
+        0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC,
+        0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+        0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C,
+        0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C
+    };
+
+    crc ^= data;
+    crc = (crc >> 4) ^ crc_nibble[crc & 0xf];
+    crc = (crc >> 4) ^ crc_nibble[crc & 0xf];
+
+    return crc;
+}
+
+/**
+ * @brief      Send the bytes buffered in the sink
+ */
+static void snapshot_sink_flush(snapshot_sink_t *sink)
+{
+    if (!sink->count_only && sink->len) {
+        ei_write_string((char *)sink->buf, sink->len);
     }
+    sink->len = 0;
+}
 
-    size_t per_pixel_buffer_ix = 0;
+/**
+ * @brief      Add one payload byte to the sink, or only count it
+ */
+static inline void snapshot_sink_put(snapshot_sink_t *sink, uint8_t data)
+{
+    sink->total++;
+    if (sink->count_only) {
+        return;
+    }
+
+    sink->crc = snapshot_crc32_update(sink->crc, data);
+    sink->buf[sink->len++] = data;
+    if (sink->len == SNAPSHOT_BIN_CHUNK) {
+        snapshot_sink_flush(sink);
+    }
+}
+
+/**
+ * @brief      PackBits encode length pixels into the sink. Runs of 3 or more
+ *             equal pixels are repeated, anything else is sent as literals.
+ */
+static void snapshot_rle_encode(const uint8_t *in, size_t length, snapshot_sink_t *sink)
+{
+    size_t ix = 0;
 
-    for (size_t ix = 0; ix < signal.total_length; ix += signal_chunk_size) {
-        size_t items_to_read = signal_chunk_size;
-        if (items_to_read > signal.total_length - ix) {
-            items_to_read = signal.total_length - ix;
+    while (ix < length) {
+        size_t run = 1;
+        while ((ix + run < length) && (run < 128) && (in[ix + run] == in[ix])) {
+            run++;
         }
 
-        int r = signal.get_data(ix, items_to_read, signal_buf);
-        if (r != 0) {
-            ei_printf("ERR: Failed to get data from signal (%d)\r\n", r);
-            ei_free(signal_buf);
-            ei_free(per_pixel_buffer);
-            ei_free(snapshot_mem);
-            break;
+        if (run >= 3) {
+            snapshot_sink_put(sink, (uint8_t)(257 - run));
+            snapshot_sink_put(sink, in[ix]);
+            ix += run;
+            continue;
         }
 
-        for (size_t px = 0; px < items_to_read; px++) {
-            uint32_t pixel = static_cast<uint32_t>(signal_buf[px]);
+        // literals, up to where the next run of 3 starts
+        size_t lit = 0;
+        while ((ix + lit < length) && (lit < 128)) {
+            if ((ix + lit + 2 < length) &&
+                (in[ix + lit] == in[ix + lit + 1]) && (in[ix + lit] == in[ix + lit + 2])) {
+                break;
+            }
+            lit++;
+        }
 
-            // grab rgb
-            uint8_t r = static_cast<float>(pixel >> 16 & 0xff);
-            uint8_t g = static_cast<float>(pixel >> 8 & 0xff);
-            uint8_t b = static_cast<float>(pixel & 0xff);
+        snapshot_sink_put(sink, (uint8_t)(lit - 1));
+        for (size_t px = 0; px < lit; px++) {
+            snapshot_sink_put(sink, in[ix + px]);
+        }
+        ix += lit;
+    }
+}
 
-            // is monochrome anyway now, so just print 1 pixel at a time
-            const bool print_rgb = false;
+/**
+ * @brief      Write one frame to uart, straight from the 8-bit image
+ *
+ * @param[in]  frame   image and output format
+ */
+static void snapshot_write_frame(const snapshot_frame_t *frame)
+{
+    size_t length = frame->width * frame->height;
 
-            if (print_rgb) {
-                per_pixel_buffer[per_pixel_buffer_ix + 0] = r;
-                per_pixel_buffer[per_pixel_buffer_ix + 1] = g;
-                per_pixel_buffer[per_pixel_buffer_ix + 2] = b;
-                per_pixel_buffer_ix += 3;
-            }
-            else {
-                per_pixel_buffer[per_pixel_buffer_ix + 0] = r;
-                per_pixel_buffer_ix++;
-            }
+    if (frame->format == EI_SNAPSHOT_FORMAT_BASE64) {
+        char base64_buffer[SNAPSHOT_B64_CHUNK / 3 * 4];
 
-            if (per_pixel_buffer_ix >= 513) {
-                const size_t base64_output_size = 684;
-
-                char *base64_buffer = (char *)ei_malloc(base64_output_size);
-                if (!base64_buffer) {
-                    ei_printf(
-                        "ERR: Cannot allocate base64 buffer of size %lu, out of memory\r\n",
-                        base64_output_size);
-                    ei_free(signal_buf);
-                    ei_free(per_pixel_buffer);
-                    ei_free(snapshot_mem);
-                    return false;
-                }
+        if (frame->print_oks) {
+            ei_write_string((char *)"OK\r\n", 4);
+        }
 
-                int r = base64_encode(
-                    (const char *)per_pixel_buffer,
-                    per_pixel_buffer_ix,
-                    base64_buffer,
-                    base64_output_size);
-                if (r < 0) {
-                    ei_printf("ERR: Failed to base64 encode (%d)\r\n", r);
-                    ei_free(signal_buf);
-                    ei_free(per_pixel_buffer);
-                    ei_free(snapshot_mem);
-                    return false;
-                }
+        for (size_t ix = 0; ix < length; ix += SNAPSHOT_B64_CHUNK) {
+            size_t chunk = length - ix;
+            if (chunk > SNAPSHOT_B64_CHUNK) {
+                chunk = SNAPSHOT_B64_CHUNK;
+            }
 
+            int r = base64_encode(
+                (const char *)&frame->image[ix],
+                chunk,
+                base64_buffer,
+                sizeof(base64_buffer));
+            if (r > 0) {
                 ei_write_string(base64_buffer, r);
-                per_pixel_buffer_ix = 0;
-                ei_free(base64_buffer);
             }
-            EiDevice.set_state(eiStateUploading);
         }
+
+        ei_write_string((char *)"\r\n", 2);
+        if (frame->print_oks) {
+            ei_write_string((char *)"OK\r\n", 4);
+        }
+        return;
     }
 
-    const size_t new_base64_buffer_output_size = floor(per_pixel_buffer_ix / 3 * 4) + 4;
-    char *base64_buffer = (char *)ei_malloc(new_base64_buffer_output_size);
-    if (!base64_buffer) {
-        ei_printf(
-            "ERR: Cannot allocate base64 buffer of size %lu, out of memory\r\n",
-            new_base64_buffer_output_size);
-        ei_free(signal_buf);
-        ei_free(per_pixel_buffer);
-        ei_free(snapshot_mem);
-        return false;
+    snapshot_sink_t sink;
+    sink.len = 0;
+    sink.total = 0;
+    sink.crc = 0xFFFFFFFF;
+    sink.count_only = false;
+
+    uint32_t payload_length = length;
+    if (frame->format == EI_SNAPSHOT_FORMAT_RLE) {
+        // sizing pass, the length goes in front of the payload
+        sink.count_only = true;
+        snapshot_rle_encode(frame->image, length, &sink);
+        payload_length = sink.total;
+        sink.count_only = false;
     }
 
-    int r = base64_encode(
-        (const char *)per_pixel_buffer,
-        per_pixel_buffer_ix,
-        base64_buffer,
-        new_base64_buffer_output_size);
-    if (r < 0) {
-        ei_printf("ERR: Failed to base64 encode (%d)\r\n", r);
-        ei_free(signal_buf);
-        ei_free(per_pixel_buffer);
-        ei_free(snapshot_mem);
-        return false;
+    uint8_t header[SNAPSHOT_FRAME_HEADER_SIZE] = {
+        'E', 'I', 'F', 'R',
+        (uint8_t)frame->format, 0,
+        (uint8_t)(frame->width), (uint8_t)(frame->width >> 8),
+        (uint8_t)(frame->height), (uint8_t)(frame->height >> 8),
+        (uint8_t)(frame->index), (uint8_t)(frame->index >> 8),
+        (uint8_t)(frame->index >> 16), (uint8_t)(frame->index >> 24),
+        (uint8_t)(payload_length), (uint8_t)(payload_length >> 8),
+        (uint8_t)(payload_length >> 16), (uint8_t)(payload_length >> 24)
+    };
+    ei_write_string((char *)header, sizeof(header));
+
+    if (frame->format == EI_SNAPSHOT_FORMAT_RLE) {
+        snapshot_rle_encode(frame->image, length, &sink);
     }
+    else {
+        for (size_t ix = 0; ix < length; ix++) {
+            snapshot_sink_put(&sink, frame->image[ix]);
+        }
+    }
+    snapshot_sink_flush(&sink);
 
-    ei_write_string(base64_buffer, r);
-    ei_printf("\r\n");
+    uint32_t crc = sink.crc ^ 0xFFFFFFFF;
+    uint8_t trailer[4] = {
+        (uint8_t)(crc), (uint8_t)(crc >> 8), (uint8_t)(crc >> 16), (uint8_t)(crc >> 24)
+    };
+    ei_write_string((char *)trailer, sizeof(trailer));
+}
 
-    ei_free(base64_buffer);
-    ei_free(signal_buf);
-    ei_free(per_pixel_buffer);
-    ei_free(snapshot_mem);
-    EiDevice.set_state(eiStateIdle);
+/**
+ * @brief      Snapshot transmit task, writes out snapshot_tx_frame when
+ *             notified and gives snapshot_tx_done when it is out
+ */
+static void snapshot_tx_task(void *arg)
+{
+    (void)arg;
 
-    if (print_oks) {
-        ei_printf("OK\r\n");
+    while (1) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        snapshot_write_frame(&snapshot_tx_frame);
+        xSemaphoreGive(snapshot_tx_done);
+    }
+}
+
+/**
+ * @brief      Create the snapshot transmit task, if not done yet
+ *
+ * @retval     false if the task could not be created, frames are then
+ *             written out by the caller
+ */
+static bool snapshot_tx_init(void)
+{
+    if (snapshot_tx_done == NULL) {
+        snapshot_tx_done = xSemaphoreCreateBinary();
+        if (snapshot_tx_done == NULL) {
+            return false;
+        }
+        xSemaphoreGive(snapshot_tx_done);
+    }
+
+    if (snapshot_tx_task_handle == NULL) {
+        if (xTaskCreate(snapshot_tx_task, "Snapshot TX", SNAPSHOT_TX_TASK_STACK, NULL,
+                SNAPSHOT_TX_TASK_PRIO, &snapshot_tx_task_handle) != pdPASS) {
+            snapshot_tx_task_handle = NULL;
+            return false;
+        }
     }
 
     return true;
 }
 
+/**
+ * @brief      Hand a frame to the transmit task, once the previous one is out.
+ *             Returns straight away, the frame buffer has to stay untouched
+ *             until the next snapshot_tx_send or snapshot_tx_wait returns.
+ */
+static void snapshot_tx_send(const snapshot_frame_t *frame)
+{
+    if (snapshot_tx_task_handle == NULL) {
+        snapshot_write_frame(frame);
+        return;
+    }
+
+    xSemaphoreTake(snapshot_tx_done, portMAX_DELAY);
+    snapshot_tx_frame = *frame;
+    xTaskNotifyGive(snapshot_tx_task_handle);
+}
+
+/**
+ * @brief      Wait until the transmit task sent out the last frame
+ */
+static void snapshot_tx_wait(void)
+{
+    if (snapshot_tx_task_handle == NULL) {
+        return;
+    }
+
+    xSemaphoreTake(snapshot_tx_done, portMAX_DELAY);
+    xSemaphoreGive(snapshot_tx_done);
+}
+
 static bool verify_inputs(size_t width, size_t height)
 {
     const ei_device_snapshot_resolutions_t *list;
@@ -782,10 +1315,6 @@ static void resample_u8(uint8_t *source_buffer, int source_width, int source_hei
 #ifdef __ARM_FEATURE_SIMD32
 #include <device.h>
 #endif
-// This needs to be < 16 or it won't fit. Cortex-M4 only has SIMD for signed multiplies
-#define FRAC_BITS 14
-#define FRAC_VAL (1<<FRAC_BITS)
-#define FRAC_MASK (FRAC_VAL - 1)
 //
 // Resize
 //
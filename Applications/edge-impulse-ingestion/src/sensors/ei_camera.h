@@ -42,6 +42,7 @@
 #include "ei_device_eta_ecm3532.h"
 #include "../edge-impulse-sdk/porting/ei_classifier_porting.h"
 #include "../edge-impulse-sdk/dsp/numpy_types.h"
+#include "ei_config_types.h"
 
 /* Constants --------------------------------------------------------------- */
 #define EI_CAMERA_RAW_FRAME_BUFFER_COLS           256
@@ -51,8 +52,15 @@
 extern bool ei_camera_init(void);
 extern void ei_camera_deinit(void);
 extern bool ei_camera_capture(uint32_t img_width, uint32_t img_height, uint8_t *buf);
+extern bool ei_camera_capture_frame(void);
+extern bool ei_camera_frame_to_lut(uint32_t img_width, uint32_t img_height, int8_t *out_buf,
+    const int8_t *lut, size_t channels);
+extern bool ei_camera_capture_to_lut(uint32_t img_width, uint32_t img_height, int8_t *out_buf,
+    const int8_t *lut, size_t channels);
 extern bool ei_camera_take_snapshot_encode_and_output(size_t width, size_t height, bool use_max_baudrate);
 extern bool ei_camera_start_snapshot_stream_encode_and_output(size_t width, size_t height, bool use_max_baudrate);
+extern bool ei_camera_start_snapshot_stream_format(size_t width, size_t height, bool use_max_baudrate,
+    ei_snapshot_format_t format);
 extern bool ei_camera_inference_snapshot(size_t width, size_t height);
 extern void ei_printf(const char *format, ...);
 
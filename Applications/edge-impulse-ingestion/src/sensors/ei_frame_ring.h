@@ -0,0 +1,153 @@
+/* The Clear BSD License
+ *
+ * Copyright (c) 2025 EdgeImpulse Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the disclaimer
+ * below) provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ *   * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ *
+ *   * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from this
+ *   software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE GRANTED BY
+ * THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ * CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef EI_FRAME_RING_H
+#define EI_FRAME_RING_H
+
+/* Include ----------------------------------------------------------------- */
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+/* Number of PCM frames that can be in flight between producer and consumer */
+#ifndef EI_FRAME_RING_COUNT
+#define EI_FRAME_RING_COUNT                 16
+#endif
+/* Samples per frame (16 ms at 16 kHz) */
+#ifndef EI_FRAME_RING_SAMPLES
+#define EI_FRAME_RING_SAMPLES               256
+#endif
+
+/**
+ * Single producer / single consumer ring of frames over a preallocated pool.
+ * The producer only writes head, the consumer only writes tail, a slot is
+ * owned by the consumer between the two. Indexes are running counters.
+ */
+typedef struct {
+    int16_t pool[EI_FRAME_RING_COUNT][EI_FRAME_RING_SAMPLES];
+    uint16_t n_bytes[EI_FRAME_RING_COUNT];
+    volatile uint32_t head;
+    volatile uint32_t tail;
+    /* frames dropped because the ring was full */
+    volatile uint32_t overruns;
+    /* highest number of frames waiting since the last reset */
+    uint32_t high_water;
+} ei_frame_ring_t;
+
+/**
+ * @brief      Consumer side: drop all published frames
+ */
+static inline void ei_frame_ring_flush(ei_frame_ring_t *ring)
+{
+    ring->tail = ring->head;
+}
+
+/**
+ * @brief      Consumer side: drop all frames and clear the statistics
+ */
+static inline void ei_frame_ring_reset(ei_frame_ring_t *ring)
+{
+    ei_frame_ring_flush(ring);
+    ring->overruns = 0;
+    ring->high_water = 0;
+}
+
+/**
+ * @brief      Producer side: copy a frame into a free slot and publish it,
+ *             never blocks
+ *
+ * @return     false if the ring was full and the frame was dropped
+ */
+static inline bool ei_frame_ring_push(ei_frame_ring_t *ring, const void *buf, uint16_t n_bytes)
+{
+    uint32_t head = ring->head;
+
+    if ((head - ring->tail) >= EI_FRAME_RING_COUNT) {
+        ring->overruns++;
+        return false;
+    }
+
+    if (n_bytes > sizeof(ring->pool[0])) {
+        n_bytes = sizeof(ring->pool[0]);
+    }
+
+    uint32_t slot = head % EI_FRAME_RING_COUNT;
+    memcpy(&ring->pool[slot][0], buf, n_bytes);
+    ring->n_bytes[slot] = n_bytes;
+
+    /* Slot contents must be visible before the consumer sees the new head */
+    __sync_synchronize();
+    ring->head = head + 1;
+
+    return true;
+}
+
+/**
+ * @brief      Consumer side: number of published frames, updates the
+ *             high-water mark
+ */
+static inline uint32_t ei_frame_ring_ready(ei_frame_ring_t *ring)
+{
+    uint32_t n_ready = ring->head - ring->tail;
+
+    if (n_ready > ring->high_water) {
+        ring->high_water = n_ready;
+    }
+
+    return n_ready;
+}
+
+/**
+ * @brief      Consumer side: oldest published frame, only valid while
+ *             ei_frame_ring_ready() is non-zero
+ */
+static inline int16_t *ei_frame_ring_front(ei_frame_ring_t *ring, uint16_t *n_bytes)
+{
+    uint32_t slot = ring->tail % EI_FRAME_RING_COUNT;
+
+    *n_bytes = ring->n_bytes[slot];
+    return &ring->pool[slot][0];
+}
+
+/**
+ * @brief      Consumer side: hand the oldest frame back to the producer
+ */
+static inline void ei_frame_ring_pop(ei_frame_ring_t *ring)
+{
+    /* Slot contents are consumed before it is handed back */
+    __sync_synchronize();
+    ring->tail = ring->tail + 1;
+}
+
+#endif
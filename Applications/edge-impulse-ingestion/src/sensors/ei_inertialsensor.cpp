@@ -42,6 +42,12 @@
 #include "sensor_aq.h"
 #include "eta_bsp.h"
 #include "eta_csp_spi.h"
+#include "eta_csp_timer.h"
+#include "gpio_hal.h"
+#include "arm_math.h"
+
+#include "FreeRTOS.h"
+#include "semphr.h"
 
 extern "C"{
     #include "eta_devices_icm20602.h"
@@ -50,24 +56,47 @@ extern "C"{
 /* Constant defines -------------------------------------------------------- */
 #define CONVERT_G_TO_MS2    9.80665f
 
-#define ACC_SAMPLE_TIME_MS  0.1085f
-#define FLASH_WRITE_TIME_MS 1.1f
+/* Sensor output data rate is 1kHz / (1 + SMPLRT_DIV) */
+#define IMU_BASE_INTERVAL_MS    1.f
+/* Samples in the FIFO before the sensor raises its INT pin, and the most
+   time such a batch may take. The CPU sleeps while the batch fills */
+#define IMU_FIFO_BATCH_SAMPLES  16
+#define IMU_FIFO_BATCH_MAX_MS   250
+#define IMU_INT_IRQ             HalGpioIRQ0
+
+/* Values per FIFO sample (accel xyz, gyro xyz), accel comes first */
+#define IMU_SAMPLE_STRIDE       (sizeof(tIcm20602Sample) / sizeof(int16_t))
 
 extern ei_config_t *ei_config_get_config();
 extern EI_CONFIG_ERROR ei_config_set_sample_interval(float interval);
 
 /* Private function prototypes --------------------------------------------- */
-static float icm20602_convert_raw_to_ms2(int16_t axis);
 static float ei_inertial_accel_sensitivity(void);
+static bool imu_fifo_start(float sample_interval_ms);
+static void imu_fifo_irq(void *arg);
+static void imu_fifo_fill(void);
 
 /* Private variables ------------------------------------------------------- */
-static uint32_t samplerate_divider;
-static float imu_data[N_AXIS_SAMPLED];
+/* Samples drained from the sensor FIFO, and converted to m/s2 */
+static tIcm20602Sample fifo_samples[ICM20602_FIFO_MAX_SAMPLES];
+static float fifo_data[ICM20602_FIFO_MAX_SAMPLES * IMU_SAMPLE_STRIDE];
+static uint32_t fifo_n_samples;
+static uint32_t fifo_read_ix;
+static TickType_t fifo_batch_ticks;
+static SemaphoreHandle_t fifo_ready = NULL;
+
+/* Sensor clock based time of the sample after the last one drained */
+static uint64_t fifo_next_us;
+static float fifo_interval_ms;
+/* Convert drained samples to m/s2, off for raw batches */
+static bool fifo_convert = true;
+
 static float scale_and_ms2_convert;
 
 static tIcm20602Cfg eiIcm20602Device;
 
 sampler_callback  cb_sampler;
+inertial_batch_callback cb_batch;
 
 /**
  * @brief      Setup SPI config and accelerometer convert value
@@ -90,22 +119,45 @@ bool ei_inertial_init(void)
 }
 
 /**
- * @brief      Get data from sensor, convert and call callback to handle
+ * @brief      Get the next sample and call callback to handle.
+ *             Samples come from the sensor FIFO, when that's drained this
+ *             sleeps until the sensor signals the next batch.
  */
 void ei_inertial_read_data(void)
 {
-    tIcm20602Sample sSample;
-    volatile uint32_t div_sample_count;
+    if (fifo_read_ix >= fifo_n_samples) {
+        imu_fifo_fill();
+    }
+
+    cb_sampler((const void *)&fifo_data[fifo_read_ix * IMU_SAMPLE_STRIDE], SIZEOF_N_AXIS_SAMPLED);
+    fifo_read_ix++;
+}
+
+/**
+ * @brief      Hand the buffered samples, or the next batch from the sensor
+ *             FIFO, to the batch callback in one call
+ *
+ * @return     Return value of the batch callback, true when it's done
+ */
+bool ei_inertial_read_batch(void)
+{
+    ei_inertial_batch_t batch;
 
-    for (div_sample_count = 0; div_sample_count < samplerate_divider; div_sample_count++) {
-        EtaDevicesIcm20602SampleGet(&sSample);
+    if (fifo_read_ix >= fifo_n_samples) {
+        imu_fifo_fill();
     }
 
-    imu_data[0] = icm20602_convert_raw_to_ms2(sSample.pi16Accel[0]);
-    imu_data[1] = icm20602_convert_raw_to_ms2(sSample.pi16Accel[1]);
-    imu_data[2] = icm20602_convert_raw_to_ms2(sSample.pi16Accel[2]);
+    batch.samples = fifo_convert ? &fifo_data[fifo_read_ix * IMU_SAMPLE_STRIDE] : NULL;
+    batch.raw_samples = (const int16_t *)&fifo_samples[fifo_read_ix];
+    batch.n_samples = fifo_n_samples - fifo_read_ix;
+    batch.stride = IMU_SAMPLE_STRIDE;
+    batch.interval_ms = fifo_interval_ms;
+    batch.timestamp_us = fifo_next_us -
+        (uint64_t)((float)batch.n_samples * fifo_interval_ms * 1000.f);
+
+    fifo_read_ix = fifo_n_samples;
 
-    cb_sampler((const void *)&imu_data[0], SIZEOF_N_AXIS_SAMPLED);
+    return cb_batch(&batch);
 }
 
 /**
@@ -119,13 +171,61 @@ void ei_inertial_read_data(void)
 bool ei_inertial_sample_start(sampler_callback callsampler, float sample_interval_ms)
 {
     cb_sampler = callsampler;
+    fifo_convert = true;
 
-    samplerate_divider = (int)(sample_interval_ms / ACC_SAMPLE_TIME_MS) -
-        (FLASH_WRITE_TIME_MS / ACC_SAMPLE_TIME_MS);
+    return imu_fifo_start(sample_interval_ms);
+}
 
-    EiDevice.set_state(eiStateSampling);
+/**
+ * @brief      Setup timing and batch callback function
+ *
+ * @param[in]  callback            Function to handle a batch of samples
+ * @param[in]  sample_interval_ms  The sample interval milliseconds
+ *
+ * @return     true
+ */
+bool ei_inertial_batch_start(inertial_batch_callback callback, float sample_interval_ms)
+{
+    cb_batch = callback;
+    fifo_convert = true;
 
-    return true;
+    return imu_fifo_start(sample_interval_ms);
+}
+
+/**
+ * @brief      Setup timing and batch callback function, for batches of the
+ *             samples as read from the sensor. Skips the float conversion
+ *
+ * @param[in]  callback            Function to handle a batch of raw samples
+ * @param[in]  sample_interval_ms  The sample interval milliseconds
+ *
+ * @return     true
+ */
+bool ei_inertial_raw_batch_start(inertial_batch_callback callback, float sample_interval_ms)
+{
+    cb_batch = callback;
+    fifo_convert = false;
+
+    return imu_fifo_start(sample_interval_ms);
+}
+
+/**
+ * @brief      Value of one raw accelerometer step
+ *
+ * @return     m/s2 per LSB
+ */
+float ei_inertial_sample_scale(void)
+{
+    return scale_and_ms2_convert;
+}
+
+/**
+ * @brief      Stop sampling into the sensor FIFO
+ */
+void ei_inertial_sample_stop(void)
+{
+    HalGpioIntDisable(IMU_INT_IRQ, ETA_BSP_ICM20602_INT);
+    EtaDevicesIcm20602FifoStop();
 }
 
 /**
@@ -162,15 +262,106 @@ bool ei_inertial_setup_data_sampling(void)
 /* Static functions -------------------------------------------------------- */
 
 /**
- * @brief      Convert raw accelerometer axis data in g to ms2
+ * @brief      Configure the sensor output data rate and FIFO watermark, and
+ *             start sampling into the FIFO
  *
- * @param[in]  axis   The axis
+ * @param[in]  sample_interval_ms  The sample interval milliseconds
  *
- * @return     Return mg value
+ * @return     false if the FIFO interrupt couldn't be setup
+ */
+static bool imu_fifo_start(float sample_interval_ms)
+{
+    int32_t rate_div = (int32_t)((sample_interval_ms / IMU_BASE_INTERVAL_MS) + 0.5f) - 1;
+    if (rate_div < 0) {
+        rate_div = 0;
+    }
+    else if (rate_div > 255) {
+        rate_div = 255;
+    }
+
+    float interval_ms = IMU_BASE_INTERVAL_MS * (float)(rate_div + 1);
+    uint32_t batch = (uint32_t)(IMU_FIFO_BATCH_MAX_MS / interval_ms);
+    if (batch > IMU_FIFO_BATCH_SAMPLES) {
+        batch = IMU_FIFO_BATCH_SAMPLES;
+    }
+    else if (batch == 0) {
+        batch = 1;
+    }
+
+    /* Wait up to two batches for the INT pin, before checking the FIFO anyway */
+    fifo_batch_ticks = pdMS_TO_TICKS((uint32_t)(interval_ms * batch * 2)) + 1;
+
+    if (fifo_ready == NULL) {
+        fifo_ready = xSemaphoreCreateBinary();
+        if (fifo_ready == NULL) {
+            return false;
+        }
+        HalGpioIntInit(ETA_BSP_ICM20602_INT, IMU_INT_IRQ, imu_fifo_irq, NULL,
+            HalGpioTrigHigh, HalGpioPullNone);
+        HalGpioIntDisable(IMU_INT_IRQ, ETA_BSP_ICM20602_INT);
+    }
+
+    fifo_n_samples = 0;
+    fifo_read_ix = 0;
+    fifo_interval_ms = interval_ms;
+    fifo_next_us = (uint64_t)EtaCspTimerCountGetMs() * 1000;
+    EtaDevicesIcm20602FifoStart((uint8_t)rate_div, (uint16_t)batch);
+
+    EiDevice.set_state(eiStateSampling);
+
+    return true;
+}
+
+/**
+ * @brief      INT pin raised on FIFO watermark or overflow. The pin stays
+ *             high until the status is read, so mask it until then
+ */
+static void imu_fifo_irq(void *arg)
+{
+    BaseType_t higher_priority_task_woken = pdFALSE;
+
+    HalGpioIntDisable(IMU_INT_IRQ, ETA_BSP_ICM20602_INT);
+    xSemaphoreGiveFromISR(fifo_ready, &higher_priority_task_woken);
+    portYIELD_FROM_ISR(higher_priority_task_woken);
+}
+
+/**
+ * @brief      Sleep until the sensor FIFO holds a batch, then drain it in
+ *             bursts. Samples lost to an overflow are skipped.
  */
-static float icm20602_convert_raw_to_ms2(int16_t axis)
+static void imu_fifo_fill(void)
 {
-    return ((float)axis * scale_and_ms2_convert);
+    int32_t n_samples;
+
+    fifo_read_ix = 0;
+
+    for (;;) {
+        n_samples = EtaDevicesIcm20602FifoRead(fifo_samples, ICM20602_FIFO_MAX_SAMPLES);
+        if (n_samples > 0) {
+            break;
+        }
+        else if (n_samples < 0) {
+            /* Overflow, the FIFO restarts from now */
+            fifo_next_us = (uint64_t)EtaCspTimerCountGetMs() * 1000;
+        }
+
+        HalGpioIntClear(IMU_INT_IRQ, ETA_BSP_ICM20602_INT);
+        HalGpioIntEnable(IMU_INT_IRQ, ETA_BSP_ICM20602_INT);
+        xSemaphoreTake(fifo_ready, fifo_batch_ticks);
+    }
+
+    fifo_n_samples = (uint32_t)n_samples;
+    fifo_next_us += (uint64_t)((float)fifo_n_samples * fifo_interval_ms * 1000.f);
+
+    if (!fifo_convert) {
+        return;
+    }
+
+    /* Convert the whole batch in one pass, raw / 32768 * full scale * g.
+       Only the accelerometer values (first N_AXIS_SAMPLED of each stride) are used */
+    arm_q15_to_float((q15_t *)fifo_samples, fifo_data, fifo_n_samples * IMU_SAMPLE_STRIDE);
+    arm_scale_f32(fifo_data, scale_and_ms2_convert * 32768.f, fifo_data,
+        fifo_n_samples * IMU_SAMPLE_STRIDE);
 }
 
 /**
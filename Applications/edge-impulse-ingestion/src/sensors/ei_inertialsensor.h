@@ -43,11 +43,34 @@ typedef float sample_format_t;
 #define N_AXIS_SAMPLED			3
 #define SIZEOF_N_AXIS_SAMPLED	(sizeof(sample_format_t) * N_AXIS_SAMPLED)
 
+/**
+ * Batch of samples drained from the sensor FIFO. Sample n starts at
+ * samples[n * stride] with N_AXIS_SAMPLED accelerometer values in m/s2, and
+ * was taken at timestamp_us + n * interval_ms. raw_samples holds the same
+ * values as read from the sensor, times ei_inertial_sample_scale() is m/s2.
+ * Batches started with ei_inertial_raw_batch_start only have raw_samples.
+ */
+typedef struct {
+    const sample_format_t *samples;
+    const int16_t *raw_samples;
+    uint32_t n_samples;
+    uint32_t stride;
+    uint64_t timestamp_us;
+    float interval_ms;
+} ei_inertial_batch_t;
+
+/** Batch handler, returns true when no more samples are needed */
+typedef bool (*inertial_batch_callback)(const ei_inertial_batch_t *batch);
 
 /* Function prototypes ----------------------------------------------------- */
 bool ei_inertial_init(void);
 void ei_inertial_read_data(void);
+bool ei_inertial_read_batch(void);
 bool ei_inertial_sample_start(sampler_callback callback, float sample_interval_ms);
+bool ei_inertial_batch_start(inertial_batch_callback callback, float sample_interval_ms);
+bool ei_inertial_raw_batch_start(inertial_batch_callback callback, float sample_interval_ms);
+float ei_inertial_sample_scale(void);
+void ei_inertial_sample_stop(void);
 bool ei_inertial_setup_data_sampling(void);
 
 #endif
\ No newline at end of file
@@ -45,7 +45,7 @@
 #include "eta_bsp.h"
 
 #include "FreeRTOS.h"
-#include "queue.h"
+#include "semphr.h"
 
 /* Audio sampling config */
 #define AUDIO_SAMPLING_FREQUENCY            16000
@@ -54,14 +54,40 @@
 #define AUDIO_DSP_SAMPLE_RESOLUTION         (sizeof(short))
 #define AUDIO_DSP_SAMPLE_BUFFER_SIZE        (AUDIO_SAMPLES_PER_MS * AUDIO_DSP_SAMPLE_LENGTH_MS * AUDIO_DSP_SAMPLE_RESOLUTION)
 
+/* Number of PCM frames that can be in flight between FrameCb and the consumer */
+#define EI_FRAME_RING_COUNT                 16
+#define EI_FRAME_RING_SAMPLES               (AUDIO_SAMPLES_PER_MS * AUDIO_DSP_SAMPLE_LENGTH_MS)
+#include "ei_frame_ring.h"
 
-/** Status and control struct for inferencing struct */
+/* Slices of headroom on top of the model window in continuous mode */
+#define AUDIO_HISTORY_EXTRA_SLICES          1
+
+/* Audio erased before recording starts (~2 s.), the rest is erased while recording.
+   Audio outruns a sector erase, the lead and the frame ring absorb the difference */
+#define AUDIO_ERASE_AHEAD_LEAD              MX25R_BLOCK64_SIZE
+
+
+/**
+ * Status and control struct for inferencing. Samples are kept in a circular
+ * history, all indexes are running sample counters (modulo history size on access).
+ * FrameCb writes the history (write_ix), the inference task reads it (read_ix,
+ * next_ix), so frames keep coming in while a slice is being classified.
+ */
 typedef struct {
-    int16_t *buffers[2];
-    uint8_t buf_select;
-    uint8_t buf_ready;
-    uint32_t buf_count;
+    int16_t *history;
+    uint32_t history_size;
+    /* first sample of the slice returned by the last record, in use by the classifier */
+    volatile uint32_t read_ix;
+    /* first sample of the slice the next record will return */
+    volatile uint32_t next_ix;
+    /* total samples written into history */
+    volatile uint32_t write_ix;
+    /* samples dropped because the history was full */
+    volatile uint32_t overruns;
+    /* most samples ahead of read_ix since inference started */
+    uint32_t high_water;
     uint32_t n_samples;
+    volatile bool continuous;
 } inference_t;
 
 
@@ -77,12 +103,6 @@ typedef struct {
     uint8_t rFLen;
 }tPdmcfg;
 
-struct frameEvarg {
-    int32_t flen;
-    int32_t num;
-    int16_t fbuf[512];
-};
-
 /* Extern prototypes declerations ------------------------------------------ */
 typedef void (*tPCMFrameCb)(void *ptr, void *buf, uint16_t blen);
 extern "C" int ecm3532_pdm_init(tPdmcfg *sPdm, tPCMFrameCb fPcmCb, void *vCbptr);
@@ -103,7 +123,7 @@ static int ei_seek(EI_SENSOR_AQ_STREAM*, long int offset, int origin)
 }
 
 /* Private variables ------------------------------------------------------- */
-static bool record_ready = false;
+static volatile bool record_ready = false;
 static uint32_t headerOffset;
 static uint32_t samples_required;
 static uint32_t current_sample;
@@ -121,7 +141,11 @@ static sensor_aq_ctx ei_mic_ctx = {
     NULL,
 };
 
-static QueueHandle_t frameEv = NULL;
+/* Producer is FrameCb, consumer is get_dsp_data. Sampling only, inference frames go to the history */
+static ei_frame_ring_t frame_ring;
+/* frames dropped since the stream started, frame_ring.overruns is per record */
+static uint32_t frame_ring_dropped;
+static SemaphoreHandle_t frame_ready = NULL;
 // static int16_t audio_buffer[AUDIO_DSP_SAMPLE_BUFFER_SIZE];
 static tPdmcfg sPdmcfg;
 
@@ -136,7 +160,14 @@ static tPdmcfg sPdmcfg;
  */
 static void audio_buffer_callback(void *buffer, uint32_t n_bytes)
 {
-    ei_eta_fs_write_samples((const void *)buffer, headerOffset + current_sample, n_bytes);
+    int16_t *samples = (int16_t *)buffer;
+
+    /* Apply the 1-bit gain in place, the consumer owns the slot */
+    for(uint32_t i = 0; i < (n_bytes >> 1); i++) {
+        samples[i] = samples[i] << 1;
+    }
+
+    ei_eta_fs_stream_write((const void *)buffer, n_bytes);
 
     ei_mic_ctx.signature_ctx->update(ei_mic_ctx.signature_ctx, (uint8_t*)buffer, n_bytes);
 
@@ -147,47 +178,77 @@ static void audio_buffer_callback(void *buffer, uint32_t n_bytes)
 }
 
 /**
- * @brief      Inference audio callback, store samples in ram buffer
- *             Signal when buffer is full, and swap buffers
+ * @brief      Inference audio callback, called from FrameCb. Appends samples to
+ *             the circular history. The slice at read_ix is in use by the
+ *             classifier and is never overwritten, new samples are dropped
+ *             (and counted) when the history is full up to it
  * @param      buffer   Pointer to source buffer
  * @param[in]  n_bytes  Number of bytes to write
  */
-static void audio_buffer_inference_callback(void *buffer, uint32_t n_bytes)
+static void audio_buffer_inference_callback(const void *buffer, uint32_t n_bytes)
 {
-    int16_t *samples = (int16_t *)buffer;
+    const int16_t *samples = (const int16_t *)buffer;
+    uint32_t n = n_bytes >> 1;
+    uint32_t write_ix = inference.write_ix;
+    uint32_t read_ix = inference.read_ix;
+
+    if (!inference.continuous) {
+        /* window complete, rest of the frame is not needed */
+        uint32_t n_needed = inference.n_samples - (write_ix - inference.next_ix);
+        if (n > n_needed) {
+            n = n_needed;
+        }
+    }
 
-    for(uint32_t i = 0; i < (n_bytes >> 1); i++) {
-        inference.buffers[inference.buf_select][inference.buf_count++] = samples[i];
+    uint32_t n_free = inference.history_size - (write_ix - read_ix);
+    if (n > n_free) {
+        inference.overruns += n - n_free;
+        n = n_free;
+    }
 
-        if(inference.buf_count >= inference.n_samples) {
-            inference.buf_select ^= 1;
-            inference.buf_count = 0;
-            inference.buf_ready = 1;
-        }
+    for(uint32_t i = 0; i < n; i++) {
+        inference.history[(write_ix + i) % inference.history_size] = samples[i] << 1;
     }
+
+    write_ix += n;
+    if ((write_ix - read_ix) > inference.high_water) {
+        inference.high_water = write_ix - read_ix;
+    }
+
+    /* Samples must be visible before the reader sees the new write_ix */
+    __sync_synchronize();
+    inference.write_ix = write_ix;
 }
-static int max_msg_ready = 0;
+
+/**
+ * @brief      Drop all frames in the ring and clear the statistics
+ */
+static void frame_ring_reset(void)
+{
+    ei_frame_ring_reset(&frame_ring);
+    frame_ring_dropped = 0;
+    xSemaphoreTake(frame_ready, 0);
+}
+
 /**
- * @brief      Check DSP semaphores, when ready get sample buffer that belongs
- *             to the semaphore.
+ * @brief      Wait for the DSP to deliver frames, then hand every published
+ *             slot to the callback and release it back to the producer.
  * @param[in]  callback  Callback needs to handle the audio samples
  */
 static void get_dsp_data(void (*callback)(void *buffer, uint32_t n_bytes))
 {
-    struct frameEvarg evArg;
-    int n_msg_ready;
-    do {
-        xQueueReceive(frameEv, &evArg, portMAX_DELAY);
-
-        callback((void *)&evArg.fbuf[0], evArg.flen);
+    while (ei_frame_ring_ready(&frame_ring) == 0) {
+        xSemaphoreTake(frame_ready, portMAX_DELAY);
+    }
 
-        n_msg_ready = uxQueueMessagesWaiting(frameEv);
+    do {
+        uint16_t n_bytes;
+        int16_t *frame = ei_frame_ring_front(&frame_ring, &n_bytes);
 
-        if(n_msg_ready > max_msg_ready) {
-            max_msg_ready = n_msg_ready;
-        }
+        callback((void *)frame, n_bytes);
 
-    }while(n_msg_ready);
+        ei_frame_ring_pop(&frame_ring);
+    } while (ei_frame_ring_ready(&frame_ring) != 0);
 }
 
 
@@ -286,21 +347,31 @@ static bool create_header(void)
     }
 
     headerOffset = end_of_header_ix;
+    tr = ei_eta_fs_stream_begin(headerOffset);
+    if (tr != 0) {
+        ei_printf("Failed to start the sample stream (%d)\n", tr);
+        return false;
+    }
 
     return true;
 }
 
+/**
+ * @brief      PCM frame callback. Moves the frame out of the DSP ping-pong
+ *             buffer into the inference history, or into a free pool slot
+ *             when sampling, and publishes it. Never blocks.
+ */
 static void FrameCb(void *ptr, void *buf, uint16_t blen)
 {
     if (record_ready == true) {
-        struct frameEvarg evArg;
-
-        evArg.flen = blen;
-
-        for(int i = 0; i < (blen >> 1); i++) {
-            evArg.fbuf[i] = *((int16_t *)buf + i) << 1;
+        if (inference.history != NULL) {
+            /* Inferencing, straight into the history */
+            audio_buffer_inference_callback(buf, blen);
+            xSemaphoreGive(frame_ready);
+        }
+        else if (ei_frame_ring_push(&frame_ring, buf, blen)) {
+            xSemaphoreGive(frame_ready);
         }
-        xQueueSendToBack(frameEv, &evArg, portMAX_DELAY);
     }
 }
 
@@ -321,7 +392,7 @@ void ei_microphone_init(void)
     *(pdm0_core_conf) |= ((GAIN_34_5dB << PGA_R) | (GAIN_34_5dB << PGA_L));
     *(pdm1_core_conf) |= ((GAIN_34_5dB << PGA_R) | (GAIN_34_5dB << PGA_L));
 
-    frameEv = xQueueCreate(32, sizeof(struct frameEvarg));
+    frame_ready = xSemaphoreCreateBinary();
 
     sPdmcfg.pdmNum = 1;
     sPdmcfg.sRate = AUDIO_SAMPLES_PER_MS;
@@ -347,7 +418,8 @@ bool ei_microphone_record(uint32_t sample_length_ms, uint32_t start_delay_ms, bo
         EiDevice.delay_ms(2000 - start_delay_ms);
     }
 
-    if (ei_eta_fs_erase_sampledata(0, (samples_required << 1) + ei_eta_fs_get_block_size()) !=
+    if (ei_eta_fs_erase_ahead_start(
+            (samples_required << 1) + ei_eta_fs_get_block_size(), AUDIO_ERASE_AHEAD_LEAD) !=
         ETA_FS_CMD_OK) {
 
         ecm3532_stop_pdm_stream(sPdmcfg.pdmNum);
@@ -363,27 +435,37 @@ bool ei_microphone_record(uint32_t sample_length_ms, uint32_t start_delay_ms, bo
     return true;
 }
 
-bool ei_microphone_inference_start(uint32_t n_samples)
+/**
+ * @brief      Allocate the audio history and start the PDM stream
+ * @param[in]  n_samples  Samples returned per record (a window, or a slice in continuous mode)
+ * @param[in]  n_slices   Slices per model window, 1 when not running continuous
+ */
+bool ei_microphone_inference_start(uint32_t n_samples, uint32_t n_slices)
 {
+    uint32_t history_size = n_samples * n_slices;
 
-    inference.buffers[0] = (int16_t *)ei_malloc(n_samples * sizeof(int16_t));
-
-    if (inference.buffers[0] == NULL) {
-        return false;
+    if (n_slices > 1) {
+        history_size += n_samples * AUDIO_HISTORY_EXTRA_SLICES;
     }
 
-    inference.buffers[1] = (int16_t *)ei_malloc(n_samples * sizeof(int16_t));
+    int16_t *history = (int16_t *)ei_malloc(history_size * sizeof(int16_t));
 
-    if (inference.buffers[1] == NULL) {
-        ei_free(inference.buffers[0]);
+    if (history == NULL) {
         return false;
     }
 
-    inference.buf_select = 0;
-    inference.buf_count = 0;
+    inference.history_size = history_size;
     inference.n_samples = n_samples;
-    inference.buf_ready = 0;
-
+    inference.read_ix = 0;
+    inference.next_ix = 0;
+    inference.write_ix = 0;
+    inference.overruns = 0;
+    inference.high_water = 0;
+    inference.continuous = (n_slices > 1);
+    /* Set last, FrameCb fills the history once it is there */
+    inference.history = history;
+
+    frame_ring_reset();
     ecm3532_start_pdm_stream(sPdmcfg.pdmNum);
     record_ready = true;
 
@@ -395,23 +477,29 @@ bool ei_microphone_inference_record(bool continuous)
 {
     bool ret = true;
 
-    while(inference.buf_ready == 0) {
-        get_dsp_data(&audio_buffer_inference_callback);
+    inference.continuous = continuous;
+
+    while((inference.write_ix - inference.next_ix) < inference.n_samples) {
+        xSemaphoreTake(frame_ready, portMAX_DELAY);
     };
 
     if (continuous == false) {
         record_ready = false;
     }
 
-    if (continuous && max_msg_ready == 32) {
+    uint32_t overruns = inference.overruns;
+    if (continuous && overruns > 0) {
         ei_printf(
-            "Error sample buffer overrun. Decrease the number of slices per model window "
-            "(EI_CLASSIFIER_SLICES_PER_MODEL_WINDOW)\n");
+            "Error sample buffer overrun (%lu samples dropped). Decrease the number of slices per model window "
+            "(EI_CLASSIFIER_SLICES_PER_MODEL_WINDOW)\n", overruns);
         ret = false;
     }
 
-    max_msg_ready = 0;
-    inference.buf_ready = 0;
+    /* Hands the previous slice back to FrameCb */
+    inference.read_ix = inference.next_ix;
+    inference.next_ix += inference.n_samples;
+
+    __sync_fetch_and_sub(&inference.overruns, overruns);
 
     return ret;
 }
@@ -421,18 +509,49 @@ bool ei_microphone_inference_record(bool continuous)
  */
 void ei_microphone_inference_reset_buffers(void)
 {
-    inference.buf_ready = 0;
-    inference.buf_count = 0;
+    inference.read_ix = 0;
+    inference.next_ix = 0;
+    inference.write_ix = 0;
+    inference.overruns = 0;
+    xSemaphoreTake(frame_ready, 0);
     record_ready = true;
-    xQueueReset(frameEv);
 }
 
 /**
- * Get raw audio signal data
+ * Get raw audio signal data, straight from the history of the last recorded slice
  */
 int ei_microphone_audio_signal_get_data(size_t offset, size_t length, float *out_ptr)
 {
-    arm_q15_to_float(&inference.buffers[inference.buf_select ^ 1][offset], out_ptr, length);
+    uint32_t ix = (inference.read_ix + offset) % inference.history_size;
+    uint32_t n_first = inference.history_size - ix;
+
+    if (n_first >= length) {
+        arm_q15_to_float(&inference.history[ix], out_ptr, length);
+    }
+    else {
+        arm_q15_to_float(&inference.history[ix], out_ptr, n_first);
+        arm_q15_to_float(&inference.history[0], out_ptr + n_first, length - n_first);
+    }
+
+    return 0;
+}
+
+/**
+ * Same as ei_microphone_audio_signal_get_data, but hands out the q15 samples
+ * for the fixed-point DSP blocks
+ */
+int ei_microphone_audio_signal_get_data_i16(size_t offset, size_t length, int16_t *out_ptr)
+{
+    uint32_t ix = (inference.read_ix + offset) % inference.history_size;
+    uint32_t n_first = inference.history_size - ix;
+
+    if (n_first >= length) {
+        memcpy(out_ptr, &inference.history[ix], length * sizeof(int16_t));
+    }
+    else {
+        memcpy(out_ptr, &inference.history[ix], n_first * sizeof(int16_t));
+        memcpy(out_ptr + n_first, &inference.history[0], (length - n_first) * sizeof(int16_t));
+    }
 
     return 0;
 }
@@ -440,16 +559,31 @@ int ei_microphone_audio_signal_get_data(size_t offset, size_t length, float *out
 bool ei_microphone_inference_end(void)
 {
     record_ready = false;
-
-    /* Empty queue before stopping stream */
-    xQueueReset(frameEv);
     ecm3532_stop_pdm_stream(sPdmcfg.pdmNum);
 
-    ei_free(inference.buffers[0]);
-    ei_free(inference.buffers[1]);
+    /* FrameCb is done with the history, the statistics stay for AT+AUDIOSTATS */
+    int16_t *history = inference.history;
+    inference.history = NULL;
+    ei_free(history);
     return true;
 }
 
+/**
+ * @brief      Print how full the PDM frame ring got, and how many frames were
+ *             dropped, since the last recording or inference run started
+ */
+void ei_microphone_print_ring_stats(void)
+{
+    ei_printf("Audio frame ring: high-water %lu of %d frames (%lu ms.), %lu frames dropped\n",
+        frame_ring.high_water, EI_FRAME_RING_COUNT,
+        frame_ring.high_water * AUDIO_DSP_SAMPLE_LENGTH_MS,
+        frame_ring_dropped + frame_ring.overruns);
+    if (inference.history_size > 0) {
+        ei_printf("Audio history: high-water %lu of %lu ms. behind the classified slice\n",
+            inference.high_water / AUDIO_SAMPLES_PER_MS, inference.history_size / AUDIO_SAMPLES_PER_MS);
+    }
+}
+
 /**
  * Sample raw data
  */
@@ -482,10 +616,11 @@ bool ei_microphone_sample_start(void)
 
     current_sample = 0;
 
-    bool r = ei_microphone_record(ei_config_get_config()->sample_length_ms, (((samples_required <<1)/ ei_eta_fs_get_block_size()) * ETA_FS_BLOCK_ERASE_TIME_MS), true);
+    bool r = ei_microphone_record(ei_config_get_config()->sample_length_ms, ((AUDIO_ERASE_AHEAD_LEAD / ei_eta_fs_get_block_size()) * ETA_FS_BLOCK_ERASE_TIME_MS), true);
     if (!r) {
         return r;
     }
+    frame_ring_reset();
     record_ready = true;
     EiDevice.set_state(eiStateSampling);
 
@@ -495,6 +630,11 @@ bool ei_microphone_sample_start(void)
 
     ecm3532_stop_pdm_stream(sPdmcfg.pdmNum);
 
+    if (ei_eta_fs_stream_flush() != ETA_FS_CMD_OK) {
+        ei_printf("Failed to flush audio to flash\n");
+        return false;
+    }
+
     int ctx_err =
         ei_mic_ctx.signature_ctx->finish(ei_mic_ctx.signature_ctx, ei_mic_ctx.hash_buffer.buffer);
     if (ctx_err != 0) {
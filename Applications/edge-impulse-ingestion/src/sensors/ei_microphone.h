@@ -42,13 +42,15 @@
 
 /* Function prototypes ----------------------------------------------------- */
 void ei_microphone_init(void);
-bool ei_microphone_inference_start(uint32_t n_samples);
+bool ei_microphone_inference_start(uint32_t n_samples, uint32_t n_slices);
 
 bool ei_microphone_sample_start(void);
 bool ei_microphone_inference_record(bool continuous);
 void ei_microphone_inference_reset_buffers(void);
 int ei_microphone_audio_signal_get_data(size_t offset, size_t length, float *out_ptr);
+int ei_microphone_audio_signal_get_data_i16(size_t offset, size_t length, int16_t *out_ptr);
 bool ei_microphone_inference_end(void);
+void ei_microphone_print_ring_stats(void);
 
 
 #endif
\ No newline at end of file
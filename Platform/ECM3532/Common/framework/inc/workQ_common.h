@@ -15,10 +15,21 @@
 #ifndef H_WORKQ_COMMON_
 #define H_WORKQ_COMMON_
 #include "config.h"
-//TBD: Needs to go to config.h
+// Queue depth is part of the M3/DSP shared memory layout, both images must
+// be built with the same CONFIG_WORK_QUEUE_SIZE. One slot stays empty, so
+// MAX_WORK_QUEUE_SIZE - 1 works can be pending.
+#ifdef CONFIG_WORK_QUEUE_SIZE
+#define MAX_WORK_QUEUE_SIZE CONFIG_WORK_QUEUE_SIZE
+#else
 #define MAX_WORK_QUEUE_SIZE 2
-/* reserved 32 for tM3DSPSharedMemory */
-#define SHARED_MEMORY_ALLOCATOR_SIZE (CONFIG_SHM_LENGTH - 32)
+#endif
+/* reserved for tM3DSPSharedMemory, everything but byteArray rounded up to 32 */
+#define SHARED_MEMORY_RESERVED_SIZE ((12 + (6 * MAX_WORK_QUEUE_SIZE) + 31) & ~31)
+#define SHARED_MEMORY_ALLOCATOR_SIZE (CONFIG_SHM_LENGTH - SHARED_MEMORY_RESERVED_SIZE)
+
+// DSP to M3 header sent when a work is taken out of a queue the M3 is
+// waiting on: module DEBUG, event, user defined field 3
+#define WORK_QUEUE_SPACE_MSG 0x1C
 
 #ifdef __GNUC__
 #include "stdint.h"
@@ -33,10 +44,15 @@ typedef struct workDescriptor_t {
     uint16_t argumentPointerOffset; //memory offset where additional arguments for commands are located.
 }tWorkDescriptor;
 
+// Single producer (M3), single consumer (DSP) ring. writeIndex and
+// producerWaiting are only written by the M3, readIndex only by the DSP.
+// A slot is filled before writeIndex moves past it and read before
+// readIndex does, so neither side needs a lock.
 typedef struct workQueue_t {
     uint16_t readIndex;
     uint16_t writeIndex;
     tWorkDescriptor workArray[MAX_WORK_QUEUE_SIZE];
+    uint16_t producerWaiting; // M3 blocked on a full queue, DSP sends WORK_QUEUE_SPACE_MSG
 } tWorkQueue;
 
 typedef struct sharedMemory_t {
@@ -49,6 +65,10 @@ typedef struct sharedMemory_t {
 
 int WorkQueueInit(tWorkQueue* queue);   //Shared queue between m3 and dsp will be initialized by M3
 int WorkQueueAdd(tWorkQueue* queue, tWorkDescriptor* work);  //New workTask will be added by M3 into queue
+#ifdef __GNUC__
+int WorkQueueAddBatch(tWorkQueue* queue, tWorkDescriptor* works, uint16_t numWorks); //M3 adds works, one doorbell for all
+void WorkQueueSpaceAvailableFromISR(void); //M3 IPC ISR on WORK_QUEUE_SPACE_MSG
+#endif
 
 #ifdef __GNUC__
 int WorkQueueRemove(tWorkQueue chess_storage(IOMEM)* queue, tWorkDescriptor* work); //DSP will takeout task from queue and process.
@@ -46,6 +46,7 @@ int MsgQueueInit(tMsgQueue* queue);
 int MsgQueueAdd(tMsgQueue* queue, tdspLocalMsg* msg);
 int MsgQueueRemove(tMsgQueue* queue, tdspLocalMsg* msg);
 uint8_t IsMsgQueueEmpty(tMsgQueue* queue);
+uint8_t IsMsgQueueFull(tMsgQueue* queue);
 
 
 #endif//# H_DSP_MSG_
@@ -44,6 +44,7 @@ int MsgQueueAdd(tMsgQueue* queue, tdspLocalMsg* msg)
 		next = 0;
 
 	if (next == queue->readIndex) { // if the writeIndex + 1 == readIndex, circular buffer is full
+		enable_interrupt();
 		return -1; // We can assert too
 	}
 	// Load data and then move
@@ -65,6 +66,7 @@ int MsgQueueRemove(tMsgQueue* queue, tdspLocalMsg* msg)
     uint8_t index = 0;
     disable_interrupt();
 	if (queue->writeIndex == queue->readIndex) {  // if the writeIndex == readIndex, we don't have any data
+		enable_interrupt();
 		return -1;
 	}
 	next = queue->readIndex + 1;  // next is where readIndex will point to after this read.
@@ -89,4 +91,16 @@ uint8_t IsMsgQueueEmpty(tMsgQueue* queue)
     enable_interrupt();
     return result;
 }
-
+uint8_t IsMsgQueueFull(tMsgQueue* queue)
+{
+    uint8_t next;
+    uint8_t result = 0;
+    disable_interrupt();
+    next = queue->writeIndex + 1;
+    if (next >= MAX_DSP_LOCAL_QUEUE_SIZE)
+        next = 0;
+    if (next == queue->readIndex)
+        result = 1;
+    enable_interrupt();
+    return result;
+}
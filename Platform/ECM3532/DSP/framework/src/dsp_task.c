@@ -82,7 +82,9 @@ void DspTaskSchedule(void)
     tWorkDescriptor work;
     while (1)
     {
-        if (IsWorkQueueEmpty(&(PhysicalSharedMemory.workQueue)))
+        // Works stay in the shared queue while the local one is full, the
+        // M3 then blocks instead of the work getting dropped
+        if (IsWorkQueueEmpty(&(PhysicalSharedMemory.workQueue)) || IsMsgQueueFull(&dspMsgQ))
         {
 
             if (IsMsgQueueEmpty(&dspMsgQ))
@@ -12,10 +12,18 @@
 // from Eta Compute Inc.
 //////////////////////////////////////////////////////////////////////////
 #include "workQ_common.h"
+#include "eta_csp_mailbox.h"
+
+// Consumer side of the M3 to DSP ring. Every shared memory access goes
+// through the volatile IOMEM queue pointer, so they are done in program
+// order: the slot is read before readIndex moves, readIndex moves before
+// producerWaiting is checked.
+
 int WorkQueueInit(tWorkQueue* queue)
 {
     uint8_t index = 0;
     queue->readIndex = queue->writeIndex = 0;
+    queue->producerWaiting = 0;
     //Follow a away which can work for all compilers even chess. later can be chanaged. So no memcpy
     for (index = 0; index < MAX_WORK_QUEUE_SIZE; index++) {
         queue->workArray[index].moduleId = 0;
@@ -51,19 +59,24 @@ int WorkQueueAdd(tWorkQueue* queue, tWorkDescriptor* work)
 int WorkQueueRemove(volatile tWorkQueue chess_storage(IOMEM)* queue, tWorkDescriptor* work)
 {
     uint16_t next;
-    if (queue->writeIndex == queue->readIndex) {  // if the writeIndex == readIndex, we don't have any data
+    uint16_t readIndex = queue->readIndex;
+    if (queue->writeIndex == readIndex) {  // if the writeIndex == readIndex, we don't have any data
         return -1;
     }
 
-    next = queue->readIndex + 1;  // next is where readIndex will point to after this read.
+    next = readIndex + 1;  // next is where readIndex will point to after this read.
     if (next >= MAX_WORK_QUEUE_SIZE)
         next = 0;
     //Read data and move
-    work->moduleId = queue->workArray[queue->readIndex].moduleId;
-    work->operation = queue->workArray[queue->readIndex].operation;
-    work->argumentPointerOffset = queue->workArray[queue->readIndex].argumentPointerOffset;
+    work->moduleId = queue->workArray[readIndex].moduleId;
+    work->operation = queue->workArray[readIndex].operation;
+    work->argumentPointerOffset = queue->workArray[readIndex].argumentPointerOffset;
 
     queue->readIndex = next;              // readIndex to next offset.
+
+    // M3 is blocked on a full queue, tell it there is room now
+    if (queue->producerWaiting)
+        EtaCspMboxDsp2M3(WORK_QUEUE_SPACE_MSG, 0);
     return 0;  // return success to indicate successful push.
 }
 
@@ -19,13 +19,30 @@
 #define NORMAL_CONV_2D          0
 #define DEPTHWISE_CONV_2D   1
 
+#define EXEC_NO_WORK				0xFF
+
+// One bit per schedList slot
+#if CONFIG_EXEC_MAX_SCHEDULED_WORK <= 8
+typedef uint8_t ExecWorkMask_t;
+#elif CONFIG_EXEC_MAX_SCHEDULED_WORK <= 16
+typedef uint16_t ExecWorkMask_t;
+#elif CONFIG_EXEC_MAX_SCHEDULED_WORK <= 32
+typedef uint32_t ExecWorkMask_t;
+#else
+#error "CONFIG_EXEC_MAX_SCHEDULED_WORK can be at most 32"
+#endif
+#define EXEC_WORK_BIT(X)			((ExecWorkMask_t)1 << (X))
+
 struct privateInfo
 {
 	uint8_t bufState:2;
 	uint8_t bufType:2;
-	uint8_t usageCount:2;
 	uint8_t tobeFreed:1;
-	uint8_t reserved:1;
+	uint8_t aliased:1;		// bound by ExecBindPlan, may share bytes with other operands
+	uint8_t reserved:2;
+	uint8_t usageCount;		// works in flight using the buffer
+	uint8_t lastWriter;		// schedList index of the last writer in flight, or EXEC_NO_WORK
+	ExecWorkMask_t readers;	// works in flight reading the buffer
 	void *bufAddr;
 };
 
@@ -36,14 +53,13 @@ typedef struct ExecWork
 	uint8_t numInputs;
     uint8_t opID;
 	uint8_t valid:1;
-	uint8_t wait4Completion:1;
+	uint8_t submitted:1;	// handed to SubmitM3Work/SubmitDSPWork
     uint8_t variant :2;
     uint8_t reserved:4;
+	uint8_t pendingDeps;	// works this one still waits for
+	ExecWorkMask_t waiters;	// works waiting for this one
 	ExecOperand_t * inbufs[CONFIG_EXEC_MAX_INPUTS] ;
 	ExecOperand_t * outBuf;	//
-#ifdef CONFIG_BIN_SEM
-	SemaphoreHandle_t waitSem;
-#endif
 	void *params;
 } ExecWork_t ;
 
@@ -106,6 +122,13 @@ typedef struct
 
 
 uint8_t CheckAndScheduleWork (ExecWork_t * work, uint8_t inoutExist) ;
+
+// Object pools, executor_pool.c
+void ExecPoolsInit (void);
+struct privateInfo * ExecAllocPrivInfo (void);
+void ExecFreePrivInfo (struct privateInfo * privinfo);
+void * ExecAllocParams (uint32_t size);
+void ExecFreeParams (void * params);
 void SubmitM3Work (uint8_t execWorkID) ;
 void SubmitDSPWork (uint8_t execWorkID) ;
 
@@ -1,13 +1,37 @@
 #ifndef	_EXECUTOR_CFG_H_
 #define	_EXECUTOR_CFG_H_
 
-#define CONFIG_EXEC_MAX_SCHEDULED_WORK		4	// Lets be fair 2 in DSP and 2 in M3. assuming they do not have any data dependency
+// Works in flight across M3 and DSP, dependent works wait in the window
+// for their inputs instead of blocking the submitter
+#ifndef CONFIG_EXEC_MAX_SCHEDULED_WORK
+#define CONFIG_EXEC_MAX_SCHEDULED_WORK		8
+#endif
 #define CONFIG_EXEC_MAX_INPUTS				5	// 2 inputs and 2 scratches
 
+// Pool sizes, operands allocated with ExecAllocMem and params of works in
+// flight (one more for the submitter waiting for a slot)
+#ifndef CONFIG_EXEC_PRIVINFO_POOL_SIZE
+#define CONFIG_EXEC_PRIVINFO_POOL_SIZE		48
+#endif
+#ifndef CONFIG_EXEC_PARAM_POOL_SIZE
+#define CONFIG_EXEC_PARAM_POOL_SIZE		(CONFIG_EXEC_MAX_SCHEDULED_WORK + 1)
+#endif
+#if CONFIG_EXEC_PARAM_POOL_SIZE < (CONFIG_EXEC_MAX_SCHEDULED_WORK + 1)
+#error "CONFIG_EXEC_PARAM_POOL_SIZE must be at least CONFIG_EXEC_MAX_SCHEDULED_WORK + 1"
+#endif
+#if (CONFIG_EXEC_PRIVINFO_POOL_SIZE < 1) || (CONFIG_EXEC_PRIVINFO_POOL_SIZE > 1024)
+#error "CONFIG_EXEC_PRIVINFO_POOL_SIZE must be 1 to 1024"
+#endif
+
+// A DSP response taking longer means the DSP image does not run the
+// executor (or hangs), no DSP work is submitted after that
+#ifndef CONFIG_EXEC_DSP_RESP_TIMEOUT_MS
+#define CONFIG_EXEC_DSP_RESP_TIMEOUT_MS		1000
+#endif
+
 #define CONFIG_EXEC_M3_TASK_STACK_SIZE          (1024)
 #define CONFIG_EXEC_DSP_TASK_STACK_SIZE        (256 /2 )
-#define CONFIG_EXEC_M3_QUEUE_NUM_ELEMENTS   4
-#define CONFIG_EXEC_DSP_QUEUE_NUM_ELEMENTS 4
-//#define  CONFIG_TASK_NOTIFY   1
-#define CONFIG_BIN_SEM              1
+// Ready works are queued from completion, the queues hold every slot
+#define CONFIG_EXEC_M3_QUEUE_NUM_ELEMENTS   CONFIG_EXEC_MAX_SCHEDULED_WORK
+#define CONFIG_EXEC_DSP_QUEUE_NUM_ELEMENTS CONFIG_EXEC_MAX_SCHEDULED_WORK
 #endif /*_EXECUTOR_CFG_H_*/
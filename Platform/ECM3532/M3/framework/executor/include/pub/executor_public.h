@@ -25,9 +25,41 @@
 #define NO_INPUT_ALLOC
 #define NO_OUTPUT_ALLOC
 #define WAIT_4_COMPLETION()                                 ExecWaitForCompletion()
+#define WAIT_4_BUF(X)                                       ExecWaitForBuf(&X)
 
 ExecStatus ExecInit (void);
 
+// Occupancy of the executor object pools
+typedef struct
+{
+    uint16_t size;          // blocks in the pool
+    uint16_t used;          // blocks in use now
+    uint16_t peak;          // most blocks ever in use
+    uint16_t heapFallbacks; // allocations served by the heap, pool empty
+} ExecPoolStats_t;
+
+void ExecGetPoolStats (ExecPoolStats_t * privInfoStats, ExecPoolStats_t * paramStats);
+
+// Static memory plan: operands with non overlapping lifetimes share one
+// arena. Fill opd, record every op using an operand with ExecPlanUse (op
+// index in submission order), then ExecPlanMemory gives the offsets and the
+// arena size (bufs gets sorted by size) and ExecBindPlan maps every operand
+// into the arena once, instead of allocating them per inference
+#define EXEC_PLAN_UNUSED                                    0xFFFF
+#define EXEC_PLAN_BUF(X)                                    { .opd = &(X), .firstUse = EXEC_PLAN_UNUSED, .lastUse = EXEC_PLAN_UNUSED, .offset = 0 }
+
+typedef struct
+{
+    ExecOperand_t * opd;
+    uint16_t firstUse;      // first op index using the operand
+    uint16_t lastUse;       // last op index using the operand
+    uint32_t offset;        // byte offset in the arena, set by ExecPlanMemory
+} ExecPlanBuf_t;
+
+void ExecPlanUse (ExecPlanBuf_t * bufs, uint16_t numBufs, ExecOperand_t * opd, uint16_t opIndex);
+ExecStatus ExecPlanMemory (ExecPlanBuf_t * bufs, uint16_t numBufs, uint32_t * arenaSize);
+ExecStatus ExecBindPlan (ExecPlanBuf_t * bufs, uint16_t numBufs, void * arena);
+
 
 // Kernel functions on M3 : Limited now  only for CIfar 10
 ExecStatus Exec_conv2d_q7 ( uint8_t execHwId, ExecOperand_t * inArray, ExecOperand_t * wt, ExecOperand_t * bias, ExecOperand_t * outArray, ExecOperand_t * buffIn, const conv2d_opt *opt);
@@ -56,7 +56,10 @@ struct   privateInfo * privInfo;
 
 // DIrect Memory Functions
 ExecStatus ExecAllocMem(ExecOperand_t  *p, void * baseAddr, uint32_t offset );
+ExecStatus ExecReMapMem (ExecOperand_t  *p, void * baseAddr, uint32_t offset);
 void ExecFreeMem (ExecOperand_t  *p);
 void * ExecGetBufAddr (ExecOperand_t  *p);
 void  ExecWaitForCompletion ( void );
+void  ExecWaitForBuf (ExecOperand_t  *p);
+int  ExecDspResponding (void);
 #endif /* _EXECUTOR_TYPES_H_*/
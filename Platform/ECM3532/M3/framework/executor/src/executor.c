@@ -15,7 +15,6 @@
 
 #define GET_HIGH_16(X) ((((uint32_t)(X)) & 0xFFFF0000) >> 16)
 #define GET_LOW_16(X)  (((uint32_t)(X))& 0x0000FFFF)
-#define CONFIG_TASK_NOTIFY
 #define DIV_ROUND_UP(n,d) (((n) + (d) - 1) / (d))
 #define DIV_ROUND_DOWN (n,d) ((n)/ (d))
 
@@ -29,19 +28,86 @@
 #define PTR_DUMP8(X,N)   {  dumpArray8( NAME(X) , (X),N);}
 #define PTR_DUMP16(X,N)   {  dumpArray16( NAME(X) , (X),N);}
 #endif
-#ifdef CONFIG_TASK_NOTIFY
-static TaskHandle_t xTaskToNotify = NULL;
-#endif
 ExecWork_t schedList[CONFIG_EXEC_MAX_SCHEDULED_WORK] ={0};
 SemaphoreHandle_t schedListMutex = NULL;
+// Free schedList slots, counted so submitters block when the window is full
+static SemaphoreHandle_t schedSlotSem = NULL;
+static ExecWorkMask_t schedFreeMask = 0;
+static uint8_t schedInFlight = 0;
+// ExecWaitForCompletion() callers block on this until nothing is in flight.
+// Counting, given once per registered waiter so none misses its wakeup
+static SemaphoreHandle_t schedIdleSem = NULL;
+static uint8_t schedIdleWaiters = 0;
+// ExecWaitForBuf() callers block on this until a work completes
+static SemaphoreHandle_t schedBufSem = NULL;
+static uint8_t schedBufWaiters = 0;
 SemaphoreHandle_t execDspRespSem =NULL;
+// Header of the DSP responses, for the latency stats
+static uint8_t execDspRespHeader = 0;
 QueueHandle_t executor_m3Q = NULL;
 QueueHandle_t executor_dspQ = NULL;
 
+// Set for good when the DSP missed a response
+static volatile bool execDspDown = false;
+
+// Block until the DSP responds, the response callback runs from the IPC ISR.
+// Gives up after CONFIG_EXEC_DSP_RESP_TIMEOUT_MS and the DSP is not waited
+// for again, the caller fails its work
+static inline ExecStatus ExecWaitDspResp (void)
+{
+    if (execDspDown)
+        return EXEC_STATUS_ERR_GEN;
+    if (xSemaphoreTake(execDspRespSem, pdMS_TO_TICKS(CONFIG_EXEC_DSP_RESP_TIMEOUT_MS)) != pdTRUE)
+    {
+        ecm35xx_printf("DSP response timeout\r\n");
+        execDspDown = true;
+        return EXEC_STATUS_ERR_GEN;
+    }
+    RPC_LATENCY_WAKE(execDspRespHeader);
+    return EXEC_STATUS_OK;
+}
+
+// Hand a work to the DSP. Nothing is submitted once the DSP is down, and a
+// work queue the DSP does not drain takes it down as well
+static ExecStatus ExecDspSubmit (uint8_t opId, tExecutorRpcWork * rWork)
+{
+    if (execDspDown)
+        return EXEC_STATUS_ERR_GEN;
+    if (rpcSubmitWork(RPC_MODULE_ID_EXECUTOR, opId, (void*)rWork))
+    {
+        ecm35xx_printf("DSP work queue stuck\r\n");
+        execDspDown = true;
+        return EXEC_STATUS_ERR_GEN;
+    }
+    return EXEC_STATUS_OK;
+}
+
+// Submit and wait, for the works that have nothing to do on the M3 meanwhile
+static inline ExecStatus ExecDspRun (uint8_t opId, tExecutorRpcWork * rWork)
+{
+    ExecStatus status = ExecDspSubmit(opId, rWork);
+    if (status == EXEC_STATUS_OK)
+        status = ExecWaitDspResp();
+    return status;
+}
+
+// Free memory handed to the DSP, from the shared allocator or the heap.
+// A DSP that missed a response may still read or write it, so it is leaked
+// then rather than handed out again. Nothing is submitted after that
+static void ExecDspFree (void * mem, bool shared)
+{
+    if (!mem || execDspDown)
+        return;
+    if (shared)
+        SharedMemFree(mem);
+    else
+        vPortFree(mem);
+}
+
 
 static void ExecCompleteWork (uint8_t execWorkID);
-static void HandleInputBufPostCompletion (ExecOperand_t * inbuf) ;
-static void HandleOutputBufPostCompletion (ExecOperand_t * outBuf) ;
+static void HandleBufPostCompletion (ExecOperand_t * buf, uint8_t execWorkID) ;
+static void QueueWork (uint8_t execWorkID);
 static void ExecFree(void * bufAddr,uint8_t memType);
 static  void *  ExecAlloc (uint32_t size, uint8_t memType);
 static void    DestroyBuf (ExecOperand_t * buf) ;
@@ -106,236 +172,332 @@ for ( index = 0 ; index < size; index ++){
 
 }
 #endif
+// True if buffer number index (inputs first, then the output) of a work
+// is used elsewhere in the same work, so each buffer is tracked once
+static inline bool IsRepeatedBuf (ExecWork_t * work, uint8_t index)
+{
+    ExecOperand_t * buf;
+    uint8_t prev;
+
+    // the output always counts, inputs that are also the output do not
+    if (index >= work->numInputs)
+        return false;
+    buf = (work->inbufs)[index];
+    if (buf == work->outBuf)
+        return true;
+    for (prev = 0; prev < index; prev++)
+    {
+        if ((work->inbufs)[prev] == buf)
+            return true;
+    }
+    return false;
+}
+
+// Put a work whose dependencies are all done on its hardware queue.
+// Queues are as deep as schedList, so this never blocks
+static void QueueWork (uint8_t execWorkID)
+{
+    if (schedList[execWorkID].execHwId == EXEC_HW_ID_DSP)
+        xQueueSendToBack(executor_dspQ, (void *) &execWorkID, 0);
+    else
+        xQueueSendToBack(executor_m3Q, (void *) &execWorkID, 0);
+}
+
 static void __attribute__((optimize("O3")))
 ExecCompleteWork (uint8_t execWorkID)
 {
 	uint8_t index = 0;
 	ExecWork_t * work =  & (schedList[execWorkID]);
-	uint8_t memType = OPD_MEM_TYPE_M3_LOCAL;
+	ExecWorkMask_t waiters;
+	uint8_t idleWakes = 0;
+	uint8_t bufWakes;
 	xSemaphoreTake (schedListMutex, portMAX_DELAY);
-     //ecm35xx_printf("wait4Completion   = %d...\r\n",work->wait4Completion);
 	// Deal with input and output buffers memory
-      //ecm35xx_printf("work id for completing %d ...\r\n",execWorkID);
+	for (index = 0; index <= (work->numInputs); index++)
+	{
+		if (!IsRepeatedBuf (work, index))
+		{
+			HandleBufPostCompletion ((index < work->numInputs) ? (work->inbufs)[index] : work->outBuf, execWorkID);
+		}
+	}
 	for (index = 0; index < (work->numInputs); index++)
 	{
-		HandleInputBufPostCompletion ((work->inbufs)[index]);
-           //ecm35xx_printf(" here 1   ...\r\n");
 		(work->inbufs)[index] = 0;
 	}
-	HandleOutputBufPostCompletion (work->outBuf);
-      // ecm35xx_printf(" here 2   ...\r\n");
-	//work->outBuf = 0;
 	// Deal with param memory  if any
 	if (work->params)
 	{
-        /*
-		if (work->execHwId == EXEC_HW_ID_DSP)
-			memType = OPD_MEM_TYPE_SHARED; */
-		ExecFree (work->params, memType);
+		ExecFreeParams (work->params);
 	}
-    // ecm35xx_printf(" here 3   ...\r\n");
+	// Release the works waiting on this one, the ones already submitted
+	// and without other pending dependencies go to their hardware queue
+	waiters = work->waiters;
+	while (waiters)
+	{
+		index = __builtin_ctz (waiters);
+		waiters &= waiters - 1;
+		schedList[index].pendingDeps--;
+		if ((schedList[index].pendingDeps == 0) && (schedList[index].submitted))
+		{
+			QueueWork (index);
+		}
+	}
+	work->waiters = 0;
 	work->valid = WORK_ID_INVALID;
 	work->numInputs = 0;
-	// if someone is waiting then reset  the  flag and give semaphore
-	if (work->wait4Completion == true)
+	schedFreeMask |= EXEC_WORK_BIT (execWorkID);
+	schedInFlight--;
+	if (schedInFlight == 0)
 	{
-		  //ecm35xx_printf("giving semaphore for index = %d ...\r\n",execWorkID);
-#ifdef CONFIG_BIN_SEM
-        xSemaphoreGive (work->waitSem);
-#endif
- #ifdef CONFIG_TASK_NOTIFY
- xTaskNotifyGive( xTaskToNotify );
-#endif
-        work->wait4Completion = false;
+		idleWakes = schedIdleWaiters;
+		schedIdleWaiters = 0;
 	}
-    //ecm35xx_printf("done with completion  ...\r\n");
+	bufWakes = schedBufWaiters;
+	schedBufWaiters = 0;
 	xSemaphoreGive (schedListMutex);
+	xSemaphoreGive (schedSlotSem);
+	while (idleWakes--)
+	{
+		xSemaphoreGive (schedIdleSem);
+	}
+	while (bufWakes--)
+	{
+		xSemaphoreGive (schedBufSem);
+	}
 }
 void  ExecWaitForCompletion ( void )
 {
-    uint8_t index = 0;
+    bool wait = false;
     // wait for all currently scheduled operation to get over
     xSemaphoreTake (schedListMutex, portMAX_DELAY);
-    for (index = 0; index < CONFIG_EXEC_MAX_SCHEDULED_WORK; index++)
+    if (schedInFlight)
     {
-        if ((schedList[index]).valid == WORK_ID_VALID)
-        {
-            schedList[index].wait4Completion = true;
-            xSemaphoreGive (schedListMutex);
- #ifdef CONFIG_BIN_SEM
-               xSemaphoreTake (schedList[index].waitSem, portMAX_DELAY);
-
-#endif
- #ifdef CONFIG_TASK_NOTIFY
-                    ulTaskNotifyTake( pdTRUE, portMAX_DELAY );
-#endif
-                    //ecm35xx_printf("worke up... \r\n");
-					xSemaphoreTake (schedListMutex, portMAX_DELAY);
-        }
+        schedIdleWaiters++;
+        wait = true;
     }
     xSemaphoreGive (schedListMutex);
+    if (wait)
+    {
+        xSemaphoreTake (schedIdleSem, portMAX_DELAY);
+    }
 }
 
-__attribute__((optimize("O3")))  uint8_t
-CheckAndScheduleWork (ExecWork_t * work, uint8_t inoutExist)
+// 0 once the DSP missed a response, outputs of DSP works are not valid then
+int  ExecDspResponding (void)
 {
-	uint8_t index1 = 0;
-	uint8_t index2 = 0;
-	uint8_t freeIndex = 0;
-	ExecWork_t tempWork;
-    struct privateInfo *privinfo;
- #ifdef CONFIG_TASK_NOTIFY
-    if (!xTaskToNotify)
-    xTaskToNotify = xTaskGetCurrentTaskHandle();
-#endif
-	// take mutex
-	xSemaphoreTake (schedListMutex, portMAX_DELAY);
-	// For each input of current work
-	// check them with each scheduled work's output
-	//TBD: optimisation
-	for (index1 = 0; index1 < (work->numInputs); index1++)
+    return !execDspDown;
+}
+
+// Wait for the work writing a buffer, if any, to complete. Works writing
+// other buffers stay in flight. Woken on every completion, so recheck
+void  ExecWaitForBuf (ExecOperand_t  *p)
+{
+    struct privateInfo *privinfo = p->privInfo;
+    bool wait;
+    do
+    {
+        xSemaphoreTake (schedListMutex, portMAX_DELAY);
+        wait = (privinfo->lastWriter != EXEC_NO_WORK);
+        if (wait)
+        {
+            schedBufWaiters++;
+        }
+        xSemaphoreGive (schedListMutex);
+        if (wait)
+        {
+            xSemaphoreTake (schedBufSem, portMAX_DELAY);
+        }
+    } while (wait);
+}
+
+static inline bool BufsOverlap (ExecOperand_t * a, ExecOperand_t * b)
+{
+	int8_t * aStart = (int8_t *) a->privInfo->bufAddr;
+	int8_t * bStart = (int8_t *) b->privInfo->bufAddr;
+	uint32_t aBytes = (a->numElements) * ((a->basetypeSize) + 1);
+	uint32_t bBytes = (b->numElements) * ((b->basetypeSize) + 1);
+	return (aStart < (bStart + bBytes)) && (bStart < (aStart + aBytes));
+}
+
+// Planned operands with disjoint lifetimes share arena bytes but not their
+// privateInfo, so the per buffer tracking does not order the works using
+// them. Depend on every other work in flight using an overlapping planned
+// operand, unless both works only read it.
+// To be called holding the schedListMutex
+static ExecWorkMask_t AliasDeps (ExecWork_t * work, uint8_t execWorkID)
+{
+	ExecWorkMask_t deps = 0;
+	ExecOperand_t * buf;
+	ExecOperand_t * other;
+	uint8_t index;
+	uint8_t slot;
+	uint8_t otherIndex;
+
+	for (index = 0; index <= (work->numInputs); index++)
 	{
-		for (index2 = 0; index2 < CONFIG_EXEC_MAX_SCHEDULED_WORK; index2++)
+		if (IsRepeatedBuf (work, index))
+			continue;
+		buf = (index < work->numInputs) ? (work->inbufs)[index] : work->outBuf;
+		if (!buf->privInfo->aliased)
+			continue;
+		for (slot = 0; slot < CONFIG_EXEC_MAX_SCHEDULED_WORK; slot++)
 		{
-			tempWork = schedList[index2];
-			if (tempWork.valid == WORK_ID_INVALID)
-			{
-				freeIndex = index2;
-			}
-			else
+			if ((slot == execWorkID) || (schedList[slot].valid != WORK_ID_VALID) ||
+					(deps & EXEC_WORK_BIT (slot)))
+				continue;
+			for (otherIndex = 0; otherIndex <= schedList[slot].numInputs; otherIndex++)
 			{
-				if ((work->inbufs)[index1] == tempWork.outBuf)
+				other = (otherIndex < schedList[slot].numInputs) ? (schedList[slot].inbufs)[otherIndex] : schedList[slot].outBuf;
+				// the same operand is tracked through its privateInfo
+				if ((other->privInfo == buf->privInfo) || !other->privInfo->aliased)
+					continue;
+				if ((buf != work->outBuf) && (other != schedList[slot].outBuf))
+					continue;
+				if (BufsOverlap (buf, other))
 				{
-					// Dependency found
-					schedList[index2].wait4Completion = true;
-                   // ecm35xx_printf("stalling... \r\n");
-                      //ecm35xx_printf("waiting  semaphore for index = %d ...\r\n",index2);
-                        //   ecm35xx_printf("wait4Completion = %d ...\r\n",schedList[index2].wait4Completion);
-					// Go for Stall and release the mutex
-					xSemaphoreGive (schedListMutex);
- #ifdef CONFIG_BIN_SEM
-                    xSemaphoreTake (tempWork.waitSem, portMAX_DELAY);
-
-#endif
- #ifdef CONFIG_TASK_NOTIFY
-                    ulTaskNotifyTake( pdTRUE, portMAX_DELAY );
-#endif
-                   // ecm35xx_printf("worke up... \r\n");
-					xSemaphoreTake (schedListMutex, portMAX_DELAY);
-                     //ecm35xx_printf("wlocked again the mutex.. \r\n");
+					deps |= EXEC_WORK_BIT (slot);
+					break;
 				}
 			}
 		}
 	}
-     //ecm35xx_printf("freeIndex %d ...\r\n",freeIndex);
-	// Now we kow the freeindex where we should insert
-	schedList[freeIndex].execHwId = work->execHwId;
-	schedList[freeIndex].params = work->params;
-	schedList[freeIndex].outBuf = work->outBuf;
-   schedList[freeIndex]. opID= work->opID;
-   schedList[freeIndex]. variant= work->variant;
-     privinfo =  (schedList[freeIndex].outBuf )->privInfo;
-     privinfo->bufState = BUF_STATE_MEM_ACTIVE;
-     privinfo->bufType = BUF_TYPE_OUT;
-     if (inoutExist == true)
-      privinfo->bufType = BUF_TYPE_INOUT;
-  privinfo->usageCount = privinfo->usageCount +1;
-	schedList[freeIndex].numInputs = work->numInputs;
+	return deps;
+}
+
+// Add a work to the dependency graph. Every buffer records its last
+// in-flight writer and its in-flight readers. A work depends on the last
+// writer of each input (RAW), and on the last writer and the readers of its
+// output (WAW, WAR). Planned operands sharing bytes are ordered the same
+// way, see AliasDeps. The submitter only blocks when schedList is full, the
+// work is queued to its hardware once all the works it depends on completed
+__attribute__((optimize("O3")))  uint8_t
+CheckAndScheduleWork (ExecWork_t * work, uint8_t inoutExist)
+{
+	uint8_t index1 = 0;
+	uint8_t freeIndex = 0;
+	ExecWorkMask_t deps = 0;
+	ExecWork_t * slot;
+    struct privateInfo *privinfo;
+	// wait for a free slot, then take mutex
+	xSemaphoreTake (schedSlotSem, portMAX_DELAY);
+	xSemaphoreTake (schedListMutex, portMAX_DELAY);
+	freeIndex = __builtin_ctz (schedFreeMask);
+	schedFreeMask &= ~EXEC_WORK_BIT (freeIndex);
+	slot = &(schedList[freeIndex]);
+
+	slot->execHwId = work->execHwId;
+	slot->params = work->params;
+	slot->outBuf = work->outBuf;
+	slot->opID = work->opID;
+	slot->variant = work->variant;
+	slot->numInputs = work->numInputs;
 	for (index1 = 0; index1 < (work->numInputs); index1++)
-    {
-    	(schedList[freeIndex]).inbufs[index1] = (work->inbufs)[index1];
-       privinfo =  (schedList[freeIndex]).inbufs[index1] ->privInfo;
-       privinfo->usageCount = privinfo->usageCount +1;
-       privinfo->bufState = BUF_STATE_MEM_ACTIVE;
-       privinfo->bufType = BUF_TYPE_IN;
-       if  (inoutExist == true)
-       {
-           if ((work->inbufs)[index1] == work->outBuf)
-             privinfo->bufType = BUF_TYPE_INOUT;
-       }
-    }
+	{
+		(slot->inbufs)[index1] = (work->inbufs)[index1];
+	}
+
+	deps = AliasDeps (slot, freeIndex);
 
-    schedList[freeIndex].wait4Completion = false;
-	schedList[freeIndex].valid = WORK_ID_VALID;
+	// Inputs, read after write on the last writer
+	for (index1 = 0; index1 < (work->numInputs); index1++)
+	{
+		if (IsRepeatedBuf (slot, index1))
+			continue;
+		privinfo = (slot->inbufs)[index1]->privInfo;
+		if (privinfo->lastWriter != EXEC_NO_WORK)
+			deps |= EXEC_WORK_BIT (privinfo->lastWriter);
+		privinfo->readers |= EXEC_WORK_BIT (freeIndex);
+		privinfo->usageCount = privinfo->usageCount + 1;
+		privinfo->bufState = BUF_STATE_MEM_ACTIVE;
+		privinfo->bufType = BUF_TYPE_IN;
+	}
 
+	// Output, write after write and write after read
+	privinfo = (slot->outBuf)->privInfo;
+	if (privinfo->lastWriter != EXEC_NO_WORK)
+		deps |= EXEC_WORK_BIT (privinfo->lastWriter);
+	deps |= privinfo->readers;
+	privinfo->lastWriter = freeIndex;
+	privinfo->readers = 0;
+	privinfo->usageCount = privinfo->usageCount + 1;
+	privinfo->bufState = BUF_STATE_MEM_ACTIVE;
+	privinfo->bufType = BUF_TYPE_OUT;
+	if (inoutExist == true)
+		privinfo->bufType = BUF_TYPE_INOUT;
+
+	slot->pendingDeps = 0;
+	slot->waiters = 0;
+	slot->submitted = false;
+	while (deps)
+	{
+		index1 = __builtin_ctz (deps);
+		deps &= deps - 1;
+		schedList[index1].waiters |= EXEC_WORK_BIT (freeIndex);
+		slot->pendingDeps++;
+	}
+	slot->valid = WORK_ID_VALID;
+	schedInFlight++;
 
 	xSemaphoreGive (schedListMutex);
-    //ecm35xx_printf("finishing CheckAndScheduleWork.\r\n",freeIndex);
     return freeIndex;
 }
+
+// Mark a work as submitted, it is queued right away if it has no pending
+// dependencies, otherwise by the completion of its last dependency
+static void SubmitWork (uint8_t execWorkID)
+{
+    bool ready;
+    xSemaphoreTake (schedListMutex, portMAX_DELAY);
+    schedList[execWorkID].submitted = true;
+    ready = (schedList[execWorkID].pendingDeps == 0);
+    if (ready)
+    {
+        QueueWork (execWorkID);
+    }
+    xSemaphoreGive (schedListMutex);
+}
+
  void
 SubmitM3Work (uint8_t execWorkID)
 {
-    xQueueSendToBack(executor_m3Q, (void *) &execWorkID, portMAX_DELAY);
+    SubmitWork (execWorkID);
 }
 
  void
 SubmitDSPWork (uint8_t execWorkID)
 {
-    xQueueSendToBack(executor_dspQ, (void *) &execWorkID, portMAX_DELAY);
+    SubmitWork (execWorkID);
 }
 
 
-//Deal with input  buffers post completion of an operation
+//Deal with a buffer used by a completed operation
 // To be called holding the schedListMutex
-
 static void
-HandleInputBufPostCompletion (ExecOperand_t * inbuf)
+HandleBufPostCompletion (ExecOperand_t * buf, uint8_t execWorkID)
 {
-	struct privateInfo *privinfo = inbuf->privInfo;
-	// only call with buffers with type IN
-    privinfo->usageCount = privinfo->usageCount - 1;
-	if (privinfo->bufType == BUF_TYPE_IN)
+	struct privateInfo *privinfo = buf->privInfo;
+	if (privinfo->lastWriter == execWorkID)
 	{
-		if (inbuf->memScope == OPD_MEM_SCOPE_GLOBAL)
-		{
-
-			if (!(privinfo->usageCount))
-			{
-				if (privinfo->tobeFreed)
-				{
-					DestroyBuf (inbuf);
-				}
-				else
-				{
-					privinfo->bufState = BUF_STATE_MEM_IDLE;
-					privinfo->bufType = BUF_TYPE_NONE;
-				}
-			}
-		}
-		else if (inbuf->memScope == OPD_MEM_SCOPE_OPERATION)
-		{
-
-			// When usage count reaches zero destroy  the buffer
-			if (!(privinfo->usageCount))
-			{
-				DestroyBuf (inbuf);
-			}
-		}
-		else
-		{
-			// TRACE: " Wrong mem scope for input buffer
-		}
+		privinfo->lastWriter = EXEC_NO_WORK;
 	}
-}
-//Deal with output   buffers post completion of an operation
-// To be called holding the schedListMutex
-static void
-HandleOutputBufPostCompletion (ExecOperand_t * outBuf)
-{
-	struct privateInfo *privinfo = outBuf->privInfo;
-	// only applicable for  buffers with type OUT and INOUT
-	if ((privinfo->bufType == BUF_TYPE_OUT)
-			|| (privinfo->bufType == BUF_TYPE_INOUT))
+	privinfo->readers &= ~EXEC_WORK_BIT (execWorkID);
+	privinfo->usageCount = privinfo->usageCount - 1;
+	if (privinfo->usageCount)
+	{
+		// still used by other works in flight
+		return;
+	}
+	// we never destroy an output buffer unless already asked, per operation
+	// input buffers go when their last user is done
+	if ((privinfo->tobeFreed) ||
+			((buf->memScope == OPD_MEM_SCOPE_OPERATION) && (buf != schedList[execWorkID].outBuf)))
+	{
+		DestroyBuf (buf);
+	}
+	else
 	{
-		privinfo->usageCount = privinfo->usageCount - 1;
 		privinfo->bufState = BUF_STATE_MEM_IDLE;
 		privinfo->bufType = BUF_TYPE_NONE;
-		// we never destroy the output buffer unless already asked
-		if ((!(privinfo->usageCount)) && (privinfo->tobeFreed))
-		{
-			DestroyBuf (outBuf);
-		}
 	}
 }
 
@@ -346,7 +508,7 @@ __attribute__((optimize("O3")))  void ExecFreeMem (ExecOperand_t  *p)
     {
         // Error trace
         struct privateInfo *privinfo = p->privInfo;
-        vPortFree (privinfo);
+        ExecFreePrivInfo (privinfo);
         return;
     }
     else
@@ -378,11 +540,12 @@ ExecStatus  __attribute__((optimize("O3"))) ExecAllocMem(ExecOperand_t  *p, void
     struct privateInfo *privinfo ;
     int8_t * base =( int8_t*) baseAddr; ;
     // first allocate the private structure
-    p->privInfo = ( struct privateInfo  * ) pvPortMalloc(sizeof (struct privateInfo ));
+    p->privInfo = ExecAllocPrivInfo();
     if (  p->privInfo)
     {
         privinfo =  p->privInfo;
         memset(privinfo, 0, sizeof(struct privateInfo));
+        privinfo->lastWriter = EXEC_NO_WORK;
     }
   else
    {
@@ -423,6 +586,7 @@ ExecStatus  __attribute__((optimize("O3"))) ExecReMapMem (ExecOperand_t  *p, voi
     {
         privinfo =  p->privInfo;
         memset(privinfo, 0, sizeof(struct privateInfo));
+        privinfo->lastWriter = EXEC_NO_WORK;
         privinfo->bufAddr =  (void *)  (base+ (((p->basetypeSize) +1) * offset));
         status = EXEC_STATUS_OK;
     }
@@ -465,7 +629,7 @@ DestroyBuf (ExecOperand_t * buf)
     privinfo->bufType = BUF_TYPE_NONE;
 	privinfo->tobeFreed = 0;
     privinfo->usageCount = 0;
-    vPortFree(privinfo);
+    ExecFreePrivInfo(privinfo);
 }
 
 
@@ -675,17 +839,71 @@ static void ExecM3Task(void *pvParameters)
     }
 }
 
+// Finish a DSP work. One the DSP failed runs on the M3 instead when the M3
+// has the same op, it takes the same buffers and params. Others complete
+// with whatever is in their output
+static void ExecDspCompleteWork (uint8_t execWorkID, ExecStatus status)
+{
+    ExecWork_t * work = &(schedList[execWorkID]);
+    uint8_t m3OpID = 0;
+
+    if (status != EXEC_STATUS_OK)
+    {
+        switch (work->opID)
+        {
+#ifdef CONFIG_OP_M3_CONV2D_Q7
+            case EXEC_OP_DSP_CHW_3X3_CONV2D_STRIDE2_PAD0_RELU:
+            case EXEC_OP_DSP_CHW_3X3_CONV2D_STRIDE1_PAD0_RELU:
+            case EXEC_OP_DSP_CHW_2X2_CONV2D_STRIDE2_PAD0_RELU:
+                m3OpID = EXEC_OP_M3_CONV2D_Q7;
+                break;
+#endif
+#ifdef CONFIG_OP_M3_DS_CONV2D_Q7
+            case EXEC_OP_DSP_DS_CHW_3X3_CONV2D_STRIDE2_PAD0_RELU:
+            case EXEC_OP_DSP_DS_CHW_3X3_CONV2D_STRIDE1_PAD0_RELU:
+            case EXEC_OP_DSP_DS_CHW_2X2_CONV2D_STRIDE2_PAD0_RELU:
+                m3OpID = EXEC_OP_M3_DS_CONV2D_Q7;
+                break;
+#endif
+#ifdef CONFIG_OP_M3_PW_CONV2D_Q7
+            case EXEC_OP_DSP_HWC_PW_CONV2D_Q7:
+                m3OpID = EXEC_OP_M3_PW_CONV2D_Q7;
+                break;
+#endif
+            default:
+                ecm35xx_printf("DSP work %d failed\r\n", work->opID);
+                break;
+        }
+    }
+    if (m3OpID)
+    {
+        // The M3 queue is as deep as schedList too
+        work->opID = m3OpID;
+        work->execHwId = EXEC_HW_ID_M3;
+        QueueWork(execWorkID);
+        return;
+    }
+    ExecCompleteWork(execWorkID);
+}
+
 static void ExecDspTask(void *pvParameters)
 {
      uint8_t workIndex = 0;
       ExecWork_t  * pWork;
       int8_t fast = 0;
+      ExecStatus status;
     while (1)
     {
         // receive from Queue
         xQueueReceive( executor_dspQ,  &( workIndex ),  portMAX_DELAY);
         // ecm35xx_printf("Got work   .. index = %d .\r\n",workIndex);
         pWork = &(schedList[workIndex]);
+        // Nothing more goes to a DSP that missed a response
+        if (execDspDown)
+        {
+            ExecDspCompleteWork(workIndex, EXEC_STATUS_ERR_GEN);
+            continue;
+        }
 
         switch ( pWork->opID)
         {
@@ -696,10 +914,10 @@ static void ExecDspTask(void *pvParameters)
                 exec_conv2d_relu_avgpool_q7_t *  params =  (exec_conv2d_relu_avgpool_q7_t *) ( pWork->params);
                 // ecm35xx_printf ( " pbuf_0_0 = %x, pbuf_1_0 = %x, pbuf_0_4 = %x\r\n", ExecGetBufAddr((pWork->inbufs)[0]),ExecGetBufAddr(pWork->outBuf),ExecGetBufAddr((pWork->inbufs)[1]));
                 // ecm35xx_printf ( " pbuf_0_1 = %x, pbuf_0_2 = %x\r\n", params->wt,params->bias);
-                eta_conv2d_q7_CHW_ker2x2_stride1_pad0_relu_avgPool_2x2_stride2_pad0(( const q7_t * )ExecGetBufAddr((pWork->inbufs)[0]),  ( const q7_t *) params->wt, (const q7_t *) params->bias, ( q7_t *) ExecGetBufAddr(pWork->outBuf),  ( q7_t * )ExecGetBufAddr((pWork->inbufs)[1]),  (const conv2d_relu_avgpool_opt) (params->opt));
+                status = eta_conv2d_q7_CHW_ker2x2_stride1_pad0_relu_avgPool_2x2_stride2_pad0(( const q7_t * )ExecGetBufAddr((pWork->inbufs)[0]),  ( const q7_t *) params->wt, (const q7_t *) params->bias, ( q7_t *) ExecGetBufAddr(pWork->outBuf),  ( q7_t * )ExecGetBufAddr((pWork->inbufs)[1]),  (const conv2d_relu_avgpool_opt) (params->opt));
                //  ecm35xx_printf("Done  work   ...\r\n");
                 // ecm35xx_printf("wait4Completion   = %d...\r\n",pWork->wait4Completion);
-                ExecCompleteWork(workIndex);
+                ExecDspCompleteWork(workIndex, status);
                //ecm35xx_printf("A\r\n");
             }
             break;
@@ -708,8 +926,8 @@ static void ExecDspTask(void *pvParameters)
             case EXEC_OP_DSP_CHW_3X3_CONV2D_RELU_AVGPOOL_Q7:
             {
                   exec_conv2d_relu_avgpool_q7_t *  params =  (exec_conv2d_relu_avgpool_q7_t *) ( pWork->params);
-                 eta_conv2d_q7_CHW_ker3x3_stride1_pad0_relu_avgPool_2x2_stride2_pad0(( const q7_t * )ExecGetBufAddr((pWork->inbufs)[0]),  ( const q7_t *) params->wt, (const q7_t *) params->bias, ( q7_t *) ExecGetBufAddr(pWork->outBuf),  ( q7_t * )ExecGetBufAddr((pWork->inbufs)[1]),  (const conv2d_relu_avgpool_opt) (params->opt));
-                 ExecCompleteWork(workIndex);
+                 status = eta_conv2d_q7_CHW_ker3x3_stride1_pad0_relu_avgPool_2x2_stride2_pad0(( const q7_t * )ExecGetBufAddr((pWork->inbufs)[0]),  ( const q7_t *) params->wt, (const q7_t *) params->bias, ( q7_t *) ExecGetBufAddr(pWork->outBuf),  ( q7_t * )ExecGetBufAddr((pWork->inbufs)[1]),  (const conv2d_relu_avgpool_opt) (params->opt));
+                 ExecDspCompleteWork(workIndex, status);
                 //ecm35xx_printf("A\r\n");
             }
 
@@ -728,10 +946,10 @@ static void ExecDspTask(void *pvParameters)
 
                 // ecm35xx_printf ( " pbuf_0_0 = %x, pbuf_1_0 = %x, pbuf_0_4 = %x\r\n", ExecGetBufAddr((pWork->inbufs)[0]),ExecGetBufAddr(pWork->outBuf),ExecGetBufAddr((pWork->inbufs)[1]));
                 // ecm35xx_printf ( " pbuf_0_1 = %x, pbuf_0_2 = %x\r\n", params->wt,params->bias);
-                eta_pw_conv2d_q7_hwc_dsp(( const q7_t * )ExecGetBufAddr((pWork->inbufs)[0]),  ( const q7_t *) params->wt, (const q7_t *) params->bias, ( q7_t *) ExecGetBufAddr(pWork->outBuf),  ( q7_t * )ExecGetBufAddr((pWork->inbufs)[1]),  ( conv2d_opt) (params->opt),fast);
+                status = eta_pw_conv2d_q7_hwc_dsp(( const q7_t * )ExecGetBufAddr((pWork->inbufs)[0]),  ( const q7_t *) params->wt, (const q7_t *) params->bias, ( q7_t *) ExecGetBufAddr(pWork->outBuf),  ( q7_t * )ExecGetBufAddr((pWork->inbufs)[1]),  ( conv2d_opt) (params->opt),fast);
                  //  ecm35xx_printf("Done  work   ...\r\n");
                 // ecm35xx_printf("wait4Completion   = %d...\r\n",pWork->wait4Completion);
-                ExecCompleteWork(workIndex);
+                ExecDspCompleteWork(workIndex, status);
             }
             break;
 #endif
@@ -748,8 +966,8 @@ static void ExecDspTask(void *pvParameters)
 
                 exec_conv2d_q7_t *  params =  (exec_conv2d_q7_t *) ( pWork->params);
 
-                eta_conv2d_q7_chw_relu_dsp(( const q7_t * )ExecGetBufAddr((pWork->inbufs)[0]),  ( const q7_t *) params->wt, (const q7_t *) params->bias, ( q7_t *) ExecGetBufAddr(pWork->outBuf),  ( q7_t * )ExecGetBufAddr((pWork->inbufs)[1]),  ( conv2d_opt) (params->opt), pWork->opID,variant);
-                ExecCompleteWork(workIndex);
+                status = eta_conv2d_q7_chw_relu_dsp(( const q7_t * )ExecGetBufAddr((pWork->inbufs)[0]),  ( const q7_t *) params->wt, (const q7_t *) params->bias, ( q7_t *) ExecGetBufAddr(pWork->outBuf),  ( q7_t * )ExecGetBufAddr((pWork->inbufs)[1]),  ( conv2d_opt) (params->opt), pWork->opID,variant);
+                ExecDspCompleteWork(workIndex, status);
             }
             break;
 #if defined(CONFIG_OP_DSP_DS_CHW_3X3_CONV2D_STRIDE1_PAD0_RELU_INPLACE) ||\
@@ -763,8 +981,8 @@ static void ExecDspTask(void *pvParameters)
 
                 exec_conv2d_q7_t *  params =  (exec_conv2d_q7_t *) ( pWork->params);
 
-                eta_conv2d_q7_chw_relu_dsp_inplace(( q7_t * )ExecGetBufAddr((pWork->inbufs)[0]),  ( const q7_t *) params->wt, (const q7_t *) params->bias, ( q7_t * )ExecGetBufAddr((pWork->inbufs)[1]),  ( conv2d_opt) (params->opt), pWork->opID,variant);
-                ExecCompleteWork(workIndex);
+                status = eta_conv2d_q7_chw_relu_dsp_inplace(( q7_t * )ExecGetBufAddr((pWork->inbufs)[0]),  ( const q7_t *) params->wt, (const q7_t *) params->bias, ( q7_t * )ExecGetBufAddr((pWork->inbufs)[1]),  ( conv2d_opt) (params->opt), pWork->opID,variant);
+                ExecDspCompleteWork(workIndex, status);
             }
             break;
 #endif
@@ -778,6 +996,7 @@ static void ExecDspTask(void *pvParameters)
                 rWork = SharedMemAlloc(sizeof(tExecutorRpcWork));
                 if (!rWork) {
                     ecm35xx_printf("Malloc Failed\r\n");
+                    ExecDspCompleteWork(workIndex, EXEC_STATUS_ERR_MEM);
                     break;
                 }
 
@@ -800,10 +1019,9 @@ static void ExecDspTask(void *pvParameters)
                 (rWork->outbuf).ahbAddrLo = GET_LOW_16(addrOut);
 
                 memcpy(&rWork->params, params, sizeof(tDsp_math_fft_opt));
-                rpcSubmitWork(RPC_MODULE_ID_EXECUTOR, pWork->opID, (void*)rWork);
-                xSemaphoreTake(execDspRespSem, portMAX_DELAY);
-                SharedMemFree(rWork);
-                ExecCompleteWork(workIndex);
+                status = ExecDspRun(pWork->opID, rWork);
+                ExecDspFree(rWork, true);
+                ExecDspCompleteWork(workIndex, status);
 
                 break;
             }
@@ -826,6 +1044,7 @@ static void ExecDspTask(void *pvParameters)
                 rWork = SharedMemAlloc(sizeof(tExecutorRpcWork));
                 if (!rWork) {
                     ecm35xx_printf("Malloc Failed\r\n");
+                    ExecDspCompleteWork(workIndex, EXEC_STATUS_ERR_MEM);
                     break;
                 }
 
@@ -848,10 +1067,9 @@ static void ExecDspTask(void *pvParameters)
                 (rWork->outbuf).ahbAddrLo = GET_LOW_16(addrOut);
 
                 memcpy(&rWork->params, params, sizeof(tDsp_math_func_opt));
-                rpcSubmitWork(RPC_MODULE_ID_EXECUTOR, pWork->opID, (void*)rWork);
-                xSemaphoreTake(execDspRespSem, portMAX_DELAY);
-                SharedMemFree(rWork);
-                ExecCompleteWork(workIndex);
+                status = ExecDspRun(pWork->opID, rWork);
+                ExecDspFree(rWork, true);
+                ExecDspCompleteWork(workIndex, status);
 
                 break;
             }
@@ -870,13 +1088,15 @@ __attribute__((section(".initSection"))) ExecStatus ExecInit (void)
 {
   uint8_t index = 0;
   ExecStatus status = EXEC_STATUS_OK;
+  ExecPoolsInit();
   schedListMutex = xSemaphoreCreateMutex();
-  #ifdef CONFIG_BIN_SEM
+  schedSlotSem = xSemaphoreCreateCounting(CONFIG_EXEC_MAX_SCHEDULED_WORK, CONFIG_EXEC_MAX_SCHEDULED_WORK);
+  schedIdleSem = xSemaphoreCreateCounting(UINT8_MAX, 0);
+  schedBufSem = xSemaphoreCreateCounting(UINT8_MAX, 0);
   for (index= 0; index < CONFIG_EXEC_MAX_SCHEDULED_WORK; index++)
   {
-       schedList[index].waitSem= xSemaphoreCreateBinary();
-   }
- #endif
+       schedFreeMask |= EXEC_WORK_BIT (index);
+  }
  execDspRpcInit();
   executor_m3Q = xQueueCreate(CONFIG_EXEC_M3_QUEUE_NUM_ELEMENTS, sizeof(uint8_t));
   executor_dspQ = xQueueCreate(CONFIG_EXEC_DSP_QUEUE_NUM_ELEMENTS, sizeof(uint8_t));
@@ -887,9 +1107,10 @@ __attribute__((section(".initSection"))) ExecStatus ExecInit (void)
 
 static int execDspNotifyResponse(uint32_t header, uint32_t data)
 {
-    // Give response semaphore
-    xSemaphoreGive(execDspRespSem);
-    return 0;
+    BaseType_t xTaskWoken = pdFALSE;
+    // Give response semaphore, called from the IPC ISR
+    xSemaphoreGiveFromISR(execDspRespSem, &xTaskWoken);
+    return (xTaskWoken == pdTRUE);
 }
 
 // Header
@@ -914,7 +1135,8 @@ static int execDspNotifyEvent(uint32_t header, uint32_t data)
     SET_MODULEID(eventHeaderMask, RPC_MODULE_ID_EXECUTOR);
     SET_EVT_RSP(eventHeaderMask, RPC_RESPONSE);
     // register with RPC notification  for all responses
-    rpcRegisterEventCb(eventHeaderMask, execDspNotifyResponse);
+    execDspRespHeader = eventHeaderMask;
+    rpcRegisterEventIsrCb(eventHeaderMask, execDspNotifyResponse);
     // register with RPC notification for events
     SET_EVT_RSP(eventHeaderMask, RPC_EVENT);
     rpcRegisterEventCb(eventHeaderMask, execDspNotifyEvent);
@@ -939,6 +1161,7 @@ static  ExecStatus eta_pw_conv2d_q7_hwc_dsp( const q7_t *  inArray,  const q7_t
   uint32_t inArraySize, weightArraySize, biasArraySize, outArraySize;
   int index = 0;
    uint8_t opId =0;
+  ExecStatus status;
    //uint64_t start_ms, stop_ms;
    //Make sure to change their types
    shMemBufPtr dspInArray = 0;
@@ -965,7 +1188,10 @@ static  ExecStatus eta_pw_conv2d_q7_hwc_dsp( const q7_t *  inArray,  const q7_t
         dspOutArray = (  shMemBufPtr) pvPortMalloc(outArraySize*  (sizeof (dspOutArray[0]))); // Packing Dma not working now. So keep space for 16 bit data
    //ecm35xx_printf(" weights  do not fit in memory\r\n");
    if ( ! dspOutArray)
+   {
       ecm35xx_printf("No memory for  dspOutArray...\r\n");
+      return EXEC_STATUS_ERR_MEM;
+   }
 
     }
    if ( ((weightArraySize + biasArraySize) < DSP_WEIGHT_BIAS_MEM_LIMIT) && ((inArraySize + outArraySize) >DSP_INOUT_MEM_LIMIT)) {
@@ -979,11 +1205,12 @@ static  ExecStatus eta_pw_conv2d_q7_hwc_dsp( const q7_t *  inArray,  const q7_t
             opId = EXEC_OP_DSP_HWC_PW_CONV2D_Q7_FAST;
     }
     execRpcWork = SharedMemAlloc(sizeof(tExecutorRpcWork));
-    memset((void *) execRpcWork,0, sizeof(tExecutorRpcWork));
     if (!execRpcWork) {
         //TBD: Add trace message of error
-        return -1;
+        if (dspOutArray) vPortFree(dspOutArray);
+        return EXEC_STATUS_ERR_MEM;
     }
+    memset((void *) execRpcWork,0, sizeof(tExecutorRpcWork));
      execRpcWork-> status = -1;
     (execRpcWork->inbuf).ahbAddrHi = GET_HIGH_16(inArray) ;
     (execRpcWork->inbuf).ahbAddrLo = GET_LOW_16(inArray) ;
@@ -1047,31 +1274,29 @@ static  ExecStatus eta_pw_conv2d_q7_hwc_dsp( const q7_t *  inArray,  const q7_t
        pwOpt. act_max   = opt. act_max;
     memcpy (&((execRpcWork->params).convPwParams),&pwOpt,sizeof(conv_pw_opt));
     }
-    rpcSubmitWork(RPC_MODULE_ID_EXECUTOR, opId, (void*)execRpcWork);
-
     // work for wait to get over from DSP
  //  ecm35xx_printf(" S \r\n");
-
-     xSemaphoreTake(execDspRespSem, portMAX_DELAY);
+    status = ExecDspRun(opId, execRpcWork);
      //ecm35xx_printf(" D \r\n");
      if ( opId == EXEC_OP_DSP_HWC_PW_CONV2D_Q7_WEIGHT_DONT_FIT)
      {
          //ecm35xx_printf(" C \r\n");
          // convert the output to HWC
             //CHWq15_to_HWCq7( dspOutArray, outArray, outHeight, outWidth, outChannel);
-            CHWq7_to_HWCq7_Ex(dspOutArray, outArray,
-                              outHeight, outWidth, outChannel,
-                              0, outChannel);
-            vPortFree(dspOutArray);
+         if (status == EXEC_STATUS_OK)
+             CHWq7_to_HWCq7_Ex(dspOutArray, outArray,
+                               outHeight, outWidth, outChannel,
+                               0, outChannel);
+         ExecDspFree(dspOutArray, false);
             //SharedMemFree(dspOutArray);
      }
-   SharedMemFree(execRpcWork);
+   ExecDspFree(execRpcWork, true);
      //ecm35xx_printf("DD\r\n");
 
     // PTR_DUMP16(dspOutArray,outArraySize);
 
     // Get back  to caller
-    return EXEC_STATUS_OK;
+    return status;
 
 }
 #endif
@@ -1101,6 +1326,7 @@ static ExecStatus  eta_conv2d_q7_chw_relu_dsp_inplace (q7_t * inArray,  const q7
   shMemBufPtr dspBias  = 0;
   shMemBufPtr  dspOutArray = 0;
   int8_t * bitset = 0;
+  ExecStatus status = EXEC_STATUS_OK;
   // find sizes of all of the arrays using the info present in opt
   kernelHeight = opt.filt_rows;
   kernelWidth = opt.filt_cols;
@@ -1194,9 +1420,10 @@ static ExecStatus  eta_conv2d_q7_chw_relu_dsp_inplace (q7_t * inArray,  const q7
 
     execRpcWork = SharedMemAlloc(sizeof(tExecutorRpcWork));
     //memset((void *) execRpcWork,0, sizeof(tExecutorRpcWork));
-    if (!execRpcWork) {
+    if (!execRpcWork || !dspInArray || !dspOutArray) {
       //TBD: Add trace message of error
-      return -1;
+      status = EXEC_STATUS_ERR_MEM;
+      goto exit;
     }
 
     // Fill in the shared data structure with DSP
@@ -1306,7 +1533,8 @@ static ExecStatus  eta_conv2d_q7_chw_relu_dsp_inplace (q7_t * inArray,  const q7
         inBuffPatch = (inBuffPatch + 1) % 2;
 
         // Send the patch to DSP to process
-        rpcSubmitWork(RPC_MODULE_ID_EXECUTOR, opID, (void*)execRpcWork);
+        if (ExecDspSubmit(opID, execRpcWork) != EXEC_STATUS_OK)
+          goto exit;
         dspBusy=1;
         //ecm35xx_printf("tmpDspOutArray: %x\r\n", (tmpDspOutArray-dspOutArray));
         tmpDspOutArray += outColsPerIter * outChannel;
@@ -1351,7 +1579,8 @@ static ExecStatus  eta_conv2d_q7_chw_relu_dsp_inplace (q7_t * inArray,  const q7
 
         if(dspBusy)
         {
-          xSemaphoreTake(execDspRespSem, portMAX_DELAY);
+          if (ExecWaitDspResp() != EXEC_STATUS_OK)
+            goto exit;
           dspBusy = 0;
         }
         // Send the patch to DSP to process
@@ -1359,7 +1588,8 @@ static ExecStatus  eta_conv2d_q7_chw_relu_dsp_inplace (q7_t * inArray,  const q7
         (execRpcWork->inbuf).ahbAddrLo = GET_LOW_16(&dspInArray[inBuffPatch*W*H*C]) ;
         (execRpcWork->outbuf).ahbAddrHi = GET_HIGH_16(tmpDspOutArray) ;
         (execRpcWork->outbuf).ahbAddrLo = GET_LOW_16(tmpDspOutArray) ;
-        rpcSubmitWork(RPC_MODULE_ID_EXECUTOR, opID, (void*)execRpcWork);
+        if (ExecDspSubmit(opID, execRpcWork) != EXEC_STATUS_OK)
+          goto exit;
         dspBusy=1;
         //ecm35xx_printf("tmpDspOutArray: %x\r\n", (tmpDspOutArray-dspOutArray));
         tmpDspOutArray += outColsPerIter * outChannel;
@@ -1398,7 +1628,8 @@ static ExecStatus  eta_conv2d_q7_chw_relu_dsp_inplace (q7_t * inArray,  const q7
 
         if(dspBusy)
         {
-          xSemaphoreTake(execDspRespSem, portMAX_DELAY);
+          if (ExecWaitDspResp() != EXEC_STATUS_OK)
+            goto exit;
           dspBusy = 0;
         }
         // Send the patch to DSP to process
@@ -1406,7 +1637,8 @@ static ExecStatus  eta_conv2d_q7_chw_relu_dsp_inplace (q7_t * inArray,  const q7
         (execRpcWork->inbuf).ahbAddrLo = GET_LOW_16(&dspInArray[inBuffPatch*W*H*C]) ;
         (execRpcWork->outbuf).ahbAddrHi = GET_HIGH_16(tmpDspOutArray) ;
         (execRpcWork->outbuf).ahbAddrLo = GET_LOW_16(tmpDspOutArray) ;
-        rpcSubmitWork(RPC_MODULE_ID_EXECUTOR, opID, (void*)execRpcWork);
+        if (ExecDspSubmit(opID, execRpcWork) != EXEC_STATUS_OK)
+          goto exit;
         dspBusy=1;
         //ecm35xx_printf("tmpDspOutArray: %x\r\n", (tmpDspOutArray-dspOutArray));
         tmpDspOutArray += outColsPerIter * outChannel;
@@ -1480,7 +1712,8 @@ static ExecStatus  eta_conv2d_q7_chw_relu_dsp_inplace (q7_t * inArray,  const q7
         //ecm35xx_printf("\r\n");
         if(dspBusy)
         {
-          xSemaphoreTake(execDspRespSem, portMAX_DELAY);
+          if (ExecWaitDspResp() != EXEC_STATUS_OK)
+            goto exit;
           dspBusy = 0;
         }
         // Send the patch to DSP to process
@@ -1489,7 +1722,8 @@ static ExecStatus  eta_conv2d_q7_chw_relu_dsp_inplace (q7_t * inArray,  const q7
         (execRpcWork->outbuf).ahbAddrHi = GET_HIGH_16(tmpDspOutArray) ;
         (execRpcWork->outbuf).ahbAddrLo = GET_LOW_16(tmpDspOutArray) ;
         //ecm35xx_printf("submitting center left\r\n");
-        rpcSubmitWork(RPC_MODULE_ID_EXECUTOR, opID, (void*)execRpcWork);
+        if (ExecDspSubmit(opID, execRpcWork) != EXEC_STATUS_OK)
+          goto exit;
         dspBusy=1;
         //xSemaphoreTake(execDspRespSem, portMAX_DELAY);
         //ecm35xx_printf("output patch:\r\n");
@@ -1531,7 +1765,8 @@ static ExecStatus  eta_conv2d_q7_chw_relu_dsp_inplace (q7_t * inArray,  const q7
 
         if(dspBusy)
         {
-          xSemaphoreTake(execDspRespSem, portMAX_DELAY);
+          if (ExecWaitDspResp() != EXEC_STATUS_OK)
+            goto exit;
           dspBusy = 0;
         }
         //ecm35xx_printf("output patch:\r\n");
@@ -1545,7 +1780,8 @@ static ExecStatus  eta_conv2d_q7_chw_relu_dsp_inplace (q7_t * inArray,  const q7
         (execRpcWork->outbuf).ahbAddrHi = GET_HIGH_16(tmpDspOutArray) ;
         (execRpcWork->outbuf).ahbAddrLo = GET_LOW_16(tmpDspOutArray) ;
         //ecm35xx_printf("submitting center center\r\n");
-        rpcSubmitWork(RPC_MODULE_ID_EXECUTOR, opID, (void*)execRpcWork);
+        if (ExecDspSubmit(opID, execRpcWork) != EXEC_STATUS_OK)
+          goto exit;
         dspBusy=1;
         tmpDspOutArray += outColsPerIter * outChannel;
         inBuffPatch = (inBuffPatch + 1) % 2;
@@ -1578,7 +1814,8 @@ static ExecStatus  eta_conv2d_q7_chw_relu_dsp_inplace (q7_t * inArray,  const q7
 
         if(dspBusy)
         {
-          xSemaphoreTake(execDspRespSem, portMAX_DELAY);
+          if (ExecWaitDspResp() != EXEC_STATUS_OK)
+            goto exit;
           dspBusy = 0;
         }
         // Send the patch to DSP to process
@@ -1586,7 +1823,8 @@ static ExecStatus  eta_conv2d_q7_chw_relu_dsp_inplace (q7_t * inArray,  const q7
         (execRpcWork->inbuf).ahbAddrLo = GET_LOW_16(&dspInArray[inBuffPatch*W*H*C]) ;
         (execRpcWork->outbuf).ahbAddrHi = GET_HIGH_16(tmpDspOutArray) ;
         (execRpcWork->outbuf).ahbAddrLo = GET_LOW_16(tmpDspOutArray) ;
-        rpcSubmitWork(RPC_MODULE_ID_EXECUTOR, opID, (void*)execRpcWork);
+        if (ExecDspSubmit(opID, execRpcWork) != EXEC_STATUS_OK)
+          goto exit;
         dspBusy=1;
         tmpDspOutArray += outColsPerIter * outChannel;
         inBuffPatch = (inBuffPatch + 1) % 2;
@@ -1675,14 +1913,16 @@ static ExecStatus  eta_conv2d_q7_chw_relu_dsp_inplace (q7_t * inArray,  const q7
 
         if(dspBusy)
         {
-          xSemaphoreTake(execDspRespSem, portMAX_DELAY);
+          if (ExecWaitDspResp() != EXEC_STATUS_OK)
+            goto exit;
           dspBusy = 0;
         }
         (execRpcWork->inbuf).ahbAddrHi = GET_HIGH_16(&dspInArray[inBuffPatch*W*H*C]) ;
         (execRpcWork->inbuf).ahbAddrLo = GET_LOW_16(&dspInArray[inBuffPatch*W*H*C]) ;
         (execRpcWork->outbuf).ahbAddrHi = GET_HIGH_16(tmpDspOutArray) ;
         (execRpcWork->outbuf).ahbAddrLo = GET_LOW_16(tmpDspOutArray) ;
-        rpcSubmitWork(RPC_MODULE_ID_EXECUTOR, opID, (void*)execRpcWork);
+        if (ExecDspSubmit(opID, execRpcWork) != EXEC_STATUS_OK)
+          goto exit;
         dspBusy = 1;
         //ecm35xx_printf("tmpDspOutArray: %x\r\n", (tmpDspOutArray-dspOutArray));
         tmpDspOutArray += outColsPerIter * outChannel;
@@ -1724,7 +1964,8 @@ static ExecStatus  eta_conv2d_q7_chw_relu_dsp_inplace (q7_t * inArray,  const q7
 
         if(dspBusy)
         {
-          xSemaphoreTake(execDspRespSem, portMAX_DELAY);
+          if (ExecWaitDspResp() != EXEC_STATUS_OK)
+            goto exit;
           dspBusy = 0;
         }
         // Send the patch to DSP to process
@@ -1732,7 +1973,8 @@ static ExecStatus  eta_conv2d_q7_chw_relu_dsp_inplace (q7_t * inArray,  const q7
         (execRpcWork->inbuf).ahbAddrLo = GET_LOW_16(&dspInArray[inBuffPatch*W*H*C]) ;
         (execRpcWork->outbuf).ahbAddrHi = GET_HIGH_16(tmpDspOutArray) ;
         (execRpcWork->outbuf).ahbAddrLo = GET_LOW_16(tmpDspOutArray) ;
-        rpcSubmitWork(RPC_MODULE_ID_EXECUTOR, opID, (void*)execRpcWork);
+        if (ExecDspSubmit(opID, execRpcWork) != EXEC_STATUS_OK)
+          goto exit;
         dspBusy = 1;
         tmpDspOutArray += outColsPerIter * outChannel;
         inBuffPatch = (inBuffPatch + 1) % 2;
@@ -1770,7 +2012,8 @@ static ExecStatus  eta_conv2d_q7_chw_relu_dsp_inplace (q7_t * inArray,  const q7
 
         if(dspBusy)
         {
-          xSemaphoreTake(execDspRespSem, portMAX_DELAY);
+          if (ExecWaitDspResp() != EXEC_STATUS_OK)
+            goto exit;
           dspBusy = 0;
         }
         // Send the patch to DSP to process
@@ -1778,7 +2021,8 @@ static ExecStatus  eta_conv2d_q7_chw_relu_dsp_inplace (q7_t * inArray,  const q7
         (execRpcWork->inbuf).ahbAddrLo = GET_LOW_16(&dspInArray[inBuffPatch*W*H*C]) ;
         (execRpcWork->outbuf).ahbAddrHi = GET_HIGH_16(tmpDspOutArray) ;
         (execRpcWork->outbuf).ahbAddrLo = GET_LOW_16(tmpDspOutArray) ;
-        rpcSubmitWork(RPC_MODULE_ID_EXECUTOR, opID, (void*)execRpcWork);
+        if (ExecDspSubmit(opID, execRpcWork) != EXEC_STATUS_OK)
+          goto exit;
         dspBusy = 1;
         //ecm35xx_printf("tmpDspOutArray: %x\r\n", (tmpDspOutArray-dspOutArray));
         tmpDspOutArray += outColsPerIter * outChannel;
@@ -1796,7 +2040,8 @@ static ExecStatus  eta_conv2d_q7_chw_relu_dsp_inplace (q7_t * inArray,  const q7
 
     if(dspBusy)
     {
-      xSemaphoreTake(execDspRespSem, portMAX_DELAY);
+      if (ExecWaitDspResp() != EXEC_STATUS_OK)
+        goto exit;
       dspBusy = 0;
     }
 
@@ -1817,18 +2062,22 @@ static ExecStatus  eta_conv2d_q7_chw_relu_dsp_inplace (q7_t * inArray,  const q7
   g_outHeight = outHeight;
   g_outWidth  = outWidth;
   g_outChannel = outChannel;
+exit:
+  // A submit or a wait that failed took the DSP down
+  if ((status == EXEC_STATUS_OK) && execDspDown)
+    status = EXEC_STATUS_ERR_GEN;
   // Free all shared memory pointers
   //ecm35xx_printf("free up memory\r\n");
   if ( bitset) vPortFree(bitset);
-  if ( dspInArray) vPortFree(dspInArray);
-  if ( dspInArray1) vPortFree(dspInArray1);
-  if ( dspWeight) vPortFree(dspWeight);
-  if ( dspBias) vPortFree(dspBias);
-  if ( dspOutArray) vPortFree(dspOutArray);
-  if (execRpcWork) SharedMemFree(execRpcWork);
+  ExecDspFree(dspInArray, false);
+  ExecDspFree(dspInArray1, false);
+  ExecDspFree(dspWeight, false);
+  ExecDspFree(dspBias, false);
+  ExecDspFree(dspOutArray, false);
+  ExecDspFree(execRpcWork, true);
   //ecm35xx_printf("get back to caller\r\n");
   // Get back  to caller
-  return EXEC_STATUS_OK;
+  return status;
 }
 
 static ExecStatus  eta_conv2d_q7_chw_relu_dsp (const q7_t * inArray,  const q7_t *  wt, const q7_t * bias,  q7_t *  outArray,  q7_t *  buffIn,  conv2d_opt opt, uint8_t opID, uint8_t variant)
@@ -1854,6 +2103,7 @@ static ExecStatus  eta_conv2d_q7_chw_relu_dsp (const q7_t * inArray,  const q7_t
   shMemBufPtr dspWeight = 0;
   shMemBufPtr dspBias  = 0;
   shMemBufPtr  dspOutArray = 0;
+  ExecStatus status = EXEC_STATUS_OK;
   // find sizes of all of the arrays using the info present in opt
   kernelHeight = opt.filt_rows;
   kernelWidth = opt.filt_cols;
@@ -1915,6 +2165,8 @@ static ExecStatus  eta_conv2d_q7_chw_relu_dsp (const q7_t * inArray,  const q7_t
     if ( ! dspWeight)
     {
       ecm35xx_printf("No memory for  dspWeight...\r\n");
+      status = EXEC_STATUS_ERR_MEM;
+      goto exit;
     }
 
     reorder_conv2d_kernel(( int8_t* ) wt, dspWeight,
@@ -1925,7 +2177,8 @@ static ExecStatus  eta_conv2d_q7_chw_relu_dsp (const q7_t * inArray,  const q7_t
     //memset((void *) execRpcWork,0, sizeof(tExecutorRpcWork));
     if (!execRpcWork) {
       //TBD: Add trace message of error
-      return -1;
+      status = EXEC_STATUS_ERR_MEM;
+      goto exit;
     }
 
     // Fill in the shared data structure with DSP
@@ -1978,9 +2231,11 @@ static ExecStatus  eta_conv2d_q7_chw_relu_dsp (const q7_t * inArray,  const q7_t
 
       // submit work
       //start_ms = HalTmrRead(0);
-      rpcSubmitWork(RPC_MODULE_ID_EXECUTOR, opId, (void*)execRpcWork);
+      if (ExecDspSubmit(opId, execRpcWork) != EXEC_STATUS_OK)
+        goto exit;
       // work for wait to get over from DSP
-      xSemaphoreTake(execDspRespSem, portMAX_DELAY);
+      if (ExecWaitDspResp() != EXEC_STATUS_OK)
+        goto exit;
       //stop_ms =  HalTmrRead(0);
       //ecm35xx_printf("kernel  time= %d ms\r\n", (uint32_t) (stop_ms - start_ms));
 
@@ -2020,8 +2275,10 @@ static ExecStatus  eta_conv2d_q7_chw_relu_dsp (const q7_t * inArray,  const q7_t
     memcpy (&((execRpcWork->params).conv2dParams),&temp_opt,sizeof(conv2d_opt));
 
     //FIXME uncomment following 2 line to process the last 2 rows
-    rpcSubmitWork(RPC_MODULE_ID_EXECUTOR, opId, (void*)execRpcWork);
-    xSemaphoreTake(execDspRespSem, portMAX_DELAY);
+    if (ExecDspSubmit(opId, execRpcWork) != EXEC_STATUS_OK)
+      goto exit;
+    if (ExecWaitDspResp() != EXEC_STATUS_OK)
+      goto exit;
     }
 
     //int bitset_size = opt.out_cols * opt.num_filt / 8;
@@ -2141,9 +2398,11 @@ static ExecStatus  eta_conv2d_q7_chw_relu_dsp (const q7_t * inArray,  const q7_t
 
     execRpcWork = SharedMemAlloc(sizeof(tExecutorRpcWork));
     //memset((void *) execRpcWork,0, sizeof(tExecutorRpcWork));
-    if (!execRpcWork) {
+    if (!execRpcWork || !dspInArray || !dspOutArray ||
+        (run_input_and_dsp_in_parallel && !dspInArray1)) {
       //TBD: Add trace message of error
-      return -1;
+      status = EXEC_STATUS_ERR_MEM;
+      goto exit;
     }
 
     // Fill in the shared data structure with DSP
@@ -2224,7 +2483,8 @@ static ExecStatus  eta_conv2d_q7_chw_relu_dsp (const q7_t * inArray,  const q7_t
       // submit work
 
       //start_ms = HalTmrRead(0);
-      rpcSubmitWork(RPC_MODULE_ID_EXECUTOR, opID, (void*)execRpcWork);
+      if (ExecDspSubmit(opID, execRpcWork) != EXEC_STATUS_OK)
+        goto exit;
       // work for wait to get over from DSP
       //ecm35xx_printf(" S \r\n");
 
@@ -2246,7 +2506,9 @@ static ExecStatus  eta_conv2d_q7_chw_relu_dsp (const q7_t * inArray,  const q7_t
         }
       }
 
-      xSemaphoreTake(execDspRespSem, portMAX_DELAY);
+      if (ExecWaitDspResp() != EXEC_STATUS_OK)
+
+        goto exit;
 
       //stop_ms =  HalTmrRead(0);
       //ecm35xx_printf("kernel  time= %d ms\r\n", (uint32_t) (stop_ms - start_ms));
@@ -2289,6 +2551,10 @@ static ExecStatus  eta_conv2d_q7_chw_relu_dsp (const q7_t * inArray,  const q7_t
     if ( ! dspOutArray)
       ecm35xx_printf("No memory for  dspOutArray...\r\n");
 
+    if (!dspInArray || !dspOutArray) {
+      status = EXEC_STATUS_ERR_MEM;
+      goto exit;
+    }
 
     //HWCq7_to_CHWq15((int8_t *) inArray, dspInArray, inHeight, inWidth, inChannel);
     HWCq7_to_CHWq7_with_pad_partial_channels((int8_t *) inArray, dspInArray,
@@ -2311,7 +2577,8 @@ static ExecStatus  eta_conv2d_q7_chw_relu_dsp (const q7_t * inArray,  const q7_t
     execRpcWork = SharedMemAlloc(sizeof(tExecutorRpcWork));
     if (!execRpcWork) {
       //TBD: Add trace message of error
-      return -1;
+      status = EXEC_STATUS_ERR_MEM;
+      goto exit;
     }
     // Fill in the shared data structure with DSP
     execRpcWork-> status = -1;
@@ -2357,11 +2624,15 @@ static ExecStatus  eta_conv2d_q7_chw_relu_dsp (const q7_t * inArray,  const q7_t
     //ecm35xx_printf("num_per_iter: %d\r\n", num_per_iter);
     memcpy (&((execRpcWork->params).conv2dParams),&temp_opt,sizeof(conv2d_opt));
 
-    rpcSubmitWork(RPC_MODULE_ID_EXECUTOR, opID, (void*)execRpcWork);
+    if (ExecDspSubmit(opID, execRpcWork) != EXEC_STATUS_OK)
+
+      goto exit;
     // work for wait to get over from DSP
     //ecm35xx_printf(" S \r\n");
 
-    xSemaphoreTake(execDspRespSem, portMAX_DELAY);
+    if (ExecWaitDspResp() != EXEC_STATUS_OK)
+
+      goto exit;
     /*}
     stop_ms =  HalTmrRead(0);
     ecm35xx_printf("input time= %d ms\r\n", (uint32_t) (stop_ms - start_ms));
@@ -2380,15 +2651,19 @@ static ExecStatus  eta_conv2d_q7_chw_relu_dsp (const q7_t * inArray,  const q7_t
   g_outHeight = outHeight;
   g_outWidth  = outWidth;
   g_outChannel = outChannel;
+exit:
+  // A submit or a wait that failed took the DSP down
+  if ((status == EXEC_STATUS_OK) && execDspDown)
+    status = EXEC_STATUS_ERR_GEN;
   // Free all shared memory pointers
-  if ( dspInArray) vPortFree(dspInArray);
-  if ( dspInArray1) vPortFree(dspInArray1);
-  if ( dspWeight) vPortFree(dspWeight);
-  if ( dspBias) vPortFree(dspBias);
-  if ( dspOutArray)vPortFree(dspOutArray);
-  if (execRpcWork)SharedMemFree(execRpcWork);
+  ExecDspFree(dspInArray, false);
+  ExecDspFree(dspInArray1, false);
+  ExecDspFree(dspWeight, false);
+  ExecDspFree(dspBias, false);
+  ExecDspFree(dspOutArray, false);
+  ExecDspFree(execRpcWork, true);
   // Get back  to caller
-  return EXEC_STATUS_OK;
+  return status;
 }
 #ifdef CONFIG_OP_DSP_CHW_2X2_CONV2D_RELU_AVGPOOL_Q7
 static ExecStatus eta_conv2d_q7_CHW_ker2x2_stride1_pad0_relu_avgPool_2x2_stride2_pad0(const q7_t * inArray,  const q7_t *  wt, const q7_t * bias,  q7_t *  outArray,  q7_t *  buffIn,  const conv2d_relu_avgpool_opt opt)
@@ -2403,6 +2678,7 @@ static ExecStatus eta_conv2d_q7_CHW_ker2x2_stride1_pad0_relu_avgPool_2x2_stride2
   shMemBufPtr dspWeight = 0;
    shMemBufPtr dspBias  = 0;
   shMemBufPtr  dspOutArray = 0;
+  ExecStatus status = EXEC_STATUS_OK;
   // find sizes of all of the arrays using the info present in opt
   stride = 1;
   pad = 0 ;
@@ -2456,6 +2732,11 @@ static ExecStatus eta_conv2d_q7_CHW_ker2x2_stride1_pad0_relu_avgPool_2x2_stride2
    //ecm35xx_printf(" dspOutArray [%d]\r\n",outArraySize);
   if ( ! dspOutArray)
       ecm35xx_printf("No memory for  dspOutArray...\r\n");
+  if (!dspInArray || !dspWeight || !dspBias || !dspOutArray)
+  {
+      status = EXEC_STATUS_ERR_MEM;
+      goto exit;
+  }
     // Convert all into DSP understandable form
    // start_ms = HalTmrRead(0);
      HWCq7_to_CHWq15((int8_t *) inArray, dspInArray, inHeight, inWidth, inChannel);
@@ -2471,7 +2752,8 @@ static ExecStatus eta_conv2d_q7_CHW_ker2x2_stride1_pad0_relu_avgPool_2x2_stride2
          execRpcWork = SharedMemAlloc(sizeof(tExecutorRpcWork));
     if (!execRpcWork) {
         //TBD: Add trace message of error
-        return -1;
+        status = EXEC_STATUS_ERR_MEM;
+        goto exit;
     }
     // Fill in the shared data structure with DSP
     execRpcWork-> status = -1;
@@ -2504,11 +2786,14 @@ static ExecStatus eta_conv2d_q7_CHW_ker2x2_stride1_pad0_relu_avgPool_2x2_stride2
     (execRpcWork->bias).size = biasArraySize;
     memcpy (&((execRpcWork->params).convReluPoolParams),&opt,sizeof(conv2d_relu_avgpool_opt));
     // submit work
-     rpcSubmitWork(RPC_MODULE_ID_EXECUTOR, EXEC_OP_DSP_CHW_2X2_CONV2D_RELU_AVGPOOL_Q7, (void*)execRpcWork);
+     if (ExecDspSubmit(EXEC_OP_DSP_CHW_2X2_CONV2D_RELU_AVGPOOL_Q7, execRpcWork) != EXEC_STATUS_OK)
+       goto exit;
     // work for wait to get over from DSP
     //ecm35xx_printf(" S \r\n");
 
-     xSemaphoreTake(execDspRespSem, portMAX_DELAY);
+     if (ExecWaitDspResp() != EXEC_STATUS_OK)
+
+       goto exit;
 
     // PTR_DUMP16(dspOutArray,outArraySize);
     if (  execRpcWork->status == 0)
@@ -2519,15 +2804,18 @@ static ExecStatus eta_conv2d_q7_CHW_ker2x2_stride1_pad0_relu_avgPool_2x2_stride2
      g_outHeight = outHeight;
      g_outWidth  = outWidth;
      g_outChannel = outChannel;
+exit:
+    if ((status == EXEC_STATUS_OK) && execDspDown)
+        status = EXEC_STATUS_ERR_GEN;
     // Free all shared memory pointers
 #ifdef DYNAMIC_MAPPING
-     vPortFree(dspInArray); vPortFree(dspWeight); vPortFree(dspBias); vPortFree(dspOutArray);
+     ExecDspFree(dspInArray, false); ExecDspFree(dspWeight, false); ExecDspFree(dspBias, false); ExecDspFree(dspOutArray, false);
 #else
-     SharedMemFree(dspInArray); SharedMemFree(dspWeight); SharedMemFree(dspBias); SharedMemFree(dspOutArray);
+     ExecDspFree(dspInArray, true); ExecDspFree(dspWeight, true); ExecDspFree(dspBias, true); ExecDspFree(dspOutArray, true);
 #endif
-     SharedMemFree(execRpcWork);
+     ExecDspFree(execRpcWork, true);
     // Get back  to caller
-    return EXEC_STATUS_OK;
+    return status;
 }
 #endif
 
@@ -2551,6 +2839,7 @@ static ExecStatus eta_conv2d_q7_CHW_ker3x3_stride1_pad0_relu_avgPool_2x2_stride2
     shMemBufPtr dspWeight = 0;
     shMemBufPtr dspBias  = 0;
     shMemBufPtr  dspOutArray = 0;
+    ExecStatus status = EXEC_STATUS_OK;
     // find sizes of all of the arrays using the info present in opt
     stride = 1;
     pad = 0 ;
@@ -2605,6 +2894,11 @@ static ExecStatus eta_conv2d_q7_CHW_ker3x3_stride1_pad0_relu_avgPool_2x2_stride2
     //  ecm35xx_printf(" dspOutArray [%d]\r\n",outArraySize);
     if ( ! dspOutArray)
         ecm35xx_printf("No memory for  dspOutArray...\r\n");
+    if (!dspInArray || !dspWeight || !dspBias || !dspOutArray)
+    {
+        status = EXEC_STATUS_ERR_MEM;
+        goto exit;
+    }
     // Convert all into DSP understandable form
 
     HWCq7_to_CHWq15((int8_t *) inArray, dspInArray, inHeight, inWidth, inChannel);
@@ -2621,7 +2915,8 @@ static ExecStatus eta_conv2d_q7_CHW_ker3x3_stride1_pad0_relu_avgPool_2x2_stride2
     execRpcWork = SharedMemAlloc(sizeof(tExecutorRpcWork));
     if (!execRpcWork) {
         //TBD: Add trace message of error
-        return -1;
+        status = EXEC_STATUS_ERR_MEM;
+        goto exit;
     }
     // Fill in the shared data structure with DSP
     execRpcWork->status = -1;
@@ -2654,11 +2949,13 @@ static ExecStatus eta_conv2d_q7_CHW_ker3x3_stride1_pad0_relu_avgPool_2x2_stride2
     (execRpcWork->bias).size= biasArraySize;
     memcpy (&((execRpcWork->params).convReluPoolParams),&opt,sizeof(conv2d_relu_avgpool_opt));
     // submit work
-        rpcSubmitWork(RPC_MODULE_ID_EXECUTOR, EXEC_OP_DSP_CHW_3X3_CONV2D_RELU_AVGPOOL_Q7, (void*)execRpcWork);
+        if (ExecDspSubmit(EXEC_OP_DSP_CHW_3X3_CONV2D_RELU_AVGPOOL_Q7, execRpcWork) != EXEC_STATUS_OK)
+          goto exit;
     // work for wait to get over from DSP
     //ecm35xx_printf(" Submitted to DSP \r\n");
     // start_ms = HalTmrRead(0);
-    xSemaphoreTake(execDspRespSem, portMAX_DELAY);
+    if (ExecWaitDspResp() != EXEC_STATUS_OK)
+      goto exit;
     //stop_ms =  HalTmrRead(0);
     // ecm35xx_printf("DS time= %d ms\r\n", (uint32_t) (stop_ms - start_ms));
 
@@ -2669,15 +2966,18 @@ static ExecStatus eta_conv2d_q7_CHW_ker3x3_stride1_pad0_relu_avgPool_2x2_stride2
     g_outHeight = outHeight;
     g_outWidth  = outWidth;
     g_outChannel = outChannel;
+exit:
+    if ((status == EXEC_STATUS_OK) && execDspDown)
+        status = EXEC_STATUS_ERR_GEN;
     // Free all shared memory pointers
 #ifdef DYNAMIC_MAPPING
-    vPortFree(dspInArray); vPortFree(dspWeight); vPortFree(dspBias); vPortFree(dspOutArray);
+    ExecDspFree(dspInArray, false); ExecDspFree(dspWeight, false); ExecDspFree(dspBias, false); ExecDspFree(dspOutArray, false);
 #else
-    SharedMemFree(dspInArray); SharedMemFree(dspWeight); SharedMemFree(dspBias); SharedMemFree(dspOutArray);
+    ExecDspFree(dspInArray, true); ExecDspFree(dspWeight, true); ExecDspFree(dspBias, true); ExecDspFree(dspOutArray, true);
 #endif
-    SharedMemFree(execRpcWork);
+    ExecDspFree(execRpcWork, true);
 
     // Get back  to caller
-    return EXEC_STATUS_OK;
+    return status;
 }
 #endif
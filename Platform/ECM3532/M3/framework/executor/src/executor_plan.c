@@ -0,0 +1,146 @@
+#include "config.h"
+#include "executor_public.h"
+#include "executor_config.h"
+#include "executor_private.h"
+#include <stdbool.h>
+
+// Static memory planner for executor operands. Operands whose lifetimes
+// (first and last op index using them) do not overlap share arena space.
+// Placement is greedy by size, as TFLM's GreedyMemoryPlanner: the largest
+// buffers are placed first, each at the lowest offset that does not
+// collide with an already placed buffer alive at the same time.
+
+#define PLAN_ALIGN          4
+
+static inline uint32_t PlanBufBytes (const ExecPlanBuf_t * buf)
+{
+    return (buf->opd->numElements) * ((buf->opd->basetypeSize) + 1);
+}
+
+// Offsets must be a whole number of elements for ExecReMapMem
+static inline uint32_t PlanAlign (const ExecPlanBuf_t * buf, uint32_t offset)
+{
+    uint32_t elemSize = (buf->opd->basetypeSize) + 1;
+    uint32_t align = (elemSize == 3) ? (3 * PLAN_ALIGN) : PLAN_ALIGN;
+    return ((offset + align - 1) / align) * align;
+}
+
+static inline bool PlanLifetimesOverlap (const ExecPlanBuf_t * a, const ExecPlanBuf_t * b)
+{
+    return (a->firstUse <= b->lastUse) && (b->firstUse <= a->lastUse);
+}
+
+void ExecPlanUse (ExecPlanBuf_t * bufs, uint16_t numBufs, ExecOperand_t * opd, uint16_t opIndex)
+{
+    uint16_t index;
+    for (index = 0; index < numBufs; index++)
+    {
+        if (bufs[index].opd == opd)
+        {
+            if ((bufs[index].firstUse == EXEC_PLAN_UNUSED) || (opIndex < bufs[index].firstUse))
+                bufs[index].firstUse = opIndex;
+            if ((bufs[index].lastUse == EXEC_PLAN_UNUSED) || (opIndex > bufs[index].lastUse))
+                bufs[index].lastUse = opIndex;
+            return;
+        }
+    }
+}
+
+ExecStatus ExecPlanMemory (ExecPlanBuf_t * bufs, uint16_t numBufs, uint32_t * arenaSize)
+{
+    uint16_t index1;
+    uint16_t index2;
+    uint32_t size = 0;
+
+    // Weights and biases stay where they are. Check all operands before
+    // anything is sorted or placed, so a rejected plan is left untouched
+    for (index1 = 0; index1 < numBufs; index1++)
+    {
+        if ((bufs[index1].opd->origin == OPD_ORIG_INT_PERSISTENT_MEM) || (bufs[index1].opd->origin == OPD_ORIG_EXT_PERSISTENT_MEM))
+            return EXEC_STATUS_ERR_MEM;
+    }
+
+    // Sort by size, largest first. Insertion sort, plans are small and
+    // this runs once
+    for (index1 = 1; index1 < numBufs; index1++)
+    {
+        ExecPlanBuf_t tmp = bufs[index1];
+        uint32_t tmpBytes = PlanBufBytes (&tmp);
+        index2 = index1;
+        while ((index2 > 0) && (PlanBufBytes (&bufs[index2 - 1]) < tmpBytes))
+        {
+            bufs[index2] = bufs[index2 - 1];
+            index2--;
+        }
+        bufs[index2] = tmp;
+    }
+
+    for (index1 = 0; index1 < numBufs; index1++)
+    {
+        ExecPlanBuf_t * buf = &bufs[index1];
+        uint32_t bytes = PlanBufBytes (buf);
+        uint32_t offset = 0;
+        bool moved;
+
+        if (buf->firstUse == EXEC_PLAN_UNUSED)
+        {
+            // never used, keep it out of the way of everything else
+            buf->firstUse = 0;
+            buf->lastUse = 0;
+        }
+
+        // Move past every placed buffer alive at the same time that
+        // collides, until nothing does. The first fit is the lowest
+        do
+        {
+            moved = false;
+            for (index2 = 0; index2 < index1; index2++)
+            {
+                const ExecPlanBuf_t * placed = &bufs[index2];
+                uint32_t placedEnd = placed->offset + PlanBufBytes (placed);
+                if (PlanLifetimesOverlap (buf, placed) &&
+                    (offset < placedEnd) && (placed->offset < (offset + bytes)))
+                {
+                    offset = PlanAlign (buf, placedEnd);
+                    moved = true;
+                }
+            }
+        } while (moved);
+
+        buf->offset = offset;
+        if ((offset + bytes) > size)
+            size = offset + bytes;
+    }
+
+    if (arenaSize)
+        *arenaSize = size;
+    return EXEC_STATUS_OK;
+}
+
+ExecStatus ExecBindPlan (ExecPlanBuf_t * bufs, uint16_t numBufs, void * arena)
+{
+    ExecStatus status = EXEC_STATUS_OK;
+    uint16_t index;
+
+    if (!arena)
+        return EXEC_STATUS_ERR_MEM;
+
+    for (index = 0; (index < numBufs) && (status == EXEC_STATUS_OK); index++)
+    {
+        ExecOperand_t * opd = bufs[index].opd;
+        uint32_t elemOffset = bufs[index].offset / ((opd->basetypeSize) + 1);
+
+        // The arena owns the memory and outlives every op, so the operand
+        // is neither freed by the executor nor destroyed after its last use
+        opd->origin = OPD_ORIG_IO;
+        opd->memScope = OPD_MEM_SCOPE_GLOBAL;
+        if (opd->privInfo)
+            status = ExecReMapMem (opd, arena, elemOffset);
+        else
+            status = ExecAllocMem (opd, arena, elemOffset);
+        // Works on operands sharing its bytes get ordered by the executor
+        if (status == EXEC_STATUS_OK)
+            opd->privInfo->aliased = 1;
+    }
+    return status;
+}
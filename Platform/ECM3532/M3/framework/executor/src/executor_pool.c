@@ -0,0 +1,174 @@
+#include "config.h"
+#include "executor_public.h"
+#include "executor_config.h"
+#include "executor_common.h"
+#include "executor_private.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include <stdbool.h>
+
+// Fixed size object pools for operand private info and work params, so
+// submitting a work does no FreeRTOS heap operation. An empty pool falls
+// back to the heap, the fallbacks are counted in the pool stats.
+
+// Every exec_*_t param struct fits in one param block
+typedef union
+{
+    exec_conv2d_q7_t conv2d;
+    exec_avepool2d_q7_t avepool2d;
+    exec_maxpool2d_q7_t maxpool2d;
+    exec_conv2d_relu_avgpool_q7_t conv2dReluAvgpool;
+    exec_pw_ds_conv2d_q7_t pwDsConv2d;
+    exec_concat_q7_t concat;
+    exec_sigmoid_q7_t sigmoid;
+    exec_fc_q7_t fc;
+    exec_add_q7_t add;
+    tDsp_math_fft_opt fft;
+    tDsp_math_func_opt mathFunc;
+} ExecParamBlock_t;
+
+typedef union ExecPoolBlock
+{
+    union ExecPoolBlock * next;
+    uint32_t align;
+} ExecPoolBlock_t;
+
+typedef struct
+{
+    uint8_t * mem;
+    uint16_t blockSize;
+    uint16_t numBlocks;
+    ExecPoolBlock_t * freeList;
+    bool initDone;
+    ExecPoolStats_t stats;
+} ExecPool_t;
+
+#define POOL_BLOCK_SIZE(T)      ((sizeof (T) + sizeof (ExecPoolBlock_t) - 1) & ~(sizeof (ExecPoolBlock_t) - 1))
+
+static ExecPoolBlock_t privInfoMem[CONFIG_EXEC_PRIVINFO_POOL_SIZE * POOL_BLOCK_SIZE(struct privateInfo) / sizeof (ExecPoolBlock_t)];
+static ExecPoolBlock_t paramMem[CONFIG_EXEC_PARAM_POOL_SIZE * POOL_BLOCK_SIZE(ExecParamBlock_t) / sizeof (ExecPoolBlock_t)];
+
+static ExecPool_t privInfoPool = {
+    .mem = (uint8_t *) privInfoMem,
+    .blockSize = POOL_BLOCK_SIZE(struct privateInfo),
+    .numBlocks = CONFIG_EXEC_PRIVINFO_POOL_SIZE,
+};
+static ExecPool_t paramPool = {
+    .mem = (uint8_t *) paramMem,
+    .blockSize = POOL_BLOCK_SIZE(ExecParamBlock_t),
+    .numBlocks = CONFIG_EXEC_PARAM_POOL_SIZE,
+};
+
+// To be called inside a critical section
+static void PoolInit (ExecPool_t * pool)
+{
+    uint16_t index;
+    pool->freeList = NULL;
+    for (index = pool->numBlocks; index > 0; index--)
+    {
+        ExecPoolBlock_t * block = (ExecPoolBlock_t *) (pool->mem + ((index - 1) * pool->blockSize));
+        block->next = pool->freeList;
+        pool->freeList = block;
+    }
+    pool->stats.size = pool->numBlocks;
+    pool->initDone = true;
+}
+
+static void * PoolAlloc (ExecPool_t * pool, uint32_t size)
+{
+    ExecPoolBlock_t * block = NULL;
+    taskENTER_CRITICAL();
+    if (!pool->initDone)
+    {
+        PoolInit (pool);
+    }
+    if ((size <= pool->blockSize) && pool->freeList)
+    {
+        block = pool->freeList;
+        pool->freeList = block->next;
+        pool->stats.used++;
+        if (pool->stats.used > pool->stats.peak)
+        {
+            pool->stats.peak = pool->stats.used;
+        }
+    }
+    else
+    {
+        pool->stats.heapFallbacks++;
+    }
+    taskEXIT_CRITICAL();
+
+    if (!block)
+    {
+        return pvPortMalloc (size);
+    }
+    return (void *) block;
+}
+
+static void PoolFree (ExecPool_t * pool, void * addr)
+{
+    uint8_t * ptr = (uint8_t *) addr;
+    if (!addr)
+    {
+        return;
+    }
+    if ((ptr < pool->mem) || (ptr >= (pool->mem + (pool->numBlocks * pool->blockSize))))
+    {
+        vPortFree (addr);
+        return;
+    }
+    taskENTER_CRITICAL();
+    ((ExecPoolBlock_t *) addr)->next = pool->freeList;
+    pool->freeList = (ExecPoolBlock_t *) addr;
+    pool->stats.used--;
+    taskEXIT_CRITICAL();
+}
+
+void ExecPoolsInit (void)
+{
+    taskENTER_CRITICAL();
+    if (!privInfoPool.initDone)
+    {
+        PoolInit (&privInfoPool);
+    }
+    if (!paramPool.initDone)
+    {
+        PoolInit (&paramPool);
+    }
+    taskEXIT_CRITICAL();
+}
+
+struct privateInfo * ExecAllocPrivInfo (void)
+{
+    return (struct privateInfo *) PoolAlloc (&privInfoPool, sizeof (struct privateInfo));
+}
+
+void ExecFreePrivInfo (struct privateInfo * privinfo)
+{
+    PoolFree (&privInfoPool, privinfo);
+}
+
+void * ExecAllocParams (uint32_t size)
+{
+    return PoolAlloc (&paramPool, size);
+}
+
+void ExecFreeParams (void * params)
+{
+    PoolFree (&paramPool, params);
+}
+
+void ExecGetPoolStats (ExecPoolStats_t * privInfoStats, ExecPoolStats_t * paramStats)
+{
+    ExecPoolsInit ();
+    taskENTER_CRITICAL();
+    if (privInfoStats)
+    {
+        *privInfoStats = privInfoPool.stats;
+    }
+    if (paramStats)
+    {
+        *paramStats = paramPool.stats;
+    }
+    taskEXIT_CRITICAL();
+}
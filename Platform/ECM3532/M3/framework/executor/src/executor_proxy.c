@@ -18,7 +18,7 @@ ExecStatus Exec_conv2d_q7 ( uint8_t execHwId, ExecOperand_t * inArray, ExecOpera
     ExecWork_t work;
     uint8_t index;
        // Get the param allocated and fill all the details
-     params = ( exec_conv2d_q7_t *) pvPortMalloc(sizeof (exec_conv2d_q7_t));
+     params = ( exec_conv2d_q7_t *) ExecAllocParams(sizeof (exec_conv2d_q7_t));
      params->wt =  (  const q7_t *) ExecGetBufAddr(wt);
      params->bias =  (  const q7_t *) ExecGetBufAddr(bias);
      memcpy( &(params->opt),opt,sizeof(conv2d_opt));
@@ -61,7 +61,7 @@ ExecStatus Exec_ds_conv2d_q7 ( uint8_t execHwId, ExecOperand_t * inArray, ExecOp
     ExecWork_t work;
     uint8_t index;
        // Get the param allocated and fill all the details
-     params = ( exec_conv2d_q7_t *) pvPortMalloc(sizeof (exec_conv2d_q7_t));
+     params = ( exec_conv2d_q7_t *) ExecAllocParams(sizeof (exec_conv2d_q7_t));
      params->wt =  (  const q7_t *) ExecGetBufAddr(wt);
      params->bias =  (  const q7_t *) ExecGetBufAddr(bias);
      memcpy( &(params->opt),opt,sizeof(conv2d_opt));
@@ -106,7 +106,7 @@ ExecStatus Exec_ds_conv2d_q7_inplace ( uint8_t execHwId, ExecOperand_t * inOutAr
     ExecWork_t work;
     uint8_t index;
        // Get the param allocated and fill all the details
-     params = ( exec_conv2d_q7_t *) pvPortMalloc(sizeof (exec_conv2d_q7_t));
+     params = ( exec_conv2d_q7_t *) ExecAllocParams(sizeof (exec_conv2d_q7_t));
      params->wt =  (  const q7_t *) ExecGetBufAddr(wt);
      params->bias =  (  const q7_t *) ExecGetBufAddr(bias);
      memcpy( &(params->opt),opt,sizeof(conv2d_opt));
@@ -156,7 +156,7 @@ ExecStatus Exec_pw_conv2d_q7 ( uint8_t execHwId, ExecOperand_t * inArray, ExecOp
     ExecWork_t work;
     uint8_t index;
        // Get the param allocated and fill all the details
-     params = ( exec_conv2d_q7_t *) pvPortMalloc(sizeof (exec_conv2d_q7_t));
+     params = ( exec_conv2d_q7_t *) ExecAllocParams(sizeof (exec_conv2d_q7_t));
      params->wt =  (  const q7_t *) ExecGetBufAddr(wt);
      params->bias =  (  const q7_t *) ExecGetBufAddr(bias);
      memcpy( &(params->opt),opt,sizeof(conv2d_opt));
@@ -192,7 +192,7 @@ ExecStatus Exec_pw_conv2d_q7_fast ( uint8_t execHwId, ExecOperand_t * inArray, E
     ExecWork_t work;
     uint8_t index;
        // Get the param allocated and fill all the details
-     params = ( exec_conv2d_q7_t *) pvPortMalloc(sizeof (exec_conv2d_q7_t));
+     params = ( exec_conv2d_q7_t *) ExecAllocParams(sizeof (exec_conv2d_q7_t));
      params->wt =  (  const q7_t *) ExecGetBufAddr(wt);
      params->bias =  (  const q7_t *) ExecGetBufAddr(bias);
      memcpy( &(params->opt),opt,sizeof(conv2d_opt));
@@ -223,7 +223,7 @@ ExecStatus Exec_avepool2d_q7( uint8_t execHwId, ExecOperand_t * inArray, ExecOpe
     ExecStatus status = EXEC_STATUS_OK;
     ExecWork_t work;
     uint8_t index;
-    params = (exec_avepool2d_q7_t *) pvPortMalloc(sizeof (exec_avepool2d_q7_t));
+    params = (exec_avepool2d_q7_t *) ExecAllocParams(sizeof (exec_avepool2d_q7_t));
     memcpy( &(params->opt),opt,sizeof(pool2d_opt));
     work.params = (void *) params;
     work.execHwId = execHwId;
@@ -268,7 +268,7 @@ ExecStatus Exec_conv2d_q7_CHW_ker2x2_stride1_pad0_relu_avgPool_2x2_stride2_pad0(
     ExecWork_t work;
     uint8_t index;
     // Get the param allocated and fill all the details
-     params = ( exec_conv2d_relu_avgpool_q7_t *) pvPortMalloc(sizeof (exec_conv2d_relu_avgpool_q7_t));
+     params = ( exec_conv2d_relu_avgpool_q7_t *) ExecAllocParams(sizeof (exec_conv2d_relu_avgpool_q7_t));
      params->wt =  (  const q7_t *) ExecGetBufAddr(wt);
      params->bias =  (  const q7_t *) ExecGetBufAddr(bias);
      memcpy( &(params->opt),opt,sizeof(conv2d_relu_avgpool_opt));
@@ -298,7 +298,7 @@ ExecStatus Exec_conv2d_q7_CHW_ker3x3_stride1_pad0_relu_avgPool_2x2_stride2_pad0(
     ExecWork_t work;
     uint8_t index;
     // Get the param allocated and fill all the details
-     params = ( exec_conv2d_relu_avgpool_q7_t *) pvPortMalloc(sizeof (exec_conv2d_relu_avgpool_q7_t));
+     params = ( exec_conv2d_relu_avgpool_q7_t *) ExecAllocParams(sizeof (exec_conv2d_relu_avgpool_q7_t));
      params->wt =  (  const q7_t *) ExecGetBufAddr(wt);
      params->bias =  (  const q7_t *) ExecGetBufAddr(bias);
      memcpy( &(params->opt),opt,sizeof(conv2d_relu_avgpool_opt));
@@ -327,7 +327,7 @@ ExecStatus Exec_ds_conv2d_layer2_q7 ( uint8_t execHwId, ExecOperand_t * inArray,
     ExecWork_t work;
     uint8_t index;
        // Get the param allocated and fill all the details
-     params = ( exec_conv2d_q7_t *) pvPortMalloc(sizeof (exec_conv2d_q7_t));
+     params = ( exec_conv2d_q7_t *) ExecAllocParams(sizeof (exec_conv2d_q7_t));
      params->wt =  (  const q7_t *) ExecGetBufAddr(wt);
      params->bias =  (  const q7_t *) ExecGetBufAddr(bias);
      memcpy( &(params->opt),opt,sizeof(conv2d_opt));
@@ -357,7 +357,7 @@ ExecStatus Exec_ds_conv2d_sb_layer3_q7 (uint8_t execHwId, ExecOperand_t * inOutA
     ExecWork_t work;
     uint8_t index;
        // Get the param allocated and fill all the details
-     params = ( exec_conv2d_q7_t *) pvPortMalloc(sizeof (exec_conv2d_q7_t));
+     params = ( exec_conv2d_q7_t *) ExecAllocParams(sizeof (exec_conv2d_q7_t));
      params->wt =  (  const q7_t *) ExecGetBufAddr(wt);
      params->bias =  (  const q7_t *) ExecGetBufAddr(bias);
      memcpy( &(params->opt),opt,sizeof(conv2d_opt));
@@ -390,7 +390,7 @@ ExecStatus Exec_sigmoid_q7 ( uint8_t execHwId, ExecOperand_t * inArray, int size
     uint8_t index;
 
        // Get the param allocated and fill all the details
-     params = (exec_sigmoid_q7_t *) pvPortMalloc(sizeof(exec_sigmoid_q7_t));
+     params = (exec_sigmoid_q7_t *) ExecAllocParams(sizeof (exec_sigmoid_q7_t));
      params->size =  size;
      params->width =  width;
      work.params = (void *) params;
@@ -420,7 +420,7 @@ ExecStatus Exec_concat_height_q7 ( uint8_t execHwId,
     uint8_t index;
 
        // Get the param allocated and fill all the details
-     params = (exec_concat_q7_t *) pvPortMalloc(sizeof(exec_concat_q7_t));
+     params = (exec_concat_q7_t *) ExecAllocParams(sizeof (exec_concat_q7_t));
      memcpy( &(params->opt),opt,sizeof(concat_opt));
      work.params = (void *) params;
      work.execHwId = execHwId;
@@ -454,7 +454,7 @@ ExecStatus Exec_pw_ds_conv2d_layer4and5_q7 (uint8_t execHwId, ExecOperand_t * in
     ExecWork_t work;
     uint8_t index;
        // Get the param allocated and fill all the details
-     params = (exec_pw_ds_conv2d_q7_t *) pvPortMalloc(sizeof(exec_pw_ds_conv2d_q7_t));
+     params = (exec_pw_ds_conv2d_q7_t *) ExecAllocParams(sizeof (exec_pw_ds_conv2d_q7_t));
      params->wt_pw =  (const q7_t *) ExecGetBufAddr(wt_pw);
      params->wt_ds =  (const q7_t *) ExecGetBufAddr(wt_ds);
      params->bias_pw =  (const q7_t *) ExecGetBufAddr(bias_pw);
@@ -490,7 +490,7 @@ ExecStatus Exec_maxpool_q7 (uint8_t execHwId, ExecOperand_t * inArray,
     ExecStatus status = EXEC_STATUS_OK;
     ExecWork_t work;
     uint8_t index;
-    params = (exec_maxpool2d_q7_t *) pvPortMalloc(sizeof (exec_maxpool2d_q7_t));
+    params = (exec_maxpool2d_q7_t *) ExecAllocParams(sizeof (exec_maxpool2d_q7_t));
     memcpy( &(params->opt), opt, sizeof(pool2d_opt));
     work.params = (void *) params;
     work.execHwId = execHwId;
@@ -516,7 +516,7 @@ ExecStatus Exec_fully_connected_q7(uint8_t execHwId, ExecOperand_t * inArray,
     ExecWork_t work;
     uint8_t index;
 
-    params = (exec_fc_q7_t *) pvPortMalloc(sizeof(exec_fc_q7_t));
+    params = (exec_fc_q7_t *) ExecAllocParams(sizeof (exec_fc_q7_t));
     params->wt =  (const q7_t *) ExecGetBufAddr(wt);
     params->bias =  (const q7_t *) ExecGetBufAddr(bias);
     memcpy( &(params->opt), opt, sizeof(fc_opt));
@@ -543,7 +543,7 @@ ExecStatus Exec_add_q7(uint8_t execHwId, ExecOperand_t * inArray0,
     ExecWork_t work;
     uint8_t index;
 
-    params = (exec_add_q7_t *) pvPortMalloc(sizeof(exec_add_q7_t));
+    params = (exec_add_q7_t *) ExecAllocParams(sizeof (exec_add_q7_t));
     memcpy( &(params->opt), opt, sizeof(add_opt));
     work.params = (void *) params;
     work.execHwId = execHwId;
@@ -569,7 +569,7 @@ ExecStatus Exec_fft_q15(uint8_t execHwId, ExecOperand_t * inArray0, ExecOperand_
     ExecWork_t work;
     uint8_t index;
 
-    params = (tDsp_math_fft_opt *) pvPortMalloc(sizeof(tDsp_math_fft_opt));
+    params = (tDsp_math_fft_opt *) ExecAllocParams(sizeof (tDsp_math_fft_opt));
     params->fft_length =  fft_length;
     work.params = (void *) params;
     work.execHwId = execHwId;
@@ -594,7 +594,7 @@ ExecStatus Exec_math_func_sqrt_exp_log_q15(uint8_t mathFunId, uint8_t execHwId,
     ExecWork_t work;
     uint8_t index;
 
-    params = (tDsp_math_func_opt *) pvPortMalloc(sizeof(tDsp_math_func_opt));
+    params = (tDsp_math_func_opt *) ExecAllocParams(sizeof (tDsp_math_func_opt));
     params->len =  len;
     work.params = (void *) params;
     work.execHwId = execHwId;
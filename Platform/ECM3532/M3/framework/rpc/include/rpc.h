@@ -6,11 +6,47 @@
 #define NO_OF_HEADER_FILTER_BITS      (NO_OF_MODULE_ID_BITS + NO_OF_USER_DEFINED_FIELD_BITS)
 
 typedef int (*tnotifyEventCb) (uint32_t header,uint32_t data);
+// Called from the DSP IPC ISR, may only use FromISR APIs. Returns non zero
+// if it woke a higher priority task.
+typedef int (*tnotifyEventIsrCb) (uint32_t header,uint32_t data);
+
+typedef struct {
+    uint8_t moduleId;
+    uint8_t operation;
+    void* params;   // in shared memory
+} tRpcWork;
+
 int rpcInit(void);
 void  rpcDeinit(void);
 void rpcRegisterEventCb(uint8_t eventHeaderMask, tnotifyEventCb cbFn);
+void rpcRegisterEventIsrCb(uint8_t eventHeaderMask, tnotifyEventIsrCb cbFn);
 int rpcSubmitWork(uint8_t moduleId, uint8_t operation, void* params);
+int rpcSubmitWorkBatch(tRpcWork* works, uint8_t numWorks);
+
+
+// IPC raise to waiter wake latency, in M3 cycles. The ISR stamps every DSP
+// IPC per message type (header), RPC_LATENCY_WAKE(header) records the time
+// since. Waiters woken by an ISR callback call it, the notifier task calls
+// it before running a task callback.
+#define RPC_LATENCY_ISR_PATH        0   // waiter woken by a callback run from the ISR
+#define RPC_LATENCY_TASK_PATH       1   // notifier task about to run the callback
+#define RPC_LATENCY_NUM_PATHS       2
+
+typedef struct {
+    uint32_t count;
+    uint32_t minCycles;
+    uint32_t maxCycles;
+    uint64_t totalCycles;
+} tRpcLatencyStats;
 
+#ifdef CONFIG_RPC_LATENCY_STATS
+void rpcLatencyWake(uint32_t header);
+void rpcGetLatencyStats(tRpcLatencyStats* stats); // RPC_LATENCY_NUM_PATHS entries
+void rpcResetLatencyStats(void);
+#define RPC_LATENCY_WAKE(header)    rpcLatencyWake(header)
+#else
+#define RPC_LATENCY_WAKE(header)
+#endif
 
 /*TODO*/
 #define DSP_WAKEUP_MSG  (1 << 0)
@@ -6,6 +6,8 @@
 #include "semphr.h"
 #include "dsp_ipc.h"
 #include "task.h"
+#include "ecm3532.h"
+#include "cm3.h"
 #include "print_util.h"
 
 #define MEMORY_PATTERN 0XDEAD
@@ -32,6 +34,8 @@ tM3DSPSharedMemory __attribute__((section (".shmSection"))) shmemM3Dsp = {0};
 SemaphoreHandle_t xNotifyFnListMutex;
 QueueHandle_t xNotifierQueue;
 tnotifyEventCb  notifyFnList[NOTIFY_FN_LIST_SIZE] = { 0 }; // Cost is memory ( which can be optimised)  advantage is faster serach
+// Callbacks dispatched straight from dspIpcCb, no task switch or mutex
+tnotifyEventIsrCb  notifyIsrFnList[NOTIFY_FN_LIST_SIZE] = { 0 };
 uint8_t notifierTaskActive = 0;
 static void vnotifierTask(void* pvParameters)
 {
@@ -48,6 +52,8 @@ static void vnotifierTask(void* pvParameters)
             case  IPC_FROM_DSP:
                 xSemaphoreTake(xNotifyFnListMutex, portMAX_DELAY);
                 index = (uint8_t)(ipcInfo.header & (NOTIFY_FN_LIST_SIZE -1));
+                // the task path counterpart of the waiter woken from the ISR
+                RPC_LATENCY_WAKE(ipcInfo.header);
                 if (notifyFnList[index]) {
                     notifyFnList[index](ipcInfo.header,ipcInfo.data);   // Actual Cb call
                 }
@@ -64,6 +70,87 @@ static void vnotifierTask(void* pvParameters)
     }
 }
 
+#ifdef CONFIG_RPC_LATENCY_STATS
+// DWT cycle counter, not in cm3.h
+#define DWT_CTRL                    (*(volatile uint32_t *)0xE0001000)
+#define DWT_CYCCNT                  (*(volatile uint32_t *)0xE0001004)
+#define DWT_CTRL_CYCCNTENA          (1 << 0)
+
+// One stamp per message type, an IPC of another type arriving before the
+// waiter runs does not overwrite the one it measures
+static volatile uint32_t ipcRaiseCycles[NOTIFY_FN_LIST_SIZE];
+static volatile uint8_t ipcRaisePath[NOTIFY_FN_LIST_SIZE];
+static volatile uint8_t ipcRaisePending[NOTIFY_FN_LIST_SIZE];
+static tRpcLatencyStats latencyStats[RPC_LATENCY_NUM_PATHS];
+
+static inline void rpcLatencyRaise(uint32_t header, uint8_t path)
+{
+    uint8_t index = (uint8_t)(header & (NOTIFY_FN_LIST_SIZE - 1));
+    ipcRaiseCycles[index] = DWT_CYCCNT;
+    ipcRaisePath[index] = path;
+    ipcRaisePending[index] = 1;
+}
+
+void rpcLatencyWake(uint32_t header)
+{
+    uint32_t now = DWT_CYCCNT;
+    uint8_t index = (uint8_t)(header & (NOTIFY_FN_LIST_SIZE - 1));
+    uint32_t cycles;
+    tRpcLatencyStats* stats;
+
+    taskENTER_CRITICAL();
+    if (ipcRaisePending[index])
+    {
+        ipcRaisePending[index] = 0;
+        cycles = now - ipcRaiseCycles[index];
+        stats = &latencyStats[ipcRaisePath[index]];
+        if ((stats->count == 0) || (cycles < stats->minCycles))
+            stats->minCycles = cycles;
+        if (cycles > stats->maxCycles)
+            stats->maxCycles = cycles;
+        stats->totalCycles += cycles;
+        stats->count++;
+    }
+    taskEXIT_CRITICAL();
+}
+
+void rpcGetLatencyStats(tRpcLatencyStats* stats)
+{
+    uint8_t index;
+    taskENTER_CRITICAL();
+    for (index = 0; index < RPC_LATENCY_NUM_PATHS; index++)
+        stats[index] = latencyStats[index];
+    taskEXIT_CRITICAL();
+}
+
+void rpcResetLatencyStats(void)
+{
+    uint8_t index;
+    taskENTER_CRITICAL();
+    for (index = 0; index < NOTIFY_FN_LIST_SIZE; index++)
+        ipcRaisePending[index] = 0;
+    for (index = 0; index < RPC_LATENCY_NUM_PATHS; index++)
+    {
+        latencyStats[index].count = 0;
+        latencyStats[index].minCycles = 0;
+        latencyStats[index].maxCycles = 0;
+        latencyStats[index].totalCycles = 0;
+    }
+    taskEXIT_CRITICAL();
+}
+
+__attribute__((section(".initSection")))
+static void rpcLatencyInit(void)
+{
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA;
+    DWT_CYCCNT = 0;
+    DWT_CTRL |= DWT_CTRL_CYCCNTENA;
+    rpcResetLatencyStats();
+}
+#else
+#define rpcLatencyRaise(header, path)
+#endif
+
 __attribute__((section(".initSection")))
 void rpcRegisterEventCb(uint8_t eventHeaderMask, tnotifyEventCb cbFn)
 {
@@ -72,6 +159,15 @@ void rpcRegisterEventCb(uint8_t eventHeaderMask, tnotifyEventCb cbFn)
     xSemaphoreGive(xNotifyFnListMutex);
 }
 
+// The ISR reads the table without the mutex, so a critical section here
+__attribute__((section(".initSection")))
+void rpcRegisterEventIsrCb(uint8_t eventHeaderMask, tnotifyEventIsrCb cbFn)
+{
+    taskENTER_CRITICAL();
+    notifyIsrFnList[eventHeaderMask & (NOTIFY_FN_LIST_SIZE - 1)] = cbFn;
+    taskEXIT_CRITICAL();
+}
+
 __attribute__((section(".initSection"))) int rpcInit(void)
 {
     //Fill the pattern
@@ -108,6 +204,9 @@ __attribute__((section(".initSection"))) int rpcInit(void)
         return -1;
     }
 
+#ifdef CONFIG_RPC_LATENCY_STATS
+    rpcLatencyInit();
+#endif
     dsp_irq_setup();
     return 0;
 }
@@ -122,26 +221,63 @@ void  rpcDeinit(void)
     // delete the shmemem
 }
 int rpcSubmitWork(uint8_t moduleId, uint8_t operation, void* params) {
-    tWorkDescriptor work;
+    tRpcWork work;
     work.moduleId = moduleId;
     work.operation = operation;
-    work.argumentPointerOffset = SharedMemGetOffset(params);
-    //Add this task into work queue
-    if (WorkQueueAdd(&(shmemM3Dsp.workQueue), &work))
-    {
-        //TBD: add trce or  assert
-        return -1;
+    work.params = params;
+    return rpcSubmitWorkBatch(&work, 1);
+}
+
+// Submit works in one go, the DSP gets at most one doorbell for all of them.
+// Blocks while the work queue is full, returns -1 when the DSP does not make
+// room within CONFIG_RPC_WORK_QUEUE_FULL_TIMEOUT_MS. Some of the works may
+// have been handed over by then.
+int rpcSubmitWorkBatch(tRpcWork* works, uint8_t numWorks) {
+    tWorkDescriptor work[MAX_WORK_QUEUE_SIZE - 1];
+    uint8_t index;
+    uint8_t count;
+
+    while (numWorks) {
+        count = (numWorks < (MAX_WORK_QUEUE_SIZE - 1)) ? numWorks : (MAX_WORK_QUEUE_SIZE - 1);
+        for (index = 0; index < count; index++) {
+            work[index].moduleId = works[index].moduleId;
+            work[index].operation = works[index].operation;
+            work[index].argumentPointerOffset = SharedMemGetOffset(works[index].params);
+        }
+        //Add these tasks into work queue, WorkQueueAddBatch rings the DSP if it may be sleeping
+        if (WorkQueueAddBatch(&(shmemM3Dsp.workQueue), work, count))
+        {
+            //TBD: add trce or  assert
+            return -1;
+        }
+        works += count;
+        numWorks -= count;
     }
-    //TBD: Send and IPC message to DSP if it is sleeping
-    send2dsp(DSP_WAKEUP_MSG, 0);
     return 0;
 }
 
 /* param2 is header (cmd), param1 data) */
 void dspIpcCb(uint32_t param1, uint32_t param2)
 {
-    BaseType_t xTaskWoken;
+    BaseType_t xTaskWoken = pdFALSE;
     tIpcInfo IpcMsg;
+    tnotifyEventIsrCb isrCb;
+    if (param2 == WORK_QUEUE_SPACE_MSG)
+    {
+        WorkQueueSpaceAvailableFromISR();
+        return;
+    }
+    isrCb = notifyIsrFnList[param2 & (NOTIFY_FN_LIST_SIZE - 1)];
+    if (isrCb)
+    {
+        rpcLatencyRaise(param2, RPC_LATENCY_ISR_PATH);
+        if (isrCb(param2, param1))
+        {
+            portYIELD_FROM_ISR(pdTRUE);
+        }
+        return;
+    }
+    rpcLatencyRaise(param2, RPC_LATENCY_TASK_PATH);
     IpcMsg.msgType = IPC_FROM_DSP;
     IpcMsg.header = param2;
     IpcMsg.data = param1;
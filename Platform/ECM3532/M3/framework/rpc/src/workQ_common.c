@@ -2,18 +2,61 @@
 #include "config.h"
 #include "FreeRTOS.h" //Include it for M3 build but not for DSP.
 #include "semphr.h"
+#include "task.h"
+#include "ecm3532.h"
+#include "cm3.h"
 #include "workQ_common.h"
+#include "rpc.h"
+#include "dsp_ipc.h"
+
+// Period to re-check for space while the queue is full, in case the DSP
+// notification is missed or the DSP image predates WORK_QUEUE_SPACE_MSG
+#define WORK_QUEUE_SPACE_POLL_TICKS     pdMS_TO_TICKS(5)
+
+// Longest a WorkQueueAddBatch() call waits for space before it gives up
+#ifndef CONFIG_RPC_WORK_QUEUE_FULL_TIMEOUT_MS
+#define CONFIG_RPC_WORK_QUEUE_FULL_TIMEOUT_MS   1000
+#endif
 
 #ifdef INC_FREERTOS_H
 //Needed to make the functions reentrant from multiple M3 tasks
 SemaphoreHandle_t xWorkQueueMutex;
+//Given from the IPC ISR when the DSP frees a slot
+SemaphoreHandle_t xWorkQueueSpaceSem;
 #endif
 
+static inline uint16_t WorkQueueNext(uint16_t index)
+{
+    index++;
+    if (index >= MAX_WORK_QUEUE_SIZE) //wrap around
+        index = 0;
+    return index;
+}
+
+static inline uint8_t WorkQueueIsFull(volatile tWorkQueue* queue)
+{
+    return (WorkQueueNext(queue->writeIndex) == queue->readIndex);
+}
+
+// Ring the doorbell for the works published since first. The DSP only
+// sleeps after it found the queue empty, so if it has not got to first yet
+// (works before ours still pending) or is already past it, it will see
+// every work up to writeIndex without a wakeup.
+static void WorkQueueKick(volatile tWorkQueue* queue, uint16_t first)
+{
+    __DMB();
+    if (queue->readIndex == first)
+    {
+        send2dsp(DSP_WAKEUP_MSG, 0);
+    }
+}
+
 __attribute__((section(".initSection")))
 int WorkQueueInit(tWorkQueue* queue)
 {
     uint8_t index = 0;
     queue->readIndex = queue->writeIndex = 0;
+    queue->producerWaiting = 0;
     //Follow a away which can work for all compilers even chess. later can be chanaged. So no memcpy
     for (index = 0; index < MAX_WORK_QUEUE_SIZE; index++) {
         queue->workArray[index].moduleId = 0;
@@ -22,8 +65,9 @@ int WorkQueueInit(tWorkQueue* queue)
     }
 #ifdef INC_FREERTOS_H
     xWorkQueueMutex = xSemaphoreCreateMutex();
+    xWorkQueueSpaceSem = xSemaphoreCreateBinary();
 
-    if (xWorkQueueMutex == NULL) {
+    if ((xWorkQueueMutex == NULL) || (xWorkQueueSpaceSem == NULL)) {
         //TBD: Add trace message of error
         return -1;
     }
@@ -31,57 +75,101 @@ int WorkQueueInit(tWorkQueue* queue)
     return 0;
 
 }
+
 int WorkQueueAdd(tWorkQueue* queue, tWorkDescriptor* work)
 {
-    // while adding we detect an alost full condition and assert
-    // do not write in case of full
-    uint16_t next;
+    return WorkQueueAddBatch(queue, work, 1);
+}
+
+// Add works and ring the DSP doorbell once for all of them. Blocks while the
+// queue is full, the mutex only serializes M3 tasks, the DSP never takes it.
+// Returns -1 when the DSP made no room within
+// CONFIG_RPC_WORK_QUEUE_FULL_TIMEOUT_MS, the works before the one that did
+// not fit are published and the DSP was rung for them.
+int WorkQueueAddBatch(tWorkQueue* queue, tWorkDescriptor* works, uint16_t numWorks)
+{
+    volatile tWorkQueue* q = queue;
+    uint16_t index;
+    uint16_t writeIndex;
+    uint16_t first;
 #ifdef INC_FREERTOS_H
-    xSemaphoreTake(xWorkQueueMutex, portMAX_DELAY);
+    TickType_t start;
 #endif
-    next = queue->writeIndex + 1;  // next is where writeIndex will point to after this write.
-    if (next >= MAX_WORK_QUEUE_SIZE) //wrap around
-        next = 0;
 
-    if (next == queue->readIndex) { // if the writeIndex + 1 == readIndex, circular buffer is full
-        return -1; // We can assert too
+    if (numWorks == 0)
+        return 0;
+#ifdef INC_FREERTOS_H
+    xSemaphoreTake(xWorkQueueMutex, portMAX_DELAY);
+    start = xTaskGetTickCount();
+#endif
+    first = q->writeIndex;
+    for (index = 0; index < numWorks; index++)
+    {
+        while (WorkQueueIsFull(q))
+        {
+            // DSP has to see what is published so far before it can make room
+            if (q->writeIndex != first)
+            {
+                WorkQueueKick(q, first);
+                first = q->writeIndex;
+            }
+#ifdef INC_FREERTOS_H
+            if ((xTaskGetTickCount() - start) >= pdMS_TO_TICKS(CONFIG_RPC_WORK_QUEUE_FULL_TIMEOUT_MS))
+            {
+                xSemaphoreGive(xWorkQueueMutex);
+                return -1;
+            }
+            q->producerWaiting = 1;
+            __DMB();
+            if (WorkQueueIsFull(q))
+            {
+                xSemaphoreTake(xWorkQueueSpaceSem, WORK_QUEUE_SPACE_POLL_TICKS);
+            }
+            q->producerWaiting = 0;
+#endif
+        }
+        // Load data and then move
+        writeIndex = q->writeIndex;
+        q->workArray[writeIndex].moduleId = works[index].moduleId;
+        q->workArray[writeIndex].operation = works[index].operation;
+        q->workArray[writeIndex].argumentPointerOffset = works[index].argumentPointerOffset;
+        // slot has to be visible to the DSP before the index moves past it
+        __DMB();
+        q->writeIndex = WorkQueueNext(writeIndex);
+    }
+    if (q->writeIndex != first)
+    {
+        WorkQueueKick(q, first);
     }
-    // Load data and then move
-    queue->workArray[queue->writeIndex].moduleId = work->moduleId;
-    queue->workArray[queue->writeIndex].operation = work->operation;
-    queue->workArray[queue->writeIndex].argumentPointerOffset = work->argumentPointerOffset;
-
-    queue->writeIndex = next;             // writeIndex to next data offset.
 #ifdef INC_FREERTOS_H
     xSemaphoreGive(xWorkQueueMutex);
 #endif
     return 0;  // return success to indicate successful push.
 }
 
-
-int WorkQueueRemove(tWorkQueue* queue, tWorkDescriptor* work)
+void WorkQueueSpaceAvailableFromISR(void)
 {
-    uint16_t next;
 #ifdef INC_FREERTOS_H
-    xSemaphoreTake(xWorkQueueMutex, portMAX_DELAY);
+    BaseType_t xTaskWoken = pdFALSE;
+    xSemaphoreGiveFromISR(xWorkQueueSpaceSem, &xTaskWoken);
+    portYIELD_FROM_ISR(xTaskWoken);
 #endif
+}
 
-    if (queue->writeIndex == queue->readIndex) {  // if the writeIndex == readIndex, we don't have any data
+int WorkQueueRemove(tWorkQueue* queue, tWorkDescriptor* work)
+{
+    volatile tWorkQueue* q = queue;
+    uint16_t readIndex = q->readIndex;
+
+    if (q->writeIndex == readIndex) {  // if the writeIndex == readIndex, we don't have any data
         return -1;
     }
-
-    next = queue->readIndex + 1;  // next is where readIndex will point to after this read.
-    if (next >= MAX_WORK_QUEUE_SIZE)
-        next = 0;
+    __DMB();
     //Read data and move
-    work->moduleId = queue->workArray[queue->readIndex].moduleId;
-    work->operation = queue->workArray[queue->readIndex].operation;
-    work->argumentPointerOffset = queue->workArray[queue->readIndex].argumentPointerOffset;
-
-    queue->readIndex = next;              // readIndex to next offset.
-
-#ifdef INC_FREERTOS_H
-    xSemaphoreGive(xWorkQueueMutex);
-#endif
+    work->moduleId = q->workArray[readIndex].moduleId;
+    work->operation = q->workArray[readIndex].operation;
+    work->argumentPointerOffset = q->workArray[readIndex].argumentPointerOffset;
+    __DMB();
+    q->readIndex = WorkQueueNext(readIndex);              // readIndex to next offset.
     return 0;  // return success to indicate successful push.
 }
@@ -38,6 +38,8 @@
 #include "timer_hal.h"
 #include "FreeRTOS.h"
 #include "semphr.h"
+#include "task.h"
+#include "cm3.h"
 
 //#include "eta_devices_hm01b0_raw8_qvga.h"
 #include "eta_devices_hm01b0_raw8_324x324_monochrome_5fps.h"
@@ -53,6 +55,32 @@
 #define VSYNC_LOW_GPIOIRQ 0
 #define VSYNC_HIGH_GPIOIRQ 1
 
+//
+// GPIO input and interrupt masking used by the capture loop, can be
+// overridden to replay recorded GPIO traces.
+//
+#ifndef HM01B0_GPIO_IN
+#define HM01B0_GPIO_IN()     (REG_GPIO_DATA_IN.V)
+#endif
+#ifndef HM01B0_IRQ_DISABLE
+#define HM01B0_IRQ_DISABLE() __asm volatile( "cpsid i" ::: "memory" )
+#define HM01B0_IRQ_ENABLE()  __asm volatile( "cpsie i" ::: "memory" )
+#endif
+
+//
+// Free running cycle count, every line start is checked against the line
+// period so lines missed while interrupts were enabled fail the frame.
+//
+#ifndef HM01B0_CYCLES
+#define HM01B0_DWT_CTRL     (*(volatile uint32_t *)0xE0001000)
+#define HM01B0_DWT_CYCCNT   (*(volatile uint32_t *)0xE0001004)
+#define HM01B0_CYCLES_ENABLE() do { \
+        CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA; \
+        HM01B0_DWT_CTRL |= 1; \
+    } while(0)
+#define HM01B0_CYCLES()     (HM01B0_DWT_CYCCNT)
+#endif
+
 SemaphoreHandle_t xVSHSem =  NULL;
 SemaphoreHandle_t xVSLSem =  NULL;
 //
@@ -61,6 +89,16 @@ SemaphoreHandle_t xVSLSem =  NULL;
 static uint8_t g_ui8I2cAddress = CONFIG_HM01B0_I2C_ADDRESS;
 static uint8_t g_ui8I2cInstance = CONFIG_HM01B0_I2C_INSTANCE;
 
+//
+// Row buffer, used when rows are only handed to a consumer.
+//
+static int8_t g_pi8RowBuf[END_COLUMN - STARTING_COLUMN];
+
+//
+// Line timing of the last capture.
+//
+static tHm01b0LineStats g_sLineStats;
+
 
 //
 // Pin assignments.
@@ -199,24 +237,91 @@ EtaDevicesHm01b0FramesStream(uint8_t ui8Frames)
 
 /***************************************************************************//**
  *
- * _OneFrameRead - Read in one frame.
+ * _LineRead - Read in the pixels of one line, while HSYNC is high.
+ *
+ * @param pi8Row Where to store the line, NULL to skip it.
+ *
+ * @return The number of pixels stored.
  *
  ******************************************************************************/
 static inline uint32_t
-_OneFrameRead(int8_t *pui8Frame)
+_LineRead(int8_t *pi8Row)
+{
+    uint32_t ui32Pixels = 0;
+    uint16_t col = 0;
+
+    while((HM01B0_GPIO_IN() & g_sPins.ui32Hsync))
+    {
+        //
+        // Wait for PCLK to go high.
+        //
+        while(!(HM01B0_GPIO_IN() & g_sPins.ui32Pclk));
+
+        //
+        // Save pixel value.
+        //
+        if (pi8Row && (col >= STARTING_COLUMN) && (col < END_COLUMN))
+            pi8Row[ui32Pixels++] = ((HM01B0_GPIO_IN() >> g_sPins.iD0) - 128);
+
+        col++;
+
+        //
+        // Wait for PCLK to go low.
+        //
+        while(HM01B0_GPIO_IN() & g_sPins.ui32Pclk);
+    }
+
+    return(ui32Pixels);
+}
+
+/***************************************************************************//**
+ *
+ * _FrameRowsRead - Read in one frame, a line at a time.
+ *
+ * Interrupts are only masked while a line is clocked in. In the horizontal
+ * blanking between lines they are enabled again, and the row consumer (if
+ * any) is called, so it has to return before the next HSYNC.
+ *
+ * The first two lines are read with interrupts masked to measure the line
+ * period. Every following line start is checked against it, a line that
+ * started while interrupts were enabled, or a whole line that went by,
+ * fails the frame.
+ *
+ * @param pi8Frame Frame buffer, NULL to deliver all rows from one row buffer.
+ * @param pfnRow Row consumer, may be NULL.
+ * @param pvArg Passed to the row consumer.
+ *
+ * @return The number of pixels captured, 0 if lines were missed.
+ *
+ ******************************************************************************/
+static uint32_t
+_FrameRowsRead(int8_t *pi8Frame, tHm01b0RowCallback pfnRow, void *pvArg)
 {
     bool bExit;
     uint32_t ui32Pixels;
+    uint32_t ui32RowPixels;
+    uint32_t ui32Blank;
+    uint32_t ui32LineStart;
+    uint32_t ui32Now;
+    uint32_t ui32Lines;
     int32_t i32Ret = -1;
-    uint16_t row = 0 , col = 0;
+    uint16_t row = 0;
+    int8_t *pi8Row;
 
     //
-    // Initialize exit and pixel count.
+    // Initialize exit, pixel count and line timing.
     //
     bExit = false;
     ui32Pixels = 0;
+    g_sLineStats.ui32Rows = 0;
+    g_sLineStats.ui32LateRows = 0;
+    g_sLineStats.ui32MinBlank = UINT32_MAX;
+    g_sLineStats.ui32MaxBlank = 0;
+    g_sLineStats.ui32LinePeriod = 0;
+
+    HM01B0_CYCLES_ENABLE();
 
-    if(REG_GPIO_DATA_IN.V & g_sPins.ui32Vsync)
+    if(HM01B0_GPIO_IN() & g_sPins.ui32Vsync)
     {
         HalGpioIntClear(VSYNC_LOW_GPIOIRQ, CONFIG_HM01B0_VSYNC_GPIO);
         HalGpioIntEnable(VSYNC_LOW_GPIOIRQ, CONFIG_HM01B0_VSYNC_GPIO);
@@ -232,11 +337,17 @@ _OneFrameRead(int8_t *pui8Frame)
         i32Ret  = xSemaphoreTake(xVSHSem, 1);
     } while  (!i32Ret);
 
-    __asm volatile( "cpsid i" ::: "memory" );
+    //
+    // No task switches until the frame is in, a time slice taken in the
+    // blanking would cost lines. Interrupts are still served there.
+    //
+    vTaskSuspendAll();
+    HM01B0_IRQ_DISABLE();
     HalGpioIntDisable(VSYNC_HIGH_GPIOIRQ, CONFIG_HM01B0_VSYNC_GPIO);
 
     /*  Wait for Hsync */
-    while(!(REG_GPIO_DATA_IN.V & g_sPins.ui32Hsync));
+    while(!(HM01B0_GPIO_IN() & g_sPins.ui32Hsync));
+    ui32LineStart = HM01B0_CYCLES();
 
     //
     // Wait for exit.
@@ -245,39 +356,47 @@ _OneFrameRead(int8_t *pui8Frame)
         //
         // Save pixels while HSYNC is high.
         //
-        col = 0;
-        while((REG_GPIO_DATA_IN.V & g_sPins.ui32Hsync))
-        {
-            //
-            // Wait for PCLK to go high.
-            //
-            while(!(REG_GPIO_DATA_IN.V & g_sPins.ui32Pclk));
-
-            //
-            // Save pixel value.
-            //
-            if (((col >= STARTING_COLUMN) & (col < END_COLUMN)) && (row >= STARTING_ROW))
-                pui8Frame[ui32Pixels++] = ((REG_GPIO_DATA_IN.V >> g_sPins.iD0) - 128);
+        pi8Row = NULL;
+        if (row >= STARTING_ROW)
+            pi8Row = pi8Frame ? &pi8Frame[ui32Pixels] : g_pi8RowBuf;
 
-            col++;
+        ui32RowPixels = _LineRead(pi8Row);
 
-            //
-            // Wait for PCLK to go low.
-            //
-            while(REG_GPIO_DATA_IN.V & g_sPins.ui32Pclk);
+        //
+        // Horizontal blanking, once the line period is known let pending
+        // interrupts in and hand the row over.
+        //
+        if (g_sLineStats.ui32LinePeriod)
+            HM01B0_IRQ_ENABLE();
+        if (pi8Row)
+        {
+            if (pfnRow)
+                pfnRow(g_sLineStats.ui32Rows, pi8Row, ui32RowPixels, pvArg);
 
+            ui32Pixels += ui32RowPixels;
+            g_sLineStats.ui32Rows++;
         }
+        HM01B0_IRQ_DISABLE();
 
+        //
+        // HSYNC already high means the start of the next line was missed.
+        //
+        if (((row + 1) < END_ROW) && (HM01B0_GPIO_IN() & g_sPins.ui32Hsync))
+        {
+            g_sLineStats.ui32LateRows++;
+            break;
+        }
 
         //
         // Wait for HSYNC to go high.
         //
-        while((REG_GPIO_DATA_IN.V & g_sPins.ui32Hsync) == 0)
+        ui32Blank = 0;
+        while((HM01B0_GPIO_IN() & g_sPins.ui32Hsync) == 0)
         {
             //
             // Is VSYNC low as well?
             //
-            if((REG_GPIO_DATA_IN.V & g_sPins.ui32Vsync) == 0)
+            if((HM01B0_GPIO_IN() & g_sPins.ui32Vsync) == 0)
             {
                 //
                 // Exit.
@@ -285,18 +404,54 @@ _OneFrameRead(int8_t *pui8Frame)
                 bExit = true;
                 break;
             }
+            ui32Blank++;
         }
+
+        if (!bExit)
+        {
+            if (ui32Blank < g_sLineStats.ui32MinBlank)
+                g_sLineStats.ui32MinBlank = ui32Blank;
+            if (ui32Blank > g_sLineStats.ui32MaxBlank)
+                g_sLineStats.ui32MaxBlank = ui32Blank;
+
+            //
+            // Exactly one line period since the last line start, or lines
+            // went by while the consumer or an interrupt ran.
+            //
+            ui32Now = HM01B0_CYCLES();
+            if (g_sLineStats.ui32LinePeriod == 0)
+            {
+                g_sLineStats.ui32LinePeriod = ui32Now - ui32LineStart;
+            }
+            else
+            {
+                ui32Lines = (ui32Now - ui32LineStart +
+                             (g_sLineStats.ui32LinePeriod >> 1)) /
+                            g_sLineStats.ui32LinePeriod;
+                if (ui32Lines != 1)
+                {
+                    g_sLineStats.ui32LateRows += ui32Lines - 1;
+                    break;
+                }
+            }
+            ui32LineStart = ui32Now;
+        }
+
         row++;
         if (row >= END_ROW)
             bExit = true;
     }
     while(!bExit);
 
-    __asm volatile( "cpsie i" ::: "memory" );
+    HM01B0_IRQ_ENABLE();
+    xTaskResumeAll();
 
     //
-    // Return pixels saved.
+    // Return pixels saved, none if the frame is incomplete.
     //
+    if (g_sLineStats.ui32LateRows)
+        return(0);
+
     return(ui32Pixels);
 }
 
@@ -307,7 +462,7 @@ _OneFrameRead(int8_t *pui8Frame)
  * @param pui8Frame TODO
  * @param ui32DelayMs TODO
  *
- * @return The number of pixels captured.
+ * @return The number of pixels captured, 0 if lines were missed.
  *
  ******************************************************************************/
 uint32_t
@@ -325,9 +480,48 @@ EtaDevicesHm01b0OneFrameReadBlocking(int8_t *pui8Frame)
     //
     // Read the frame.
     //
-    ui32Pixels = _OneFrameRead(pui8Frame);
+    ui32Pixels = _FrameRowsRead(pui8Frame, NULL, NULL);
     //
     // Return the number of pixels captured.
     //
     return(ui32Pixels);
 }
+
+/***************************************************************************//**
+ *
+ * EtaDevicesHm01b0FrameRowsRead - Read one frame and hand each row to a
+ * consumer as soon as it is clocked in.
+ *
+ * @param pi8Frame Frame buffer, or NULL to only deliver rows to pfnRow.
+ * @param pfnRow Row consumer, called between lines with interrupts enabled.
+ * @param pvArg Passed to the row consumer.
+ *
+ * @return The number of pixels captured, 0 if lines were missed.
+ *
+ ******************************************************************************/
+uint32_t
+EtaDevicesHm01b0FrameRowsRead(int8_t *pi8Frame, tHm01b0RowCallback pfnRow,
+                              void *pvArg)
+{
+#ifndef CONFIG_STREAMING_MODE
+    //
+    // Trigger a frame.
+    //
+    EtaDevicesHm01b0FramesStream(1);
+#endif
+
+    return(_FrameRowsRead(pi8Frame, pfnRow, pvArg));
+}
+
+/***************************************************************************//**
+ *
+ * EtaDevicesHm01b0LineStatsGet - Get the line timing of the last capture.
+ *
+ * @param psStats Where to store the line timing.
+ *
+ ******************************************************************************/
+void
+EtaDevicesHm01b0LineStatsGet(tHm01b0LineStats *psStats)
+{
+    *psStats = g_sLineStats;
+}
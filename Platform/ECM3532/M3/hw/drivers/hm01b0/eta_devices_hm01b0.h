@@ -173,6 +173,27 @@ tHm01b0Pins;
 #define AE_CTRL_ENABLE    0x00
 #define AE_CTRL_DISABLE   0x01
 
+//
+// Row consumer, called with each captured row. Runs in the horizontal
+// blanking, so has to return before the next line starts.
+//
+typedef void (*tHm01b0RowCallback)(uint32_t ui32Row, const int8_t *pi8Row,
+                                   uint32_t ui32Cols, void *pvArg);
+
+//
+// Line timing of the last capture. Blanking is counted in GPIO polls, the
+// line period in CPU cycles. Late rows are lines missed, the frame failed.
+//
+typedef struct
+{
+    uint32_t ui32Rows;
+    uint32_t ui32LateRows;
+    uint32_t ui32MinBlank;
+    uint32_t ui32MaxBlank;
+    uint32_t ui32LinePeriod;
+}
+tHm01b0LineStats;
+
 typedef enum
 {
     eHm01b0ModeStandby    = 0x0,
@@ -191,6 +212,11 @@ void EtaDevicesHm01b0Init(void);
 
 uint32_t EtaDevicesHm01b0OneFrameReadBlocking(int8_t *pui8Frame);
 
+uint32_t EtaDevicesHm01b0FrameRowsRead(int8_t *pi8Frame, tHm01b0RowCallback pfnRow,
+                                       void *pvArg);
+
+void EtaDevicesHm01b0LineStatsGet(tHm01b0LineStats *psStats);
+
 #ifdef __cplusplus
 }
 
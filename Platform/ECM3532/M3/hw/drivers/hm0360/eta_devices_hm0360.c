@@ -38,6 +38,8 @@
 #include "timer_hal.h"
 #include "FreeRTOS.h"
 #include "semphr.h"
+#include "task.h"
+#include "cm3.h"
 #include "print_util.h"
 
 #ifdef CONFIG_QQVGA_MODE
@@ -57,6 +59,32 @@
 #define VSYNC_LOW_GPIOIRQ 0
 #define VSYNC_HIGH_GPIOIRQ 1
 
+//
+// GPIO input and interrupt masking used by the capture loop, can be
+// overridden to replay recorded GPIO traces.
+//
+#ifndef HM0360_GPIO_IN
+#define HM0360_GPIO_IN()     (REG_GPIO_DATA_IN.V)
+#endif
+#ifndef HM0360_IRQ_DISABLE
+#define HM0360_IRQ_DISABLE() __asm volatile( "cpsid i" ::: "memory" )
+#define HM0360_IRQ_ENABLE()  __asm volatile( "cpsie i" ::: "memory" )
+#endif
+
+//
+// Free running cycle count, every line start is checked against the line
+// period so lines missed while interrupts were enabled fail the frame.
+//
+#ifndef HM0360_CYCLES
+#define HM0360_DWT_CTRL     (*(volatile uint32_t *)0xE0001000)
+#define HM0360_DWT_CYCCNT   (*(volatile uint32_t *)0xE0001004)
+#define HM0360_CYCLES_ENABLE() do { \
+        CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA; \
+        HM0360_DWT_CTRL |= 1; \
+    } while(0)
+#define HM0360_CYCLES()     (HM0360_DWT_CYCCNT)
+#endif
+
 SemaphoreHandle_t xVSHSem =  NULL;
 SemaphoreHandle_t xVSLSem =  NULL;
 
@@ -66,6 +94,16 @@ SemaphoreHandle_t xVSLSem =  NULL;
 static uint8_t g_ui8I2cAddress = CONFIG_HM0360_I2C_ADDRESS;
 static uint8_t g_ui8I2cInstance = CONFIG_HM0360_I2C_INSTANCE;
 
+//
+// Row buffer, used when rows are only handed to a consumer.
+//
+static uint8_t g_pui8RowBuf[END_COLUMN - STARTING_COLUMN];
+
+//
+// Line timing of the last capture.
+//
+static tHm0360LineStats g_sLineStats;
+
 //
 // Pin assignments.
 //
@@ -204,28 +242,99 @@ EtaDevicesHm0360FrameStream(void)
 
 /***************************************************************************//**
  *
- * _OneFrameRead - Read in one frame.
+ * _LineRead - Read in the pixels of one line, while HSYNC is high.
+ *
+ * @param pui8Row Where to store the line, NULL to skip it.
+ *
+ * @return The number of pixels stored.
  *
  ******************************************************************************/
-
 static inline uint32_t
-_OneFrameRead(uint8_t *pui8Frame)
+_LineRead(uint8_t *pui8Row)
+{
+    uint32_t ui32Pixels = 0;
+    uint16_t col = 0;
+    int32_t iVal;
+
+    do
+    {
+        //
+        // Wait for PCLK to go high.
+        //
+        do
+        {
+            iVal = HM0360_GPIO_IN();
+        } while (!(iVal & g_sPins.ui32Pclk));
+
+        //
+        // Save pixel value.
+        //
+        if (pui8Row && (col < END_COLUMN))
+            pui8Row[ui32Pixels++] = (iVal >> CONFIG_HM0360_D0_PIN);
+
+        ++col;
+
+        //
+        // Wait for PCLK to go low.
+        //
+        do
+        {
+            iVal = HM0360_GPIO_IN();
+        } while ((iVal & g_sPins.ui32Pclk));
+
+    } while ((iVal & g_sPins.ui32Hsync));
+
+    return(ui32Pixels);
+}
+
+/***************************************************************************//**
+ *
+ * _FrameRowsRead - Read in one frame, a line at a time.
+ *
+ * Interrupts are only masked while a line is clocked in. In the horizontal
+ * blanking between lines they are enabled again, and the row consumer (if
+ * any) is called, so it has to return before the next HSYNC.
+ *
+ * The first two lines are read with interrupts masked to measure the line
+ * period. Every following line start is checked against it, a line that
+ * started while interrupts were enabled, or a whole line that went by,
+ * fails the frame.
+ *
+ * @param pui8Frame Frame buffer, NULL to deliver all rows from one row buffer.
+ * @param pfnRow Row consumer, may be NULL.
+ * @param pvArg Passed to the row consumer.
+ *
+ * @return The number of pixels captured, 0 if lines were missed.
+ *
+ ******************************************************************************/
+static uint32_t
+_FrameRowsRead(uint8_t *pui8Frame, tHm0360RowCallback pfnRow, void *pvArg)
 {
     bool bExit;
     uint32_t ui32Pixels;
+    uint32_t ui32RowPixels;
+    uint32_t ui32Blank;
+    uint32_t ui32LineStart;
+    uint32_t ui32Now;
+    uint32_t ui32Lines;
     int32_t i32Ret = -1;
-    uint16_t row = 0 , col = 0;
-    uint32_t lscycle = 0, lecycle = 0;
-    uint32_t pscycle = 0, pecycle = 0;
-    int32_t iVal;
+    uint16_t row = 0;
+    uint8_t *pui8Row;
 
     //
-    // Initialize exit and pixel count.
+    // Initialize exit, pixel count and line timing.
     //
     bExit = false;
     ui32Pixels = 0;
+    g_sLineStats.ui32Rows = 0;
+    g_sLineStats.ui32LateRows = 0;
+    g_sLineStats.ui32MinBlank = UINT32_MAX;
+    g_sLineStats.ui32MaxBlank = 0;
+    g_sLineStats.ui32LinePeriod = 0;
+
+    HM0360_CYCLES_ENABLE();
 
-    if(REG_GPIO_DATA_IN.V & g_sPins.ui32Vsync)
+    if(HM0360_GPIO_IN() & g_sPins.ui32Vsync)
     {
         HalGpioIntClear(VSYNC_LOW_GPIOIRQ, CONFIG_HM0360_VSYNC_GPIO);
         HalGpioIntEnable(VSYNC_LOW_GPIOIRQ, CONFIG_HM0360_VSYNC_GPIO);
@@ -241,11 +350,17 @@ _OneFrameRead(uint8_t *pui8Frame)
         i32Ret  = xSemaphoreTake(xVSHSem, 1);
     } while  (!i32Ret);
 
-    __asm volatile( "cpsid i" ::: "memory" );
+    //
+    // No task switches until the frame is in, a time slice taken in the
+    // blanking would cost lines. Interrupts are still served there.
+    //
+    vTaskSuspendAll();
+    HM0360_IRQ_DISABLE();
     HalGpioIntDisable(VSYNC_HIGH_GPIOIRQ, CONFIG_HM0360_VSYNC_GPIO);
 
     /*  Wait for Hsync */
-    while(!(REG_GPIO_DATA_IN.V & g_sPins.ui32Hsync));
+    while(!(HM0360_GPIO_IN() & g_sPins.ui32Hsync));
+    ui32LineStart = HM0360_CYCLES();
 
     //
     // Wait for exit.
@@ -254,47 +369,47 @@ _OneFrameRead(uint8_t *pui8Frame)
         //
         // Save pixels while HSYNC is high.
         //
-        col = 0;
-        do
-        {
-            //
-            // Wait for PCLK to go high.
-            //
-            do
-            {
-                iVal = REG_GPIO_DATA_IN.V;
-            } while (!(iVal & g_sPins.ui32Pclk));
+        pui8Row = NULL;
+        if (row >= STARTING_ROW)
+            pui8Row = pui8Frame ? &pui8Frame[ui32Pixels] : g_pui8RowBuf;
 
-            //
-            // Save pixel value.
-            //
-            if ( col < END_COLUMN)
-                pui8Frame[ui32Pixels++] = (iVal >> CONFIG_HM0360_D0_PIN);
-
-            ++col;
-
-            //
-            // Wait for PCLK to go low.
-            //
-            //while(REG_GPIO_DATA_IN.V & g_sPins.ui32Pclk);
-            do
-            {
-                iVal = REG_GPIO_DATA_IN.V;
-            } while ((iVal & g_sPins.ui32Pclk));
+        ui32RowPixels = _LineRead(pui8Row);
 
+        //
+        // Horizontal blanking, once the line period is known let pending
+        // interrupts in and hand the row over.
+        //
+        if (g_sLineStats.ui32LinePeriod)
+            HM0360_IRQ_ENABLE();
+        if (pui8Row)
+        {
+            if (pfnRow)
+                pfnRow(g_sLineStats.ui32Rows, pui8Row, ui32RowPixels, pvArg);
 
-        } while ((iVal & g_sPins.ui32Hsync));
+            ui32Pixels += ui32RowPixels;
+            g_sLineStats.ui32Rows++;
+        }
+        HM0360_IRQ_DISABLE();
 
+        //
+        // HSYNC already high means the start of the next line was missed.
+        //
+        if (((row + 1) < END_ROW) && (HM0360_GPIO_IN() & g_sPins.ui32Hsync))
+        {
+            g_sLineStats.ui32LateRows++;
+            break;
+        }
 
         //
         // Wait for HSYNC to go high.
         //
-        while((REG_GPIO_DATA_IN.V & g_sPins.ui32Hsync) == 0)
+        ui32Blank = 0;
+        while((HM0360_GPIO_IN() & g_sPins.ui32Hsync) == 0)
         {
             //
             // Is VSYNC low as well?
             //
-            if((REG_GPIO_DATA_IN.V & g_sPins.ui32Vsync) == 0)
+            if((HM0360_GPIO_IN() & g_sPins.ui32Vsync) == 0)
             {
                 //
                 // Exit.
@@ -302,18 +417,54 @@ _OneFrameRead(uint8_t *pui8Frame)
                 bExit = true;
                 break;
             }
+            ui32Blank++;
+        }
+
+        if (!bExit)
+        {
+            if (ui32Blank < g_sLineStats.ui32MinBlank)
+                g_sLineStats.ui32MinBlank = ui32Blank;
+            if (ui32Blank > g_sLineStats.ui32MaxBlank)
+                g_sLineStats.ui32MaxBlank = ui32Blank;
+
+            //
+            // Exactly one line period since the last line start, or lines
+            // went by while the consumer or an interrupt ran.
+            //
+            ui32Now = HM0360_CYCLES();
+            if (g_sLineStats.ui32LinePeriod == 0)
+            {
+                g_sLineStats.ui32LinePeriod = ui32Now - ui32LineStart;
+            }
+            else
+            {
+                ui32Lines = (ui32Now - ui32LineStart +
+                             (g_sLineStats.ui32LinePeriod >> 1)) /
+                            g_sLineStats.ui32LinePeriod;
+                if (ui32Lines != 1)
+                {
+                    g_sLineStats.ui32LateRows += ui32Lines - 1;
+                    break;
+                }
+            }
+            ui32LineStart = ui32Now;
         }
+
         ++row;
         if (row >= END_ROW)
             bExit = true;
 
     } while(!bExit);
 
-    __asm volatile( "cpsie i" ::: "memory" );
+    HM0360_IRQ_ENABLE();
+    xTaskResumeAll();
 
     //
-    // Return pixels saved.
+    // Return pixels saved, none if the frame is incomplete.
     //
+    if (g_sLineStats.ui32LateRows)
+        return(0);
+
     return(ui32Pixels);
 }
 
@@ -324,7 +475,7 @@ _OneFrameRead(uint8_t *pui8Frame)
  * @param pui8Frame TODO
  * @param ui32DelayMs TODO
  *
- * @return The number of pixels captured.
+ * @return The number of pixels captured, 0 if lines were missed.
  *
  ******************************************************************************/
 uint32_t
@@ -344,7 +495,7 @@ EtaDevicesHm0360OneFrameReadBlocking(uint8_t *pui8Frame)
     //
     // Read the frame.
     //
-    ui32Pixels = _OneFrameRead(pui8Frame);
+    ui32Pixels = _FrameRowsRead(pui8Frame, NULL, NULL);
 
 #ifndef CONFIG_STREAMING_MODE
     Hm0360RegWrite(HM0360_MODE_SELECT, 0);
@@ -354,3 +505,51 @@ EtaDevicesHm0360OneFrameReadBlocking(uint8_t *pui8Frame)
     //
     return(ui32Pixels);
 }
+
+/***************************************************************************//**
+ *
+ * EtaDevicesHm0360FrameRowsRead - Read one frame and hand each row to a
+ * consumer as soon as it is clocked in.
+ *
+ * @param pui8Frame Frame buffer, or NULL to only deliver rows to pfnRow.
+ * @param pfnRow Row consumer, called between lines with interrupts enabled.
+ * @param pvArg Passed to the row consumer.
+ *
+ * @return The number of pixels captured, 0 if lines were missed.
+ *
+ ******************************************************************************/
+uint32_t
+EtaDevicesHm0360FrameRowsRead(uint8_t *pui8Frame, tHm0360RowCallback pfnRow,
+                              void *pvArg)
+{
+    uint32_t ui32Pixels;
+
+#ifndef CONFIG_STREAMING_MODE
+    //
+    // Trigger a frame.
+    //
+    while(HM0360_GPIO_IN() & g_sPins.ui32Vsync);
+    EtaDevicesHm0360FrameStream();
+#endif
+
+    ui32Pixels = _FrameRowsRead(pui8Frame, pfnRow, pvArg);
+
+#ifndef CONFIG_STREAMING_MODE
+    Hm0360RegWrite(HM0360_MODE_SELECT, 0);
+#endif
+
+    return(ui32Pixels);
+}
+
+/***************************************************************************//**
+ *
+ * EtaDevicesHm0360LineStatsGet - Get the line timing of the last capture.
+ *
+ * @param psStats Where to store the line timing.
+ *
+ ******************************************************************************/
+void
+EtaDevicesHm0360LineStatsGet(tHm0360LineStats *psStats)
+{
+    *psStats = g_sLineStats;
+}
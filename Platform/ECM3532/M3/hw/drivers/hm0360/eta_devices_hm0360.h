@@ -155,6 +155,27 @@ tHm0360Mode;
 #define HM0360_ANA_PLL1CFG          (0x3500)
 
 
+//
+// Row consumer, called with each captured row. Runs in the horizontal
+// blanking, so has to return before the next line starts.
+//
+typedef void (*tHm0360RowCallback)(uint32_t ui32Row, const uint8_t *pui8Row,
+                                   uint32_t ui32Cols, void *pvArg);
+
+//
+// Line timing of the last capture. Blanking is counted in GPIO polls, the
+// line period in CPU cycles. Late rows are lines missed, the frame failed.
+//
+typedef struct
+{
+    uint32_t ui32Rows;
+    uint32_t ui32LateRows;
+    uint32_t ui32MinBlank;
+    uint32_t ui32MaxBlank;
+    uint32_t ui32LinePeriod;
+}
+tHm0360LineStats;
+
 /*******************************************************************************
  *
  * External function definitions.
@@ -164,6 +185,11 @@ void EtaDevicesHm0360Init(void);
 
 uint32_t EtaDevicesHm0360OneFrameReadBlocking(uint8_t *pui8Frame);
 
+uint32_t EtaDevicesHm0360FrameRowsRead(uint8_t *pui8Frame, tHm0360RowCallback pfnRow,
+                                       void *pvArg);
+
+void EtaDevicesHm0360LineStatsGet(tHm0360LineStats *psStats);
+
 #ifdef __cplusplus
 }
 
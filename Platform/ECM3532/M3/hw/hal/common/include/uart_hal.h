@@ -124,6 +124,21 @@ typedef void (*tHalUartRxDoneCb)(void *);
  */
 typedef void (*tHalUartAsyncRecvCh)(uint8_t i8Ch);
 
+/**
+ * Function prototype for UART driver to ask for more data to transmit,
+ * required for HalUartTxFillStart. Callback should copy at most ui32Max
+ * bytes to pui8Buf and return the number of bytes copied, returning 0 ends
+ * the transfer.
+ * Callback will be called from Interrupt context, callback should
+ * do only minimum, no blocking routinue are allowed
+ * print is not allowed inside callack, will result in
+ * deadlock
+ *
+ * @return number of bytes copied to pui8Buf
+ */
+typedef uint32_t (*tHalUartTxFillCb)(uint8_t *pui8Buf, uint32_t ui32Max,
+                                     void *vArg);
+
 /**
  * Register Asynchronous receive callback
  *
@@ -211,6 +226,31 @@ int32_t HalUartReadBuf(uint8_t ui8Port, uint8_t *ui8RxBuf,
 int32_t HalUartWriteBuf(uint8_t ui8Port, uint8_t *ui8TxBuf,
                         uint32_t ui32TxCnt, tHalUartTxDoneCb fTxDoneCb,
                         void *vCbArg);
+
+/**
+ * Start interrupt driven transmit from a caller owned buffer
+ *
+ * TX FIFO is refilled from TX interrupt by calling fTxFillCb, until it
+ * returns 0. Calling again while the transfer is running does nothing,
+ * so caller can queue more data and call this after every write
+ *
+ * @param ui8Port   UART port number
+ * @param fTxFillCb callback to get data to transmit, called from ISR
+ * @param vCbArg    Argument to be called as parameter of fill callback
+ *
+ * @return 0 on success, -EBUSY if a HalUartWriteBuf transfer is running
+ */
+int32_t HalUartTxFillStart(uint8_t ui8Port, tHalUartTxFillCb fTxFillCb,
+                           void *vCbArg);
+
+/**
+ * Check if a transfer started with HalUartTxFillStart is running
+ *
+ * @param ui8Port   UART port number
+ *
+ * @return 1 if running, 0 otherwise
+ */
+int32_t HalUartTxFillBusy(uint8_t ui8Port);
 #ifdef __cplusplus
 }
 #endif
@@ -48,9 +48,11 @@ typedef struct {
     int32_t ui32UTxCnt;
     int32_t ui32URxCnt;
     tHalUartTxDoneCb fTxDone;
+    tHalUartTxFillCb fTxFill;
     tHalUartRxDoneCb fRxDone;
     void *vRxCbArg;
     void *vTxCbArg;
+    void *vTxFillArg;
     tHalUartAsyncRecvCh fRxAsyncCb[CONFIG_UART_ASYNC_RECV_MAX_CNT];
     uint8_t ui8AsyncRecvCnt;
     tUart sCspUdev;
@@ -148,6 +150,7 @@ ECM3531UartIsr(uint8_t ui8Port)
     uint8_t ui8Cnt, ui8data;
     uint8_t tx_fifo_cur_level = 0;
     uint8_t tx_fifo_space = 0;
+    uint8_t ui8TxFill[TX_FIFO_SZ];
     long lHigherPriorityTaskWoken = pdFALSE;
 
     sUp = &sUPort[UART_INDEX(ui8Port)];
@@ -204,7 +207,23 @@ ECM3531UartIsr(uint8_t ui8Port)
     if ((ui32Data & BM_UART_INT_STAT_TX_IDLE) ||
             (ui32Data & BM_UART_INT_STAT_TX_FIFO_LWM))
     {
-        if(sUp->u8TxStarted)
+        if(sUp->fTxFill)
+        {
+            REGN_W2(ui8Port, UART_INT_STAT_CLEAR,
+                    TX_IDLE, 1, TX_FIFO_LWM, 1);
+
+            /* refill from caller buffer, stop once it has nothing left */
+            tx_fifo_space = TX_FIFO_SZ - REG_UART_TX_FIFO(ui8Port).BF.COUNT;
+            ui8Cnt = sUp->fTxFill(ui8TxFill, tx_fifo_space, sUp->vTxFillArg);
+            if (ui8Cnt) {
+                EtaCspUartTx(&sUp->sCspUdev, (char *)ui8TxFill, ui8Cnt);
+            } else {
+                ECM3531UartDisTxInt(ui8Port);
+                sUp->fTxFill = NULL;
+                sUp->u8TxStarted = 0;
+            }
+        }
+        else if(sUp->u8TxStarted)
         {
             REGN_W2(ui8Port, UART_INT_STAT_CLEAR,
                     TX_IDLE, 1, TX_FIFO_LWM, 1);
@@ -416,6 +435,58 @@ int32_t HalUartWriteBuf(uint8_t ui8Port, uint8_t *ui8TxBuf,
     return i32Ret;
 }
 
+/*
+ * Start interrupt driven transmit, FIFO is refilled from
+ * fill callback till it returns 0
+ */
+int32_t HalUartTxFillStart(uint8_t ui8Port, tHalUartTxFillCb fTxFillCb,
+                           void *vCbArg)
+{
+    tECM3531Uart *sUp;
+    int32_t i32Ret = 0;
+    uint32_t ui32Cnt, ui32Space;
+    uint8_t ui8TxFill[TX_FIFO_SZ];
+
+    if ((ui8Port > CONFIG_UART_CNT) || (!fTxFillCb))
+        return -EINVAL;
+
+    sUp = &sUPort[UART_INDEX(ui8Port)];
+
+    /* keep the ISR from ending the transfer while checking it */
+    NVIC_DisableIRQ(UART0_IRQn + ui8Port);
+    if (sUp->fTxFill) {
+        /* running, ISR will pick up new data */
+    } else if (sUp->u8TxStarted) {
+        i32Ret = -EBUSY;
+    } else {
+        /* prime the FIFO, TX interrupt keeps it going from there */
+        ui32Space = TX_FIFO_SZ - REG_UART_TX_FIFO(ui8Port).BF.COUNT;
+        ui32Cnt = ui32Space ? fTxFillCb(ui8TxFill, ui32Space, vCbArg) : 0;
+        if (ui32Cnt)
+            EtaCspUartTx(&sUp->sCspUdev, (char *)ui8TxFill, ui32Cnt);
+        if (ui32Cnt || !ui32Space) {
+            sUp->fTxFill = fTxFillCb;
+            sUp->vTxFillArg = vCbArg;
+            sUp->u8TxStarted = 1;
+            ECM3531UartEnTxInt(ui8Port);
+        }
+    }
+    NVIC_EnableIRQ(UART0_IRQn + ui8Port);
+
+    return i32Ret;
+}
+
+/*
+ * Fill callback transfer running
+ */
+int32_t HalUartTxFillBusy(uint8_t ui8Port)
+{
+    if (ui8Port > CONFIG_UART_CNT)
+        return 0;
+
+    return (sUPort[UART_INDEX(ui8Port)].fTxFill != NULL);
+}
+
 /*
  * Read buffer from UART
  * Non blocking if callback is not NULL
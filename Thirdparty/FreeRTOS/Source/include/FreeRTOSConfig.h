@@ -83,6 +83,7 @@ to exclude the API function. */
 #define INCLUDE_vTaskSuspend			1
 #define INCLUDE_vTaskDelayUntil			0
 #define INCLUDE_vTaskDelay				1
+#define INCLUDE_uxTaskGetStackHighWaterMark	1
 #ifdef CONFIG_RTOS_SOFT_TIMER_PEND_CALL
 #define INCLUDE_xTimerPendFunctionCall  1
 #else
@@ -76,5 +76,12 @@
 #endif // CPU_ARC
 #endif // EI_CLASSIFIER_TFLITE_ENABLE_ARC
 
+// Keep the TFLite interpreter, tensor arena and op registrations resident
+// between inferences, instead of setting them up for every call to
+// run_inference(). Release them with run_classifier_deinit().
+#ifndef EI_CLASSIFIER_PERSISTENT_TFLITE
+#define EI_CLASSIFIER_PERSISTENT_TFLITE             0
+#endif // EI_CLASSIFIER_PERSISTENT_TFLITE
+
 // clang-format on
 #endif // _EI_CLASSIFIER_CONFIG_H_
@@ -58,6 +58,7 @@ typedef struct {
     int classification;
     int anomaly;
     int64_t dsp_us;
+    int64_t setup_us;
     int64_t classification_us;
     int64_t anomaly_us;
 } ei_impulse_result_timing_t;
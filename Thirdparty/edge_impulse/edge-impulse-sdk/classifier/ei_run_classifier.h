@@ -44,6 +44,7 @@
 #include "model-parameters/anomaly_clusters.h"
 #endif
 #include "ei_run_dsp.h"
+#include "ei_classifier_config.h"
 #include "ei_classifier_types.h"
 #include "ei_classifier_smooth.h"
 #include "ei_signal_with_axes.h"
@@ -135,13 +136,46 @@ static void calc_cepstral_mean_and_var_normalization_spectrogram(ei_matrix *matr
 
 /* Private variables ------------------------------------------------------- */
 #if EI_CLASSIFIER_LABEL_COUNT > 0
-ei_impulse_maf classifier_maf[EI_CLASSIFIER_LABEL_COUNT] = {{0}};
+ei_impulse_maf classifier_maf[EI_CLASSIFIER_LABEL_COUNT] = { };
 #else
 ei_impulse_maf classifier_maf[0];
 #endif
 
 static uint64_t classifier_continuous_features_written = 0;
 
+/* Sensor models (not audio or image) can run any DSP block continuously, the
+   latest window of raw samples is kept in a ring and the block runs over the
+   full window every slice */
+#if (EI_CLASSIFIER_SENSOR != EI_CLASSIFIER_SENSOR_MICROPHONE) && (EI_CLASSIFIER_SENSOR != EI_CLASSIFIER_SENSOR_CAMERA)
+#define EI_CLASSIFIER_HAS_CONTINUOUS_WINDOW     1
+static float classifier_continuous_window[EI_CLASSIFIER_DSP_INPUT_FRAME_SIZE];
+static size_t classifier_continuous_window_head = 0;
+static size_t classifier_continuous_window_written = 0;
+#else
+#define EI_CLASSIFIER_HAS_CONTINUOUS_WINDOW     0
+#endif
+
+#if (EI_CLASSIFIER_INFERENCING_ENGINE == EI_CLASSIFIER_TFLITE) && (EI_CLASSIFIER_PERSISTENT_TFLITE == 1)
+/**
+ * TFLite runtime state that stays resident between inferences
+ */
+typedef struct {
+    bool initialized;
+    TfLiteTensor *input;
+    TfLiteTensor *output;
+#if EI_CLASSIFIER_OBJDET_HAS_SCORE_TENSOR
+    TfLiteTensor *output_labels;
+    TfLiteTensor *output_scores;
+#endif
+#if (EI_CLASSIFIER_COMPILED != 1)
+    tflite::MicroInterpreter *interpreter;
+    uint8_t *tensor_arena;
+#endif
+} ei_tflite_persistent_state_t;
+
+static ei_tflite_persistent_state_t tflite_state;
+#endif // EI_CLASSIFIER_PERSISTENT_TFLITE
+
 /* Private functions ------------------------------------------------------- */
 
 /**
@@ -184,6 +218,66 @@ static void clear_moving_average_filter(ei_impulse_maf *maf)
     }
 }
 
+#if EI_CLASSIFIER_HAS_CONTINUOUS_WINDOW == 1
+/**
+ * @brief      Append a slice to the continuous window, overwriting the oldest
+ *             samples
+ *
+ * @param      signal  Slice of raw sample data
+ *
+ * @return     0 if ok, or the error from the signal
+ */
+static int classifier_continuous_window_push(signal_t *signal)
+{
+    size_t offset = 0;
+
+    while (offset < signal->total_length) {
+        size_t chunk = EI_CLASSIFIER_DSP_INPUT_FRAME_SIZE - classifier_continuous_window_head;
+        if (chunk > signal->total_length - offset) {
+            chunk = signal->total_length - offset;
+        }
+
+        int ret = signal->get_data(offset, chunk,
+            &classifier_continuous_window[classifier_continuous_window_head]);
+        if (ret != 0) {
+            return ret;
+        }
+
+        offset += chunk;
+        classifier_continuous_window_head += chunk;
+        if (classifier_continuous_window_head >= EI_CLASSIFIER_DSP_INPUT_FRAME_SIZE) {
+            classifier_continuous_window_head = 0;
+        }
+    }
+
+    classifier_continuous_window_written += signal->total_length;
+
+    return 0;
+}
+
+/**
+ * @brief      Get data from the continuous window, oldest sample first
+ */
+static int classifier_continuous_window_get_data(size_t offset, size_t length, float *out_ptr)
+{
+    size_t ix = (classifier_continuous_window_head + offset) % EI_CLASSIFIER_DSP_INPUT_FRAME_SIZE;
+
+    while (length > 0) {
+        size_t chunk = EI_CLASSIFIER_DSP_INPUT_FRAME_SIZE - ix;
+        if (chunk > length) {
+            chunk = length;
+        }
+
+        memcpy(out_ptr, &classifier_continuous_window[ix], chunk * sizeof(float));
+        out_ptr += chunk;
+        length -= chunk;
+        ix = 0;
+    }
+
+    return 0;
+}
+#endif // EI_CLASSIFIER_HAS_CONTINUOUS_WINDOW
+
 /**
  * @brief      Init static vars
  */
@@ -191,10 +285,51 @@ extern "C" void run_classifier_init(void)
 {
     classifier_continuous_features_written = 0;
     ei_dsp_clear_continuous_audio_state();
+#if EI_CLASSIFIER_HAS_CONTINUOUS_WINDOW == 1
+    classifier_continuous_window_head = 0;
+    classifier_continuous_window_written = 0;
+#endif
 
     for (size_t ix = 0; ix < EI_CLASSIFIER_LABEL_COUNT; ix++) {
         clear_moving_average_filter(&classifier_maf[ix]);
     }
+
+    // resolve spectral analysis configs now instead of on the first window
+    int (*spectral_analysis_fn)(signal_t *, matrix_t *, void *, const float) = &extract_spectral_analysis_features;
+    for (size_t ix = 0; ix < ei_dsp_blocks_size; ix++) {
+        if (ei_dsp_blocks[ix].extract_fn == spectral_analysis_fn) {
+            ei_dsp_prepare_spectral_analysis(
+                (ei_dsp_config_spectral_analysis_t *)ei_dsp_blocks[ix].config, EI_CLASSIFIER_FREQUENCY);
+        }
+    }
+
+#if defined(EI_CLASSIFIER_USE_QUANTIZED_DSP_BLOCK) && EI_CLASSIFIER_USE_QUANTIZED_DSP_BLOCK == 1
+    // and their fixed-point form, with the sample scale set so far
+    int (*spectral_analysis_i16_fn)(signal_i16_t *, matrix_i32_t *, void *, const float) = &extract_spectral_analysis_features;
+    for (size_t ix = 0; ix < ei_dsp_blocks_i16_size; ix++) {
+        if (ei_dsp_blocks_i16[ix].extract_fn == spectral_analysis_i16_fn) {
+            ei_dsp_spectral_prepared_entry_t *entry = ei_dsp_spectral_entry(
+                (ei_dsp_config_spectral_analysis_t *)ei_dsp_blocks_i16[ix].config, EI_CLASSIFIER_FREQUENCY);
+            if (entry) {
+                ei_dsp_prepare_spectral_analysis_fixed(entry, EI_CLASSIFIER_RAW_SAMPLE_COUNT);
+            }
+        }
+    }
+
+    // audio blocks have one axis, their window is the raw sample count
+    int (*mfe_i16_fn)(signal_i16_t *, matrix_i32_t *, void *, const float) = &extract_mfe_features;
+    int (*mfcc_i16_fn)(signal_i16_t *, matrix_i32_t *, void *, const float) = &extract_mfcc_features;
+    for (size_t ix = 0; ix < ei_dsp_blocks_i16_size; ix++) {
+        if (ei_dsp_blocks_i16[ix].extract_fn == mfe_i16_fn) {
+            ei_dsp_prepare_mfe_fixed((ei_dsp_config_mfe_t *)ei_dsp_blocks_i16[ix].config,
+                EI_CLASSIFIER_FREQUENCY, EI_CLASSIFIER_RAW_SAMPLE_COUNT);
+        }
+        else if (ei_dsp_blocks_i16[ix].extract_fn == mfcc_i16_fn) {
+            ei_dsp_prepare_mfe_fixed((ei_dsp_config_mfcc_t *)ei_dsp_blocks_i16[ix].config,
+                EI_CLASSIFIER_FREQUENCY, EI_CLASSIFIER_RAW_SAMPLE_COUNT);
+        }
+    }
+#endif
 }
 
 /**
@@ -225,6 +360,17 @@ extern "C" EI_IMPULSE_ERROR run_classifier_continuous(signal_t *signal, ei_impul
     bool is_mfe = false;
     bool is_spectrogram = false;
 
+#if EI_CLASSIFIER_HAS_CONTINUOUS_WINDOW == 1
+    if (classifier_continuous_window_push(signal) != 0) {
+        ei_printf("ERR: Failed to read slice data\n");
+        return EI_IMPULSE_DSP_ERROR;
+    }
+
+    signal_t window_signal;
+    window_signal.total_length = EI_CLASSIFIER_DSP_INPUT_FRAME_SIZE;
+    window_signal.get_data = &classifier_continuous_window_get_data;
+#endif
+
     for (size_t ix = 0; ix < ei_dsp_blocks_size; ix++) {
         ei_model_dsp_t block = ei_dsp_blocks[ix];
 
@@ -252,8 +398,37 @@ extern "C" EI_IMPULSE_ERROR run_classifier_continuous(signal_t *signal, ei_impul
             is_mfe = true;
         }
         else {
+#if EI_CLASSIFIER_HAS_CONTINUOUS_WINDOW == 1
+            /* No slice version, run the block over the latest window once it's full */
+            if (classifier_continuous_window_written >= EI_CLASSIFIER_DSP_INPUT_FRAME_SIZE) {
+#if EIDSP_SIGNAL_C_FN_POINTER
+                if (block.axes_size != EI_CLASSIFIER_RAW_SAMPLES_PER_FRAME) {
+                    ei_printf("ERR: EIDSP_SIGNAL_C_FN_POINTER can only be used when all axes are selected for DSP blocks\n");
+                    return EI_IMPULSE_DSP_ERROR;
+                }
+                int ret = block.extract_fn(&window_signal, &fm, block.config, EI_CLASSIFIER_FREQUENCY);
+#else
+                SignalWithAxes swa(&window_signal, block.axes, block.axes_size);
+                int ret = block.extract_fn(swa.get_signal(), &fm, block.config, EI_CLASSIFIER_FREQUENCY);
+#endif
+                if (ret != EIDSP_OK) {
+                    ei_printf("ERR: Failed to run DSP process (%d)\n", ret);
+                    return EI_IMPULSE_DSP_ERROR;
+                }
+
+                classifier_continuous_features_written += block.n_output_features;
+            }
+
+            if (ei_run_impulse_check_canceled() == EI_IMPULSE_CANCELED) {
+                return EI_IMPULSE_CANCELED;
+            }
+
+            out_features_index += block.n_output_features;
+            continue;
+#else
             ei_printf("ERR: Unknown extract function, only MFCC, MFE and spectrogram supported\n");
             return EI_IMPULSE_DSP_ERROR;
+#endif
         }
 
         matrix_size_t features_written;
@@ -299,9 +474,11 @@ extern "C" EI_IMPULSE_ERROR run_classifier_continuous(signal_t *signal, ei_impul
         dsp_start_us = ei_read_timer_us();
         ei::matrix_t classify_matrix(1, EI_CLASSIFIER_NN_INPUT_FRAME_SIZE);
 
-        /* Create a copy of the matrix for normalization */
+        /* Create a copy of the matrix for normalization, the DSP block keeps its frames
+           in a ring so unroll it here (oldest frame first) */
         for (size_t m_ix = 0; m_ix < EI_CLASSIFIER_NN_INPUT_FRAME_SIZE; m_ix++) {
-            classify_matrix.buffer[m_ix] = static_features_matrix.buffer[m_ix];
+            classify_matrix.buffer[m_ix] = static_features_matrix.buffer[
+                (ei_dsp_cont_features_head + m_ix) % EI_CLASSIFIER_NN_INPUT_FRAME_SIZE];
         }
 
         if (is_mfcc) {
@@ -596,6 +773,40 @@ __attribute__((unused)) static void fill_result_struct_f32(ei_impulse_result_t *
 
 #if (EI_CLASSIFIER_INFERENCING_ENGINE == EI_CLASSIFIER_TFLITE)
 
+#if (EI_CLASSIFIER_COMPILED != 1)
+/**
+ * Op resolver for the interpreter, built on first use. The interpreter keeps a
+ * reference to it, so it needs static storage, also when EI_TFLITE_RESOLVER
+ * declares 'resolver' as a local
+ *
+ * @return  The resolver
+ */
+static const tflite::MicroOpResolver& inference_tflite_resolver(void) {
+    static const tflite::MicroOpResolver *persistent_resolver = NULL;
+    if (persistent_resolver != NULL) {
+        return *persistent_resolver;
+    }
+
+#ifdef EI_TFLITE_RESOLVER
+    EI_TFLITE_RESOLVER
+#if defined(EI_CLASSIFIER_ENABLE_DETECTION_POSTPROCESS_OP)
+    resolver.AddCustom("TFLite_Detection_PostProcess", &post_process_op);
+#endif
+    // registrations are plain structs, copy them out of this frame
+    static decltype(resolver) resolver_copy(resolver);
+    persistent_resolver = &resolver_copy;
+#else
+    static tflite::AllOpsResolver resolver;
+#if defined(EI_CLASSIFIER_ENABLE_DETECTION_POSTPROCESS_OP)
+    resolver.AddCustom("TFLite_Detection_PostProcess", &post_process_op);
+#endif
+    persistent_resolver = &resolver;
+#endif
+
+    return *persistent_resolver;
+}
+#endif // EI_CLASSIFIER_COMPILED != 1
+
 /**
  * Setup the TFLite runtime
  *
@@ -616,12 +827,31 @@ static EI_IMPULSE_ERROR inference_tflite_setup(uint64_t *ctx_start_us, TfLiteTen
     tflite::MicroInterpreter** micro_interpreter,
 #endif
     uint8_t** micro_tensor_arena) {
+#if EI_CLASSIFIER_PERSISTENT_TFLITE == 1
+    if (tflite_state.initialized) {
+        *input = tflite_state.input;
+        *output = tflite_state.output;
+#if EI_CLASSIFIER_OBJDET_HAS_SCORE_TENSOR
+        *output_labels = tflite_state.output_labels;
+        *output_scores = tflite_state.output_scores;
+#endif
+#if (EI_CLASSIFIER_COMPILED != 1)
+        *micro_interpreter = tflite_state.interpreter;
+        *micro_tensor_arena = tflite_state.tensor_arena;
+#endif
+        *ctx_start_us = ei_read_timer_us();
+        return EI_IMPULSE_OK;
+    }
+#endif // EI_CLASSIFIER_PERSISTENT_TFLITE
+
 #if (EI_CLASSIFIER_COMPILED == 1)
     TfLiteStatus init_status = trained_model_init(ei_aligned_calloc);
     if (init_status != kTfLiteOk) {
         ei_printf("Failed to allocate TFLite arena (error code %d)\n", init_status);
         return EI_IMPULSE_TFLITE_ARENA_ALLOC_FAILED;
     }
+    // the compiled model owns its arena
+    *micro_tensor_arena = NULL;
 #else
     // Create an area of memory to use for input, output, and intermediate arrays.
     uint8_t *tensor_arena = (uint8_t*)ei_aligned_calloc(16, EI_CLASSIFIER_TFLITE_ARENA_SIZE);
@@ -632,8 +862,6 @@ static EI_IMPULSE_ERROR inference_tflite_setup(uint64_t *ctx_start_us, TfLiteTen
     *micro_tensor_arena = tensor_arena;
 #endif
 
-    *ctx_start_us = ei_read_timer_us();
-
     static bool tflite_first_run = true;
 
 #if (EI_CLASSIFIER_COMPILED != 1)
@@ -662,15 +890,8 @@ static EI_IMPULSE_ERROR inference_tflite_setup(uint64_t *ctx_start_us, TfLiteTen
 #endif
 
 #if (EI_CLASSIFIER_COMPILED != 1)
-#ifdef EI_TFLITE_RESOLVER
-    EI_TFLITE_RESOLVER
-#else
-    tflite::AllOpsResolver resolver;
-#endif
-#if defined(EI_CLASSIFIER_ENABLE_DETECTION_POSTPROCESS_OP)
-    resolver.AddCustom("TFLite_Detection_PostProcess", &post_process_op);
+    const tflite::MicroOpResolver& resolver = inference_tflite_resolver();
 #endif
-#endif // EI_CLASSIFIER_COMPILED != 1
 
 #if (EI_CLASSIFIER_COMPILED == 1)
     *input = trained_model_input(0);
@@ -723,6 +944,23 @@ static EI_IMPULSE_ERROR inference_tflite_setup(uint64_t *ctx_start_us, TfLiteTen
 #endif
         tflite_first_run = false;
     }
+
+#if EI_CLASSIFIER_PERSISTENT_TFLITE == 1
+    tflite_state.input = *input;
+    tflite_state.output = *output;
+#if EI_CLASSIFIER_OBJDET_HAS_SCORE_TENSOR
+    tflite_state.output_labels = *output_labels;
+    tflite_state.output_scores = *output_scores;
+#endif
+#if (EI_CLASSIFIER_COMPILED != 1)
+    tflite_state.interpreter = *micro_interpreter;
+    tflite_state.tensor_arena = *micro_tensor_arena;
+#endif
+    tflite_state.initialized = true;
+#endif // EI_CLASSIFIER_PERSISTENT_TFLITE
+
+    *ctx_start_us = ei_read_timer_us();
+
     return EI_IMPULSE_OK;
 }
 
@@ -732,7 +970,7 @@ static EI_IMPULSE_ERROR inference_tflite_setup(uint64_t *ctx_start_us, TfLiteTen
  * @param   ctx_start_us    Start time of the setup function (see above)
  * @param   output          Output tensor
  * @param   interpreter     TFLite interpreter (non-compiled models)
- * @param   tensor_arena    Allocated arena (will be freed)
+ * @param   tensor_arena    Allocated arena (will be freed, unless EI_CLASSIFIER_PERSISTENT_TFLITE is set)
  * @param   result          Struct for results
  * @param   debug           Whether to print debug info
  *
@@ -751,16 +989,21 @@ static EI_IMPULSE_ERROR inference_tflite_run(uint64_t ctx_start_us,
     ei_impulse_result_t *result,
     bool debug) {
 #if (EI_CLASSIFIER_COMPILED == 1)
+    (void)tensor_arena;
     trained_model_invoke();
 #else
     // Run inference, and report any error
     TfLiteStatus invoke_status = interpreter->Invoke();
     if (invoke_status != kTfLiteOk) {
         error_reporter->Report("Invoke failed (%d)\n", invoke_status);
+#if EI_CLASSIFIER_PERSISTENT_TFLITE != 1
         ei_aligned_free(tensor_arena);
+#endif
         return EI_IMPULSE_TFLITE_ERROR;
     }
+#if EI_CLASSIFIER_PERSISTENT_TFLITE != 1
     delete interpreter;
+#endif
 #endif
 
     uint64_t ctx_end_us = ei_read_timer_us();
@@ -796,11 +1039,13 @@ static EI_IMPULSE_ERROR inference_tflite_run(uint64_t ctx_start_us,
     }
 #endif
 
+#if EI_CLASSIFIER_PERSISTENT_TFLITE != 1
 #if (EI_CLASSIFIER_COMPILED == 1)
     trained_model_reset(ei_aligned_free);
 #else
     ei_aligned_free(tensor_arena);
 #endif
+#endif // EI_CLASSIFIER_PERSISTENT_TFLITE
 
     if (ei_run_impulse_check_canceled() == EI_IMPULSE_CANCELED) {
         return EI_IMPULSE_CANCELED;
@@ -810,6 +1055,28 @@ static EI_IMPULSE_ERROR inference_tflite_run(uint64_t ctx_start_us,
 }
 #endif // (EI_CLASSIFIER_INFERENCING_ENGINE == EI_CLASSIFIER_TFLITE)
 
+/**
+ * @brief      Release the inferencing runtime that is kept resident when
+ *             EI_CLASSIFIER_PERSISTENT_TFLITE is enabled. The next inference
+ *             will set it up again. No-op otherwise.
+ */
+extern "C" void run_classifier_deinit(void)
+{
+#if (EI_CLASSIFIER_INFERENCING_ENGINE == EI_CLASSIFIER_TFLITE) && (EI_CLASSIFIER_PERSISTENT_TFLITE == 1)
+    if (!tflite_state.initialized) {
+        return;
+    }
+
+#if (EI_CLASSIFIER_COMPILED == 1)
+    trained_model_reset(ei_aligned_free);
+#else
+    delete tflite_state.interpreter;
+    ei_aligned_free(tflite_state.tensor_arena);
+#endif
+    memset(&tflite_state, 0, sizeof(tflite_state));
+#endif
+}
+
 /**
  * @brief      Do inferencing over the processed feature matrix
  *
@@ -833,7 +1100,8 @@ extern "C" EI_IMPULSE_ERROR run_inference(
         TfLiteTensor* output_labels;
 #endif
         uint8_t* tensor_arena;
-        uint64_t ctx_start_us = ei_read_timer_us();
+        uint64_t setup_start_us = ei_read_timer_us();
+        uint64_t ctx_start_us;
 
 #if (EI_CLASSIFIER_COMPILED == 1)
         EI_IMPULSE_ERROR init_res = inference_tflite_setup(&ctx_start_us, &input, &output,
@@ -854,6 +1122,7 @@ extern "C" EI_IMPULSE_ERROR run_inference(
         if (init_res != EI_IMPULSE_OK) {
             return init_res;
         }
+        result->timing.setup_us = ctx_start_us - setup_start_us;
 
         // Place our calculated x value in the model's input tensor
 #if EI_CLASSIFIER_OBJDET_HAS_SCORE_TENSOR
@@ -1169,6 +1438,7 @@ extern "C" EI_IMPULSE_ERROR run_inference_i16(
 
 #if (EI_CLASSIFIER_INFERENCING_ENGINE == EI_CLASSIFIER_TFLITE)
     {
+        uint64_t setup_start_us = ei_read_timer_us();
         uint64_t ctx_start_us;
         TfLiteTensor* input;
         TfLiteTensor* output;
@@ -1186,22 +1456,25 @@ extern "C" EI_IMPULSE_ERROR run_inference_i16(
         if (init_res != EI_IMPULSE_OK) {
             return init_res;
         }
+        result->timing.setup_us = ctx_start_us - setup_start_us;
 
-        EIDSP_i16 scale;
-        numpy::float_to_int16(&input->params.scale, &scale, 1);
-
-        // Place our calculated x value in the model's input tensor
+        // Place our calculated x value in the model's input tensor, the features
+        // have EIDSP_I32_FEATURE_FRAC_BITS fractional bits
         bool int8_input = input->type == TfLiteType::kTfLiteInt8;
-        for (size_t ix = 0; ix < fmatrix->rows * fmatrix->cols; ix++) {
-            // Quantize the input if it is int8
-            if (int8_input) {
-                int32_t calc = (int32_t)fmatrix->buffer[ix] << 8; // Shift for scaler
-                calc /= scale;
-                calc += 0x80; // Round by adding 0.5
-                calc >>= 8; // Shift to int8_t domain
-                input->data.int8[ix] = static_cast<int8_t>(calc + input->params.zero_point);
-            } else {
-                numpy::int16_to_float((EIDSP_i16 *)&fmatrix->buffer[ix], &input->data.f[ix], 1);
+        if (int8_input) {
+            // quantize them in integer math, the multiplier is resolved once per scale
+            static float quantize_scale = 0.0f;
+            static fixed_multiplier_t quantize_multiplier;
+            if (input->params.scale != quantize_scale) {
+                numpy::fixed_multiplier_init(
+                    1.0f / (input->params.scale * (float)(1L << EIDSP_I32_FEATURE_FRAC_BITS)),
+                    &quantize_multiplier);
+                quantize_scale = input->params.scale;
+            }
+            numpy::quantize_i32_to_i8(fmatrix, input->data.int8, &quantize_multiplier, input->params.zero_point);
+        } else {
+            for (size_t ix = 0; ix < fmatrix->rows * fmatrix->cols; ix++) {
+                input->data.f[ix] = (float)fmatrix->buffer[ix] / (float)(1L << EIDSP_I32_FEATURE_FRAC_BITS);
             }
         }
 
@@ -1233,9 +1506,8 @@ extern "C" EI_IMPULSE_ERROR run_inference_i16(
 
         float input[EI_CLASSIFIER_ANOM_AXIS_SIZE];
         for (size_t ix = 0; ix < EI_CLASSIFIER_ANOM_AXIS_SIZE; ix++) {
-            // input[ix] = fmatrix->buffer[EI_CLASSIFIER_ANOM_AXIS[ix]];
-            // numpy::int16_to_float(&fmatrix->buffer[EI_CLASSIFIER_ANOM_AXIS[ix]], &input[ix], 1);
-            input[ix] = (float)fmatrix->buffer[EI_CLASSIFIER_ANOM_AXIS[ix]] / 32768.f;
+            // the clusters are float, only the few anomaly axes are converted
+            input[ix] = (float)fmatrix->buffer[EI_CLASSIFIER_ANOM_AXIS[ix]] / (float)(1L << EIDSP_I32_FEATURE_FRAC_BITS);
         }
         standard_scaler(input, ei_classifier_anom_scale, ei_classifier_anom_mean, EI_CLASSIFIER_ANOM_AXIS_SIZE);
         float anomaly = get_min_distance_to_cluster(
@@ -1412,7 +1684,7 @@ extern "C" EI_IMPULSE_ERROR run_classifier_i16(
     if (debug) {
         ei_printf("Features (%d ms.): ", result->timing.dsp);
         for (size_t ix = 0; ix < features_matrix.cols; ix++) {
-            ei_printf_float((float)features_matrix.buffer[ix] / 32768.f);
+            ei_printf_float((float)features_matrix.buffer[ix] / (float)(1L << EIDSP_I32_FEATURE_FRAC_BITS));
             ei_printf(" ");
         }
         ei_printf("\n");
@@ -1558,14 +1830,24 @@ __attribute__((unused)) static EI_IMPULSE_ERROR can_run_classifier_image_quantiz
 
 #if EI_CLASSIFIER_TFLITE_INPUT_QUANTIZED == 1 && EI_CLASSIFIER_INFERENCING_ENGINE == EI_CLASSIFIER_TFLITE
 /**
- * Special function to run the classifier on images, only works on TFLite models (either interpreter or EON)
- * that allocates a lot less memory by quantizing in place. This only works if 'can_run_classifier_image_quantized'
- * returns EI_IMPULSE_OK.
+ * Fill the quantized input tensor straight from a monochrome image source
+ * @param input Input tensor data
+ * @param input_size Input tensor size in bytes
+ * @param mono_lut Quantized value for every mono pixel value (256 entries)
+ * @param channels Values to write per pixel (1 or 3)
+ * @returns 0 if OK
  */
-extern "C" EI_IMPULSE_ERROR run_classifier_image_quantized(
+typedef int (*ei_image_mono_fill_fn)(int8_t *input, size_t input_size, const int8_t *mono_lut, size_t channels);
+
+/**
+ * Run the image classifier, input tensor either from the signal (quantized by the DSP
+ * block) or written directly by fill_fn when it's not NULL
+ */
+static EI_IMPULSE_ERROR run_classifier_image_quantized_impl(
     signal_t *signal,
+    ei_image_mono_fill_fn fill_fn,
     ei_impulse_result_t *result,
-    bool debug = false)
+    bool debug)
 {
     EI_IMPULSE_ERROR verify_res = can_run_classifier_image_quantized();
     if (verify_res != EI_IMPULSE_OK) {
@@ -1577,6 +1859,7 @@ extern "C" EI_IMPULSE_ERROR run_classifier_image_quantized(
 #if (EI_CLASSIFIER_INFERENCING_ENGINE != EI_CLASSIFIER_TFLITE)
     return EI_IMPULSE_UNSUPPORTED_INFERENCING_ENGINE;
 #else
+    uint64_t setup_start_us = ei_read_timer_us();
     uint64_t ctx_start_us;
     TfLiteTensor* input;
     TfLiteTensor* output;
@@ -1606,6 +1889,7 @@ extern "C" EI_IMPULSE_ERROR run_classifier_image_quantized(
     if (init_res != EI_IMPULSE_OK) {
         return init_res;
     }
+    result->timing.setup_us = ctx_start_us - setup_start_us;
 
     if (input->type != TfLiteType::kTfLiteInt8) {
         return EI_IMPULSE_ONLY_SUPPORTED_FOR_IMAGES;
@@ -1616,8 +1900,26 @@ extern "C" EI_IMPULSE_ERROR run_classifier_image_quantized(
     // features matrix maps around the input tensor to not allocate any memory
     ei::matrix_i8_t features_matrix(1, EI_CLASSIFIER_NN_INPUT_FRAME_SIZE, input->data.int8);
 
-    // run DSP process and quantize automatically
-    int ret = extract_image_features_quantized(signal, &features_matrix, ei_dsp_blocks[0].config, EI_CLASSIFIER_FREQUENCY);
+    int ret;
+    if (fill_fn) {
+        static int8_t mono_lut[256];
+        static size_t mono_lut_channels = 0;
+
+        if (mono_lut_channels == 0) {
+            ret = extract_image_features_quantized_mono_lut(ei_dsp_blocks[0].config, mono_lut, &mono_lut_channels);
+            if (ret != EIDSP_OK) {
+                ei_printf("ERR: Failed to run DSP process (%d)\n", ret);
+                return EI_IMPULSE_DSP_ERROR;
+            }
+        }
+
+        // source writes the quantized image into the input tensor
+        ret = fill_fn(input->data.int8, EI_CLASSIFIER_NN_INPUT_FRAME_SIZE, mono_lut, mono_lut_channels);
+    }
+    else {
+        // run DSP process and quantize automatically
+        ret = extract_image_features_quantized(signal, &features_matrix, ei_dsp_blocks[0].config, EI_CLASSIFIER_FREQUENCY);
+    }
     if (ret != EIDSP_OK) {
         ei_printf("ERR: Failed to run DSP process (%d)\n", ret);
         return EI_IMPULSE_DSP_ERROR;
@@ -1666,6 +1968,32 @@ extern "C" EI_IMPULSE_ERROR run_classifier_image_quantized(
     return EI_IMPULSE_OK;
 #endif // EI_CLASSIFIER_INFERENCING_ENGINE != EI_CLASSIFIER_TFLITE
 }
+
+/**
+ * Special function to run the classifier on images, only works on TFLite models (either interpreter or EON)
+ * that allocates a lot less memory by quantizing in place. This only works if 'can_run_classifier_image_quantized'
+ * returns EI_IMPULSE_OK.
+ */
+extern "C" EI_IMPULSE_ERROR run_classifier_image_quantized(
+    signal_t *signal,
+    ei_impulse_result_t *result,
+    bool debug = false)
+{
+    return run_classifier_image_quantized_impl(signal, NULL, result, debug);
+}
+
+/**
+ * Run the classifier on a monochrome image that fill_fn writes straight into the
+ * quantized input tensor, without going through a float signal. Same requirements
+ * as 'run_classifier_image_quantized'.
+ */
+extern "C" EI_IMPULSE_ERROR run_classifier_image_mono_quantized(
+    ei_image_mono_fill_fn fill_fn,
+    ei_impulse_result_t *result,
+    bool debug = false)
+{
+    return run_classifier_image_quantized_impl(NULL, fill_fn, result, debug);
+}
 #endif // #if EI_CLASSIFIER_TFLITE_INPUT_QUANTIZED == 1 && EI_CLASSIFIER_INFERENCING_ENGINE == EI_CLASSIFIER_TFLITE
 
 #if EIDSP_SIGNAL_C_FN_POINTER == 0
@@ -62,227 +62,381 @@ float ei_dsp_image_buffer[EI_DSP_IMAGE_BUFFER_STATIC_SIZE];
 static float *ei_dsp_cont_current_frame = nullptr;
 static size_t ei_dsp_cont_current_frame_size = 0;
 static int ei_dsp_cont_current_frame_ix = 0;
+// continuous mode keeps its feature frames in a ring instead of rolling the matrix,
+// this is the offset of the oldest frame (which is where the next frame goes)
+static size_t ei_dsp_cont_features_head = 0;
 
-__attribute__((unused)) int extract_spectral_analysis_features(signal_t *signal, matrix_t *output_matrix, void *config_ptr, const float frequency) {
-    ei_dsp_config_spectral_analysis_t config = *((ei_dsp_config_spectral_analysis_t*)config_ptr);
+/**
+ * Get the place to write `slice_size` new features into the continuous feature ring.
+ * Returns NULL if they would wrap around the end of the ring, the caller then
+ * computes into a scratch buffer and ei_dsp_cont_features_push() copies it over.
+ */
+static float *ei_dsp_cont_features_slot(matrix_t *ring, size_t slice_size) {
+    if (ei_dsp_cont_features_head + slice_size > ring->rows * ring->cols) {
+        return NULL;
+    }
+    return ring->buffer + ei_dsp_cont_features_head;
+}
 
-    int ret;
+/**
+ * Commit new features to the continuous feature ring, replacing the oldest ones
+ */
+static void ei_dsp_cont_features_push(matrix_t *ring, matrix_t *slice) {
+    size_t ring_size = ring->rows * ring->cols;
+    size_t slice_size = slice->rows * slice->cols;
 
-    const float sampling_freq = frequency;
+    if (ring_size == 0) {
+        return;
+    }
 
-    // input matrix from the raw signal
-    matrix_t input_matrix(signal->total_length / config.axes, config.axes);
-    if (!input_matrix.buffer) {
-        EIDSP_ERR(EIDSP_OUT_OF_MEM);
+    if (slice->buffer != ring->buffer + ei_dsp_cont_features_head) {
+        for (size_t ix = 0; ix < slice_size; ix++) {
+            ring->buffer[(ei_dsp_cont_features_head + ix) % ring_size] = slice->buffer[ix];
+        }
     }
 
-    signal->get_data(0, signal->total_length, input_matrix.buffer);
+    ei_dsp_cont_features_head = (ei_dsp_cont_features_head + slice_size) % ring_size;
+}
 
-    // scale the signal
-    ret = numpy::scale(&input_matrix, config.scale_axes);
-    if (ret != EIDSP_OK) {
-        ei_printf("ERR: Failed to scale signal (%d)\n", ret);
-        EIDSP_ERR(ret);
-    }
+// spectral analysis configs resolved once, more than this are resolved per call
+#ifndef EI_DSP_SPECTRAL_PREPARED_MAX
+#define EI_DSP_SPECTRAL_PREPARED_MAX        4
+#endif
 
-    // transpose the matrix so we have one row per axis (nifty!)
-    ret = numpy::transpose(&input_matrix);
-    if (ret != EIDSP_OK) {
-        ei_printf("ERR: Failed to transpose matrix (%d)\n", ret);
-        EIDSP_ERR(ret);
-    }
+// samples read from the signal at once when splitting it per axis
+#define EI_DSP_SPECTRAL_READ_FRAMES         32
 
-    // the spectral edges that we want to calculate
-    matrix_t edges_matrix_in(64, 1);
-    size_t edge_matrix_ix = 0;
+typedef struct {
+    const ei_dsp_config_spectral_analysis_t *config;
+    spectral::spectral_analysis_prepared_t prepared;
+    // fixed-point form for the i16 block, resolved on its first window
+    spectral::spectral_analysis_fixed_t fixed;
+} ei_dsp_spectral_prepared_entry_t;
 
-    char spectral_str[128] = { 0 };
-    if (strlen(config.spectral_power_edges) > sizeof(spectral_str) - 1) {
-        EIDSP_ERR(EIDSP_PARAMETER_INVALID);
+static ei_dsp_spectral_prepared_entry_t ei_dsp_spectral_prepared[EI_DSP_SPECTRAL_PREPARED_MAX];
+
+// MFE / MFCC configs resolved once for the i16 blocks, more than this are resolved per call
+#ifndef EI_DSP_MFE_FIXED_MAX
+#define EI_DSP_MFE_FIXED_MAX                2
+#endif
+
+typedef struct {
+    // ei_dsp_config_mfe_t or ei_dsp_config_mfcc_t
+    const void *config;
+    float frequency;
+    speechpy::mfe_fixed_t fixed;
+} ei_dsp_mfe_fixed_entry_t;
+
+static ei_dsp_mfe_fixed_entry_t ei_dsp_mfe_fixed[EI_DSP_MFE_FIXED_MAX];
+
+// value of one int16 sample step for the i16 DSP blocks, in the units the
+// float blocks get their samples in
+static float ei_dsp_i16_sample_scale = 1.0f;
+
+/**
+ * Set the value of one int16 sample step for the i16 (fixed-point) DSP blocks,
+ * e.g. the m/s2 per LSB of an accelerometer. The int16 features then match
+ * what the float blocks compute from sample * scale.
+ */
+__attribute__((unused)) static void ei_dsp_set_i16_sample_scale(float scale) {
+    if (scale == ei_dsp_i16_sample_scale) {
+        return;
     }
-    memcpy(spectral_str, config.spectral_power_edges, strlen(config.spectral_power_edges));
+    ei_dsp_i16_sample_scale = scale;
 
-    // convert spectral_power_edges (string) into float array
-    char *spectral_ptr = spectral_str;
-    while (spectral_ptr != NULL) {
-        while((*spectral_ptr) == ' ') {
-            spectral_ptr++;
-        }
+    for (size_t ix = 0; ix < EI_DSP_SPECTRAL_PREPARED_MAX; ix++) {
+        spectral::feature::release_spectral_analysis_fixed(&ei_dsp_spectral_prepared[ix].fixed);
+    }
+    for (size_t ix = 0; ix < EI_DSP_MFE_FIXED_MAX; ix++) {
+        speechpy::feature::release_mfe_fixed(&ei_dsp_mfe_fixed[ix].fixed);
+    }
+}
 
-        edges_matrix_in.buffer[edge_matrix_ix++] = atof(spectral_ptr);
+/**
+ * Parse a spectral_power_edges string ("0.1, 0.5, 1.0") into floats
+ */
+static int ei_dsp_parse_spectral_edges(const char *str, float *edges, size_t max_edges, size_t *edges_count) {
+    size_t count = 0;
+    const char *spectral_ptr = str;
 
-        // find next (spectral) delimiter (or '\0' character)
-        while((*spectral_ptr != ',')) {
+    while (spectral_ptr != NULL) {
+        while ((*spectral_ptr) == ' ') {
             spectral_ptr++;
-            if (*spectral_ptr == '\0') break;
         }
 
-        if (*spectral_ptr == '\0') {
-            spectral_ptr = NULL;
+        if (count == max_edges) {
+            EIDSP_ERR(EIDSP_PARAMETER_INVALID);
         }
-        else  {
+        edges[count++] = atof(spectral_ptr);
+
+        // find next (spectral) delimiter (or '\0' character)
+        spectral_ptr = strchr(spectral_ptr, ',');
+        if (spectral_ptr) {
             spectral_ptr++;
         }
     }
-    edges_matrix_in.rows = edge_matrix_ix;
 
-    // calculate how much room we need for the output matrix
-    size_t output_matrix_cols = spectral::feature::calculate_spectral_buffer_size(
-        true, config.spectral_peaks_count, edges_matrix_in.rows
-    );
-    // ei_printf("output_matrix_size %hux%zu\n", input_matrix.rows, output_matrix_cols);
-    if (output_matrix->cols * output_matrix->rows != static_cast<uint32_t>(output_matrix_cols * config.axes)) {
-        EIDSP_ERR(EIDSP_MATRIX_SIZE_MISMATCH);
-    }
+    *edges_count = count;
+    return EIDSP_OK;
+}
 
-    output_matrix->cols = output_matrix_cols;
-    output_matrix->rows = config.axes;
+/**
+ * Resolve a spectral analysis config: parse the edges, pick the filter and
+ * compute what does not depend on the signal
+ */
+static int ei_dsp_resolve_spectral_analysis(const ei_dsp_config_spectral_analysis_t *config, const float frequency,
+    spectral::spectral_analysis_prepared_t *prepared) {
+
+    float edges[EI_DSP_SPECTRAL_MAX_EDGES];
+    size_t edges_count;
+
+    prepared->bin_buckets = NULL;
+
+    int ret = ei_dsp_parse_spectral_edges(config->spectral_power_edges, edges, EI_DSP_SPECTRAL_MAX_EDGES, &edges_count);
+    if (ret != EIDSP_OK) {
+        EIDSP_ERR(ret);
+    }
 
     spectral::filter_t filter_type;
-    if (strcmp(config.filter_type, "low") == 0) {
+    if (strcmp(config->filter_type, "low") == 0) {
         filter_type = spectral::filter_lowpass;
     }
-    else if (strcmp(config.filter_type, "high") == 0) {
+    else if (strcmp(config->filter_type, "high") == 0) {
         filter_type = spectral::filter_highpass;
     }
     else {
         filter_type = spectral::filter_none;
     }
 
-    ret = spectral::feature::spectral_analysis(output_matrix, &input_matrix,
-        sampling_freq, filter_type, config.filter_cutoff, config.filter_order,
-        config.fft_length, config.spectral_peaks_count, config.spectral_peaks_threshold, &edges_matrix_in);
-    if (ret != EIDSP_OK) {
-        ei_printf("ERR: Failed to calculate spectral features (%d)\n", ret);
-        EIDSP_ERR(ret);
+    return spectral::feature::prepare_spectral_analysis(prepared, frequency,
+        filter_type, config->filter_cutoff, config->filter_order,
+        config->fft_length, config->spectral_peaks_count, config->spectral_peaks_threshold,
+        edges, edges_count);
+}
+
+/**
+ * Get the entry keeping a spectral analysis config, resolving it on first
+ * use. Returns NULL if it can't be kept, the caller then resolves it per call.
+ */
+static ei_dsp_spectral_prepared_entry_t *ei_dsp_spectral_entry(
+    const ei_dsp_config_spectral_analysis_t *config, const float frequency) {
+
+    ei_dsp_spectral_prepared_entry_t *free_entry = NULL;
+
+    for (size_t ix = 0; ix < EI_DSP_SPECTRAL_PREPARED_MAX; ix++) {
+        ei_dsp_spectral_prepared_entry_t *entry = &ei_dsp_spectral_prepared[ix];
+        if (entry->config == config && entry->prepared.sampling_freq == frequency) {
+            return entry;
+        }
+        if (!entry->config && !free_entry) {
+            free_entry = entry;
+        }
     }
 
-    // flatten again
-    output_matrix->cols = config.axes * output_matrix_cols;
-    output_matrix->rows = 1;
+    if (!free_entry) {
+        return NULL;
+    }
 
-    return EIDSP_OK;
-}
+    if (ei_dsp_resolve_spectral_analysis(config, frequency, &free_entry->prepared) != EIDSP_OK) {
+        spectral::feature::release_spectral_analysis(&free_entry->prepared);
+        return NULL;
+    }
+    free_entry->config = config;
 
-matrix_i16_t *create_edges_matrix(ei_dsp_config_spectral_analysis_t config, const float sampling_freq)
-{
-    // the spectral edges that we want to calculate
-    static matrix_i16_t edges_matrix_in(64, 1);
-    static bool matrix_created = false;
-    size_t edge_matrix_ix = 0;
+    return free_entry;
+}
 
-    if(matrix_created == false) {
+/**
+ * Get the resolved form of a spectral analysis config, resolving it on first
+ * use. Returns NULL if it can't be kept, the caller then resolves it per call.
+ */
+__attribute__((unused)) static const spectral::spectral_analysis_prepared_t *ei_dsp_prepare_spectral_analysis(
+    const ei_dsp_config_spectral_analysis_t *config, const float frequency) {
 
-        char spectral_str[128] = { 0 };
-        if (strlen(config.spectral_power_edges) > sizeof(spectral_str) - 1) {
-            return NULL;
-        }
-        memcpy(spectral_str, config.spectral_power_edges, strlen(config.spectral_power_edges));
+    ei_dsp_spectral_prepared_entry_t *entry = ei_dsp_spectral_entry(config, frequency);
 
-        // convert spectral_power_edges (string) into float array
-        char *spectral_ptr = spectral_str;
-        while (spectral_ptr != NULL) {
-            while((*spectral_ptr) == ' ') {
-                spectral_ptr++;
-            }
+    return entry ? &entry->prepared : NULL;
+}
 
-            float edge = (atof(spectral_ptr) / (float)(sampling_freq/2.f));
-            numpy::float_to_int16(&edge, &edges_matrix_in.buffer[edge_matrix_ix++], 1);
+/**
+ * Resolve the fixed-point form of a kept config for windows of `frames`
+ * samples per axis, if it isn't already
+ */
+static int ei_dsp_prepare_spectral_analysis_fixed(ei_dsp_spectral_prepared_entry_t *entry, size_t frames) {
+    if (entry->fixed.frames == frames) {
+        return EIDSP_OK;
+    }
 
-            // find next (spectral) delimiter (or '\0' character)
-            while((*spectral_ptr != ',')) {
-                spectral_ptr++;
-                if (*spectral_ptr == '\0') break;
-            }
+    spectral::feature::release_spectral_analysis_fixed(&entry->fixed);
 
-            if (*spectral_ptr == '\0') {
-                spectral_ptr = NULL;
-            }
-            else  {
-                spectral_ptr++;
-            }
-        }
-        edges_matrix_in.rows = edge_matrix_ix;
-        matrix_created = true;
+    int ret = spectral::feature::prepare_spectral_analysis_fixed(&entry->fixed, &entry->prepared,
+        frames, ei_dsp_i16_sample_scale * entry->config->scale_axes);
+    if (ret != EIDSP_OK) {
+        spectral::feature::release_spectral_analysis_fixed(&entry->fixed);
     }
 
-    return &edges_matrix_in;
+    return ret;
 }
 
-__attribute__((unused)) int extract_spectral_analysis_features(signal_i16_t *signal, matrix_i32_t *output_matrix, void *config_ptr, const float frequency) {
-    ei_dsp_config_spectral_analysis_t config = *((ei_dsp_config_spectral_analysis_t*)config_ptr);
+static int ei_dsp_run_spectral_analysis(signal_t *signal, matrix_t *output_matrix,
+    const ei_dsp_config_spectral_analysis_t *config, const spectral::spectral_analysis_prepared_t *prepared) {
 
     int ret;
 
-    const float sampling_freq = frequency;
+    size_t axes = config->axes;
+    size_t frames = signal->total_length / axes;
 
-    // input matrix from the raw signal
-    matrix_i16_t input_matrix(signal->total_length / config.axes, config.axes);
-    if (!input_matrix.buffer) {
+    // one row per axis, read and scaled straight into place instead of
+    // scaling and transposing the interleaved signal
+    matrix_t input_matrix(axes, frames);
+    EI_DSP_MATRIX(read_matrix, 1, EI_DSP_SPECTRAL_READ_FRAMES * axes);
+    if (!input_matrix.buffer || !read_matrix.buffer) {
         EIDSP_ERR(EIDSP_OUT_OF_MEM);
     }
 
-    signal->get_data(0, signal->total_length, (EIDSP_i16 *)&input_matrix.buffer[0]);
+    for (size_t frame = 0; frame < frames; frame += EI_DSP_SPECTRAL_READ_FRAMES) {
+        size_t frames_read = frames - frame;
+        if (frames_read > EI_DSP_SPECTRAL_READ_FRAMES) {
+            frames_read = EI_DSP_SPECTRAL_READ_FRAMES;
+        }
 
-    // scale the signal
-    ret = numpy::scale(&input_matrix, config.scale_axes);
-    if (ret != EIDSP_OK) {
-        ei_printf("ERR: Failed to scale signal (%d)\n", ret);
-        EIDSP_ERR(ret);
+        ret = signal->get_data(frame * axes, frames_read * axes, read_matrix.buffer);
+        if (ret != 0) {
+            EIDSP_ERR(ret);
+        }
+
+        for (size_t fx = 0; fx < frames_read; fx++) {
+            for (size_t ax = 0; ax < axes; ax++) {
+                input_matrix.buffer[(ax * frames) + frame + fx] = read_matrix.buffer[(fx * axes) + ax] * config->scale_axes;
+            }
+        }
     }
 
-    // transpose the matrix so we have one row per axis (nifty!)
-    ret = numpy::transpose(&input_matrix);
+    size_t output_matrix_cols = spectral::feature::calculate_spectral_buffer_size(
+        true, prepared->fft_peaks, prepared->edges_count
+    );
+    if (output_matrix->cols * output_matrix->rows != static_cast<uint32_t>(output_matrix_cols * axes)) {
+        EIDSP_ERR(EIDSP_MATRIX_SIZE_MISMATCH);
+    }
+
+    output_matrix->cols = output_matrix_cols;
+    output_matrix->rows = axes;
+
+    ret = spectral::feature::spectral_analysis(output_matrix, &input_matrix, prepared);
     if (ret != EIDSP_OK) {
-        ei_printf("ERR: Failed to transpose matrix (%d)\n", ret);
+        ei_printf("ERR: Failed to calculate spectral features (%d)\n", ret);
         EIDSP_ERR(ret);
     }
 
-    matrix_i16_t *edges_matrix_in = create_edges_matrix(config, sampling_freq);
+    // flatten again
+    output_matrix->cols = axes * output_matrix_cols;
+    output_matrix->rows = 1;
 
-    if(edges_matrix_in == NULL) {
-        EIDSP_ERR(EIDSP_PARAMETER_INVALID);
+    return EIDSP_OK;
+}
+
+static int ei_dsp_run_spectral_analysis(signal_i16_t *signal, matrix_i32_t *output_matrix,
+    const ei_dsp_config_spectral_analysis_t *config, const spectral::spectral_analysis_prepared_t *prepared,
+    const spectral::spectral_analysis_fixed_t *fixed) {
+
+    int ret;
+
+    size_t axes = config->axes;
+    size_t frames = signal->total_length / axes;
+
+    // one row per axis, the scale is part of the fixed-point settings
+    EI_DSP_i16_MATRIX(input_matrix, axes, frames);
+    EI_DSP_i16_MATRIX(read_matrix, 1, EI_DSP_SPECTRAL_READ_FRAMES * axes);
+
+    for (size_t frame = 0; frame < frames; frame += EI_DSP_SPECTRAL_READ_FRAMES) {
+        size_t frames_read = frames - frame;
+        if (frames_read > EI_DSP_SPECTRAL_READ_FRAMES) {
+            frames_read = EI_DSP_SPECTRAL_READ_FRAMES;
+        }
+
+        ret = signal->get_data(frame * axes, frames_read * axes, read_matrix.buffer);
+        if (ret != 0) {
+            EIDSP_ERR(ret);
+        }
+
+        for (size_t fx = 0; fx < frames_read; fx++) {
+            for (size_t ax = 0; ax < axes; ax++) {
+                input_matrix.buffer[(ax * frames) + frame + fx] = read_matrix.buffer[(fx * axes) + ax];
+            }
+        }
     }
 
-    // calculate how much room we need for the output matrix
     size_t output_matrix_cols = spectral::feature::calculate_spectral_buffer_size(
-        true, config.spectral_peaks_count, edges_matrix_in->rows
+        true, prepared->fft_peaks, prepared->edges_count
     );
-    // ei_printf("output_matrix_size %hux%zu\n", input_matrix.rows, output_matrix_cols);
-    if (output_matrix->cols * output_matrix->rows != static_cast<uint32_t>(output_matrix_cols * config.axes)) {
+    if (output_matrix->cols * output_matrix->rows != static_cast<uint32_t>(output_matrix_cols * axes)) {
         EIDSP_ERR(EIDSP_MATRIX_SIZE_MISMATCH);
     }
 
     output_matrix->cols = output_matrix_cols;
-    output_matrix->rows = config.axes;
-
-    spectral::filter_t filter_type;
-    if (strcmp(config.filter_type, "low") == 0) {
-        filter_type = spectral::filter_lowpass;
-    }
-    else if (strcmp(config.filter_type, "high") == 0) {
-        filter_type = spectral::filter_highpass;
-    }
-    else {
-        filter_type = spectral::filter_none;
-    }
+    output_matrix->rows = axes;
 
-    ret = spectral::feature::spectral_analysis(output_matrix, &input_matrix,
-        sampling_freq, filter_type, config.filter_cutoff, config.filter_order,
-        config.fft_length, config.spectral_peaks_count, config.spectral_peaks_threshold, edges_matrix_in);
+    ret = spectral::feature::spectral_analysis(output_matrix, &input_matrix, prepared, fixed);
     if (ret != EIDSP_OK) {
         ei_printf("ERR: Failed to calculate spectral features (%d)\n", ret);
         EIDSP_ERR(ret);
     }
 
     // flatten again
-    output_matrix->cols = config.axes * output_matrix_cols;
+    output_matrix->cols = axes * output_matrix_cols;
     output_matrix->rows = 1;
 
     return EIDSP_OK;
 }
 
+__attribute__((unused)) int extract_spectral_analysis_features(signal_t *signal, matrix_t *output_matrix, void *config_ptr, const float frequency) {
+    ei_dsp_config_spectral_analysis_t *config = (ei_dsp_config_spectral_analysis_t*)config_ptr;
+
+    const spectral::spectral_analysis_prepared_t *prepared = ei_dsp_prepare_spectral_analysis(config, frequency);
+    if (prepared) {
+        return ei_dsp_run_spectral_analysis(signal, output_matrix, config, prepared);
+    }
+
+    // no room to keep it, resolve for this window only
+    spectral::spectral_analysis_prepared_t local;
+    int ret = ei_dsp_resolve_spectral_analysis(config, frequency, &local);
+    if (ret == EIDSP_OK) {
+        ret = ei_dsp_run_spectral_analysis(signal, output_matrix, config, &local);
+    }
+    spectral::feature::release_spectral_analysis(&local);
+
+    return ret;
+}
+
+__attribute__((unused)) int extract_spectral_analysis_features(signal_i16_t *signal, matrix_i32_t *output_matrix, void *config_ptr, const float frequency) {
+    ei_dsp_config_spectral_analysis_t *config = (ei_dsp_config_spectral_analysis_t*)config_ptr;
+
+    size_t frames = signal->total_length / config->axes;
+
+    ei_dsp_spectral_prepared_entry_t *entry = ei_dsp_spectral_entry(config, frequency);
+    if (entry && ei_dsp_prepare_spectral_analysis_fixed(entry, frames) == EIDSP_OK) {
+        return ei_dsp_run_spectral_analysis(signal, output_matrix, config, &entry->prepared, &entry->fixed);
+    }
+
+    // no room to keep it, resolve for this window only
+    spectral::spectral_analysis_prepared_t local;
+    spectral::spectral_analysis_fixed_t local_fixed = { };
+    int ret = ei_dsp_resolve_spectral_analysis(config, frequency, &local);
+    if (ret == EIDSP_OK) {
+        ret = spectral::feature::prepare_spectral_analysis_fixed(&local_fixed, &local,
+            frames, ei_dsp_i16_sample_scale * config->scale_axes);
+    }
+    if (ret == EIDSP_OK) {
+        ret = ei_dsp_run_spectral_analysis(signal, output_matrix, config, &local, &local_fixed);
+    }
+    spectral::feature::release_spectral_analysis_fixed(&local_fixed);
+    spectral::feature::release_spectral_analysis(&local);
+
+    return ret;
+}
+
 __attribute__((unused)) int extract_raw_features(signal_t *signal, matrix_t *output_matrix, void *config_ptr, const float frequency) {
+    (void)frequency;
     ei_dsp_config_raw_t config = *((ei_dsp_config_raw_t*)config_ptr);
 
     // input matrix from the raw signal
@@ -304,6 +458,7 @@ __attribute__((unused)) int extract_raw_features(signal_t *signal, matrix_t *out
 }
 
 __attribute__((unused)) int extract_flatten_features(signal_t *signal, matrix_t *output_matrix, void *config_ptr, const float frequency) {
+    (void)frequency;
     ei_dsp_config_flatten_t config = *((ei_dsp_config_flatten_t*)config_ptr);
 
     uint32_t expected_matrix_size = 0;
@@ -470,6 +625,137 @@ __attribute__((unused)) int extract_mfcc_features(signal_t *signal, matrix_t *ou
     return EIDSP_OK;
 }
 
+/**
+ * Get the entry keeping the fixed-point form of an MFE or MFCC config,
+ * claiming a free one on first use. Returns NULL if it can't be kept.
+ */
+static ei_dsp_mfe_fixed_entry_t *ei_dsp_mfe_fixed_entry(const void *config, const float frequency) {
+    ei_dsp_mfe_fixed_entry_t *free_entry = NULL;
+
+    for (size_t ix = 0; ix < EI_DSP_MFE_FIXED_MAX; ix++) {
+        ei_dsp_mfe_fixed_entry_t *entry = &ei_dsp_mfe_fixed[ix];
+        if (entry->config == config && entry->frequency == frequency) {
+            return entry;
+        }
+        if (!entry->config && !free_entry) {
+            free_entry = entry;
+        }
+    }
+
+    if (free_entry) {
+        free_entry->config = config;
+        free_entry->frequency = frequency;
+    }
+
+    return free_entry;
+}
+
+static int ei_dsp_resolve_mfe_fixed(const ei_dsp_config_mfcc_t *config, const float sampling_frequency,
+    size_t signal_length, speechpy::mfe_fixed_t *fixed) {
+
+    return speechpy::feature::prepare_mfe_fixed(fixed, signal_length, static_cast<uint32_t>(sampling_frequency),
+        config->frame_length, config->frame_stride, config->num_filters, config->fft_length,
+        config->low_frequency, config->high_frequency, config->implementation_version,
+        config->pre_shift, config->pre_cof, false, 0, config->num_cepstral, ei_dsp_i16_sample_scale);
+}
+
+/**
+ * Get the fixed-point form of an MFCC config for windows of signal_length
+ * samples, resolving it on first use. Returns NULL if it can't be kept, the
+ * caller then resolves it per call.
+ */
+__attribute__((unused)) static const speechpy::mfe_fixed_t *ei_dsp_prepare_mfe_fixed(
+    const ei_dsp_config_mfcc_t *config, const float sampling_frequency, size_t signal_length) {
+
+    ei_dsp_mfe_fixed_entry_t *entry = ei_dsp_mfe_fixed_entry(config, sampling_frequency);
+    if (!entry) {
+        return NULL;
+    }
+
+    if (entry->fixed.signal_length != signal_length) {
+        speechpy::feature::release_mfe_fixed(&entry->fixed);
+        if (ei_dsp_resolve_mfe_fixed(config, sampling_frequency, signal_length, &entry->fixed) != EIDSP_OK) {
+            speechpy::feature::release_mfe_fixed(&entry->fixed);
+            return NULL;
+        }
+    }
+
+    return &entry->fixed;
+}
+
+static int ei_dsp_run_mfcc(signal_i16_t *signal, matrix_i32_t *output_matrix,
+    const ei_dsp_config_mfcc_t *config, const speechpy::mfe_fixed_t *fixed) {
+
+    int ret = speechpy::feature::mfcc(output_matrix, signal, fixed);
+    if (ret != EIDSP_OK) {
+        ei_printf("ERR: MFCC failed (%d)\n", ret);
+        EIDSP_ERR(ret);
+    }
+
+    // cepstral mean and variance normalization
+    ret = speechpy::processing::cmvnw(output_matrix, config->win_size, true);
+    if (ret != EIDSP_OK) {
+        ei_printf("ERR: cmvnw failed (%d)\n", ret);
+        EIDSP_ERR(ret);
+    }
+
+    return EIDSP_OK;
+}
+
+__attribute__((unused)) int extract_mfcc_features(signal_i16_t *signal, matrix_i32_t *output_matrix, void *config_ptr, const float sampling_frequency) {
+    ei_dsp_config_mfcc_t *config = (ei_dsp_config_mfcc_t*)config_ptr;
+
+    if (config->axes != 1) {
+        EIDSP_ERR(EIDSP_MATRIX_SIZE_MISMATCH);
+    }
+
+    if(config->implementation_version != 1 && config->implementation_version != 2) {
+        EIDSP_ERR(EIDSP_BLOCK_VERSION_INCORRECT);
+    }
+
+    if (signal->total_length == 0) {
+        EIDSP_ERR(EIDSP_PARAMETER_INVALID);
+    }
+
+    const uint32_t frequency = static_cast<uint32_t>(sampling_frequency);
+
+    // calculate the size of the MFCC matrix
+    matrix_size_t out_matrix_size =
+        speechpy::feature::calculate_mfcc_buffer_size(
+            signal->total_length, frequency, config->frame_length, config->frame_stride, config->num_cepstral, config->implementation_version);
+    if (out_matrix_size.rows * out_matrix_size.cols > output_matrix->rows * output_matrix->cols) {
+        ei_printf("out_matrix = %dx%d\n", (int)output_matrix->rows, (int)output_matrix->cols);
+        ei_printf("calculated size = %dx%d\n", (int)out_matrix_size.rows, (int)out_matrix_size.cols);
+        EIDSP_ERR(EIDSP_MATRIX_SIZE_MISMATCH);
+    }
+
+    output_matrix->rows = out_matrix_size.rows;
+    output_matrix->cols = out_matrix_size.cols;
+
+    int ret;
+    const speechpy::mfe_fixed_t *fixed = ei_dsp_prepare_mfe_fixed(config, sampling_frequency, signal->total_length);
+    if (fixed) {
+        ret = ei_dsp_run_mfcc(signal, output_matrix, config, fixed);
+    }
+    else {
+        // no room to keep it, resolve for this window only
+        speechpy::mfe_fixed_t local_fixed = { };
+        ret = ei_dsp_resolve_mfe_fixed(config, sampling_frequency, signal->total_length, &local_fixed);
+        if (ret == EIDSP_OK) {
+            ret = ei_dsp_run_mfcc(signal, output_matrix, config, &local_fixed);
+        }
+        speechpy::feature::release_mfe_fixed(&local_fixed);
+    }
+    if (ret != EIDSP_OK) {
+        EIDSP_ERR(ret);
+    }
+
+    output_matrix->cols = out_matrix_size.rows * out_matrix_size.cols;
+    output_matrix->rows = 1;
+
+    return EIDSP_OK;
+}
+
 
 static int extract_mfcc_run_slice(signal_t *signal, matrix_t *output_matrix, ei_dsp_config_mfcc_t *config, const float sampling_frequency, matrix_size_t *matrix_size_out, int implementation_version) {
     uint32_t frequency = (uint32_t)sampling_frequency;
@@ -482,20 +768,14 @@ static int extract_mfcc_run_slice(signal_t *signal, matrix_t *output_matrix, ei_
             signal->total_length, frequency, config->frame_length, config->frame_stride, config->num_cepstral,
             implementation_version);
 
-    // we roll the output matrix back so we have room at the end...
-    x = numpy::roll(output_matrix->buffer, output_matrix->rows * output_matrix->cols,
-        -(out_matrix_size.rows * out_matrix_size.cols));
-    if (x != EIDSP_OK) {
-        EIDSP_ERR(x);
+    // new frames replace the oldest ones in the feature ring, they're written in place
+    // unless they wrap around (then the slice matrix allocates a scratch buffer)
+    matrix_t output_matrix_slice(out_matrix_size.rows, out_matrix_size.cols,
+        ei_dsp_cont_features_slot(output_matrix, out_matrix_size.rows * out_matrix_size.cols));
+    if (!output_matrix_slice.buffer) {
+        EIDSP_ERR(EIDSP_OUT_OF_MEM);
     }
 
-    // slice in the output matrix to write to
-    // the offset in the classification matrix here is always at the end
-    size_t output_matrix_offset = (output_matrix->rows * output_matrix->cols) -
-        (out_matrix_size.rows * out_matrix_size.cols);
-
-    matrix_t output_matrix_slice(out_matrix_size.rows, out_matrix_size.cols, output_matrix->buffer + output_matrix_offset);
-
     // and run the MFCC extraction
     x = speechpy::feature::mfcc(&output_matrix_slice, signal,
         frequency, config->frame_length, config->frame_stride, config->num_cepstral, config->num_filters, config->fft_length,
@@ -505,6 +785,8 @@ static int extract_mfcc_run_slice(signal_t *signal, matrix_t *output_matrix, ei_
         EIDSP_ERR(x);
     }
 
+    ei_dsp_cont_features_push(output_matrix, &output_matrix_slice);
+
     matrix_size_out->rows += out_matrix_size.rows;
     if (out_matrix_size.cols > 0) {
         matrix_size_out->cols = out_matrix_size.cols;
@@ -745,31 +1027,20 @@ __attribute__((unused)) int extract_spectrogram_features(signal_t *signal, matri
 static int extract_spectrogram_run_slice(signal_t *signal, matrix_t *output_matrix, ei_dsp_config_spectrogram_t *config, const float sampling_frequency, matrix_size_t *matrix_size_out) {
     uint32_t frequency = (uint32_t)sampling_frequency;
 
-    int x;
-
     // calculate the size of the spectrogram matrix
     matrix_size_t out_matrix_size =
         speechpy::feature::calculate_mfe_buffer_size(
             signal->total_length, frequency, config->frame_length, config->frame_stride, config->fft_length / 2 + 1,
             config->implementation_version);
 
-    // we roll the output matrix back so we have room at the end...
-    x = numpy::roll(output_matrix->buffer, output_matrix->rows * output_matrix->cols,
-        -(out_matrix_size.rows * out_matrix_size.cols));
-    if (x != EIDSP_OK) {
-        if (preemphasis) {
-            delete preemphasis;
-        }
-        EIDSP_ERR(x);
+    // new frames replace the oldest ones in the feature ring, they're written in place
+    // unless they wrap around (then the slice matrix allocates a scratch buffer)
+    matrix_t output_matrix_slice(out_matrix_size.rows, out_matrix_size.cols,
+        ei_dsp_cont_features_slot(output_matrix, out_matrix_size.rows * out_matrix_size.cols));
+    if (!output_matrix_slice.buffer) {
+        EIDSP_ERR(EIDSP_OUT_OF_MEM);
     }
 
-    // slice in the output matrix to write to
-    // the offset in the classification matrix here is always at the end
-    size_t output_matrix_offset = (output_matrix->rows * output_matrix->cols) -
-        (out_matrix_size.rows * out_matrix_size.cols);
-
-    matrix_t output_matrix_slice(out_matrix_size.rows, out_matrix_size.cols, output_matrix->buffer + output_matrix_offset);
-
     // and run the spectrogram extraction
     int ret = speechpy::feature::spectrogram(&output_matrix_slice, signal,
         frequency, config->frame_length, config->frame_stride, config->fft_length, config->implementation_version);
@@ -779,6 +1050,8 @@ static int extract_spectrogram_run_slice(signal_t *signal, matrix_t *output_matr
         EIDSP_ERR(ret);
     }
 
+    ei_dsp_cont_features_push(output_matrix, &output_matrix_slice);
+
     matrix_size_out->rows += out_matrix_size.rows;
     if (out_matrix_size.cols > 0) {
         matrix_size_out->cols = out_matrix_size.cols;
@@ -1043,6 +1316,115 @@ __attribute__((unused)) int extract_mfe_features(signal_t *signal, matrix_t *out
     return EIDSP_OK;
 }
 
+static int ei_dsp_resolve_mfe_fixed(const ei_dsp_config_mfe_t *config, const float sampling_frequency,
+    size_t signal_length, speechpy::mfe_fixed_t *fixed) {
+
+    return speechpy::feature::prepare_mfe_fixed(fixed, signal_length, static_cast<uint32_t>(sampling_frequency),
+        config->frame_length, config->frame_stride, config->num_filters, config->fft_length,
+        config->low_frequency, config->high_frequency, config->implementation_version,
+        1, 0.98f, true, config->noise_floor_db, 0, ei_dsp_i16_sample_scale);
+}
+
+/**
+ * Get the fixed-point form of an MFE config for windows of signal_length
+ * samples, resolving it on first use. Returns NULL if it can't be kept, the
+ * caller then resolves it per call.
+ */
+__attribute__((unused)) static const speechpy::mfe_fixed_t *ei_dsp_prepare_mfe_fixed(
+    const ei_dsp_config_mfe_t *config, const float sampling_frequency, size_t signal_length) {
+
+    ei_dsp_mfe_fixed_entry_t *entry = ei_dsp_mfe_fixed_entry(config, sampling_frequency);
+    if (!entry) {
+        return NULL;
+    }
+
+    if (entry->fixed.signal_length != signal_length) {
+        speechpy::feature::release_mfe_fixed(&entry->fixed);
+        if (ei_dsp_resolve_mfe_fixed(config, sampling_frequency, signal_length, &entry->fixed) != EIDSP_OK) {
+            speechpy::feature::release_mfe_fixed(&entry->fixed);
+            return NULL;
+        }
+    }
+
+    return &entry->fixed;
+}
+
+static int ei_dsp_run_mfe(signal_i16_t *signal, matrix_i32_t *output_matrix, const speechpy::mfe_fixed_t *fixed) {
+    EI_DSP_i32_MATRIX(energy_matrix, output_matrix->rows, 1);
+
+    int ret = speechpy::feature::mfe(output_matrix, &energy_matrix, signal, fixed);
+    if (ret != EIDSP_OK) {
+        ei_printf("ERR: MFE failed (%d)\n", ret);
+        EIDSP_ERR(ret);
+    }
+
+    ret = speechpy::feature::mfe_normalization(output_matrix, fixed);
+    if (ret != EIDSP_OK) {
+        ei_printf("ERR: normalization failed (%d)\n", ret);
+        EIDSP_ERR(ret);
+    }
+
+    return EIDSP_OK;
+}
+
+__attribute__((unused)) int extract_mfe_features(signal_i16_t *signal, matrix_i32_t *output_matrix, void *config_ptr, const float sampling_frequency) {
+    ei_dsp_config_mfe_t *config = (ei_dsp_config_mfe_t*)config_ptr;
+
+    if (config->axes != 1) {
+        EIDSP_ERR(EIDSP_MATRIX_SIZE_MISMATCH);
+    }
+
+    // before version 3 the features are normalized with cmvnw over the
+    // linear energies, that one only exists in float
+    if (config->implementation_version < 3) {
+        ei_printf("ERR: MFE version %d has no int16 block\n", (int)config->implementation_version);
+        EIDSP_ERR(EIDSP_NOT_SUPPORTED);
+    }
+
+    if (signal->total_length == 0) {
+        EIDSP_ERR(EIDSP_PARAMETER_INVALID);
+    }
+
+    const uint32_t frequency = static_cast<uint32_t>(sampling_frequency);
+
+    // calculate the size of the MFE matrix
+    matrix_size_t out_matrix_size =
+        speechpy::feature::calculate_mfe_buffer_size(
+            signal->total_length, frequency, config->frame_length, config->frame_stride, config->num_filters,
+            config->implementation_version);
+    if (out_matrix_size.rows * out_matrix_size.cols > output_matrix->rows * output_matrix->cols) {
+        ei_printf("out_matrix = %dx%d\n", (int)output_matrix->rows, (int)output_matrix->cols);
+        ei_printf("calculated size = %dx%d\n", (int)out_matrix_size.rows, (int)out_matrix_size.cols);
+        EIDSP_ERR(EIDSP_MATRIX_SIZE_MISMATCH);
+    }
+
+    output_matrix->rows = out_matrix_size.rows;
+    output_matrix->cols = out_matrix_size.cols;
+
+    int ret;
+    const speechpy::mfe_fixed_t *fixed = ei_dsp_prepare_mfe_fixed(config, sampling_frequency, signal->total_length);
+    if (fixed) {
+        ret = ei_dsp_run_mfe(signal, output_matrix, fixed);
+    }
+    else {
+        // no room to keep it, resolve for this window only
+        speechpy::mfe_fixed_t local_fixed = { };
+        ret = ei_dsp_resolve_mfe_fixed(config, sampling_frequency, signal->total_length, &local_fixed);
+        if (ret == EIDSP_OK) {
+            ret = ei_dsp_run_mfe(signal, output_matrix, &local_fixed);
+        }
+        speechpy::feature::release_mfe_fixed(&local_fixed);
+    }
+    if (ret != EIDSP_OK) {
+        EIDSP_ERR(ret);
+    }
+
+    output_matrix->cols = out_matrix_size.rows * out_matrix_size.cols;
+    output_matrix->rows = 1;
+
+    return EIDSP_OK;
+}
+
 static int extract_mfe_run_slice(signal_t *signal, matrix_t *output_matrix, ei_dsp_config_mfe_t *config, const float sampling_frequency, matrix_size_t *matrix_size_out) {
     uint32_t frequency = (uint32_t)sampling_frequency;
 
@@ -1054,20 +1436,14 @@ static int extract_mfe_run_slice(signal_t *signal, matrix_t *output_matrix, ei_d
             signal->total_length, frequency, config->frame_length, config->frame_stride, config->num_filters,
             config->implementation_version);
 
-    // we roll the output matrix back so we have room at the end...
-    x = numpy::roll(output_matrix->buffer, output_matrix->rows * output_matrix->cols,
-        -(out_matrix_size.rows * out_matrix_size.cols));
-    if (x != EIDSP_OK) {
-        EIDSP_ERR(x);
+    // new frames replace the oldest ones in the feature ring, they're written in place
+    // unless they wrap around (then the slice matrix allocates a scratch buffer)
+    matrix_t output_matrix_slice(out_matrix_size.rows, out_matrix_size.cols,
+        ei_dsp_cont_features_slot(output_matrix, out_matrix_size.rows * out_matrix_size.cols));
+    if (!output_matrix_slice.buffer) {
+        EIDSP_ERR(EIDSP_OUT_OF_MEM);
     }
 
-    // slice in the output matrix to write to
-    // the offset in the classification matrix here is always at the end
-    size_t output_matrix_offset = (output_matrix->rows * output_matrix->cols) -
-        (out_matrix_size.rows * out_matrix_size.cols);
-
-    matrix_t output_matrix_slice(out_matrix_size.rows, out_matrix_size.cols, output_matrix->buffer + output_matrix_offset);
-
     // energy matrix
     EI_DSP_MATRIX(energy_matrix, out_matrix_size.rows, 1);
     if (!energy_matrix.buffer) {
@@ -1083,6 +1459,8 @@ static int extract_mfe_run_slice(signal_t *signal, matrix_t *output_matrix, ei_d
         EIDSP_ERR(x);
     }
 
+    ei_dsp_cont_features_push(output_matrix, &output_matrix_slice);
+
     matrix_size_out->rows += out_matrix_size.rows;
     if (out_matrix_size.cols > 0) {
         matrix_size_out->cols = out_matrix_size.cols;
@@ -1309,6 +1687,7 @@ __attribute__((unused)) int extract_mfe_per_slice_features(signal_t *signal, mat
 }
 
 __attribute__((unused)) int extract_image_features(signal_t *signal, matrix_t *output_matrix, void *config_ptr, const float frequency) {
+    (void)frequency;
     ei_dsp_config_image_t config = *((ei_dsp_config_image_t*)config_ptr);
 
     int16_t channel_count = strcmp(config.channels, "Grayscale") == 0 ? 1 : 3;
@@ -1371,7 +1750,71 @@ __attribute__((unused)) int extract_image_features(signal_t *signal, matrix_t *o
 
 #if EI_CLASSIFIER_TFLITE_INPUT_QUANTIZED == 1
 
+/**
+ * Quantize one packed RGB pixel to the input tensor format
+ * @param pixel Packed RGB pixel (0xRRGGBB)
+ * @param channel_count 1 for grayscale, 3 for RGB
+ * @param out Output, receives channel_count values
+ */
+static inline void extract_image_quantize_pixel(uint32_t pixel, int16_t channel_count, int8_t *out) {
+    const int32_t iRedToGray = (int32_t)(0.299f * 65536.0f);
+    const int32_t iGreenToGray = (int32_t)(0.587f * 65536.0f);
+    const int32_t iBlueToGray = (int32_t)(0.114f * 65536.0f);
+
+    if (channel_count == 3) {
+        // fast code path
+        if (EI_CLASSIFIER_TFLITE_INPUT_SCALE == 0.003921568859368563f && EI_CLASSIFIER_TFLITE_INPUT_ZEROPOINT == -128) {
+            int32_t r = static_cast<int32_t>(pixel >> 16 & 0xff);
+            int32_t g = static_cast<int32_t>(pixel >> 8 & 0xff);
+            int32_t b = static_cast<int32_t>(pixel & 0xff);
+
+            *out++ = static_cast<int8_t>(r + EI_CLASSIFIER_TFLITE_INPUT_ZEROPOINT);
+            *out++ = static_cast<int8_t>(g + EI_CLASSIFIER_TFLITE_INPUT_ZEROPOINT);
+            *out++ = static_cast<int8_t>(b + EI_CLASSIFIER_TFLITE_INPUT_ZEROPOINT);
+        }
+        // slow code path
+        else {
+            float r = static_cast<float>(pixel >> 16 & 0xff) / 255.0f;
+            float g = static_cast<float>(pixel >> 8 & 0xff) / 255.0f;
+            float b = static_cast<float>(pixel & 0xff) / 255.0f;
+
+            *out++ = static_cast<int8_t>(round(r / EI_CLASSIFIER_TFLITE_INPUT_SCALE) + EI_CLASSIFIER_TFLITE_INPUT_ZEROPOINT);
+            *out++ = static_cast<int8_t>(round(g / EI_CLASSIFIER_TFLITE_INPUT_SCALE) + EI_CLASSIFIER_TFLITE_INPUT_ZEROPOINT);
+            *out++ = static_cast<int8_t>(round(b / EI_CLASSIFIER_TFLITE_INPUT_SCALE) + EI_CLASSIFIER_TFLITE_INPUT_ZEROPOINT);
+        }
+    }
+    else {
+        // fast code path
+        if (EI_CLASSIFIER_TFLITE_INPUT_SCALE == 0.003921568859368563f && EI_CLASSIFIER_TFLITE_INPUT_ZEROPOINT == -128) {
+            int32_t r = static_cast<int32_t>(pixel >> 16 & 0xff);
+            int32_t g = static_cast<int32_t>(pixel >> 8 & 0xff);
+            int32_t b = static_cast<int32_t>(pixel & 0xff);
+
+            // ITU-R 601-2 luma transform
+            // see: https://pillow.readthedocs.io/en/stable/reference/Image.html#PIL.Image.Image.convert
+            int32_t gray = (iRedToGray * r) + (iGreenToGray * g) + (iBlueToGray * b);
+            gray >>= 16; // scale down to int8_t
+            gray += EI_CLASSIFIER_TFLITE_INPUT_ZEROPOINT;
+            if (gray < - 128) gray = -128;
+            else if (gray > 127) gray = 127;
+            *out++ = static_cast<int8_t>(gray);
+        }
+        // slow code path
+        else {
+            float r = static_cast<float>(pixel >> 16 & 0xff) / 255.0f;
+            float g = static_cast<float>(pixel >> 8 & 0xff) / 255.0f;
+            float b = static_cast<float>(pixel & 0xff) / 255.0f;
+
+            // ITU-R 601-2 luma transform
+            // see: https://pillow.readthedocs.io/en/stable/reference/Image.html#PIL.Image.Image.convert
+            float v = (0.299f * r) + (0.587f * g) + (0.114f * b);
+            *out++ = static_cast<int8_t>(round(v / EI_CLASSIFIER_TFLITE_INPUT_SCALE) + EI_CLASSIFIER_TFLITE_INPUT_ZEROPOINT);
+        }
+    }
+}
+
 __attribute__((unused)) int extract_image_features_quantized(signal_t *signal, matrix_i8_t *output_matrix, void *config_ptr, const float frequency) {
+    (void)frequency;
     ei_dsp_config_image_t config = *((ei_dsp_config_image_t*)config_ptr);
 
     int16_t channel_count = strcmp(config.channels, "Grayscale") == 0 ? 1 : 3;
@@ -1384,10 +1827,6 @@ __attribute__((unused)) int extract_image_features_quantized(signal_t *signal, m
 
     size_t output_ix = 0;
 
-    const int32_t iRedToGray = (int32_t)(0.299f * 65536.0f);
-    const int32_t iGreenToGray = (int32_t)(0.587f * 65536.0f);
-    const int32_t iBlueToGray = (int32_t)(0.114f * 65536.0f);
-
 #if defined(EI_DSP_IMAGE_BUFFER_STATIC_SIZE)
     const size_t page_size = EI_DSP_IMAGE_BUFFER_STATIC_SIZE;
 #else
@@ -1412,56 +1851,8 @@ __attribute__((unused)) int extract_image_features_quantized(signal_t *signal, m
         for (size_t jx = 0; jx < elements_to_read; jx++) {
             uint32_t pixel = static_cast<uint32_t>(input_matrix.buffer[jx]);
 
-            if (channel_count == 3) {
-                // fast code path
-                if (EI_CLASSIFIER_TFLITE_INPUT_SCALE == 0.003921568859368563f && EI_CLASSIFIER_TFLITE_INPUT_ZEROPOINT == -128) {
-                    int32_t r = static_cast<int32_t>(pixel >> 16 & 0xff);
-                    int32_t g = static_cast<int32_t>(pixel >> 8 & 0xff);
-                    int32_t b = static_cast<int32_t>(pixel & 0xff);
-
-                    output_matrix->buffer[output_ix++] = static_cast<int8_t>(r + EI_CLASSIFIER_TFLITE_INPUT_ZEROPOINT);
-                    output_matrix->buffer[output_ix++] = static_cast<int8_t>(g + EI_CLASSIFIER_TFLITE_INPUT_ZEROPOINT);
-                    output_matrix->buffer[output_ix++] = static_cast<int8_t>(b + EI_CLASSIFIER_TFLITE_INPUT_ZEROPOINT);
-                }
-                // slow code path
-                else {
-                    float r = static_cast<float>(pixel >> 16 & 0xff) / 255.0f;
-                    float g = static_cast<float>(pixel >> 8 & 0xff) / 255.0f;
-                    float b = static_cast<float>(pixel & 0xff) / 255.0f;
-
-                    output_matrix->buffer[output_ix++] = static_cast<int8_t>(round(r / EI_CLASSIFIER_TFLITE_INPUT_SCALE) + EI_CLASSIFIER_TFLITE_INPUT_ZEROPOINT);
-                    output_matrix->buffer[output_ix++] = static_cast<int8_t>(round(g / EI_CLASSIFIER_TFLITE_INPUT_SCALE) + EI_CLASSIFIER_TFLITE_INPUT_ZEROPOINT);
-                    output_matrix->buffer[output_ix++] = static_cast<int8_t>(round(b / EI_CLASSIFIER_TFLITE_INPUT_SCALE) + EI_CLASSIFIER_TFLITE_INPUT_ZEROPOINT);
-                }
-            }
-            else {
-                // fast code path
-                if (EI_CLASSIFIER_TFLITE_INPUT_SCALE == 0.003921568859368563f && EI_CLASSIFIER_TFLITE_INPUT_ZEROPOINT == -128) {
-                    int32_t r = static_cast<int32_t>(pixel >> 16 & 0xff);
-                    int32_t g = static_cast<int32_t>(pixel >> 8 & 0xff);
-                    int32_t b = static_cast<int32_t>(pixel & 0xff);
-
-                    // ITU-R 601-2 luma transform
-                    // see: https://pillow.readthedocs.io/en/stable/reference/Image.html#PIL.Image.Image.convert
-                    int32_t gray = (iRedToGray * r) + (iGreenToGray * g) + (iBlueToGray * b);
-                    gray >>= 16; // scale down to int8_t
-                    gray += EI_CLASSIFIER_TFLITE_INPUT_ZEROPOINT;
-                    if (gray < - 128) gray = -128;
-                    else if (gray > 127) gray = 127;
-                    output_matrix->buffer[output_ix++] = static_cast<int8_t>(gray);
-                }
-                // slow code path
-                else {
-                    float r = static_cast<float>(pixel >> 16 & 0xff) / 255.0f;
-                    float g = static_cast<float>(pixel >> 8 & 0xff) / 255.0f;
-                    float b = static_cast<float>(pixel & 0xff) / 255.0f;
-
-                    // ITU-R 601-2 luma transform
-                    // see: https://pillow.readthedocs.io/en/stable/reference/Image.html#PIL.Image.Image.convert
-                    float v = (0.299f * r) + (0.587f * g) + (0.114f * b);
-                    output_matrix->buffer[output_ix++] = static_cast<int8_t>(round(v / EI_CLASSIFIER_TFLITE_INPUT_SCALE) + EI_CLASSIFIER_TFLITE_INPUT_ZEROPOINT);
-                }
-            }
+            extract_image_quantize_pixel(pixel, channel_count, &output_matrix->buffer[output_ix]);
+            output_ix += channel_count;
         }
 
         bytes_left -= elements_to_read;
@@ -1469,6 +1860,30 @@ __attribute__((unused)) int extract_image_features_quantized(signal_t *signal, m
 
     return EIDSP_OK;
 }
+
+/**
+ * Build a lookup table from a monochrome pixel value (r = g = b) to its quantized
+ * input tensor value, as extract_image_features_quantized would produce it. RGB
+ * models get the same value on all three channels.
+ * @param config_ptr Image DSP block config
+ * @param lut Output, 256 entries
+ * @param channels Output, number of input channels per pixel
+ */
+__attribute__((unused)) int extract_image_features_quantized_mono_lut(void *config_ptr, int8_t *lut, size_t *channels) {
+    ei_dsp_config_image_t config = *((ei_dsp_config_image_t*)config_ptr);
+
+    int16_t channel_count = strcmp(config.channels, "Grayscale") == 0 ? 1 : 3;
+    int8_t out[3];
+
+    for (uint32_t v = 0; v < 256; v++) {
+        extract_image_quantize_pixel((v << 16) | (v << 8) | v, channel_count, out);
+        lut[v] = out[0];
+    }
+
+    *channels = (size_t)channel_count;
+
+    return EIDSP_OK;
+}
 #endif // EI_CLASSIFIER_TFLITE_INPUT_QUANTIZED == 1
 
 /**
@@ -1482,6 +1897,7 @@ __attribute__((unused)) int ei_dsp_clear_continuous_audio_state() {
     ei_dsp_cont_current_frame = nullptr;
     ei_dsp_cont_current_frame_size = 0;
     ei_dsp_cont_current_frame_ix = 0;
+    ei_dsp_cont_features_head = 0;
 
     return EIDSP_OK;
 }
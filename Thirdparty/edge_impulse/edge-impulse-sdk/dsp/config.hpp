@@ -102,6 +102,18 @@
 #define EIDSP_PRINT_ALLOCATIONS      1
 #endif
 
+// Run the FFT of the audio blocks on the ECM3532 DSP core, the target
+// provides ei_dsp_offload.h (needs the executor DSP image)
+#ifndef EIDSP_USE_ECM3532_DSP
+#define EIDSP_USE_ECM3532_DSP        0
+#endif // EIDSP_USE_ECM3532_DSP
+
+// Fractional bits of the int32 features the i16 (fixed-point) DSP blocks
+// write, a feature of 1.0 is 1 << EIDSP_I32_FEATURE_FRAC_BITS
+#ifndef EIDSP_I32_FEATURE_FRAC_BITS
+#define EIDSP_I32_FEATURE_FRAC_BITS  16
+#endif // EIDSP_I32_FEATURE_FRAC_BITS
+
 #ifndef EIDSP_SIGNAL_C_FN_POINTER
 #define EIDSP_SIGNAL_C_FN_POINTER    0
 #endif // EIDSP_SIGNAL_C_FN_POINTER
@@ -331,6 +331,44 @@ public:
         return EIDSP_OK;
     }
 
+    /**
+     * Multiply two matrices lazily per row in matrix 1 (MxN * NxK matrix),
+     * only visiting the stored run of every column of matrix 2
+     * @param i matrix1 row index
+     * @param row matrix1 row
+     * @param matrix1_cols matrix1 row size
+     * @param matrix2 Pointer to sparse matrix2 (NxK)
+     * @param out_matrix Pointer to out matrix (MxK)
+     * @returns EIDSP_OK if OK
+     */
+    static inline int dot_by_row(int i, const float *row, size_t matrix1_cols,
+        const sparse_matrix_t *matrix2, matrix_t *out_matrix)
+    {
+        if (matrix1_cols != matrix2->rows) {
+            EIDSP_ERR(EIDSP_MATRIX_SIZE_MISMATCH);
+        }
+
+        const auto *values = matrix2->values;
+        float *out = out_matrix->buffer + (i * matrix2->cols);
+
+        for (uint32_t j = 0; j < matrix2->cols; j++) {
+            const float *run = row + matrix2->col_start[j];
+            uint16_t length = matrix2->col_length[j];
+            float tmp = 0.0f;
+            for (uint16_t k = 0; k < length; k++) {
+#if EIDSP_QUANTIZE_FILTERBANK
+                tmp += run[k] * quantized_values_one_zero[values[k]];
+#else
+                tmp += run[k] * values[k];
+#endif
+            }
+            values += length;
+            out[j] = tmp;
+        }
+
+        return EIDSP_OK;
+    }
+
     /**
      * Transpose an array in place (from MxN to NxM)
      * Note: this temporary allocates a copy of the matrix on the heap.
@@ -666,6 +704,73 @@ public:
         return EIDSP_OK;
     }
 
+    /**
+     * Pad an int32 array, same as the float pad_1d_symmetric
+     */
+    static int pad_1d_symmetric(matrix_i32_t *input, matrix_i32_t *output, uint16_t pad_before, uint16_t pad_after) {
+        if (output->cols != input->cols) {
+            EIDSP_ERR(EIDSP_MATRIX_SIZE_MISMATCH);
+        }
+
+        if (output->rows != input->rows + pad_before + pad_after) {
+            EIDSP_ERR(EIDSP_MATRIX_SIZE_MISMATCH);
+        }
+
+        if (input->rows == 0) {
+            EIDSP_ERR(EIDSP_INPUT_MATRIX_EMPTY);
+        }
+
+        uint32_t pad_before_index = 0;
+        bool pad_before_direction_up = true;
+
+        for (int32_t ix = pad_before - 1; ix >= 0; ix--) {
+            memcpy(output->buffer + (input->cols * ix),
+                input->buffer + (pad_before_index * input->cols),
+                input->cols * sizeof(EIDSP_i32));
+
+            if (pad_before_index == 0 && !pad_before_direction_up) {
+                pad_before_direction_up = true;
+            }
+            else if (pad_before_index == input->rows - 1 && pad_before_direction_up) {
+                pad_before_direction_up = false;
+            }
+            else if (pad_before_direction_up) {
+                pad_before_index++;
+            }
+            else {
+                pad_before_index--;
+            }
+        }
+
+        memcpy(output->buffer + (input->cols * pad_before),
+            input->buffer,
+            input->rows * input->cols * sizeof(EIDSP_i32));
+
+        int32_t pad_after_index = input->rows - 1;
+        bool pad_after_direction_up = false;
+
+        for (int32_t ix = 0; ix < pad_after; ix++) {
+            memcpy(output->buffer + (input->cols * (ix + pad_before + input->rows)),
+                input->buffer + (pad_after_index * input->cols),
+                input->cols * sizeof(EIDSP_i32));
+
+            if (pad_after_index == 0 && !pad_after_direction_up) {
+                pad_after_direction_up = true;
+            }
+            else if (pad_after_index == static_cast<int32_t>(input->rows) - 1 && pad_after_direction_up) {
+                pad_after_direction_up = false;
+            }
+            else if (pad_after_direction_up) {
+                pad_after_index++;
+            }
+            else {
+                pad_after_index--;
+            }
+        }
+
+        return EIDSP_OK;
+    }
+
     /**
      * Scale a matrix in place
      * @param matrix
@@ -1503,6 +1608,7 @@ public:
         }
         return EIDSP_OK;
 #else
+        (void)src; (void)src_size; (void)output; (void)output_size; (void)n_fft;
         return EIDSP_REQUIRES_CMSIS_DSP;
 #endif
     }
@@ -1575,6 +1681,7 @@ public:
         }
         return EIDSP_OK;
 #else
+        (void)src; (void)src_size; (void)output; (void)output_size; (void)n_fft;
         return EIDSP_REQUIRES_CMSIS_DSP;
 #endif
     }
@@ -1729,10 +1836,91 @@ public:
 
         return EIDSP_OK;
 #else
+        (void)src; (void)src_size; (void)output; (void)output_size; (void)n_fft;
         return EIDSP_REQUIRES_CMSIS_DSP;
 #endif
     }
 
+    /**
+     * Compute the one-dimensional discrete Fourier Transform for real input,
+     * in q31. The output is scaled down by n_fft (as arm_rfft_q31 does), so
+     * inputs up to 2^31 can't overflow.
+     * Without CMSIS-DSP this runs through the float transform, scaled the same way.
+     * @param src Source buffer
+     * @param src_size Size of the source buffer
+     * @param output Output buffer, DFT / n_fft
+     * @param output_size Size of the output buffer, should be n_fft / 2 + 1
+     * @returns 0 if OK
+     */
+    static int rfft(const EIDSP_i32 *src, size_t src_size, fft_complex_i32_t *output, size_t output_size, size_t n_fft) {
+        size_t n_fft_out_features = (n_fft / 2) + 1;
+        if (output_size != n_fft_out_features) {
+            EIDSP_ERR(EIDSP_BUFFER_SIZE_MISMATCH);
+        }
+
+        // truncate if needed
+        if (src_size > n_fft) {
+            src_size = n_fft;
+        }
+
+#if EIDSP_USE_CMSIS_DSP
+        if (n_fft != 32 && n_fft != 64 && n_fft != 128 && n_fft != 256 &&
+            n_fft != 512 && n_fft != 1024 && n_fft != 2048 && n_fft != 4096) {
+            EIDSP_ERR(EIDSP_PARAMETER_INVALID); // fixed fft lib does not support arbitrary input length
+        }
+
+        arm_rfft_instance_q31 rfft_instance;
+        arm_status status = arm_rfft_init_q31(&rfft_instance, n_fft, 0, 1);
+        if (status != ARM_MATH_SUCCESS) {
+            return status;
+        }
+
+        // the transform works in place on its input, and writes both halves of the spectrum
+        EI_DSP_i32_MATRIX(fft_input, 1, n_fft);
+        EI_DSP_i32_MATRIX(fft_output, 1, n_fft << 1);
+        if (!fft_input.buffer || !fft_output.buffer) {
+            EIDSP_ERR(EIDSP_OUT_OF_MEM);
+        }
+
+        memcpy(fft_input.buffer, src, src_size * sizeof(EIDSP_i32));
+        memset(fft_input.buffer + src_size, 0, (n_fft - src_size) * sizeof(EIDSP_i32));
+
+        arm_rfft_q31(&rfft_instance, fft_input.buffer, fft_output.buffer);
+
+        for (size_t ix = 0; ix < n_fft_out_features; ix++) {
+            output[ix].r = fft_output.buffer[ix * 2];
+            output[ix].i = fft_output.buffer[ix * 2 + 1];
+        }
+#else
+        EI_DSP_MATRIX(fft_input, 1, n_fft);
+        fft_complex_t *fft_output = (fft_complex_t *)ei_dsp_malloc(n_fft_out_features * sizeof(fft_complex_t));
+        if (!fft_input.buffer || !fft_output) {
+            ei_dsp_free(fft_output, n_fft_out_features * sizeof(fft_complex_t));
+            EIDSP_ERR(EIDSP_OUT_OF_MEM);
+        }
+
+        float scale = 1.0f / static_cast<float>(n_fft);
+        for (size_t ix = 0; ix < src_size; ix++) {
+            fft_input.buffer[ix] = static_cast<float>(src[ix]) * scale;
+        }
+
+        int ret = software_rfft(fft_input.buffer, fft_output, n_fft, n_fft_out_features);
+        if (ret != EIDSP_OK) {
+            ei_dsp_free(fft_output, n_fft_out_features * sizeof(fft_complex_t));
+            EIDSP_ERR(ret);
+        }
+
+        for (size_t ix = 0; ix < n_fft_out_features; ix++) {
+            output[ix].r = static_cast<EIDSP_i32>(lrintf(fft_output[ix].r));
+            output[ix].i = static_cast<EIDSP_i32>(lrintf(fft_output[ix].i));
+        }
+
+        ei_dsp_free(fft_output, n_fft_out_features * sizeof(fft_complex_t));
+#endif
+
+        return EIDSP_OK;
+    }
+
     /**
      * Return evenly spaced numbers over a specified interval.
      * Returns num evenly spaced samples, calculated over the interval [start, stop].
@@ -2107,6 +2295,157 @@ public:
         return (int32_t)val;
     }
 
+    /**
+     * Represent a real scale factor for fixed_multiply. Meant to be done
+     * once up front, this is the only part that uses float.
+     * @param value Scale factor, >= 0
+     * @param out Multiplier
+     */
+    static void fixed_multiplier_init(float value, fixed_multiplier_t *out)
+    {
+        if (!(value > 0.0f)) {
+            out->multiplier = 0;
+            out->shift = 0;
+            return;
+        }
+
+        int exponent;
+        float fraction = frexpf(value, &exponent);
+        int64_t multiplier = (int64_t)(fraction * 2147483648.0f + 0.5f);
+        if (multiplier == (1LL << 31)) {
+            multiplier >>= 1;
+            exponent++;
+        }
+
+        out->multiplier = (int32_t)multiplier;
+        out->shift = exponent;
+    }
+
+    /**
+     * Multiply by a real scale factor in integer math
+     * @param x Value
+     * @param m Scale factor from fixed_multiplier_init
+     * @param shift Extra power of two to scale by
+     * @returns x * m * 2^shift, rounded and saturated to int32
+     */
+    static int32_t fixed_multiply(int64_t x, const fixed_multiplier_t *m, int shift = 0)
+    {
+        if (x == 0 || m->multiplier == 0) {
+            return 0;
+        }
+
+        bool negative = x < 0;
+        uint64_t value = negative ? -(uint64_t)x : (uint64_t)x;
+
+        // keep the top 32 bits so the product fits 64 bits
+        if (value >> 32) {
+            int drop = 32 - __builtin_clz((uint32_t)(value >> 32));
+            value >>= drop;
+            shift += drop;
+        }
+
+        uint64_t product = value * (uint32_t)m->multiplier;
+        int right_shift = 31 - m->shift - shift;
+        uint64_t result;
+
+        if (right_shift >= 64) {
+            return 0;
+        }
+        else if (right_shift > 0) {
+            result = (product + (1ULL << (right_shift - 1))) >> right_shift;
+        }
+        else if (right_shift > -32 && !(product >> (63 + right_shift))) {
+            result = product << -right_shift;
+        }
+        else {
+            result = 0x80000000ULL;
+        }
+
+        if (negative) {
+            return result > 0x80000000ULL ? INT32_MIN : -(int64_t)result;
+        }
+        return result > 0x7fffffffULL ? INT32_MAX : (int32_t)result;
+    }
+
+    /**
+     * Integer square root
+     * @returns floor(sqrt(x))
+     */
+    static uint32_t isqrt(uint64_t x)
+    {
+        uint64_t result = 0;
+        uint64_t bit = 1ULL << 62;
+
+        while (bit > x) {
+            bit >>= 2;
+        }
+
+        while (bit != 0) {
+            if (x >= result + bit) {
+                x -= result + bit;
+                result = (result >> 1) + bit;
+            }
+            else {
+                result >>= 1;
+            }
+            bit >>= 2;
+        }
+
+        return (uint32_t)result;
+    }
+
+    /**
+     * Integer base 2 logarithm, bit by bit from the squared mantissa
+     * @param x Value, > 0
+     * @returns log2(x) with 16 fractional bits, accurate to one step
+     */
+    static int32_t log2_fixed(uint64_t x)
+    {
+        int exponent = 63 - __builtin_clzll(x);
+
+        // mantissa in [1, 2) with 30 fractional bits
+        uint64_t m = exponent >= 30 ? x >> (exponent - 30) : x << (30 - exponent);
+        int32_t result = exponent * 65536;
+
+        for (int32_t bit = 32768; bit != 0; bit >>= 1) {
+            m = (m * m) >> 30;
+            if (m >= (2ULL << 30)) {
+                m >>= 1;
+                result += bit;
+            }
+        }
+
+        return result;
+    }
+
+    /**
+     * Quantize int32 fixed-point values to int8, as a tensor with
+     * real = (q - zero_point) * scale wants them
+     * @param input Values
+     * @param output int8 values, as many as input has
+     * @param multiplier 1 / (scale * one), where one is the fixed-point 1.0
+     * @param zero_point Zero point of the int8 values
+     * @returns 0 if OK
+     */
+    static int quantize_i32_to_i8(const matrix_i32_t *input, EIDSP_i8 *output,
+        const fixed_multiplier_t *multiplier, int32_t zero_point)
+    {
+        size_t size = input->rows * input->cols;
+
+        for (size_t ix = 0; ix < size; ix++) {
+            int64_t q = (int64_t)fixed_multiply(input->buffer[ix], multiplier) + zero_point;
+            if (q < -128) {
+                q = -128;
+            }
+            else if (q > 127) {
+                q = 127;
+            }
+            output[ix] = (EIDSP_i8)q;
+        }
+
+        return EIDSP_OK;
+    }
+
     /**
      * Normalize a matrix to 0..1. Does an in-place replacement.
      * Normalization done per row.
@@ -2227,6 +2566,8 @@ private:
 
     static int software_rfft(float *fft_input, fft_complex_t *output, size_t n_fft, size_t n_fft_out_features)
     {
+        (void)n_fft_out_features;
+
         // create fftr context
         size_t kiss_fftr_mem_length;
 
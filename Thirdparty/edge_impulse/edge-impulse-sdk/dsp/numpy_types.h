@@ -494,6 +494,33 @@ typedef struct ei_quantized_matrix {
 #endif // #ifdef __cplusplus
 } quantized_matrix_t;
 
+/**
+ * A sparse matrix (N x K) where the non-zero values of every column are in
+ * one run of consecutive rows, e.g. a transposed filterbank where every
+ * filter only touches a few FFT bins. Only the runs are stored, column after
+ * column. Plain struct, the buffers are allocated and freed by the owner.
+ */
+typedef struct {
+    uint32_t rows;
+    uint32_t cols;
+    uint16_t *col_start;  // first row of the run of every column
+    uint16_t *col_length; // number of rows in the run of every column
+#if EIDSP_QUANTIZE_FILTERBANK
+    uint8_t *values;      // quantized with numpy::quantize_zero_one
+#else
+    float *values;
+#endif
+} sparse_matrix_t;
+
+/**
+ * A real scale factor for integer math, multiplier * 2^(shift - 31) with
+ * multiplier in [2^30, 2^31), or 0. See numpy::fixed_multiplier_init.
+ */
+typedef struct {
+    int32_t multiplier;
+    int shift;
+} fixed_multiplier_t;
+
 /**
  * Size of a matrix
  */
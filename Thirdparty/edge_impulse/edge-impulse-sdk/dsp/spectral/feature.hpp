@@ -48,6 +48,43 @@ typedef enum {
     filter_highpass = 2
 } filter_t;
 
+#define EI_DSP_SPECTRAL_MAX_EDGES       64
+#define EI_DSP_SPECTRAL_NO_BUCKET       0xFF
+
+// Spectral analysis settings resolved once, see prepare_spectral_analysis
+typedef struct {
+    float sampling_freq;
+    filter_t filter_type;
+    filters::butterworth_t filter;
+    uint16_t fft_length;
+    uint8_t fft_peaks;
+    float fft_peaks_threshold;
+    uint16_t edges_count;
+    // power edge bucket of every periodogram bin, fft_length / 2 + 1 of them
+    uint8_t *bin_buckets;
+    uint16_t bucket_bins[EI_DSP_SPECTRAL_MAX_EDGES - 1];
+} spectral_analysis_prepared_t;
+
+// Fixed-point form of a prepared spectral analysis for int16 signals, see
+// prepare_spectral_analysis_fixed. Features come out with
+// EIDSP_I32_FEATURE_FRAC_BITS fractional bits.
+typedef struct {
+    // samples per axis this was resolved for, 0 if not resolved
+    uint32_t frames;
+    filters::butterworth_fixed_t filter;
+    // scale the RMS and the FFT peak magnitudes to features
+    fixed_multiplier_t rms_scale;
+    fixed_multiplier_t peak_scale;
+    int32_t fft_peaks_threshold;
+    // frequency step between the FFT peak bins, in q32
+    uint64_t peak_freq_step;
+    // scale the summed bin power of every edge bucket to a feature
+    fixed_multiplier_t bucket_scale[EI_DSP_SPECTRAL_MAX_EDGES - 1];
+    // FFT of the samples the periodogram detrends, fft_length / 2 + 1 bins,
+    // so detrending is a subtraction in the frequency domain
+    fft_complex_i32_t *detrend_fft;
+} spectral_analysis_fixed_t;
+
 class feature {
 public:
     /**
@@ -193,9 +230,24 @@ public:
         return EIDSP_OK;
     }
 
-    static int spectral_analysis(
-        matrix_i32_t *out_features,
-        matrix_i16_t *input_matrix,
+    /**
+     * Resolve everything spectral_analysis does not need to compute per
+     * window: the filter coefficients and the power edge of every
+     * periodogram bin. Release with release_spectral_analysis.
+     * @param prepared Output
+     * @param sampling_freq Sampling frequency of the signal
+     * @param filter_type Filter type
+     * @param filter_cutoff Filter cutoff frequency
+     * @param filter_order Filter order
+     * @param fft_length Length of the FFT signal
+     * @param fft_peaks Number of FFT peaks to find
+     * @param fft_peaks_threshold Minimum threshold
+     * @param edges Spectral power edges, ascending
+     * @param edges_count Number of edges
+     * @returns 0 if OK
+     */
+    static int prepare_spectral_analysis(
+        spectral_analysis_prepared_t *prepared,
         float sampling_freq,
         filter_t filter_type,
         float filter_cutoff,
@@ -203,26 +255,88 @@ public:
         uint16_t fft_length,
         uint8_t fft_peaks,
         float fft_peaks_threshold,
-        matrix_i16_t *edges_matrix_in
+        const float *edges,
+        size_t edges_count
     ) {
-        if (out_features->rows != input_matrix->rows) {
-            EIDSP_ERR(EIDSP_MATRIX_SIZE_MISMATCH);
+        if (edges_count > EI_DSP_SPECTRAL_MAX_EDGES) {
+            EIDSP_ERR(EIDSP_PARAMETER_INVALID);
         }
 
-        if (out_features->cols != calculate_spectral_buffer_size(true, fft_peaks, edges_matrix_in->rows)) {
+        memset(prepared, 0, sizeof(spectral_analysis_prepared_t));
+        prepared->sampling_freq = sampling_freq;
+        prepared->filter_type = filter_type;
+        prepared->fft_length = fft_length;
+        prepared->fft_peaks = fft_peaks;
+        prepared->fft_peaks_threshold = fft_peaks_threshold;
+        prepared->edges_count = edges_count;
+
+        if (filter_type != filter_none) {
+            int ret = filters::butterworth_init(&prepared->filter,
+                filter_type == filter_highpass, filter_order, sampling_freq, filter_cutoff);
+            if (ret != EIDSP_OK) {
+                EIDSP_ERR(ret);
+            }
+        }
+
+        size_t bins = fft_length / 2 + 1;
+        prepared->bin_buckets = (uint8_t *)ei_malloc(bins);
+        if (!prepared->bin_buckets) {
+            EIDSP_ERR(EIDSP_OUT_OF_MEM);
+        }
+
+        // same frequencies and bucket test as periodogram and spectral_power_edges
+        for (size_t ix = 0; ix < bins; ix++) {
+            float t = static_cast<float>(ix) * (1.0f / (fft_length * (1.0f / sampling_freq)));
+
+            prepared->bin_buckets[ix] = EI_DSP_SPECTRAL_NO_BUCKET;
+            for (size_t ex = 0; ex + 1 < edges_count; ex++) {
+                if (t >= edges[ex] && t < edges[ex + 1]) {
+                    prepared->bin_buckets[ix] = ex;
+                    prepared->bucket_bins[ex]++;
+                    break;
+                }
+            }
+        }
+
+        return EIDSP_OK;
+    }
+
+    static void release_spectral_analysis(spectral_analysis_prepared_t *prepared)
+    {
+        ei_free(prepared->bin_buckets);
+        prepared->bin_buckets = NULL;
+    }
+
+    /**
+     * Calculate the spectral features over a signal, with the settings
+     * resolved by prepare_spectral_analysis.
+     * @param out_features Output matrix. Use `calculate_spectral_buffer_size` to calculate
+     *  the size required. Needs as many rows as `raw_data`.
+     * @param input_matrix Signal, with one row per axis
+     * @param prepared Prepared settings
+     * @returns 0 if OK
+     */
+    static int spectral_analysis(
+        matrix_t *out_features,
+        matrix_t *input_matrix,
+        const spectral_analysis_prepared_t *prepared
+    ) {
+        if (out_features->rows != input_matrix->rows) {
             EIDSP_ERR(EIDSP_MATRIX_SIZE_MISMATCH);
         }
 
-        if (edges_matrix_in->cols != 1) {
+        if (out_features->cols != calculate_spectral_buffer_size(true, prepared->fft_peaks, prepared->edges_count)) {
             EIDSP_ERR(EIDSP_MATRIX_SIZE_MISMATCH);
         }
 
         int ret;
 
         size_t axes = input_matrix->rows;
+        uint16_t fft_length = prepared->fft_length;
+        size_t buckets = prepared->edges_count > 0 ? prepared->edges_count - 1 : 0;
 
         // calculate the mean
-        EI_DSP_i16_MATRIX(mean_matrix, axes, 1);
+        EI_DSP_MATRIX(mean_matrix, axes, 1);
         ret = numpy::mean(input_matrix, &mean_matrix);
         if (ret != EIDSP_OK) {
             EIDSP_ERR(EIDSP_MATRIX_SIZE_MISMATCH);
@@ -235,53 +349,35 @@ public:
         }
 
         // apply filter
-        if (filter_type == filter_lowpass) {
-            ret = spectral::processing::i16_filter(
-                input_matrix, sampling_freq, filter_order, filter_cutoff, 0);
-            if (ret != EIDSP_OK) {
-                EIDSP_ERR(EIDSP_MATRIX_SIZE_MISMATCH);
-            }
-        }
-        else if (filter_type == filter_highpass) {
-            ret = spectral::processing::i16_filter(
-                input_matrix, sampling_freq, filter_order, 0, filter_cutoff);
-            if (ret != EIDSP_OK) {
-                EIDSP_ERR(EIDSP_MATRIX_SIZE_MISMATCH);
+        if (prepared->filter_type != filter_none) {
+            for (size_t row = 0; row < axes; row++) {
+                float *axis = input_matrix->buffer + (row * input_matrix->cols);
+                filters::butterworth_apply(&prepared->filter, axis, axis, input_matrix->cols);
             }
         }
 
         // calculate RMS
-        EI_DSP_i16_MATRIX(rms_matrix, axes, 1);
+        EI_DSP_MATRIX(rms_matrix, axes, 1);
         ret = numpy::rms(input_matrix, &rms_matrix);
         if (ret != EIDSP_OK) {
             EIDSP_ERR(EIDSP_MATRIX_SIZE_MISMATCH);
         }
 
-        // calculate FFT
-        EI_DSP_i32_MATRIX(fft_matrix, 1, fft_length / 2 + 1);
-        ei_matrix_i32 axis_matrix_i32(1, input_matrix->cols);
-
-        // find peaks in FFT
-        EI_DSP_i16_MATRIX(peaks_matrix, axes, fft_peaks * 2);
-
-        // EIDSP_i16 fft_scaled = fft_length / 10;
-
-        EI_DSP_i16_MATRIX(period_fft_matrix, 1, fft_length / 2 + 1);
-        EI_DSP_i16_MATRIX(period_freq_matrix, 1, fft_length / 2 + 1);
-        EI_DSP_i16_MATRIX(edges_matrix_out, edges_matrix_in->rows - 1, 1);
-
-        for (size_t row = 0; row < input_matrix->rows; row++) {
-            // per axis code
+        EI_DSP_MATRIX(fft_matrix, 1, fft_length / 2 + 1);
+        EI_DSP_MATRIX(peaks_matrix, prepared->fft_peaks, 2);
+        EI_DSP_MATRIX(period_fft_matrix, 1, fft_length / 2 + 1);
+        EI_DSP_MATRIX(period_freq_matrix, 1, fft_length / 2 + 1);
+        EI_DSP_MATRIX(buckets_matrix, 1, buckets);
+        if (!fft_matrix.buffer || !period_fft_matrix.buffer || !period_freq_matrix.buffer) {
+            EIDSP_ERR(EIDSP_OUT_OF_MEM);
+        }
 
+        for (size_t row = 0; row < axes; row++) {
             // get a slice of the current axis
-            EI_DSP_i16_MATRIX_B(axis_matrix, 1, input_matrix->cols, input_matrix->buffer + (row * input_matrix->cols));
-
-            // Convert to i32 for accuracy
-            for(uint32_t i = 0; i < input_matrix->cols; i++) {
-                axis_matrix_i32.buffer[i] = ((EIDSP_i32)axis_matrix.buffer[i]) << 16;
-            }
+            EI_DSP_MATRIX_B(axis_matrix, 1, input_matrix->cols, input_matrix->buffer + (row * input_matrix->cols));
 
-            ret = numpy::rfft(axis_matrix_i32.buffer, axis_matrix.cols, fft_matrix.buffer, fft_matrix.cols, fft_length);
+            // calculate FFT
+            ret = numpy::rfft(axis_matrix.buffer, axis_matrix.cols, fft_matrix.buffer, fft_matrix.cols, fft_length);
             if (ret != EIDSP_OK) {
                 EIDSP_ERR(EIDSP_MATRIX_SIZE_MISMATCH);
             }
@@ -289,48 +385,324 @@ public:
             // multiply by 2/N
             numpy::scale(&fft_matrix, (2.0f / static_cast<float>(fft_length)));
 
-            // we're now using the FFT matrix to calculate peaks etc.
-            EI_DSP_i32_MATRIX(peaks_matrix, fft_peaks, 2);
-            ret = spectral::processing::find_fft_peaks(&fft_matrix, &peaks_matrix, sampling_freq, fft_peaks_threshold, fft_length);
+            ret = spectral::processing::find_fft_peaks(&fft_matrix, &peaks_matrix,
+                prepared->sampling_freq, prepared->fft_peaks_threshold, fft_length);
             if (ret != EIDSP_OK) {
                 EIDSP_ERR(EIDSP_MATRIX_SIZE_MISMATCH);
             }
 
             // calculate periodogram for spectral power buckets
             ret = spectral::processing::periodogram(&axis_matrix,
-                &period_fft_matrix, &period_freq_matrix, sampling_freq, fft_length);
+                &period_fft_matrix, &period_freq_matrix, prepared->sampling_freq, fft_length);
             if (ret != EIDSP_OK) {
                 EIDSP_ERR(ret);
             }
 
-            // EI_DSP_i16_MATRIX(edges_matrix_out, edges_matrix_in->rows - 1, 1);
-            ret = spectral::processing::spectral_power_edges(
-                &period_fft_matrix,
-                &period_freq_matrix,
-                edges_matrix_in,
-                &edges_matrix_out,
-                sampling_freq);
-            if (ret != EIDSP_OK) {
-                EIDSP_ERR(ret);
+            // average the power per bucket, bins were mapped up front
+            for (size_t ex = 0; ex < buckets; ex++) {
+                buckets_matrix.buffer[ex] = 0.0f;
+            }
+            for (size_t ix = 0; ix < period_fft_matrix.cols; ix++) {
+                uint8_t ex = prepared->bin_buckets[ix];
+                if (ex != EI_DSP_SPECTRAL_NO_BUCKET) {
+                    buckets_matrix.buffer[ex] += period_fft_matrix.buffer[ix];
+                }
             }
 
-            EIDSP_i32 *features_row = out_features->buffer + (row * out_features->cols);
+            float *features_row = out_features->buffer + (row * out_features->cols);
 
             size_t fx = 0;
 
             features_row[fx++] = rms_matrix.buffer[row];
-
             for (size_t peak_row = 0; peak_row < peaks_matrix.rows; peak_row++) {
+                features_row[fx++] = peaks_matrix.buffer[peak_row * peaks_matrix.cols + 0];
+                features_row[fx++] = peaks_matrix.buffer[peak_row * peaks_matrix.cols + 1];
+            }
+            for (size_t ex = 0; ex < buckets; ex++) {
+                float power = 0.0f;
+                if (prepared->bucket_bins[ex] != 0) {
+                    power = buckets_matrix.buffer[ex] / static_cast<float>(prepared->bucket_bins[ex]);
+                }
+                features_row[fx++] = power / 10.0f;
+            }
+        }
 
-                features_row[fx++] = (EIDSP_i16)(peaks_matrix.buffer[peak_row * peaks_matrix.cols + 0] >> 16) * fft_length;
-                features_row[fx++] = (EIDSP_i16)(peaks_matrix.buffer[peak_row * peaks_matrix.cols + 1] >> 16) * fft_length;
+        return EIDSP_OK;
+    }
+
+    /**
+     * Resolve the fixed-point form of a prepared spectral analysis, for
+     * windows of int16 samples. Everything that needs float happens here,
+     * the per window math in spectral_analysis is integer only.
+     * Release with release_spectral_analysis_fixed.
+     * @param fixed Output
+     * @param prepared Settings from prepare_spectral_analysis
+     * @param frames Samples per axis of every window
+     * @param input_scale Value of one int16 step, the float DSP block would
+     *  get sample * input_scale as its input
+     * @returns 0 if OK
+     */
+    static int prepare_spectral_analysis_fixed(
+        spectral_analysis_fixed_t *fixed,
+        const spectral_analysis_prepared_t *prepared,
+        uint32_t frames,
+        float input_scale
+    ) {
+        uint16_t fft_length = prepared->fft_length;
+        size_t bins = fft_length / 2 + 1;
+        size_t buckets = prepared->edges_count > 0 ? prepared->edges_count - 1 : 0;
+
+        if (frames == 0 || fft_length < 4) {
+            EIDSP_ERR(EIDSP_PARAMETER_INVALID);
+        }
+
+        memset(fixed, 0, sizeof(spectral_analysis_fixed_t));
+
+        if (prepared->filter_type != filter_none) {
+            filters::butterworth_fixed_init(&fixed->filter, &prepared->filter);
+        }
+
+        // samples are filtered with 8 fractional bits
+        const float one = static_cast<float>(1L << EIDSP_I32_FEATURE_FRAC_BITS);
+        float sample_scale = input_scale * one / 256.0f;
+
+        numpy::fixed_multiplier_init(sample_scale, &fixed->rms_scale);
+        // find_fft_peaks works on the magnitudes times 2 / N, the fixed
+        // transform already is DFT / N
+        numpy::fixed_multiplier_init(2.0f * sample_scale, &fixed->peak_scale);
+        fixed->fft_peaks_threshold = static_cast<int32_t>(lrintf(prepared->fft_peaks_threshold * one));
+
+        // same frequencies as the linspace in find_fft_peaks
+        float freq_step = (prepared->sampling_freq / 2.0f) / static_cast<float>(fft_length / 2 - 1);
+        fixed->peak_freq_step = static_cast<uint64_t>(freq_step * 4294967296.0f + 0.5f);
+
+        // periodogram: power = m * |DFT|^2 / (fs * nperseg), with |DFT| = N * |X|;
+        // the summed bin power is shifted down by the bit length of N
+        uint32_t nperseg = frames < fft_length ? frames : fft_length;
+        int power_bits = 32 - __builtin_clz(fft_length);
+        float power_scale = (static_cast<float>(fft_length) * static_cast<float>(fft_length)) *
+            static_cast<float>(1L << power_bits) /
+            (prepared->sampling_freq * static_cast<float>(nperseg)) *
+            (input_scale * input_scale) * one / 65536.0f;
+
+        for (size_t ex = 0; ex < buckets; ex++) {
+            if (prepared->bucket_bins[ex] != 0) {
+                numpy::fixed_multiplier_init(
+                    power_scale / (10.0f * static_cast<float>(prepared->bucket_bins[ex])),
+                    &fixed->bucket_scale[ex]);
             }
+        }
 
-            for (size_t edge_row = 0; edge_row < edges_matrix_out.rows; edge_row++) {
-                features_row[fx] = (EIDSP_i16)(edges_matrix_out.buffer[edge_row * edges_matrix_out.cols] >> 16);
+        // periodogram subtracts the mean of the first nperseg samples, that
+        // is mean * DFT(ones over nperseg) / N in the frequency domain, in q30
+        fixed->detrend_fft = (fft_complex_i32_t *)ei_malloc(bins * sizeof(fft_complex_i32_t));
+        if (!fixed->detrend_fft) {
+            EIDSP_ERR(EIDSP_OUT_OF_MEM);
+        }
+
+        const float q30 = static_cast<float>(1L << 30);
+        fixed->detrend_fft[0].r = static_cast<int32_t>(lrintf(q30 * nperseg / fft_length));
+        fixed->detrend_fft[0].i = 0;
+        for (size_t ix = 1; ix < bins; ix++) {
+            // sum of e^-j*theta*n over n < nperseg = (1 - e^-j*theta*nperseg) / (1 - e^-j*theta)
+            float theta = 2.0f * static_cast<float>(M_PI) * ix / fft_length;
+            float nr = 1.0f - cosf(theta * nperseg), ni = sinf(theta * nperseg);
+            float dr = 1.0f - cosf(theta), di = sinf(theta);
+            float d = (dr * dr + di * di) * fft_length;
+            fixed->detrend_fft[ix].r = static_cast<int32_t>(lrintf(q30 * (nr * dr + ni * di) / d));
+            fixed->detrend_fft[ix].i = static_cast<int32_t>(lrintf(q30 * (ni * dr - nr * di) / d));
+        }
+
+        fixed->frames = frames;
+
+        return EIDSP_OK;
+    }
+
+    static void release_spectral_analysis_fixed(spectral_analysis_fixed_t *fixed)
+    {
+        ei_free(fixed->detrend_fft);
+        fixed->detrend_fft = NULL;
+        fixed->frames = 0;
+    }
+
+    /**
+     * Calculate the spectral features over an int16 signal in integer math,
+     * same features as the float spectral_analysis. For the FPU-less cores.
+     * @param out_features Output matrix, features with EIDSP_I32_FEATURE_FRAC_BITS
+     *  fractional bits. Use `calculate_spectral_buffer_size` to calculate
+     *  the size required. Needs as many rows as `raw_data`.
+     * @param input_matrix Signal, with one row per axis
+     * @param prepared Prepared settings
+     * @param fixed Fixed-point settings for windows of input_matrix->cols samples
+     * @returns 0 if OK
+     */
+    static int spectral_analysis(
+        matrix_i32_t *out_features,
+        matrix_i16_t *input_matrix,
+        const spectral_analysis_prepared_t *prepared,
+        const spectral_analysis_fixed_t *fixed
+    ) {
+        if (out_features->rows != input_matrix->rows) {
+            EIDSP_ERR(EIDSP_MATRIX_SIZE_MISMATCH);
+        }
+
+        if (out_features->cols != calculate_spectral_buffer_size(true, prepared->fft_peaks, prepared->edges_count)) {
+            EIDSP_ERR(EIDSP_MATRIX_SIZE_MISMATCH);
+        }
+
+        if (fixed->frames != input_matrix->cols) {
+            EIDSP_ERR(EIDSP_MATRIX_SIZE_MISMATCH);
+        }
+
+        int ret;
+
+        size_t axes = input_matrix->rows;
+        size_t frames = input_matrix->cols;
+        uint16_t fft_length = prepared->fft_length;
+        size_t bins = fft_length / 2 + 1;
+        size_t buckets = prepared->edges_count > 0 ? prepared->edges_count - 1 : 0;
+        size_t nperseg = frames < fft_length ? frames : fft_length;
+        int power_bits = 32 - __builtin_clz(fft_length);
+        const int frac_shift = 32 - EIDSP_I32_FEATURE_FRAC_BITS;
+
+        EI_DSP_i32_MATRIX(axis_matrix, 1, frames);
+        EI_DSP_i32_MATRIX(peaks_matrix, prepared->fft_peaks, 2);
+        uint64_t *bucket_power = (uint64_t *)ei_dsp_malloc((buckets + 1) * sizeof(uint64_t));
+        fft_complex_i32_t *fft_output = (fft_complex_i32_t *)ei_dsp_malloc(bins * sizeof(fft_complex_i32_t));
+        if (!bucket_power || !fft_output) {
+            ei_dsp_free(bucket_power, (buckets + 1) * sizeof(uint64_t));
+            ei_dsp_free(fft_output, bins * sizeof(fft_complex_i32_t));
+            EIDSP_ERR(EIDSP_OUT_OF_MEM);
+        }
+
+        for (size_t row = 0; row < axes; row++) {
+            const EIDSP_i16 *in = input_matrix->buffer + (row * frames);
+            int32_t *y = axis_matrix.buffer;
+
+            // subtract the mean, with 8 fractional bits
+            int64_t sum = 0;
+            for (size_t ix = 0; ix < frames; ix++) {
+                sum += in[ix];
+            }
+            int64_t mean = (sum * 256 + (int64_t)(frames / 2) * (sum < 0 ? -1 : 1)) / (int64_t)frames;
+            for (size_t ix = 0; ix < frames; ix++) {
+                y[ix] = (int32_t)in[ix] * 256 - (int32_t)mean;
+            }
+
+            if (prepared->filter_type != filter_none) {
+                filters::butterworth_fixed_apply(&fixed->filter, y, y, frames);
+            }
+
+            // RMS, and the headroom for the transform
+            uint64_t square_sum = 0;
+            uint32_t max = 0;
+            for (size_t ix = 0; ix < frames; ix++) {
+                uint32_t v = y[ix] < 0 ? -(uint32_t)y[ix] : (uint32_t)y[ix];
+                square_sum += (uint64_t)v * v;
+                if (v > max) {
+                    max = v;
+                }
+            }
+            uint32_t rms = numpy::isqrt((square_sum + frames / 2) / frames);
+
+            // scale the samples to just under 2^29, |X| then stays below 2^29
+            // and detrending below 2^30
+            int shift = max == 0 ? 0 : __builtin_clz(max) - 3;
+            if (shift > 0) {
+                for (size_t ix = 0; ix < frames; ix++) {
+                    y[ix] *= (1 << shift);
+                }
+            }
+            else if (shift < 0) {
+                for (size_t ix = 0; ix < frames; ix++) {
+                    y[ix] = (y[ix] + (1 << (-shift - 1))) >> -shift;
+                }
+            }
+
+            ret = numpy::rfft(y, frames, fft_output, bins, fft_length);
+            if (ret != EIDSP_OK) {
+                ei_dsp_free(bucket_power, (buckets + 1) * sizeof(uint64_t));
+                ei_dsp_free(fft_output, bins * sizeof(fft_complex_i32_t));
+                EIDSP_ERR(ret);
+            }
+
+            // FFT peaks, same selection as find_fft_peaks: the first fft_peaks * 10
+            // local maxima, dropped under the threshold, the largest ones first.
+            // Local maxima compare on the squared magnitude.
+            memset(peaks_matrix.buffer, 0, prepared->fft_peaks * 2 * sizeof(EIDSP_i32));
+            uint64_t prev = (uint64_t)((int64_t)fft_output[0].r * fft_output[0].r) +
+                (uint64_t)((int64_t)fft_output[0].i * fft_output[0].i);
+            uint64_t cur = (uint64_t)((int64_t)fft_output[1].r * fft_output[1].r) +
+                (uint64_t)((int64_t)fft_output[1].i * fft_output[1].i);
+            size_t found = 0;
+            for (size_t ix = 1; ix < bins - 1 && found < (size_t)prepared->fft_peaks * 10; ix++) {
+                uint64_t next = (uint64_t)((int64_t)fft_output[ix + 1].r * fft_output[ix + 1].r) +
+                    (uint64_t)((int64_t)fft_output[ix + 1].i * fft_output[ix + 1].i);
+
+                if (cur > prev && cur > next) {
+                    found++;
+
+                    int32_t amplitude = numpy::fixed_multiply(numpy::isqrt(cur), &fixed->peak_scale, -shift);
+                    if (amplitude >= fixed->fft_peaks_threshold) {
+                        int32_t freq = (int32_t)((ix * fixed->peak_freq_step + (1ULL << (frac_shift - 1))) >> frac_shift);
+
+                        for (size_t px = 0; px < prepared->fft_peaks; px++) {
+                            if (amplitude > peaks_matrix.buffer[px * 2 + 1]) {
+                                memmove(peaks_matrix.buffer + (px + 1) * 2, peaks_matrix.buffer + px * 2,
+                                    (prepared->fft_peaks - px - 1) * 2 * sizeof(EIDSP_i32));
+                                peaks_matrix.buffer[px * 2] = freq;
+                                peaks_matrix.buffer[px * 2 + 1] = amplitude;
+                                break;
+                            }
+                        }
+                    }
+                }
+
+                prev = cur;
+                cur = next;
+            }
+
+            // periodogram, detrended in the frequency domain
+            int64_t detrend_sum = 0;
+            for (size_t ix = 0; ix < nperseg; ix++) {
+                detrend_sum += y[ix];
+            }
+            int64_t detrend = detrend_sum / (int64_t)nperseg;
+
+            memset(bucket_power, 0, (buckets + 1) * sizeof(uint64_t));
+            for (size_t ix = 0; ix < bins; ix++) {
+                uint8_t ex = prepared->bin_buckets[ix];
+                if (ex == EI_DSP_SPECTRAL_NO_BUCKET) {
+                    continue;
+                }
+
+                int64_t zr = fft_output[ix].r - ((detrend * fixed->detrend_fft[ix].r) >> 30);
+                int64_t zi = fft_output[ix].i - ((detrend * fixed->detrend_fft[ix].i) >> 30);
+                uint64_t power = (uint64_t)(zr * zr) + (uint64_t)(zi * zi);
+                if (ix != bins - 1) {
+                    power <<= 1;
+                }
+                bucket_power[ex] += power >> power_bits;
+            }
+
+            EIDSP_i32 *features_row = out_features->buffer + (row * out_features->cols);
+
+            size_t fx = 0;
+
+            features_row[fx++] = numpy::fixed_multiply(rms, &fixed->rms_scale);
+            for (size_t peak_row = 0; peak_row < peaks_matrix.rows; peak_row++) {
+                features_row[fx++] = peaks_matrix.buffer[peak_row * peaks_matrix.cols + 0];
+                features_row[fx++] = peaks_matrix.buffer[peak_row * peaks_matrix.cols + 1];
+            }
+            for (size_t ex = 0; ex < buckets; ex++) {
+                features_row[fx++] = numpy::fixed_multiply((int64_t)bucket_power[ex],
+                    &fixed->bucket_scale[ex], -2 * shift);
             }
         }
 
+        ei_dsp_free(bucket_power, (buckets + 1) * sizeof(uint64_t));
+        ei_dsp_free(fft_output, bins * sizeof(fft_complex_i32_t));
+
         return EIDSP_OK;
     }
 
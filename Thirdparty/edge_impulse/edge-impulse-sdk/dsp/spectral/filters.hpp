@@ -157,6 +157,168 @@ namespace filters {
         ei_free(w2);
     }
 
+    // Butterworth with its coefficients computed once, see butterworth_init
+    #define EI_DSP_BUTTERWORTH_MAX_ORDER    8
+
+    typedef struct {
+        int n_steps;
+        bool highpass;
+        float A[EI_DSP_BUTTERWORTH_MAX_ORDER / 2];
+        float d1[EI_DSP_BUTTERWORTH_MAX_ORDER / 2];
+        float d2[EI_DSP_BUTTERWORTH_MAX_ORDER / 2];
+    } butterworth_t;
+
+    /**
+     * Compute the Butterworth filter parameters, same as butterworth_lowpass
+     * and butterworth_highpass do on every call.
+     * @param filter Filter to initialize
+     * @param highpass Highpass when true, lowpass otherwise
+     * @param filter_order Even filter order (between 2..8)
+     * @param sampling_freq Sample frequency of the signal
+     * @param cutoff_freq Cut-off frequency of the signal
+     * @returns 0 if OK
+     */
+    static int butterworth_init(
+        butterworth_t *filter,
+        bool highpass,
+        int filter_order,
+        float sampling_freq,
+        float cutoff_freq)
+    {
+        if (filter_order < 0 || filter_order > EI_DSP_BUTTERWORTH_MAX_ORDER) {
+            EIDSP_ERR(EIDSP_PARAMETER_INVALID);
+        }
+
+        filter->n_steps = filter_order / 2;
+        filter->highpass = highpass;
+
+        float a = tan(M_PI * cutoff_freq / sampling_freq);
+        float a2 = pow(a, 2);
+
+        for (int ix = 0; ix < filter->n_steps; ix++) {
+            float r = sin(M_PI * ((2.0 * ix) + 1.0) / (2.0 * filter_order));
+            sampling_freq = a2 + (2.0 * a * r) + 1.0;
+            filter->A[ix] = highpass ? 1.0f / sampling_freq : a2 / sampling_freq;
+            filter->d1[ix] = 2.0 * (1 - a2) / sampling_freq;
+            filter->d2[ix] = -(a2 - (2.0 * a * r) + 1.0) / sampling_freq;
+        }
+
+        return EIDSP_OK;
+    }
+
+    /**
+     * Apply a filter from butterworth_init, src and dest may be the same.
+     * @param filter Initialized filter
+     * @param src Source array
+     * @param dest Destination array
+     * @param size Size of both source and destination arrays
+     */
+    static void butterworth_apply(
+        const butterworth_t *filter,
+        const float *src,
+        float *dest,
+        size_t size)
+    {
+        float w0[EI_DSP_BUTTERWORTH_MAX_ORDER / 2];
+        float w1[EI_DSP_BUTTERWORTH_MAX_ORDER / 2] = { 0 };
+        float w2[EI_DSP_BUTTERWORTH_MAX_ORDER / 2] = { 0 };
+        float sign = filter->highpass ? -1.0f : 1.0f;
+
+        for (size_t sx = 0; sx < size; sx++) {
+            dest[sx] = src[sx];
+
+            for (int i = 0; i < filter->n_steps; i++) {
+                w0[i] = filter->d1[i] * w1[i] + filter->d2[i] * w2[i] + dest[sx];
+                dest[sx] = filter->A[i] * (w0[i] + (sign * 2.0 * w1[i]) + w2[i]);
+                w2[i] = w1[i];
+                w1[i] = w0[i];
+            }
+        }
+    }
+
+    // Fractional bits of the fixed-point Butterworth coefficients, and the
+    // extra bits of precision the filter state carries over its input
+    #define EI_DSP_BUTTERWORTH_COEF_BITS    30
+    #define EI_DSP_BUTTERWORTH_STATE_BITS   16
+
+    // butterworth_t with its coefficients in fixed point, see butterworth_fixed_init
+    typedef struct {
+        int n_steps;
+        bool highpass;
+        int32_t A[EI_DSP_BUTTERWORTH_MAX_ORDER / 2];
+        int32_t d1[EI_DSP_BUTTERWORTH_MAX_ORDER / 2];
+        int32_t d2[EI_DSP_BUTTERWORTH_MAX_ORDER / 2];
+    } butterworth_fixed_t;
+
+    /**
+     * Convert the coefficients of an initialized filter to fixed point.
+     * All of them are within (-2, 2).
+     * @param fixed Filter to initialize
+     * @param filter Filter from butterworth_init
+     */
+    static void butterworth_fixed_init(butterworth_fixed_t *fixed, const butterworth_t *filter)
+    {
+        const float one = static_cast<float>(1L << EI_DSP_BUTTERWORTH_COEF_BITS);
+
+        fixed->n_steps = filter->n_steps;
+        fixed->highpass = filter->highpass;
+
+        for (int ix = 0; ix < filter->n_steps; ix++) {
+            fixed->A[ix] = static_cast<int32_t>(lrintf(filter->A[ix] * one));
+            fixed->d1[ix] = static_cast<int32_t>(lrintf(filter->d1[ix] * one));
+            fixed->d2[ix] = static_cast<int32_t>(lrintf(filter->d2[ix] * one));
+        }
+    }
+
+    /**
+     * Multiply a filter state by a coefficient, 64 x 32 bits without
+     * overflowing the 64 bit product
+     */
+    static inline int64_t butterworth_fixed_mul(int64_t state, int32_t coef)
+    {
+        int64_t high = (state >> 32) * coef;
+        int64_t low = ((int64_t)(uint32_t)state * coef) >> EI_DSP_BUTTERWORTH_COEF_BITS;
+
+        return high * (1LL << (32 - EI_DSP_BUTTERWORTH_COEF_BITS)) + low;
+    }
+
+    /**
+     * Apply a filter from butterworth_fixed_init, same as butterworth_apply
+     * in integer math. src and dest may be the same.
+     * Samples up to 2^25 in magnitude are fine for cutoffs down to 1/1000
+     * of the sampling frequency.
+     * @param filter Initialized filter
+     * @param src Source array
+     * @param dest Destination array
+     * @param size Size of both source and destination arrays
+     */
+    static void butterworth_fixed_apply(
+        const butterworth_fixed_t *filter,
+        const int32_t *src,
+        int32_t *dest,
+        size_t size)
+    {
+        int64_t w0;
+        int64_t w1[EI_DSP_BUTTERWORTH_MAX_ORDER / 2] = { 0 };
+        int64_t w2[EI_DSP_BUTTERWORTH_MAX_ORDER / 2] = { 0 };
+        const int64_t round = 1LL << (EI_DSP_BUTTERWORTH_STATE_BITS - 1);
+
+        for (size_t sx = 0; sx < size; sx++) {
+            int64_t value = (int64_t)src[sx] * (1LL << EI_DSP_BUTTERWORTH_STATE_BITS);
+
+            for (int i = 0; i < filter->n_steps; i++) {
+                w0 = butterworth_fixed_mul(w1[i], filter->d1[i]) +
+                    butterworth_fixed_mul(w2[i], filter->d2[i]) + value;
+                value = filter->highpass ? (w0 - 2 * w1[i] + w2[i]) : (w0 + 2 * w1[i] + w2[i]);
+                value = butterworth_fixed_mul(value, filter->A[i]);
+                w2[i] = w1[i];
+                w1[i] = w0;
+            }
+
+            dest[sx] = static_cast<int32_t>((value + round) >> EI_DSP_BUTTERWORTH_STATE_BITS);
+        }
+    }
+
 } // namespace filters
 } // namespace spectral
 } // namespace ei
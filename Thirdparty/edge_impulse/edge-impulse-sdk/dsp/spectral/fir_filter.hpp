@@ -109,6 +109,7 @@ public:
         float highpass_cutoff = 0,
         int decimation_ratio = 1) :  taps(filter_size) , history(filter_size, 0)
     {
+        (void)decimation_ratio;
         this->filter_size = filter_size;
         std::vector<float> f_taps(filter_size, 0);
         if( highpass_cutoff == 0 && lowpass_cutoff == 0 ) 
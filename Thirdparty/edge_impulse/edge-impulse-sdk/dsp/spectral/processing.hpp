@@ -186,7 +186,7 @@ namespace processing {
      * TODO (will the cutoff be the start of rolloff, or the -20 dB level?)
      * @return int always EIDSP_OK (for now)
      */
-    static int i16_filter(
+    __attribute__((unused)) static int i16_filter(
         matrix_i16_t *matrix,
         float sampling_frequency,
         uint8_t filter_order,
@@ -525,7 +525,7 @@ namespace processing {
     }
 
 
-    static int find_fft_peaks(
+    __attribute__((unused)) static int find_fft_peaks(
         matrix_i32_t *fft_matrix,
         matrix_i32_t *output_matrix,
         float sampling_freq,
@@ -626,6 +626,8 @@ namespace processing {
         matrix_t *output_matrix,
         float sampling_freq
     ) {
+        (void)sampling_freq;
+
         if (fft_matrix->rows != 1 || freq_matrix->rows != 1) {
             EIDSP_ERR(EIDSP_MATRIX_SIZE_MISMATCH);
         }
@@ -679,6 +681,8 @@ namespace processing {
         matrix_i16_t *output_matrix,
         float sampling_freq
     ) {
+        (void)sampling_freq;
+
         if (fft_matrix->rows != 1 || freq_matrix->rows != 1) {
             EIDSP_ERR(EIDSP_MATRIX_SIZE_MISMATCH);
         }
@@ -44,54 +44,88 @@
 namespace ei {
 namespace speechpy {
 
+// Mel filterbanks kept by mfe() for the next call, one per set of settings
+#ifndef EI_DSP_FILTERBANK_CACHE_SIZE
+#define EI_DSP_FILTERBANK_CACHE_SIZE        2
+#endif
+
+typedef struct {
+    uint32_t sampling_freq;
+    uint32_t low_freq;
+    uint32_t high_freq;
+    uint16_t num_filter;
+    uint16_t coefficients;
+    sparse_matrix_t filterbanks;
+} filterbank_cache_entry_t;
+
+// Fixed-point form of the MFE / MFCC settings for int16 signals, see
+// prepare_mfe_fixed. Features come out with EIDSP_I32_FEATURE_FRAC_BITS
+// fractional bits.
+typedef struct {
+    // signal length this was resolved for, 0 if not resolved
+    uint32_t signal_length;
+    // frames as stack_frames places them
+    uint32_t frame_length;
+    uint32_t frame_stride;
+    uint16_t frames;
+    uint16_t fft_length;
+    uint16_t num_filters;
+    // preemphasis y[n] = x[n] - cof * x[n - shift] (end of the signal for
+    // n < shift), cof in q30
+    uint16_t pre_shift;
+    int32_t pre_cof;
+    // frames with a preemphasized sample (x << 30 - cof * x') above this are
+    // scaled by 1 / 32768, as the float preemphasis with rescale does
+    uint64_t rescale_limit;
+    // filterbank runs over the power spectrum bins, weights in q15
+    uint16_t *col_start;
+    uint16_t *col_length;
+    uint16_t *weights;
+    // bits the power spectrum is shifted down to, so the filterbank sums fit 64 bits
+    int power_bits;
+    // log2 of the float filterbank output and frame energy per step of the
+    // integer sums, before the per frame shifts, in q16
+    int32_t log2_offset;
+    int32_t log2_energy_offset;
+    // log2 of what the float blocks use instead of zero (1e-10), in q16
+    int32_t log2_zero;
+    // MFE normalization: (max(log2, mfe_floor) + mfe_offset) * mfe_scale
+    int32_t mfe_floor;
+    int32_t mfe_offset;
+    fixed_multiplier_t mfe_scale;
+    // MFCC: natural log per log2 step, and the DCT-II (ortho) rows of the
+    // kept coefficients, num_cepstral x num_filters in q30
+    fixed_multiplier_t ln_scale;
+    uint16_t num_cepstral;
+    int32_t *dct;
+} mfe_fixed_t;
+
 class feature {
 public:
     /**
-     * Compute the Mel-filterbanks. Each filter will be stored in one rows.
-     * The columns correspond to fft bins.
+     * Compute the FFT bin of every mel point of a filterbank. Filter i spans
+     * bins freq_index[i] to freq_index[i + 2], peaking at freq_index[i + 1].
      *
-     * @param filterbanks Matrix of size num_filter * coefficients
+     * @param freq_index Output, num_filter + 2 bins
      * @param num_filter the number of filters in the filterbank
      * @param coefficients (fftpoints//2 + 1)
-     * @param sampling_freq  the samplerate of the signal we are working
-     *                       with. It affects mel spacing.
-     * @param low_freq lowest band edge of mel filters, default 0 Hz
-     * @param high_freq highest band edge of mel filters, default samplerate / 2
-     * @param output_transposed If set to true this will transpose the matrix (memory efficient).
-     *                          This is more efficient than calling this function and then transposing
-     *                          as the latter requires the filterbank to be allocated twice (for a short while).
+     * @param sampling_freq the samplerate of the signal
+     * @param low_freq lowest band edge of mel filters
+     * @param high_freq highest band edge of mel filters
      * @returns EIDSP_OK if OK
      */
-    static int filterbanks(
-#if EIDSP_QUANTIZE_FILTERBANK
-        quantized_matrix_t *filterbanks,
-#else
-        matrix_t *filterbanks,
-#endif
+    static int filterbank_freq_index(int *freq_index,
         uint16_t num_filter, int coefficients, uint32_t sampling_freq,
-        uint32_t low_freq, uint32_t high_freq,
-        bool output_transposed = false
-        )
+        uint32_t low_freq, uint32_t high_freq)
     {
         const size_t mels_mem_size = (num_filter + 2) * sizeof(float);
         const size_t hertz_mem_size = (num_filter + 2) * sizeof(float);
-        const size_t freq_index_mem_size = (num_filter + 2) * sizeof(int);
 
         float *mels = (float*)ei_dsp_malloc(mels_mem_size);
         if (!mels) {
             EIDSP_ERR(EIDSP_OUT_OF_MEM);
         }
 
-        if (filterbanks->rows != num_filter || filterbanks->cols != static_cast<uint32_t>(coefficients)) {
-            EIDSP_ERR(EIDSP_MATRIX_SIZE_MISMATCH);
-        }
-
-#if EIDSP_QUANTIZE_FILTERBANK
-        memset(filterbanks->buffer, 0, filterbanks->rows * filterbanks->cols * sizeof(uint8_t));
-#else
-        memset(filterbanks->buffer, 0, filterbanks->rows * filterbanks->cols * sizeof(float));
-#endif
-
         // Computing the Mel filterbank
         // converting the upper and lower frequencies to Mels.
         // num_filter + 2 is because for num_filter filterbanks we need
@@ -131,15 +165,62 @@ public:
         // The frequency resolution required to put filters at the
         // exact points calculated above should be extracted.
         //  So we should round those frequencies to the closest FFT bin.
+        for (uint16_t ix = 0; ix < num_filter + 2; ix++) {
+            freq_index[ix] = static_cast<int>(floor((coefficients + 1) * hertz[ix] / sampling_freq));
+        }
+        ei_dsp_free(hertz, hertz_mem_size);
+
+        return EIDSP_OK;
+    }
+
+    /**
+     * Compute the Mel-filterbanks. Each filter will be stored in one rows.
+     * The columns correspond to fft bins.
+     *
+     * @param filterbanks Matrix of size num_filter * coefficients
+     * @param num_filter the number of filters in the filterbank
+     * @param coefficients (fftpoints//2 + 1)
+     * @param sampling_freq  the samplerate of the signal we are working
+     *                       with. It affects mel spacing.
+     * @param low_freq lowest band edge of mel filters, default 0 Hz
+     * @param high_freq highest band edge of mel filters, default samplerate / 2
+     * @param output_transposed If set to true this will transpose the matrix (memory efficient).
+     *                          This is more efficient than calling this function and then transposing
+     *                          as the latter requires the filterbank to be allocated twice (for a short while).
+     * @returns EIDSP_OK if OK
+     */
+    static int filterbanks(
+#if EIDSP_QUANTIZE_FILTERBANK
+        quantized_matrix_t *filterbanks,
+#else
+        matrix_t *filterbanks,
+#endif
+        uint16_t num_filter, int coefficients, uint32_t sampling_freq,
+        uint32_t low_freq, uint32_t high_freq,
+        bool output_transposed = false
+        )
+    {
+        const size_t freq_index_mem_size = (num_filter + 2) * sizeof(int);
+
+        if (filterbanks->rows != num_filter || filterbanks->cols != static_cast<uint32_t>(coefficients)) {
+            EIDSP_ERR(EIDSP_MATRIX_SIZE_MISMATCH);
+        }
+
+#if EIDSP_QUANTIZE_FILTERBANK
+        memset(filterbanks->buffer, 0, filterbanks->rows * filterbanks->cols * sizeof(uint8_t));
+#else
+        memset(filterbanks->buffer, 0, filterbanks->rows * filterbanks->cols * sizeof(float));
+#endif
+
         int *freq_index = (int*)ei_dsp_malloc(freq_index_mem_size);
         if (!freq_index) {
-            ei_dsp_free(hertz, hertz_mem_size);
             EIDSP_ERR(EIDSP_OUT_OF_MEM);
         }
-        for (uint16_t ix = 0; ix < num_filter + 2; ix++) {
-            freq_index[ix] = static_cast<int>(floor((coefficients + 1) * hertz[ix] / sampling_freq));
+        int ret = filterbank_freq_index(freq_index, num_filter, coefficients, sampling_freq, low_freq, high_freq);
+        if (ret != EIDSP_OK) {
+            ei_dsp_free(freq_index, freq_index_mem_size);
+            EIDSP_ERR(ret);
         }
-        ei_dsp_free(hertz, hertz_mem_size);
 
         for (size_t i = 0; i < num_filter; i++) {
             int left = freq_index[i];
@@ -181,6 +262,159 @@ public:
         return EIDSP_OK;
     }
 
+    /**
+     * Compute the Mel-filterbanks as a sparse matrix, transposed (one row per
+     * fft bin, one column per filter). Same values as filterbanks(), but only
+     * the bins a filter touches are stored. Free with free_sparse_filterbanks.
+     *
+     * @param filterbanks Output
+     * @param num_filter the number of filters in the filterbank
+     * @param coefficients (fftpoints//2 + 1)
+     * @param sampling_freq the samplerate of the signal
+     * @param low_freq lowest band edge of mel filters
+     * @param high_freq highest band edge of mel filters
+     * @returns EIDSP_OK if OK
+     */
+    static int sparse_filterbanks(sparse_matrix_t *filterbanks,
+        uint16_t num_filter, int coefficients, uint32_t sampling_freq,
+        uint32_t low_freq, uint32_t high_freq)
+    {
+        const size_t freq_index_mem_size = (num_filter + 2) * sizeof(int);
+
+        memset(filterbanks, 0, sizeof(sparse_matrix_t));
+
+        int *freq_index = (int*)ei_dsp_malloc(freq_index_mem_size);
+        if (!freq_index) {
+            EIDSP_ERR(EIDSP_OUT_OF_MEM);
+        }
+        int ret = filterbank_freq_index(freq_index, num_filter, coefficients, sampling_freq, low_freq, high_freq);
+        if (ret != EIDSP_OK) {
+            ei_dsp_free(freq_index, freq_index_mem_size);
+            EIDSP_ERR(ret);
+        }
+
+        // room for every bin from left to right, the zero ends are dropped below
+        size_t max_values = 0;
+        for (size_t i = 0; i < num_filter; i++) {
+            max_values += freq_index[i + 2] - freq_index[i] + 1;
+        }
+
+        filterbanks->rows = coefficients;
+        filterbanks->cols = num_filter;
+        filterbanks->col_start = (uint16_t*)ei_calloc(2 * num_filter, sizeof(uint16_t));
+        filterbanks->values = (decltype(filterbanks->values))ei_calloc(max_values, sizeof(*filterbanks->values));
+        if (!filterbanks->col_start || !filterbanks->values) {
+            ei_dsp_free(freq_index, freq_index_mem_size);
+            free_sparse_filterbanks(filterbanks);
+            EIDSP_ERR(EIDSP_OUT_OF_MEM);
+        }
+        filterbanks->col_length = filterbanks->col_start + num_filter;
+
+        size_t values_count = 0;
+        for (size_t i = 0; i < num_filter; i++) {
+            int left = freq_index[i];
+            int middle = freq_index[i + 1];
+            int right = freq_index[i + 2];
+
+            EI_DSP_MATRIX(z, 1, (right - left + 1));
+            if (!z.buffer) {
+                ei_dsp_free(freq_index, freq_index_mem_size);
+                free_sparse_filterbanks(filterbanks);
+                EIDSP_ERR(EIDSP_OUT_OF_MEM);
+            }
+            numpy::linspace(left, right, (right - left + 1), z.buffer);
+            functions::triangle(z.buffer, (right - left + 1), left, middle, right);
+
+            // keep the run between the first and the last non-zero weight
+            int first = -1;
+            int last = -1;
+            for (int zx = 0; zx < (right - left + 1); zx++) {
+#if EIDSP_QUANTIZE_FILTERBANK
+                filterbanks->values[values_count + zx] = numpy::quantize_zero_one(z.buffer[zx]);
+#else
+                filterbanks->values[values_count + zx] = z.buffer[zx];
+#endif
+                if (filterbanks->values[values_count + zx] != 0) {
+                    if (first < 0) {
+                        first = zx;
+                    }
+                    last = zx;
+                }
+            }
+
+            if (first < 0) {
+                filterbanks->col_start[i] = left;
+                filterbanks->col_length[i] = 0;
+                continue;
+            }
+            if (first > 0) {
+                memmove(filterbanks->values + values_count, filterbanks->values + values_count + first,
+                    (last - first + 1) * sizeof(*filterbanks->values));
+            }
+            filterbanks->col_start[i] = left + first;
+            filterbanks->col_length[i] = last - first + 1;
+            values_count += last - first + 1;
+        }
+
+        ei_dsp_free(freq_index, freq_index_mem_size);
+
+        return EIDSP_OK;
+    }
+
+    static void free_sparse_filterbanks(sparse_matrix_t *filterbanks)
+    {
+        ei_free(filterbanks->col_start);
+        ei_free(filterbanks->values);
+        filterbanks->col_start = NULL;
+        filterbanks->col_length = NULL;
+        filterbanks->values = NULL;
+    }
+
+    /**
+     * Get the sparse Mel-filterbanks for these settings, computing them on
+     * first use. They only depend on the settings, so they are kept for the
+     * next call, e.g. the next slice in continuous mode.
+     * @returns NULL if they can't be kept, the caller then computes them with sparse_filterbanks
+     */
+    static const sparse_matrix_t *cached_sparse_filterbanks(
+        uint16_t num_filter, int coefficients, uint32_t sampling_freq,
+        uint32_t low_freq, uint32_t high_freq)
+    {
+        static filterbank_cache_entry_t cache[EI_DSP_FILTERBANK_CACHE_SIZE];
+        filterbank_cache_entry_t *free_entry = NULL;
+
+        for (size_t ix = 0; ix < EI_DSP_FILTERBANK_CACHE_SIZE; ix++) {
+            filterbank_cache_entry_t *entry = &cache[ix];
+            if (!entry->filterbanks.col_start) {
+                if (!free_entry) {
+                    free_entry = entry;
+                }
+                continue;
+            }
+            if (entry->sampling_freq == sampling_freq && entry->coefficients == coefficients &&
+                entry->num_filter == num_filter && entry->low_freq == low_freq && entry->high_freq == high_freq) {
+                return &entry->filterbanks;
+            }
+        }
+
+        if (!free_entry) {
+            return NULL;
+        }
+
+        if (sparse_filterbanks(&free_entry->filterbanks, num_filter, coefficients,
+                sampling_freq, low_freq, high_freq) != EIDSP_OK) {
+            free_sparse_filterbanks(&free_entry->filterbanks);
+            return NULL;
+        }
+        free_entry->sampling_freq = sampling_freq;
+        free_entry->low_freq = low_freq;
+        free_entry->high_freq = high_freq;
+        free_entry->num_filter = num_filter;
+        free_entry->coefficients = coefficients;
+
+        return &free_entry->filterbanks;
+    }
+
     /**
      * Compute Mel-filterbank energy features from an audio signal.
      * @param out_features Use `calculate_mfe_buffer_size` to allocate the right matrix.
@@ -219,7 +453,7 @@ public:
             low_frequency = 300;
         }
 
-        stack_frames_info_t stack_frame_info = { 0 };
+        stack_frames_info_t stack_frame_info = { };
         stack_frame_info.signal = signal;
 
         ret = processing::stack_frames(
@@ -252,81 +486,23 @@ public:
 
         uint16_t coefficients = fft_length / 2 + 1;
 
-        // calculate the filterbanks first... preferably I would want to do the matrix multiplications
-        // whenever they happen, but OK...
-#if EIDSP_QUANTIZE_FILTERBANK
-        EI_DSP_QUANTIZED_MATRIX(filterbanks, num_filters, coefficients, &numpy::dequantize_zero_one);
-#else
-        EI_DSP_MATRIX(filterbanks, num_filters, coefficients);
-#endif
-        if (!filterbanks.buffer) {
-            EIDSP_ERR(EIDSP_OUT_OF_MEM);
-        }
-
-        ret = feature::filterbanks(
-            &filterbanks, num_filters, coefficients, sampling_frequency, low_frequency, high_frequency, true);
-        if (ret != 0) {
-            EIDSP_ERR(ret);
+        const sparse_matrix_t *filterbanks = cached_sparse_filterbanks(
+            num_filters, coefficients, sampling_frequency, low_frequency, high_frequency);
+        if (filterbanks) {
+            ret = mfe_frames(&stack_frame_info, filterbanks, fft_length, out_features, out_energies);
         }
-        for (size_t ix = 0; ix < stack_frame_info.frame_ixs->size(); ix++) {
-            size_t power_spectrum_frame_size = (fft_length / 2 + 1);
-
-            EI_DSP_MATRIX(power_spectrum_frame, 1, power_spectrum_frame_size);
-            if (!power_spectrum_frame.buffer) {
-                EIDSP_ERR(EIDSP_OUT_OF_MEM);
-            }
-
-            // get signal data from the audio file
-            EI_DSP_MATRIX(signal_frame, 1, stack_frame_info.frame_length);
-
-            // don't read outside of the audio buffer... we'll automatically zero pad then
-            size_t signal_offset = stack_frame_info.frame_ixs->at(ix);
-            size_t signal_length = stack_frame_info.frame_length;
-            if (signal_offset + signal_length > stack_frame_info.signal->total_length) {
-                signal_length = signal_length -
-                    (stack_frame_info.signal->total_length - (signal_offset + signal_length));
-            }
-
-            ret = stack_frame_info.signal->get_data(
-                signal_offset,
-                signal_length,
-                signal_frame.buffer
-            );
-            if (ret != 0) {
-                EIDSP_ERR(ret);
-            }
-
-            ret = processing::power_spectrum(
-                signal_frame.buffer,
-                stack_frame_info.frame_length,
-                power_spectrum_frame.buffer,
-                power_spectrum_frame_size,
-                fft_length
-            );
-
-            if (ret != 0) {
-                EIDSP_ERR(ret);
-            }
-
-            float energy = numpy::sum(power_spectrum_frame.buffer, power_spectrum_frame_size);
-            if (energy == 0) {
-                energy = 1e-10;
-            }
-
-            out_energies->buffer[ix] = energy;
-
-            // calculate the out_features directly here
-            ret = numpy::dot_by_row(
-                ix,
-                power_spectrum_frame.buffer,
-                power_spectrum_frame_size,
-                &filterbanks,
-                out_features
-            );
-
-            if (ret != 0) {
-                EIDSP_ERR(ret);
+        else {
+            // cache is full, compute them for this call only
+            sparse_matrix_t local_filterbanks;
+            ret = sparse_filterbanks(
+                &local_filterbanks, num_filters, coefficients, sampling_frequency, low_frequency, high_frequency);
+            if (ret == EIDSP_OK) {
+                ret = mfe_frames(&stack_frame_info, &local_filterbanks, fft_length, out_features, out_energies);
             }
+            free_sparse_filterbanks(&local_filterbanks);
+        }
+        if (ret != EIDSP_OK) {
+            EIDSP_ERR(ret);
         }
 
         functions::zero_handling(out_features);
@@ -355,7 +531,7 @@ public:
     {
         int ret = 0;
 
-        stack_frames_info_t stack_frame_info = { 0 };
+        stack_frames_info_t stack_frame_info = { };
         stack_frame_info.signal = signal;
 
         ret = processing::stack_frames(
@@ -384,6 +560,11 @@ public:
             *(out_features->buffer + i) = 0;
         }
 
+#if EIDSP_USE_ECM3532_DSP
+        // once for all frames, power_spectrum() falls back to the M3 FFT
+        ei_ecm3532_spectrum spectrum(fft_length, 1);
+#endif
+
         for (size_t ix = 0; ix < stack_frame_info.frame_ixs->size(); ix++) {
             // get signal data from the audio file
             EI_DSP_MATRIX(signal_frame, 1, stack_frame_info.frame_length);
@@ -424,6 +605,16 @@ public:
                 }
             }
 
+#if EIDSP_USE_ECM3532_DSP
+            ret = processing::power_spectrum(
+                signal_frame.buffer,
+                stack_frame_info.frame_length,
+                out_features->buffer + (ix * coefficients),
+                coefficients,
+                fft_length,
+                &spectrum
+            );
+#else
             ret = processing::power_spectrum(
                 signal_frame.buffer,
                 stack_frame_info.frame_length,
@@ -431,6 +622,7 @@ public:
                 coefficients,
                 fft_length
             );
+#endif
 
             if (ret != 0) {
                 EIDSP_ERR(ret);
@@ -595,6 +787,598 @@ public:
         size_matrix.cols = cols;
         return size_matrix;
     }
+
+    /**
+     * Resolve the fixed-point form of an MFE or MFCC block, for windows of
+     * int16 samples. Everything that needs float happens here, the per
+     * window math in the int16 mfe / mfcc is integer only.
+     * Release with release_mfe_fixed.
+     * @param fixed Output
+     * @param signal_length Samples in every window
+     * @param sampling_frequency, frame_length, frame_stride, num_filters,
+     *  fft_length, low_frequency, high_frequency, version As for mfe()
+     * @param pre_shift, pre_cof Preemphasis, as for processing::preemphasis
+     * @param rescale Scale frames outside -1..1 by 1 / 32768, as processing::preemphasis
+     * @param noise_floor_db Noise floor of the MFE normalization
+     * @param num_cepstral Cepstral coefficients for mfcc(), 0 for mfe() only
+     * @param input_scale Value of one int16 step, the float DSP block would
+     *  get sample * input_scale as its input
+     * @returns 0 if OK
+     */
+    static int prepare_mfe_fixed(
+        mfe_fixed_t *fixed,
+        size_t signal_length,
+        uint32_t sampling_frequency,
+        float frame_length, float frame_stride, uint16_t num_filters,
+        uint16_t fft_length, uint32_t low_frequency, uint32_t high_frequency,
+        uint16_t version,
+        int pre_shift, float pre_cof, bool rescale,
+        int noise_floor_db,
+        uint16_t num_cepstral,
+        float input_scale
+    ) {
+        memset(fixed, 0, sizeof(mfe_fixed_t));
+
+        if (signal_length == 0 || fft_length < 4 || num_filters == 0 || num_cepstral > num_filters ||
+                pre_shift < 1 || static_cast<size_t>(pre_shift) > signal_length || !(input_scale > 0.0f)) {
+            EIDSP_ERR(EIDSP_PARAMETER_INVALID);
+        }
+
+        if (high_frequency == 0) {
+            high_frequency = sampling_frequency / 2;
+        }
+
+        if (low_frequency == 0) {
+            low_frequency = 300;
+        }
+
+        // frames exactly where stack_frames puts them for the float blocks
+        signal_t frames_signal;
+        frames_signal.total_length = signal_length;
+        frames_signal.get_data = &mfe_fixed_no_data;
+
+        stack_frames_info_t stack_frame_info = { };
+        stack_frame_info.signal = &frames_signal;
+
+        int ret = processing::stack_frames(&stack_frame_info, sampling_frequency,
+            frame_length, frame_stride, false, version);
+        if (ret != EIDSP_OK) {
+            EIDSP_ERR(ret);
+        }
+        size_t frames = stack_frame_info.frame_ixs->size();
+        if (frames == 0 || frames > UINT16_MAX) {
+            EIDSP_ERR(EIDSP_PARAMETER_INVALID);
+        }
+
+        fixed->frame_length = stack_frame_info.frame_length;
+        fixed->frame_stride = frames > 1 ?
+            stack_frame_info.frame_ixs->at(1) - stack_frame_info.frame_ixs->at(0) : 0;
+        fixed->frames = frames;
+        fixed->fft_length = fft_length;
+        fixed->num_filters = num_filters;
+
+        const float q30 = static_cast<float>(1L << 30);
+        fixed->pre_shift = pre_shift;
+        fixed->pre_cof = static_cast<int32_t>(lrintf(pre_cof * q30));
+
+        double limit = q30 / static_cast<double>(input_scale);
+        fixed->rescale_limit = rescale && limit < 4611686018427387904.0 ?
+            static_cast<uint64_t>(limit) : UINT64_MAX;
+
+        // the filterbank, weights in q15
+        uint16_t coefficients = fft_length / 2 + 1;
+        sparse_matrix_t filterbanks;
+        ret = sparse_filterbanks(&filterbanks, num_filters, coefficients, sampling_frequency,
+            low_frequency, high_frequency);
+        if (ret != EIDSP_OK) {
+            free_sparse_filterbanks(&filterbanks);
+            EIDSP_ERR(ret);
+        }
+
+        size_t weights_count = 0;
+        uint16_t max_run = 1;
+        for (size_t i = 0; i < num_filters; i++) {
+            weights_count += filterbanks.col_length[i];
+            if (filterbanks.col_length[i] > max_run) {
+                max_run = filterbanks.col_length[i];
+            }
+        }
+
+        fixed->col_start = (uint16_t *)ei_calloc(2 * num_filters, sizeof(uint16_t));
+        fixed->weights = (uint16_t *)ei_calloc(weights_count > 0 ? weights_count : 1, sizeof(uint16_t));
+        if (!fixed->col_start || !fixed->weights) {
+            free_sparse_filterbanks(&filterbanks);
+            release_mfe_fixed(fixed);
+            EIDSP_ERR(EIDSP_OUT_OF_MEM);
+        }
+        fixed->col_length = fixed->col_start + num_filters;
+        memcpy(fixed->col_start, filterbanks.col_start, 2 * num_filters * sizeof(uint16_t));
+
+        for (size_t ix = 0; ix < weights_count; ix++) {
+#if EIDSP_QUANTIZE_FILTERBANK
+            float weight = quantized_values_one_zero[filterbanks.values[ix]];
+#else
+            float weight = filterbanks.values[ix];
+#endif
+            fixed->weights[ix] = static_cast<uint16_t>(lrintf(weight * 32768.0f));
+        }
+        free_sparse_filterbanks(&filterbanks);
+
+        // a q15 weight times the power of a bin, summed over the longest run
+        fixed->power_bits = 63 - 16 - (32 - __builtin_clz(max_run));
+        if (fixed->power_bits > 48) {
+            fixed->power_bits = 48;
+        }
+
+        // samples go to the transform as (x << 30 - cof * x') << shift, the
+        // transform is DFT / N. The float power is |DFT|^2 / N of the samples
+        // times input_scale, so per step of |X|^2 it is N * input_scale^2 / 2^60,
+        // and 2^15 less per step of the q15 filterbank sums.
+        float log2_power = log2f(static_cast<float>(fft_length)) + 2.0f * log2f(input_scale) - 60.0f;
+        fixed->log2_energy_offset = static_cast<int32_t>(lrintf(log2_power * 65536.0f));
+        fixed->log2_offset = static_cast<int32_t>(lrintf((log2_power - 15.0f) * 65536.0f));
+        fixed->log2_zero = static_cast<int32_t>(lrintf(log2f(1e-10f) * 65536.0f));
+
+        // mfe_normalization: (10 * log10(f) + noise) / (noise + 12), clipped to 0..1
+        const float one = static_cast<float>(1L << EIDSP_I32_FEATURE_FRAC_BITS);
+        const float db_per_log2 = 10.0f * log10f(2.0f);
+        const float noise = static_cast<float>(noise_floor_db * -1);
+        fixed->mfe_floor = static_cast<int32_t>(lrintf(log2f(1e-30f) * 65536.0f));
+        fixed->mfe_offset = static_cast<int32_t>(lrintf(noise / db_per_log2 * 65536.0f));
+        numpy::fixed_multiplier_init(db_per_log2 / (noise + 12.0f) * one / 65536.0f, &fixed->mfe_scale);
+
+        numpy::fixed_multiplier_init(logf(2.0f) * one / 65536.0f, &fixed->ln_scale);
+
+        // scipy's DCT-II with norm='ortho', what numpy::dct2 computes
+        if (num_cepstral > 0) {
+            fixed->dct = (int32_t *)ei_calloc(num_cepstral * num_filters, sizeof(int32_t));
+            if (!fixed->dct) {
+                release_mfe_fixed(fixed);
+                EIDSP_ERR(EIDSP_OUT_OF_MEM);
+            }
+            for (size_t k = 0; k < num_cepstral; k++) {
+                double norm = sqrt((k == 0 ? 1.0 : 2.0) / static_cast<double>(num_filters));
+                for (size_t n = 0; n < num_filters; n++) {
+                    double c = cos(M_PI * static_cast<double>(k * (2 * n + 1)) / static_cast<double>(2 * num_filters));
+                    fixed->dct[k * num_filters + n] = static_cast<int32_t>(lrint(c * norm * 1073741824.0));
+                }
+            }
+            fixed->num_cepstral = num_cepstral;
+        }
+
+        fixed->signal_length = signal_length;
+
+        return EIDSP_OK;
+    }
+
+    static void release_mfe_fixed(mfe_fixed_t *fixed)
+    {
+        ei_free(fixed->col_start);
+        ei_free(fixed->weights);
+        ei_free(fixed->dct);
+        fixed->col_start = NULL;
+        fixed->col_length = NULL;
+        fixed->weights = NULL;
+        fixed->dct = NULL;
+        fixed->signal_length = 0;
+    }
+
+    /**
+     * Mel-filterbank energies of an int16 signal in integer math, the
+     * base 2 logarithm of what the float mfe() computes (zeros replaced
+     * the same way), in q16. Preemphasis is part of the fixed-point settings.
+     * @param out_features Output, one row per frame, num_filters columns
+     * @param out_energies Output, log2 of the frame energies, one row per frame
+     * @param signal int16 signal
+     * @param fixed Fixed-point settings for windows of signal->total_length samples
+     * @returns 0 if OK
+     */
+    static int mfe(matrix_i32_t *out_features, matrix_i32_t *out_energies,
+        signal_i16_t *signal, const mfe_fixed_t *fixed)
+    {
+        if (fixed->signal_length != signal->total_length) {
+            EIDSP_ERR(EIDSP_SIGNAL_SIZE_MISMATCH);
+        }
+
+        if (out_features->rows != fixed->frames || out_features->cols != fixed->num_filters) {
+            EIDSP_ERR(EIDSP_MATRIX_SIZE_MISMATCH);
+        }
+
+        if (out_energies->rows != fixed->frames || out_energies->cols != 1) {
+            EIDSP_ERR(EIDSP_MATRIX_SIZE_MISMATCH);
+        }
+
+        int ret;
+
+        size_t frame_length = fixed->frame_length;
+        size_t pre_shift = fixed->pre_shift;
+        size_t used = frame_length < fixed->fft_length ? frame_length : fixed->fft_length;
+        size_t bins = fixed->fft_length / 2 + 1;
+
+        // every frame with the samples its preemphasis looks back to
+        EI_DSP_i16_MATRIX(frame_matrix, 1, pre_shift + frame_length);
+        EI_DSP_i32_MATRIX(y_matrix, 1, used);
+        fft_complex_i32_t *fft_output = (fft_complex_i32_t *)ei_dsp_malloc(bins * sizeof(fft_complex_i32_t));
+        uint64_t *power = (uint64_t *)ei_dsp_malloc(bins * sizeof(uint64_t));
+        if (!fft_output || !power) {
+            ei_dsp_free(fft_output, bins * sizeof(fft_complex_i32_t));
+            ei_dsp_free(power, bins * sizeof(uint64_t));
+            EIDSP_ERR(EIDSP_OUT_OF_MEM);
+        }
+
+        for (size_t ix = 0; ix < fixed->frames; ix++) {
+            size_t offset = ix * fixed->frame_stride;
+            EIDSP_i16 *x = frame_matrix.buffer;
+
+            // samples before the start of the signal come from its end
+            if (offset >= pre_shift) {
+                ret = signal->get_data(offset - pre_shift, pre_shift + frame_length, x);
+            }
+            else {
+                ret = signal->get_data(signal->total_length - (pre_shift - offset), pre_shift - offset, x);
+                if (ret == 0) {
+                    ret = signal->get_data(0, offset + frame_length, x + (pre_shift - offset));
+                }
+            }
+            if (ret != 0) {
+                ei_dsp_free(fft_output, bins * sizeof(fft_complex_i32_t));
+                ei_dsp_free(power, bins * sizeof(uint64_t));
+                EIDSP_ERR(ret);
+            }
+
+            // preemphasis, x << 30 - cof * x'. Only the first `used` samples
+            // reach the transform, but the rescale looks at the whole frame.
+            uint64_t max = 0;
+            uint64_t frame_max = 0;
+            for (size_t n = 0; n < frame_length; n++) {
+                int64_t v = (int64_t)x[pre_shift + n] * (1LL << 30) - (int64_t)fixed->pre_cof * x[n];
+                uint64_t mag = v < 0 ? -(uint64_t)v : (uint64_t)v;
+                if (mag > frame_max) {
+                    frame_max = mag;
+                }
+                if (n < used) {
+                    if (mag > max) {
+                        max = mag;
+                    }
+                }
+            }
+            bool rescaled = frame_max > fixed->rescale_limit;
+
+            // scale the samples to just under 2^30
+            int shift = max == 0 ? 0 : __builtin_clzll(max) - 34;
+            int32_t *y = y_matrix.buffer;
+            for (size_t n = 0; n < used; n++) {
+                int64_t v = (int64_t)x[pre_shift + n] * (1LL << 30) - (int64_t)fixed->pre_cof * x[n];
+                if (shift >= 0) {
+                    y[n] = (int32_t)(v * (1LL << shift));
+                }
+                else {
+                    y[n] = (int32_t)((v + (1LL << (-shift - 1))) >> -shift);
+                }
+            }
+
+            ret = numpy::rfft(y, used, fft_output, bins, fixed->fft_length);
+            if (ret != EIDSP_OK) {
+                ei_dsp_free(fft_output, bins * sizeof(fft_complex_i32_t));
+                ei_dsp_free(power, bins * sizeof(uint64_t));
+                EIDSP_ERR(ret);
+            }
+
+            uint64_t power_max = 0;
+            for (size_t b = 0; b < bins; b++) {
+                power[b] = (uint64_t)((int64_t)fft_output[b].r * fft_output[b].r) +
+                    (uint64_t)((int64_t)fft_output[b].i * fft_output[b].i);
+                if (power[b] > power_max) {
+                    power_max = power[b];
+                }
+            }
+
+            // power per bin below 2^power_bits
+            int power_shift = power_max == 0 ? 0 : (64 - __builtin_clzll(power_max)) - fixed->power_bits;
+            if (power_shift < 0) {
+                power_shift = 0;
+            }
+
+            uint64_t energy = 0;
+            for (size_t b = 0; b < bins; b++) {
+                power[b] >>= power_shift;
+                energy += power[b];
+            }
+
+            // log2 of 2^(power_shift - 2 * shift), and of the 1 / 32768 rescale
+            int32_t frame_log2 = (power_shift - 2 * shift - (rescaled ? 30 : 0)) * 65536;
+
+            out_energies->buffer[ix] = energy == 0 ? fixed->log2_zero :
+                numpy::log2_fixed(energy) + fixed->log2_energy_offset + frame_log2;
+
+            const uint16_t *weights = fixed->weights;
+            EIDSP_i32 *features_row = out_features->buffer + (ix * fixed->num_filters);
+            for (size_t i = 0; i < fixed->num_filters; i++) {
+                const uint64_t *run = power + fixed->col_start[i];
+                uint64_t sum = 0;
+                for (size_t k = 0; k < fixed->col_length[i]; k++) {
+                    sum += run[k] * weights[k];
+                }
+                weights += fixed->col_length[i];
+
+                features_row[i] = sum == 0 ? fixed->log2_zero :
+                    numpy::log2_fixed(sum) + fixed->log2_offset + frame_log2;
+            }
+        }
+
+        ei_dsp_free(fft_output, bins * sizeof(fft_complex_i32_t));
+        ei_dsp_free(power, bins * sizeof(uint64_t));
+
+        return EIDSP_OK;
+    }
+
+    /**
+     * MFE normalization of the log2 energies from the int16 mfe(), same
+     * as processing::mfe_normalization. Does an in-place replacement.
+     * @param features_matrix log2 energies in q16, normalized features with
+     *  EIDSP_I32_FEATURE_FRAC_BITS fractional bits after
+     * @param fixed Fixed-point settings
+     * @returns 0 if OK
+     */
+    static int mfe_normalization(matrix_i32_t *features_matrix, const mfe_fixed_t *fixed)
+    {
+        const int32_t one = 1L << EIDSP_I32_FEATURE_FRAC_BITS;
+
+        for (size_t ix = 0; ix < features_matrix->rows * features_matrix->cols; ix++) {
+            int32_t f = features_matrix->buffer[ix];
+            if (f < fixed->mfe_floor) {
+                f = fixed->mfe_floor;
+            }
+            f = numpy::fixed_multiply((int64_t)f + fixed->mfe_offset, &fixed->mfe_scale);
+            if (f < 0) f = 0;
+            else if (f > one) f = one;
+            features_matrix->buffer[ix] = f;
+        }
+
+        return EIDSP_OK;
+    }
+
+    /**
+     * Compute MFCC features from an int16 signal in integer math, same
+     * features as the float mfcc() with dc_elimination.
+     * @param out_features Output, features with EIDSP_I32_FEATURE_FRAC_BITS
+     *  fractional bits. Use `calculate_mfcc_buffer_size` to allocate the right matrix.
+     * @param signal int16 signal
+     * @param fixed Fixed-point settings for windows of signal->total_length
+     *  samples, with num_cepstral coefficients
+     * @returns 0 if OK
+     */
+    static int mfcc(matrix_i32_t *out_features, signal_i16_t *signal, const mfe_fixed_t *fixed)
+    {
+        if (fixed->num_cepstral == 0 || out_features->cols != fixed->num_cepstral) {
+            EIDSP_ERR(EIDSP_MATRIX_SIZE_MISMATCH);
+        }
+
+        if (out_features->rows != fixed->frames) {
+            EIDSP_ERR(EIDSP_MATRIX_SIZE_MISMATCH);
+        }
+
+        size_t num_filters = fixed->num_filters;
+
+        EI_DSP_i32_MATRIX(features_matrix, fixed->frames, num_filters);
+        EI_DSP_i32_MATRIX(energy_matrix, fixed->frames, 1);
+
+        int ret = mfe(&features_matrix, &energy_matrix, signal, fixed);
+        if (ret != EIDSP_OK) {
+            EIDSP_ERR(ret);
+        }
+
+        for (size_t row = 0; row < fixed->frames; row++) {
+            EIDSP_i32 *features_row = features_matrix.buffer + (row * num_filters);
+            EIDSP_i32 *out_row = out_features->buffer + (row * fixed->num_cepstral);
+
+            // natural log, then the DCT
+            for (size_t n = 0; n < num_filters; n++) {
+                features_row[n] = numpy::fixed_multiply(features_row[n], &fixed->ln_scale);
+            }
+
+            for (size_t k = 0; k < fixed->num_cepstral; k++) {
+                const int32_t *dct_row = fixed->dct + (k * num_filters);
+                int64_t sum = 0;
+                for (size_t n = 0; n < num_filters; n++) {
+                    sum += (int64_t)dct_row[n] * features_row[n];
+                }
+                out_row[k] = (EIDSP_i32)((sum + (1LL << 29)) >> 30);
+            }
+
+            // replace first cepstral coefficient with log of frame energy for DC elimination
+            out_row[0] = numpy::fixed_multiply(energy_matrix.buffer[row], &fixed->ln_scale);
+        }
+
+        return EIDSP_OK;
+    }
+
+private:
+    /**
+     * Signal for stack_frames in prepare_mfe_fixed, which only places the frames
+     */
+    static int mfe_fixed_no_data(size_t offset, size_t length, float *out_ptr)
+    {
+        (void)offset; (void)length; (void)out_ptr;
+        return EIDSP_OUT_OF_BOUNDS;
+    }
+
+    /**
+     * Frame loop of mfe(): power spectrum, energy and filterbank of every frame
+     */
+    static int mfe_frames(stack_frames_info_t *stack_frame_info, const sparse_matrix_t *filterbanks,
+        uint16_t fft_length, matrix_t *out_features, matrix_t *out_energies)
+    {
+        int ret = 0;
+
+#if EIDSP_USE_ECM3532_DSP
+        if (ei_ecm3532_spectrum::supported(fft_length)) {
+            return mfe_frames_on_dsp(stack_frame_info, filterbanks, fft_length, out_features, out_energies);
+        }
+#endif
+
+        size_t power_spectrum_frame_size = (fft_length / 2 + 1);
+
+        EI_DSP_MATRIX(power_spectrum_frame, 1, power_spectrum_frame_size);
+        if (!power_spectrum_frame.buffer) {
+            EIDSP_ERR(EIDSP_OUT_OF_MEM);
+        }
+
+        // get signal data from the audio file
+        EI_DSP_MATRIX(signal_frame, 1, stack_frame_info->frame_length);
+        if (!signal_frame.buffer) {
+            EIDSP_ERR(EIDSP_OUT_OF_MEM);
+        }
+
+        for (size_t ix = 0; ix < stack_frame_info->frame_ixs->size(); ix++) {
+            // don't read outside of the audio buffer... we'll automatically zero pad then
+            size_t signal_offset = stack_frame_info->frame_ixs->at(ix);
+            size_t signal_length = stack_frame_info->frame_length;
+            if (signal_offset + signal_length > stack_frame_info->signal->total_length) {
+                signal_length = signal_length -
+                    (stack_frame_info->signal->total_length - (signal_offset + signal_length));
+            }
+
+            ret = stack_frame_info->signal->get_data(
+                signal_offset,
+                signal_length,
+                signal_frame.buffer
+            );
+            if (ret != 0) {
+                EIDSP_ERR(ret);
+            }
+
+            ret = processing::power_spectrum(
+                signal_frame.buffer,
+                stack_frame_info->frame_length,
+                power_spectrum_frame.buffer,
+                power_spectrum_frame_size,
+                fft_length
+            );
+
+            if (ret != 0) {
+                EIDSP_ERR(ret);
+            }
+
+            float energy = numpy::sum(power_spectrum_frame.buffer, power_spectrum_frame_size);
+            if (energy == 0) {
+                energy = 1e-10;
+            }
+
+            out_energies->buffer[ix] = energy;
+
+            // calculate the out_features directly here
+            ret = numpy::dot_by_row(
+                ix,
+                power_spectrum_frame.buffer,
+                power_spectrum_frame_size,
+                filterbanks,
+                out_features
+            );
+
+            if (ret != 0) {
+                EIDSP_ERR(ret);
+            }
+        }
+
+        return EIDSP_OK;
+    }
+
+#if EIDSP_USE_ECM3532_DSP
+    /**
+     * Frame loop of mfe() with the FFT on the DSP core. The DSP transforms
+     * frame ix while the M3 applies the filterbank to frame ix - 1. The
+     * spectrum is allocated once for all frames. A frame the DSP can't do
+     * (no slot, DSP not responding) is computed on the M3, so each slot
+     * keeps its signal frame until its power spectrum is in.
+     */
+    static int mfe_frames_on_dsp(stack_frames_info_t *stack_frame_info, const sparse_matrix_t *filterbanks,
+        uint16_t fft_length, matrix_t *out_features, matrix_t *out_energies)
+    {
+        int ret = 0;
+        size_t frame_count = stack_frame_info->frame_ixs->size();
+        size_t power_spectrum_frame_size = (fft_length / 2 + 1);
+
+        ei_ecm3532_spectrum spectrum(fft_length, 2);
+
+        EI_DSP_MATRIX(power_spectrum_frame, 1, power_spectrum_frame_size);
+        if (!power_spectrum_frame.buffer) {
+            EIDSP_ERR(EIDSP_OUT_OF_MEM);
+        }
+
+        // one signal frame per slot
+        EI_DSP_MATRIX(signal_frames, 2, stack_frame_info->frame_length);
+        if (!signal_frames.buffer) {
+            EIDSP_ERR(EIDSP_OUT_OF_MEM);
+        }
+
+        for (size_t ix = 0; ix <= frame_count; ix++) {
+            if (ix < frame_count) {
+                float *signal_frame = signal_frames.buffer + ((ix & 1) * signal_frames.cols);
+
+                // same bounds as the loop in mfe()
+                size_t signal_offset = stack_frame_info->frame_ixs->at(ix);
+                size_t signal_length = stack_frame_info->frame_length;
+                if (signal_offset + signal_length > stack_frame_info->signal->total_length) {
+                    signal_length = signal_length -
+                        (stack_frame_info->signal->total_length - (signal_offset + signal_length));
+                }
+
+                ret = stack_frame_info->signal->get_data(
+                    signal_offset,
+                    signal_length,
+                    signal_frame
+                );
+                if (ret != 0) {
+                    EIDSP_ERR(ret);
+                }
+
+                // on failure power() below fails too and the M3 does it
+                spectrum.start(ix & 1, signal_frame, stack_frame_info->frame_length);
+            }
+
+            if (ix == 0) {
+                continue;
+            }
+
+            size_t row = ix - 1;
+
+            ret = spectrum.power(row & 1, power_spectrum_frame.buffer, power_spectrum_frame_size);
+            if (ret != 0) {
+                ret = processing::power_spectrum(
+                    signal_frames.buffer + ((row & 1) * signal_frames.cols),
+                    stack_frame_info->frame_length,
+                    power_spectrum_frame.buffer,
+                    power_spectrum_frame_size,
+                    fft_length
+                );
+                if (ret != 0) {
+                    EIDSP_ERR(ret);
+                }
+            }
+
+            float energy = numpy::sum(power_spectrum_frame.buffer, power_spectrum_frame_size);
+            if (energy == 0) {
+                energy = 1e-10;
+            }
+
+            out_energies->buffer[row] = energy;
+
+            ret = numpy::dot_by_row(
+                row,
+                power_spectrum_frame.buffer,
+                power_spectrum_frame_size,
+                filterbanks,
+                out_features
+            );
+            if (ret != 0) {
+                EIDSP_ERR(ret);
+            }
+        }
+
+        return EIDSP_OK;
+    }
+#endif
 };
 
 } // namespace speechpy
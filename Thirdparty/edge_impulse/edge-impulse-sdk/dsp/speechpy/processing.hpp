@@ -36,6 +36,9 @@
 #define _EIDSP_SPEECHPY_PROCESSING_H_
 
 #include "../numpy.hpp"
+#if EIDSP_USE_ECM3532_DSP
+#include "ei_dsp_offload.h"
+#endif
 
 namespace ei {
 namespace speechpy {
@@ -433,6 +436,29 @@ namespace processing {
         return EIDSP_OK;
     }
 
+#if EIDSP_USE_ECM3532_DSP
+    /**
+     * Power spectrum of a frame with the FFT on the DSP core, slot 0 of a
+     * spectrum allocated once per feature extraction. Computed on the M3 if
+     * the spectrum has no slot or the DSP does not respond.
+     * @param spectrum DSP spectrum with fft_points
+     */
+    static int power_spectrum(float *frame, size_t frame_size, float *out_buffer, size_t out_buffer_size, uint16_t fft_points,
+        ei_ecm3532_spectrum *spectrum)
+    {
+        if (out_buffer_size != static_cast<size_t>(fft_points / 2 + 1)) {
+            EIDSP_ERR(EIDSP_MATRIX_SIZE_MISMATCH);
+        }
+
+        if (spectrum->start(0, frame, frame_size) == EIDSP_OK &&
+            spectrum->power(0, out_buffer, out_buffer_size) == EIDSP_OK) {
+            return EIDSP_OK;
+        }
+
+        return power_spectrum(frame, frame_size, out_buffer, out_buffer_size, fft_points);
+    }
+#endif
+
     /**
      * This function performs local cepstral mean and
      * variance normalization on a sliding window. The code assumes that
@@ -469,69 +495,246 @@ namespace processing {
             EIDSP_ERR(ret);
         }
 
-        EI_DSP_MATRIX(mean_matrix, vec_pad.cols, 1);
-        if (!mean_matrix.buffer) {
+        // the window slides one row per frame, so keep running sums per column
+        // (add the row entering the window, drop the row leaving it) instead of
+        // recomputing the mean / std over the full window for every frame.
+        // The sums are doubles: in float the add / drop drifts over long inputs,
+        // and sum_sq / n - mean^2 cancels on columns with a large mean
+        double *window_sum = (double *)ei_dsp_calloc(features_matrix->cols, sizeof(double));
+        if (!window_sum) {
             EIDSP_ERR(EIDSP_OUT_OF_MEM);
         }
 
-        EI_DSP_MATRIX(window_variance, vec_pad.cols, 1);
-        if (!window_variance.buffer) {
-            return EIDSP_OUT_OF_MEM;
+        double *window_sum_sq = NULL;
+        if (variance_normalization == true) {
+            window_sum_sq = (double *)ei_dsp_calloc(features_matrix->cols, sizeof(double));
+            if (!window_sum_sq) {
+                ei_dsp_free(window_sum, features_matrix->cols * sizeof(double));
+                EIDSP_ERR(EIDSP_OUT_OF_MEM);
+            }
+        }
+
+        const size_t cols = vec_pad.cols;
+        const size_t first_rows = win_size < vec_pad.rows ? win_size : vec_pad.rows;
+        const double win_size_inv = 1.0 / static_cast<double>(win_size);
+
+        for (size_t row = 0; row < first_rows; row++) {
+            for (size_t col = 0; col < cols; col++) {
+                window_sum[col] += vec_pad.buffer[(row * cols) + col];
+            }
         }
 
         for (size_t ix = 0; ix < features_matrix->rows; ix++) {
-            // create a slice on the vec_pad
-            EI_DSP_MATRIX_B(window, win_size, vec_pad.cols, vec_pad.buffer + (ix * vec_pad.cols));
-            if (!window.buffer) {
-                EIDSP_ERR(EIDSP_OUT_OF_MEM);
+            // subtract the mean for the features
+            features_buffer_ptr = &features_matrix->buffer[ix * cols];
+            for (size_t col = 0; col < cols; col++) {
+                features_buffer_ptr[col] -= static_cast<float>(window_sum[col] * win_size_inv);
+            }
+
+            // and slide the window
+            const float *leaving = vec_pad.buffer + (ix * cols);
+            for (size_t col = 0; col < cols; col++) {
+                window_sum[col] -= leaving[col];
+            }
+            if (ix + win_size < vec_pad.rows) {
+                const float *entering = vec_pad.buffer + ((ix + win_size) * cols);
+                for (size_t col = 0; col < cols; col++) {
+                    window_sum[col] += entering[col];
+                }
             }
+        }
 
-            ret = numpy::mean_axis0(&window, &mean_matrix);
+        if (variance_normalization == true) {
+            ret = numpy::pad_1d_symmetric(features_matrix, &vec_pad, pad_size, pad_size);
             if (ret != EIDSP_OK) {
+                ei_dsp_free(window_sum, cols * sizeof(double));
+                ei_dsp_free(window_sum_sq, cols * sizeof(double));
                 EIDSP_ERR(ret);
             }
 
-            // subtract the mean for the features
-            for (size_t fm_col = 0; fm_col < features_matrix->cols; fm_col++) {
-                features_matrix->buffer[(ix * features_matrix->cols) + fm_col] =
-                    features_matrix->buffer[(ix * features_matrix->cols) + fm_col] - mean_matrix.buffer[fm_col];
+            memset(window_sum, 0, cols * sizeof(double));
+            for (size_t row = 0; row < first_rows; row++) {
+                for (size_t col = 0; col < cols; col++) {
+                    double v = vec_pad.buffer[(row * cols) + col];
+                    window_sum[col] += v;
+                    window_sum_sq[col] += v * v;
+                }
+            }
+
+            for (size_t ix = 0; ix < features_matrix->rows; ix++) {
+                // population std over the window, same as numpy::std_axis0
+                features_buffer_ptr = &features_matrix->buffer[ix * cols];
+                for (size_t col = 0; col < cols; col++) {
+                    double mean = window_sum[col] * win_size_inv;
+                    double variance = (window_sum_sq[col] * win_size_inv) - (mean * mean);
+                    // only rounding can take it below 0, the window is all one value then
+                    if (variance < 0.0) {
+                        variance = 0.0;
+                    }
+                    features_buffer_ptr[col] = features_buffer_ptr[col] / (sqrtf(static_cast<float>(variance)) + 1e-10);
+                }
+
+                const float *leaving = vec_pad.buffer + (ix * cols);
+                for (size_t col = 0; col < cols; col++) {
+                    double v = leaving[col];
+                    window_sum[col] -= v;
+                    window_sum_sq[col] -= v * v;
+                }
+                if (ix + win_size < vec_pad.rows) {
+                    const float *entering = vec_pad.buffer + ((ix + win_size) * cols);
+                    for (size_t col = 0; col < cols; col++) {
+                        double v = entering[col];
+                        window_sum[col] += v;
+                        window_sum_sq[col] += v * v;
+                    }
+                }
             }
+
+            ei_dsp_free(window_sum_sq, cols * sizeof(double));
+        }
+
+        ei_dsp_free(window_sum, cols * sizeof(double));
+
+        if (scale) {
+            ret = numpy::normalize(features_matrix);
+            if (ret != EIDSP_OK) {
+                EIDSP_ERR(ret);
+            }
+        }
+
+        return EIDSP_OK;
+    }
+
+    /**
+     * Local cepstral mean and variance normalization on fixed-point
+     * features, same windows as the float cmvnw (without scale). Integer only.
+     * @param features_matrix input feature matrix with EIDSP_I32_FEATURE_FRAC_BITS
+     *   fractional bits, will be modified in place
+     * @param win_size The size of sliding window for local normalization.
+     * @param variance_normalization If the variance normilization should
+     *   be performed or not.
+     * @returns 0 if OK
+     */
+    static int cmvnw(matrix_i32_t *features_matrix, uint16_t win_size, bool variance_normalization)
+    {
+        if (win_size == 0) {
+            return EIDSP_OK;
         }
 
+        uint16_t pad_size = (win_size - 1) / 2;
+        const size_t cols = features_matrix->cols;
+
+        int ret;
+
+        EI_DSP_i32_MATRIX(vec_pad, features_matrix->rows + (pad_size * 2), cols);
+
         ret = numpy::pad_1d_symmetric(features_matrix, &vec_pad, pad_size, pad_size);
         if (ret != EIDSP_OK) {
             EIDSP_ERR(ret);
         }
 
-        for (size_t ix = 0; ix < features_matrix->rows; ix++) {
-            // create a slice on the vec_pad
-            EI_DSP_MATRIX_B(window, win_size, vec_pad.cols, vec_pad.buffer + (ix * vec_pad.cols));
-            if (!window.buffer) {
-                EIDSP_ERR(EIDSP_OUT_OF_MEM);
+        // running sums per column, as the float cmvnw, exact in int64
+        int64_t *window_sum = (int64_t *)ei_dsp_calloc(cols, sizeof(int64_t));
+        uint64_t *window_sum_sq = (uint64_t *)ei_dsp_calloc(cols, sizeof(uint64_t));
+        if (!window_sum || !window_sum_sq) {
+            ei_dsp_free(window_sum, cols * sizeof(int64_t));
+            ei_dsp_free(window_sum_sq, cols * sizeof(uint64_t));
+            EIDSP_ERR(EIDSP_OUT_OF_MEM);
+        }
+
+        const size_t first_rows = win_size < vec_pad.rows ? win_size : vec_pad.rows;
+        const int64_t win = win_size;
+
+        for (size_t row = 0; row < first_rows; row++) {
+            for (size_t col = 0; col < cols; col++) {
+                window_sum[col] += vec_pad.buffer[(row * cols) + col];
             }
+        }
 
-            if (variance_normalization == true) {
-                ret = numpy::std_axis0(&window, &window_variance);
-                if (ret != EIDSP_OK) {
-                    EIDSP_ERR(ret);
-                }
+        for (size_t ix = 0; ix < features_matrix->rows; ix++) {
+            EIDSP_i32 *features_row = &features_matrix->buffer[ix * cols];
+            for (size_t col = 0; col < cols; col++) {
+                int64_t sum = window_sum[col];
+                features_row[col] -= (EIDSP_i32)((sum + (sum < 0 ? -win / 2 : win / 2)) / win);
+            }
 
-                features_buffer_ptr = &features_matrix->buffer[ix * vec_pad.cols];
-                for (size_t col = 0; col < vec_pad.cols; col++) {
-                    *(features_buffer_ptr) = (*(features_buffer_ptr)) /
-                                             (window_variance.buffer[col] + 1e-10);
-                    features_buffer_ptr++;
+            const EIDSP_i32 *leaving = vec_pad.buffer + (ix * cols);
+            for (size_t col = 0; col < cols; col++) {
+                window_sum[col] -= leaving[col];
+            }
+            if (ix + win_size < vec_pad.rows) {
+                const EIDSP_i32 *entering = vec_pad.buffer + ((ix + win_size) * cols);
+                for (size_t col = 0; col < cols; col++) {
+                    window_sum[col] += entering[col];
                 }
             }
         }
 
-        if (scale) {
-            ret = numpy::normalize(features_matrix);
+        if (variance_normalization == true) {
+            ret = numpy::pad_1d_symmetric(features_matrix, &vec_pad, pad_size, pad_size);
             if (ret != EIDSP_OK) {
+                ei_dsp_free(window_sum, cols * sizeof(int64_t));
+                ei_dsp_free(window_sum_sq, cols * sizeof(uint64_t));
                 EIDSP_ERR(ret);
             }
+
+            memset(window_sum, 0, cols * sizeof(int64_t));
+            for (size_t row = 0; row < first_rows; row++) {
+                for (size_t col = 0; col < cols; col++) {
+                    int64_t v = vec_pad.buffer[(row * cols) + col];
+                    window_sum[col] += v;
+                    window_sum_sq[col] += (uint64_t)(v * v);
+                }
+            }
+
+            for (size_t ix = 0; ix < features_matrix->rows; ix++) {
+                // population std over the window, variance with twice the
+                // fractional bits so its square root has them once
+                EIDSP_i32 *features_row = &features_matrix->buffer[ix * cols];
+                for (size_t col = 0; col < cols; col++) {
+                    // (win * sum_sq - sum^2) / win^2, exact until the division
+                    uint64_t sum_sq = (uint64_t)win * window_sum_sq[col];
+                    uint64_t sum_2 = (uint64_t)(window_sum[col] * window_sum[col]);
+                    if (sum_sq <= sum_2) {
+                        features_row[col] = 0;
+                        continue;
+                    }
+                    int64_t std = numpy::isqrt((sum_sq - sum_2) / (uint64_t)(win * win));
+                    if (std == 0) {
+                        features_row[col] = 0;
+                        continue;
+                    }
+                    int64_t value = (int64_t)features_row[col] * (1LL << EIDSP_I32_FEATURE_FRAC_BITS);
+                    int64_t normalized = (value + (value < 0 ? -std / 2 : std / 2)) / std;
+                    if (normalized > INT32_MAX) {
+                        normalized = INT32_MAX;
+                    }
+                    else if (normalized < INT32_MIN) {
+                        normalized = INT32_MIN;
+                    }
+                    features_row[col] = (EIDSP_i32)normalized;
+                }
+
+                const EIDSP_i32 *leaving = vec_pad.buffer + (ix * cols);
+                for (size_t col = 0; col < cols; col++) {
+                    int64_t v = leaving[col];
+                    window_sum[col] -= v;
+                    window_sum_sq[col] -= (uint64_t)(v * v);
+                }
+                if (ix + win_size < vec_pad.rows) {
+                    const EIDSP_i32 *entering = vec_pad.buffer + ((ix + win_size) * cols);
+                    for (size_t col = 0; col < cols; col++) {
+                        int64_t v = entering[col];
+                        window_sum[col] += v;
+                        window_sum_sq[col] += (uint64_t)(v * v);
+                    }
+                }
+            }
         }
 
+        ei_dsp_free(window_sum, cols * sizeof(int64_t));
+        ei_dsp_free(window_sum_sq, cols * sizeof(uint64_t));
+
         return EIDSP_OK;
     }
 
@@ -151,6 +151,10 @@ typedef struct {
     // Start a snapshot stream
     bool (*start_snapshot_stream)(size_t width, size_t height, bool use_max_baudrate);
 
+    // Start a snapshot stream in the given output format
+    bool (*start_snapshot_stream_format)(size_t width, size_t height, bool use_max_baudrate,
+        ei_snapshot_format_t format);
+
     // Get Data Output Baudrate
     int (*get_data_output_baudrate)(ei_device_data_output_baudrate_t *baudrate);
 
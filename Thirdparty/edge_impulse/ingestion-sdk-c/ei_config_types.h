@@ -25,6 +25,13 @@ typedef enum {
     EI_SECURITY_UNKNOWN      = 0xFF,     /*!< unknown/unsupported security in scan results */
 } ei_config_security_t;
 
+// output format of a snapshot stream
+typedef enum {
+    EI_SNAPSHOT_FORMAT_BASE64 = 0,      /*!< base64 encoded lines, the default */
+    EI_SNAPSHOT_FORMAT_RAW    = 1,      /*!< binary frames, raw pixels */
+    EI_SNAPSHOT_FORMAT_RLE    = 2,      /*!< binary frames, PackBits run length encoded pixels */
+} ei_snapshot_format_t;
+
 
 // All the possible configuration options we can set
 typedef struct {
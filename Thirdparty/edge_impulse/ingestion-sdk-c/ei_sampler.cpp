@@ -40,6 +40,7 @@
 #include "ei_config_types.h"
 #include "ei_eta_fs_commands.h"
 #include "ei_device_eta_ecm3532.h"
+#include "ei_inertialsensor.h"
 
 #include "sensor_aq_mbedtls_hs256.h"
 
@@ -51,10 +52,6 @@ using namespace events;
 #endif
 
 
-/** @todo Should be called by function pointer */
-extern bool ei_inertial_sample_start(sampler_callback callback, float sample_interval_ms);
-extern void ei_inertial_read_data(void);
-
 extern void ei_printf(const char *format, ...);
 extern void ei_printf_float(float value);
 extern ei_config_t *ei_config_get_config();
@@ -67,21 +64,17 @@ static uint32_t sample_buffer_size;
 static uint32_t headerOffset = 0;
 
 
-static char write_word_buf[4];
 static int write_addr = 0;
 
 static size_t ei_write(const void *buffer, size_t size, size_t count, EI_SENSOR_AQ_STREAM*)
 {
-    for(size_t i=0; i<count; i++) {
-
-        write_word_buf[write_addr&0x3] = *((char *)buffer+i);
-
-       if((++write_addr & 0x03) == 0x00) {
-           ei_eta_fs_write_samples(write_word_buf, (write_addr - 4) + headerOffset, 4);
-       }
-
+    /* Collected per flash page, see ei_eta_fs_stream_write() */
+    if(ei_eta_fs_stream_write(buffer, count) != 0) {
+        return 0;
     }
 
+    write_addr += count;
+
     return count;
 }
 
@@ -111,23 +104,15 @@ static sensor_aq_ctx ei_mic_ctx = {
 
 static void ei_write_last_data(void)
 {
+    const uint8_t end_fill[8] = { 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF };
     uint8_t fill = ((uint8_t)write_addr & 0x03);
-    uint8_t insert_end_address = 0;
 
-    if(fill != 0x00) {
-        for(uint8_t i=fill; i<4; i++) {
-            write_word_buf[i] = 0xFF;
-        }
+    /* Pad to a word, then append a word for end character */
+    ei_eta_fs_stream_write(end_fill, (fill ? (4 - fill) : 0) + 4);
 
-        ei_eta_fs_write_samples(write_word_buf, (write_addr & ~0x03) + headerOffset, 4);
-        insert_end_address = 4;
+    if(ei_eta_fs_stream_flush() != 0) {
+        ei_printf("Failed to flush sample data to flash\n");
     }
-
-    /* Write appending word for end character */    
-    for(uint8_t i=0; i<4; i++) {
-        write_word_buf[i] = 0xFF;
-    }
-    ei_eta_fs_write_samples(write_word_buf, (write_addr & ~0x03) + headerOffset + insert_end_address, 4);    
 }
 
 EI_SENSOR_AQ_STREAM stream;
@@ -135,7 +120,7 @@ EI_SENSOR_AQ_STREAM stream;
 
 /* Private function prototypes --------------------------------------------- */
 static void finish_and_upload(char *filename, uint32_t sample_length_ms);
-static bool sample_data_callback(const void *sample_buf, uint32_t byteLenght);
+static bool sample_batch_callback(const ei_inertial_batch_t *batch);
 
 static bool create_header(sensor_aq_payload_info *payload);
 
@@ -173,30 +158,33 @@ bool ei_sampler_start_sampling(void *v_ptr_payload, uint32_t sample_size)
     ei_printf("Samples req: %d\r\n", samples_required);
 
     // Minimum delay of 2000 ms for daemon
-    if(((sample_buffer_size / ei_eta_fs_get_block_size())+1) * ETA_FS_BLOCK_ERASE_TIME_MS < 2000) {
+    // only the start of the sample data is erased here, the rest is erased while sampling
+    if(((ETA_FS_ERASE_AHEAD_LEAD / ei_eta_fs_get_block_size())+1) * ETA_FS_BLOCK_ERASE_TIME_MS < 2000) {
         ei_printf("Starting in %lu ms... (or until all flash was erased)\n", 2000);
         EiDevice.delay_ms(2000);
     }
     else {
         ei_printf("Starting in %lu ms... (or until all flash was erased)\n",
-        ((sample_buffer_size / ei_eta_fs_get_block_size())+1) * ETA_FS_BLOCK_ERASE_TIME_MS);
+        ((ETA_FS_ERASE_AHEAD_LEAD / ei_eta_fs_get_block_size())+1) * ETA_FS_BLOCK_ERASE_TIME_MS);
     }
 
-	if(ei_eta_fs_erase_sampledata(0, sample_buffer_size + ei_eta_fs_get_block_size()) != ETA_FS_CMD_OK)
+	if(ei_eta_fs_erase_ahead_start(sample_buffer_size + ei_eta_fs_get_block_size(), ETA_FS_ERASE_AHEAD_LEAD) != ETA_FS_CMD_OK)
 		return false;
 
+    /* float32 decodes to the same values as the default smallest float encoding */
+    ei_mic_ctx.encoding = AQ_ENCODING_FLOAT32;
+
     if(create_header(payload) == false)
         return false;
 
-
-    if(ei_inertial_sample_start(&sample_data_callback, ei_config_get_config()->sample_interval_ms) == false) {
+    if(ei_inertial_batch_start(&sample_batch_callback, ei_config_get_config()->sample_interval_ms) == false) {
         return false;
     }
 
 	ei_printf("Sampling...\n");        
-    while(current_sample < samples_required) {
-        ei_inertial_read_data();
-    };
+    while(ei_inertial_read_batch() == false) { };
+
+    ei_inertial_sample_stop();
 
     ei_write_last_data();
     write_addr++;
@@ -303,6 +291,11 @@ static bool create_header(sensor_aq_payload_info *payload)
 
     headerOffset = end_of_header_ix;
     write_addr = 0;
+    tr = ei_eta_fs_stream_begin(headerOffset);
+    if (tr != 0) {
+        ei_printf("Failed to start the sample stream (%d)\n", tr);
+        return false;
+    }
 
     return true;
 }
@@ -326,21 +319,26 @@ static void finish_and_upload(char *filename, uint32_t sample_length_ms)
 }
 
 /**
- * @brief      Write samples to FLASH in CBOR format
+ * @brief      Write a batch of samples to FLASH in CBOR format, in one
+ *             encoder pass and signature update
  *
- * @param[in]  sample_buf  The sample buffer
- * @param[in]  byteLenght  The byte lenght
+ * @param[in]  batch  Samples drained from the sensor FIFO
  *
  * @return     true if all required samples are received. Caller should stop sampling,
  */
-static bool sample_data_callback(const void *sample_buf, uint32_t byteLenght)
-{    
-    sensor_aq_add_data(&ei_mic_ctx, (float *)sample_buf, byteLenght / sizeof(float));
-
-    if(++current_sample > samples_required) {
-        return true;
+static bool sample_batch_callback(const ei_inertial_batch_t *batch)
+{
+    uint32_t n_samples = samples_required - current_sample;
+    if(batch->n_samples < n_samples) {
+        n_samples = batch->n_samples;
     }
-    else {
-        return false;
+
+    int r = sensor_aq_add_data_n(&ei_mic_ctx, batch->samples, n_samples, batch->stride);
+    if(r != AQ_OK) {
+        ei_printf("Failed to write samples (%d)\n", r);
     }
+
+    current_sample += n_samples;
+
+    return (current_sample >= samples_required);
 }
@@ -36,6 +36,7 @@
 
 #include <stdint.h>
 #include <float.h>
+#include <string.h>
 #include "qcbor.h"
 //#include "setup.h"
 #include "sensor_aq.h"
@@ -96,6 +97,33 @@ __attribute__((unused)) static bool is_valid_senml_unit(const char *unit) {
     return false;
 }
 
+/**
+ * Largest number of bytes a single value takes in the current encoding
+ */
+static size_t sensor_aq_max_value_size(sensor_aq_ctx *ctx) {
+    switch (ctx->encoding) {
+        case AQ_ENCODING_FLOAT32: return 5;
+        default: return 9;
+    }
+}
+
+/**
+ * Encode a single value in the encoding of the context
+ */
+static inline void sensor_aq_encode_value(sensor_aq_ctx *ctx, float value) {
+    switch (ctx->encoding) {
+        case AQ_ENCODING_FLOAT32: {
+            uint32_t bits;
+            memcpy(&bits, &value, sizeof(bits));
+            QCBOREncode_AddType7(&ctx->encode_context, sizeof(float), bits);
+            break;
+        }
+        default:
+            QCBOREncode_AddDouble(&ctx->encode_context, value);
+            break;
+    }
+}
+
 static int sensor_aq_update_sig_and_write_to_file(sensor_aq_ctx *ctx, uint8_t *ptr, size_t size) {
     if (ctx->stream == NULL) {
         return AQ_STREAM_IS_NULL;
@@ -351,22 +379,19 @@ int sensor_aq_add_data(sensor_aq_ctx *ctx, float values[], size_t values_size) {
         return AQ_STREAM_IS_NULL;
     }
 
-    // clear memory
-    memset(ctx->cbor_buffer.ptr, 0, ctx->cbor_buffer.len);
-
-    // re-initialize
+    // re-initialize, flushing already cleared the bytes we wrote last time
     QCBOREncode_Init(&ctx->encode_context, ctx->cbor_buffer);
 
     // If we only have a single axis then emit flattened array (saves space)
     if (values_size == 1) {
-        QCBOREncode_AddDouble(&ctx->encode_context, values[0]);
+        sensor_aq_encode_value(ctx, values[0]);
     }
     else {
         // otherwise create an array
         QCBOREncode_OpenArray(&ctx->encode_context);
 
         for (size_t ix = 0; ix < values_size; ix++) {
-            QCBOREncode_AddDouble(&ctx->encode_context, values[ix]);
+            sensor_aq_encode_value(ctx, values[ix]);
         }
 
         QCBOREncode_CloseArray(&ctx->encode_context);
@@ -414,6 +439,57 @@ int sensor_aq_add_data_i16(sensor_aq_ctx *ctx, int16_t values[], size_t values_s
     return sensor_aq_flush_buffer(ctx);
 }
 
+/**
+ * Add data to the sensor file for many intervals at the same time
+ * Frames are encoded into the CBOR buffer back to back, and only written
+ * out (and added to the signature) when the buffer is full
+ * @param ctx The context
+ * @param values Values, frame n starts at values[n * stride] and holds axis_count values
+ * @param n_samples Number of frames
+ * @param stride Distance between the start of two frames, at least axis_count
+ */
+int sensor_aq_add_data_n(sensor_aq_ctx *ctx, const float values[], size_t n_samples, size_t stride) {
+    if (stride < ctx->axis_count) {
+        return AQ_VALUES_SIZE_DOES_NOT_MATCH_AXIS_COUNT;
+    }
+
+    if (ctx->stream == NULL) {
+        return AQ_STREAM_IS_NULL;
+    }
+
+    const size_t axis_count = ctx->axis_count;
+    // single axis frames are flattened, otherwise add the array header
+    const size_t max_frame_size = (axis_count > 1 ? 1 : 0) + axis_count * sensor_aq_max_value_size(ctx);
+
+    QCBOREncode_Init(&ctx->encode_context, ctx->cbor_buffer);
+
+    for (size_t ix = 0; ix < n_samples; ix++) {
+        if (ctx->encode_context.OutBuf.data_len + max_frame_size > ctx->cbor_buffer.len) {
+            int fr = sensor_aq_flush_buffer(ctx);
+            if (fr != AQ_OK) {
+                return fr;
+            }
+        }
+
+        const float *frame = &values[ix * stride];
+
+        if (axis_count == 1) {
+            sensor_aq_encode_value(ctx, frame[0]);
+        }
+        else {
+            QCBOREncode_OpenArray(&ctx->encode_context);
+
+            for (size_t ax = 0; ax < axis_count; ax++) {
+                sensor_aq_encode_value(ctx, frame[ax]);
+            }
+
+            QCBOREncode_CloseArray(&ctx->encode_context);
+        }
+    }
+
+    return sensor_aq_flush_buffer(ctx);
+}
+
 /**
  * Add data to the sensor file for many intervals at the same time
  * This only works if there is only a single sensor
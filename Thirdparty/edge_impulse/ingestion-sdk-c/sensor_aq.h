@@ -84,6 +84,16 @@ typedef enum {
     AQ_OUT_OF_MEM = -6020
 } sensor_aq_status;
 
+/**
+ * How sample values are written to the 'values' array
+ */
+typedef enum {
+    // smallest IEEE754 type that holds the value without loss (float16/32/64)
+    AQ_ENCODING_DOUBLE = 0,
+    // always float32, 5 bytes per value, no double conversion
+    AQ_ENCODING_FLOAT32 = 1
+} sensor_aq_encoding_t;
+
 /**
  * Buffer context
  */
@@ -165,6 +175,9 @@ typedef struct {
 
     // active stream
     EI_SENSOR_AQ_STREAM *stream;
+
+    // Optional: value encoding, defaults to AQ_ENCODING_DOUBLE
+    sensor_aq_encoding_t encoding;
 } sensor_aq_ctx;
 
 /**
@@ -199,6 +212,7 @@ int sensor_aq_init(sensor_aq_ctx *ctx, sensor_aq_payload_info *payload_info, EI_
 int sensor_aq_add_data(sensor_aq_ctx *ctx, float values[], size_t values_size);
 int sensor_aq_add_data_i16(sensor_aq_ctx *ctx, int16_t values[], size_t values_size);
 int sensor_aq_add_data_batch(sensor_aq_ctx *ctx, int16_t values[], size_t values_size);
+int sensor_aq_add_data_n(sensor_aq_ctx *ctx, const float values[], size_t n_samples, size_t stride);
 int sensor_aq_finish(sensor_aq_ctx *ctx);
 
 #endif // _EDGE_IMPULSE_SENSOR_AQ_H_
@@ -50,6 +50,9 @@ extern "C" {
 #include "executor_public.h"
 #include "timer_hal.h"
 #include "uart_hal.h"
+#include "FreeRTOS.h"
+#include "semphr.h"
+#include "task.h"
 }
 
 #include <cstdarg>
@@ -102,6 +105,25 @@ static tEiState ei_program_state = eiStateIdle;
 tUart etaUart;
 #define EI_USED_UART &etaUart
 
+//
+// Interrupt mask access of the TX ring, can be overridden for a host build.
+//
+#ifndef EI_TX_PRIMASK_GET
+#define EI_TX_PRIMASK_GET(v)    __asm volatile("mrs %0, primask" : "=r"(v))
+#define EI_TX_BASEPRI_GET(v)    __asm volatile("mrs %0, basepri" : "=r"(v))
+#define EI_TX_PRIMASK_SET(v)    __asm volatile("msr primask, %0" :: "r"(v) : "memory")
+#define EI_TX_IRQ_DISABLE()     __asm volatile("cpsid i" ::: "memory")
+#endif
+
+/** Serial TX ring, drained by the UART TX interrupt. Must be a power of 2 */
+#define EI_TX_RING_SIZE 2048
+
+static uint8_t tx_ring[EI_TX_RING_SIZE];
+static volatile uint32_t tx_head = 0;
+static volatile uint32_t tx_tail = 0;
+static SemaphoreHandle_t tx_lock = NULL;
+static ei_write_stats_t tx_stats = { EI_TX_RING_SIZE, 0, 0 };
+
 /* Private function declarations ------------------------------------------- */
 static int get_id_c(uint8_t out_buffer[32], size_t *out_size);
 static int get_type_c(uint8_t out_buffer[32], size_t *out_size);
@@ -112,6 +134,8 @@ static bool read_sample_buffer(size_t begin, size_t length, void (*data_fn)(uint
 static int get_data_output_baudrate_c(ei_device_data_output_baudrate_t *baudrate);
 static void set_max_data_output_baudrate_c();
 static void set_default_data_output_baudrate_c();
+static size_t tx_queue(const char *data, size_t length, bool block);
+static void tx_direct(const char *data, size_t length);
 
 /* Public functions -------------------------------------------------------- */
 
@@ -530,6 +554,10 @@ bool ei_user_invoke_stop(void)
 void ei_serial_setup(void)
 {
     EtaCspUartInit(&etaUart, (tUartNum)CONFIG_DEBUG_UART, eUartBaud115200, eUartFlowControlNone);
+
+    if (tx_lock == NULL) {
+        tx_lock = xSemaphoreCreateMutex();
+    }
 }
 
 /**
@@ -547,58 +575,153 @@ void ei_printf(const char *format, ...)
     va_end(args);
 
     if (r > 0) {
-        EtaCspUartPuts(EI_USED_UART, print_buf);
+        if (r >= (int)sizeof(print_buf)) {
+            r = sizeof(print_buf) - 1;
+        }
+        tx_queue(print_buf, r, true);
     }
 }
 
 /**
- * @brief      Print a float value, bypassing the stdio %f
- *             Uses standard serial out
+ * @brief      Format a float with a fixed number of decimals, integer math only.
+ *             The float is split into its 24 bit mantissa and binary exponent,
+ *             scaled by 10^decimals and rounded half to even, so the output is
+ *             the same as snprintf("%.*f") without going through soft double.
  *
- * @param[in]  f     Float value to print.
+ * @param      buf       Output buffer, EI_FORMAT_FLOAT_MAX_SIZE is always enough
+ * @param[in]  size      Size of buf
+ * @param[in]  f         Float value to format
+ * @param[in]  decimals  Number of decimals, 0 .. EI_FORMAT_FLOAT_MAX_DECIMALS
+ *
+ * @return     Number of characters written (excluding the terminator), or -1
+ *             if buf is too small
  */
-void ei_printf_float(float f)
+int ei_format_float(char *buf, size_t size, float f, int decimals)
 {
-    float n = f;
+    static const uint32_t pow10[EI_FORMAT_FLOAT_MAX_DECIMALS + 1] = {
+        1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000
+    };
+    char tmp[EI_FORMAT_FLOAT_MAX_SIZE];
+    char *c = tmp;
+    uint32_t bits;
+
+    if (decimals < 0) {
+        decimals = 0;
+    }
+    else if (decimals > EI_FORMAT_FLOAT_MAX_DECIMALS) {
+        decimals = EI_FORMAT_FLOAT_MAX_DECIMALS;
+    }
+
+    memcpy(&bits, &f, sizeof(bits));
 
-    static double PRECISION = 0.00001;
-    static int MAX_NUMBER_STRING_SIZE = 32;
+    uint32_t biased_exp = (bits >> 23) & 0xff;
+    uint32_t mantissa = bits & 0x7fffff;
 
-    char s[MAX_NUMBER_STRING_SIZE];
+    if (bits >> 31) {
+        *(c++) = '-';
+    }
 
-    if (n == 0.0) {
-        ei_printf("0.00000");
+    if (biased_exp == 0xff) {
+        const char *special = mantissa ? "nan" : "inf";
+        while (*special) {
+            *(c++) = *(special++);
+        }
+    }
+    /* Integer part above 2^63 does not fit, these never show up in results */
+    else if (biased_exp >= 127 + 63) {
+        int length = snprintf(buf, size, "%.*f", decimals, (double)f);
+        return (length < 0 || (size_t)length >= size) ? -1 : length;
     }
     else {
-        int digit, m; //, m1;
-        char *c = s;
-        int neg = (n < 0);
-        if (neg) {
-            n = -n;
+        int exp;
+        uint64_t scaled;
+
+        if (biased_exp == 0) {
+            exp = 1 - 127 - 23;
         }
-        // calculate magnitude
-        m = log10(n);
-        if (neg) {
-            *(c++) = '-';
+        else {
+            mantissa |= 0x800000;
+            exp = (int)biased_exp - 127 - 23;
         }
-        if (m < 1.0) {
-            m = 0;
+
+        /* mantissa * 2^exp * 10^decimals, rounded to an integer */
+        if (exp >= 0) {
+            scaled = (uint64_t)mantissa << exp;
         }
-        // convert the number
-        while (n > PRECISION || m >= 0) {
-            double weight = pow(10.0, m);
-            if (weight > 0 && !isinf(weight)) {
-                digit = floor(n / weight);
-                n -= (digit * weight);
-                *(c++) = '0' + digit;
+        else {
+            scaled = (uint64_t)mantissa * pow10[decimals];
+            int shift = -exp;
+            if (shift >= 64) {
+                scaled = 0;
+            }
+            else {
+                uint64_t rem = scaled & (((uint64_t)1 << shift) - 1);
+                uint64_t half = (uint64_t)1 << (shift - 1);
+                scaled >>= shift;
+                if (rem > half || (rem == half && (scaled & 1))) {
+                    scaled++;
+                }
             }
-            if (m == 0 && n > 0) {
-                *(c++) = '.';
+        }
+
+        uint64_t int_part;
+        uint32_t frac_part = 0;
+        if (exp >= 0) {
+            int_part = scaled;
+        }
+        else if (scaled <= UINT32_MAX) {
+            /* Common case, stay in 32 bit division */
+            int_part = (uint32_t)scaled / pow10[decimals];
+            frac_part = (uint32_t)scaled % pow10[decimals];
+        }
+        else {
+            int_part = scaled / pow10[decimals];
+            frac_part = (uint32_t)(scaled % pow10[decimals]);
+        }
+
+        char digits[20];
+        int n = 0;
+        do {
+            digits[n++] = '0' + (int_part % 10);
+            int_part /= 10;
+        } while (int_part);
+        while (n) {
+            *(c++) = digits[--n];
+        }
+
+        if (decimals > 0) {
+            *(c++) = '.';
+            for (int d = decimals - 1; d >= 0; d--) {
+                c[d] = '0' + (frac_part % 10);
+                frac_part /= 10;
             }
-            m--;
+            c += decimals;
         }
-        *(c) = '\0';
-        ei_write_string(s, c - s);
+    }
+
+    size_t length = c - tmp;
+    if (length + 1 > size) {
+        return -1;
+    }
+    memcpy(buf, tmp, length);
+    buf[length] = '\0';
+
+    return (int)length;
+}
+
+/**
+ * @brief      Print a float value with 5 decimals, bypassing the stdio %f
+ *             Uses standard serial out
+ *
+ * @param[in]  f     Float value to print.
+ */
+void ei_printf_float(float f)
+{
+    char s[EI_FORMAT_FLOAT_MAX_SIZE];
+
+    int length = ei_format_float(s, sizeof(s), f, 5);
+    if (length > 0) {
+        ei_write_string(s, length);
     }
 }
 
@@ -610,8 +733,8 @@ void ei_printf_float(float f)
  */
 void ei_write_string(char *data, int length)
 {
-    for (int i = 0; i < length; i++) {
-        EtaCspUartPutc(EI_USED_UART, *(data++));
+    if (length > 0) {
+        tx_queue(data, length, true);
     }
 }
 
@@ -622,10 +745,193 @@ void ei_write_string(char *data, int length)
  */
 void ei_putc(char cChar)
 {
-    EtaCspUartPutc(EI_USED_UART, cChar);
+    tx_queue(&cChar, 1, true);
+}
+
+/**
+ * @brief      Queue serial data without waiting. What does not fit in the
+ *             TX ring is dropped and counted.
+ *
+ * @param      data    The data
+ * @param[in]  length  The length
+ *
+ * @return     Number of bytes queued
+ */
+size_t ei_write(const char *data, size_t length)
+{
+    return tx_queue(data, length, false);
+}
+
+/**
+ * @brief      Wait until all queued serial data is sent out
+ */
+void ei_write_flush(void)
+{
+    tx_queue(NULL, 0, true);
+    EtaCspUartTxWait(EI_USED_UART);
+}
+
+/**
+ * @brief      Get serial output statistics
+ *
+ * @param[out] stats  TX ring size, high water mark and dropped bytes
+ */
+void ei_write_get_stats(ei_write_stats_t *stats)
+{
+    *stats = tx_stats;
 }
 
 /* Private functions ------------------------------------------------------- */
+
+/**
+ * @brief      TX interrupt fill callback, moves queued bytes to the UART FIFO.
+ *             Only the UART ISR and the FIFO priming in HalUartTxFillStart
+ *             (with the UART interrupt disabled) call it, so the ring has one
+ *             consumer at a time.
+ */
+static uint32_t tx_fill(uint8_t *buf, uint32_t max, void *arg)
+{
+    (void)arg;
+    uint32_t tail = tx_tail;
+    uint32_t count = tx_head - tail;
+
+    if (count > max) {
+        count = max;
+    }
+
+    for (uint32_t i = 0; i < count; i++) {
+        buf[i] = tx_ring[(tail + i) & (EI_TX_RING_SIZE - 1)];
+    }
+    tx_tail = tail + count;
+
+    return count;
+}
+
+/**
+ * @brief      True when the TX interrupt can not be waited for (scheduler not
+ *             running, called from an ISR or interrupts masked). The data is
+ *             then written to the UART directly.
+ */
+static inline bool tx_irq_blocked(void)
+{
+    uint32_t primask, basepri;
+
+    EI_TX_PRIMASK_GET(primask);
+    EI_TX_BASEPRI_GET(basepri);
+
+    return (xTaskGetSchedulerState() != taskSCHEDULER_RUNNING) ||
+        xPortIsInsideInterrupt() || primask || basepri;
+}
+
+/**
+ * @brief      Write bytes to the UART directly, with interrupts masked so the
+ *             TX interrupt can't put ring data in between. Never touches the
+ *             ring, queued data goes out after it.
+ */
+static void tx_direct(const char *data, size_t length)
+{
+    uint32_t primask;
+
+    EI_TX_PRIMASK_GET(primask);
+    EI_TX_IRQ_DISABLE();
+
+    for (size_t i = 0; i < length; i++) {
+        EtaCspUartPutc(EI_USED_UART, data[i]);
+    }
+
+    EI_TX_PRIMASK_SET(primask);
+}
+
+/**
+ * @brief      Count bytes that did not go out
+ */
+static void tx_dropped(size_t length)
+{
+    taskENTER_CRITICAL();
+    tx_stats.dropped += length;
+    taskEXIT_CRITICAL();
+}
+
+/**
+ * @brief      Queue bytes in the TX ring. Blocking writers wait for room
+ *             (sleeping, not spinning) and hold the lock for the whole
+ *             message, so messages never interleave. Non blocking writers
+ *             drop what does not fit, or everything if another writer
+ *             holds the ring.
+ *
+ *             Only task context writers holding the lock move tx_head, the
+ *             TX interrupt is the only one moving tx_tail. Writers that can't
+ *             take the lock (ISR, interrupts masked, no scheduler) bypass the
+ *             ring, see tx_direct.
+ *
+ * @param[in]  data    The data, NULL with length 0 to wait for an empty ring
+ * @param[in]  length  The length
+ * @param[in]  block   Wait for room instead of dropping
+ *
+ * @return     Number of bytes queued
+ */
+static size_t tx_queue(const char *data, size_t length, bool block)
+{
+    size_t queued = 0;
+
+    if ((tx_lock == NULL) || tx_irq_blocked()) {
+        tx_direct(data, length);
+        return length;
+    }
+
+    if (xSemaphoreTake(tx_lock, block ? portMAX_DELAY : 0) != pdTRUE) {
+        tx_dropped(length);
+        return 0;
+    }
+
+    while (queued < length || (block && length == 0 && tx_head != tx_tail)) {
+        uint32_t head = tx_head;
+        uint32_t space = EI_TX_RING_SIZE - (head - tx_tail);
+
+        if (space == 0 || length == 0) {
+            if (!block) {
+                break;
+            }
+            HalUartTxFillStart(CONFIG_DEBUG_UART, tx_fill, NULL);
+            vTaskDelay(1);
+            continue;
+        }
+
+        uint32_t n = length - queued;
+        if (n > space) {
+            n = space;
+        }
+
+        uint32_t offset = head & (EI_TX_RING_SIZE - 1);
+        uint32_t first = EI_TX_RING_SIZE - offset;
+        if (first > n) {
+            first = n;
+        }
+        memcpy(&tx_ring[offset], &data[queued], first);
+        memcpy(tx_ring, &data[queued + first], n - first);
+
+        // ring contents have to be in place before the ISR sees the new head
+        __asm volatile("" ::: "memory");
+        tx_head = head + n;
+        queued += n;
+
+        uint32_t level = tx_head - tx_tail;
+        if (level > tx_stats.high_water) {
+            tx_stats.high_water = level;
+        }
+    }
+
+    if (queued < length) {
+        tx_dropped(length - queued);
+    }
+
+    xSemaphoreGive(tx_lock);
+
+    HalUartTxFillStart(CONFIG_DEBUG_UART, tx_fill, NULL);
+
+    return queued;
+}
+
 static void timer_callback(void *arg)
 {
     static char toggle = 0;
@@ -721,11 +1027,13 @@ static int get_data_output_baudrate_c(ei_device_data_output_baudrate_t *baudrate
 
 static void set_max_data_output_baudrate_c()
 {
+    ei_write_flush();
     EtaCspUartBaudSet(&etaUart, (tUartBaud)ei_dev_max_data_output_baudrate.val);
 }
 
 static void set_default_data_output_baudrate_c()
 {
+    ei_write_flush();
     EtaCspUartBaudSet(&etaUart, (tUartBaud)ei_dev_default_data_output_baudrate.val);
 }
 
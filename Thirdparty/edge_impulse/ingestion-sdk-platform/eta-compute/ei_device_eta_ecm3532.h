@@ -55,6 +55,11 @@
 
 #define EI_DEVICE_N_RESIZE_RESOLUTIONS      4
 
+/** Decimals and buffer size for ei_format_float */
+#define EI_FORMAT_FLOAT_MAX_DECIMALS        9
+/* sign, the 39 integer digits of FLT_MAX, point, decimals, terminator */
+#define EI_FORMAT_FLOAT_MAX_SIZE            (1 + 39 + 1 + EI_FORMAT_FLOAT_MAX_DECIMALS + 1)
+
 typedef enum
 {
     eiStateIdle = 0,
@@ -65,6 +70,13 @@ typedef enum
 
 } tEiState;
 
+/** Serial output statistics */
+typedef struct {
+    uint32_t size;          /* TX ring size in bytes */
+    uint32_t high_water;    /* most bytes queued in the TX ring at once */
+    uint32_t dropped;       /* bytes ei_write could not queue */
+} ei_write_stats_t;
+
 /** C Callback types */
 typedef int (*c_callback)(uint8_t out_buffer[32], size_t *out_size);
 typedef bool (*c_callback_status)(void);
@@ -118,10 +130,14 @@ void ei_serial_setup(void);
 void ei_printf_ble(const char *format, ...);
 void ei_printf(const char *format, ...);
 void ei_printf_float(float f);
+int ei_format_float(char *buf, size_t size, float f, int decimals);
 void ei_printfloat(int n_decimals, int n, ...);
 
 void ei_write_string(char *data, int length);
 void ei_putc(char cChar);
+size_t ei_write(const char *data, size_t length);
+void ei_write_flush(void);
+void ei_write_get_stats(ei_write_stats_t *stats);
 
 /* Reference to object for external usage ---------------------------------- */
 extern EiDeviceEtaEcm3532 EiDevice;
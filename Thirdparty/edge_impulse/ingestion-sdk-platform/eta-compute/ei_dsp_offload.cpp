@@ -0,0 +1,312 @@
+/* The Clear BSD License
+ *
+ * Copyright (c) 2025 EdgeImpulse Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the disclaimer
+ * below) provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ *   * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ *
+ *   * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from this
+ *   software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE GRANTED BY
+ * THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ * CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/* Include ----------------------------------------------------------------- */
+#include "config.h"
+#include "ei_dsp_offload.h"
+#include "edge-impulse-sdk/dsp/returntypes.hpp"
+#include "edge-impulse-sdk/porting/ei_classifier_porting.h"
+
+#include <math.h>
+
+#if defined(CONFIG_EI_DSP_OFFLOAD)
+
+extern "C" {
+#include "executor_public.h"
+}
+
+/* Constants --------------------------------------------------------------- */
+/** FFT lengths of the DSP q15 rfft, which also run through arm_rfft_q15 */
+#define EI_DSP_OFFLOAD_MIN_FFT      32
+#define EI_DSP_OFFLOAD_MAX_FFT      1024
+
+struct ei_ecm3532_spectrum::slot_t {
+    ExecOperand_t in;
+    ExecOperand_t out;
+    int16_t *in_buffer;
+    int16_t *out_buffer;
+    int exponent;
+    bool pending;
+};
+
+/* Private functions ------------------------------------------------------- */
+static void describe_operand(ExecOperand_t *opd, size_t n_elements)
+{
+    opd->origin = OPD_ORIG_IO;
+    opd->accessType = OPD_ACCESS_TYPE_RW;
+    opd->memType = OPD_MEM_TYPE_M3_LOCAL;
+    opd->basetypeSize = OPD_BASE_SIZE_BYTES_2;
+    opd->memScope = OPD_MEM_SCOPE_GLOBAL;
+    opd->numElements = n_elements;
+    opd->privInfo = NULL;
+}
+
+/**
+ * @brief      Place the operands of n slots in one arena with the executor's
+ *             memory planner and map them there
+ *
+ *             Op order of one round: start() of every slot, then power() of
+ *             every slot. The FFT of a slot runs from its start() until its
+ *             power() waits for it, so its input and output are live over
+ *             that whole span. With two slots in flight nothing can share,
+ *             the arena is the sum of the buffers in one allocation.
+ *
+ * @param[in]  n     Number of slots
+ *
+ * @return     false if memory runs out, nothing stays allocated then
+ */
+bool ei_ecm3532_spectrum::plan_slots(size_t n)
+{
+    ExecPlanBuf_t plan[2 * EI_DSP_OFFLOAD_MAX_SLOTS];
+    uint16_t n_bufs = 0;
+    uint32_t arena_size = 0;
+
+    for (size_t ix = 0; ix < n; ix++) {
+        slot_t *s = &slots[ix];
+
+        /* DSP output is the full complex spectrum, re and im per bin */
+        describe_operand(&s->in, n_fft);
+        describe_operand(&s->out, 2 * n_fft);
+
+        ExecOperand_t *opds[] = { &s->in, &s->out };
+        for (size_t op = 0; op < 2; op++) {
+            plan[n_bufs].opd = opds[op];
+            plan[n_bufs].firstUse = EXEC_PLAN_UNUSED;
+            plan[n_bufs].lastUse = EXEC_PLAN_UNUSED;
+            plan[n_bufs].offset = 0;
+            n_bufs++;
+        }
+    }
+    for (size_t ix = 0; ix < n; ix++) {
+        slot_t *s = &slots[ix];
+
+        ExecPlanUse(plan, n_bufs, &s->in, ix);
+        ExecPlanUse(plan, n_bufs, &s->out, ix);
+        ExecPlanUse(plan, n_bufs, &s->in, n + ix);
+        ExecPlanUse(plan, n_bufs, &s->out, n + ix);
+    }
+
+    if (ExecPlanMemory(plan, n_bufs, &arena_size) != EXEC_STATUS_OK) {
+        return false;
+    }
+
+    arena = ei_malloc(arena_size);
+    if (!arena) {
+        return false;
+    }
+
+    if (ExecBindPlan(plan, n_bufs, arena) != EXEC_STATUS_OK) {
+        for (uint16_t ix = 0; ix < n_bufs; ix++) {
+            if (plan[ix].opd->privInfo) {
+                ExecFreeMem(plan[ix].opd);
+                plan[ix].opd->privInfo = NULL;
+            }
+        }
+        ei_free(arena);
+        arena = NULL;
+        return false;
+    }
+
+    for (size_t ix = 0; ix < n; ix++) {
+        slots[ix].in_buffer = (int16_t *)ExecGetBufAddr(&slots[ix].in);
+        slots[ix].out_buffer = (int16_t *)ExecGetBufAddr(&slots[ix].out);
+    }
+
+    return true;
+}
+
+/* Public functions -------------------------------------------------------- */
+bool ei_ecm3532_spectrum::supported(size_t n_fft)
+{
+    return (n_fft >= EI_DSP_OFFLOAD_MIN_FFT) && (n_fft <= EI_DSP_OFFLOAD_MAX_FFT) &&
+        ((n_fft & (n_fft - 1)) == 0);
+}
+
+/**
+ * @brief      Allocate the slots. If memory runs out fewer slots are usable,
+ *             start() and power() on a missing slot give EIDSP_OUT_OF_MEM
+ *
+ * @param[in]  fft_points  FFT length, see supported()
+ * @param[in]  max_slots   Slots wanted, at most EI_DSP_OFFLOAD_MAX_SLOTS
+ */
+ei_ecm3532_spectrum::ei_ecm3532_spectrum(size_t fft_points, size_t max_slots)
+    : n_fft(fft_points), n_slots(0), slots(NULL), arena(NULL)
+{
+    if (!supported(n_fft) || max_slots == 0 || max_slots > EI_DSP_OFFLOAD_MAX_SLOTS) {
+        return;
+    }
+
+    slots = (slot_t *)ei_calloc(max_slots, sizeof(slot_t));
+    if (!slots) {
+        return;
+    }
+
+    for (size_t n = max_slots; n > 0; n--) {
+        if (plan_slots(n)) {
+            n_slots = n;
+            break;
+        }
+    }
+}
+
+ei_ecm3532_spectrum::~ei_ecm3532_spectrum()
+{
+    for (size_t ix = 0; ix < n_slots; ix++) {
+        slot_t *s = &slots[ix];
+
+        /* the DSP may still be writing into it */
+        if (s->pending) {
+            ExecWaitForBuf(&s->out);
+        }
+        ExecFreeMem(&s->in);
+        ExecFreeMem(&s->out);
+    }
+    ei_free(arena);
+    ei_free(slots);
+}
+
+/**
+ * @brief      Quantize a frame and queue its FFT on the DSP
+ *
+ * @param[in]  slot        Slot to use, waits if its previous FFT is pending
+ * @param[in]  frame       Frame, truncated or zero padded to the FFT length
+ * @param[in]  frame_size  Number of samples in frame
+ *
+ * @return     EIDSP_OK, or an EIDSP error (no slot, DSP not responding), the
+ *             caller computes the frame on the M3 then
+ */
+int ei_ecm3532_spectrum::start(size_t slot, const float *frame, size_t frame_size)
+{
+    if (slot >= n_slots) {
+        return ei::EIDSP_OUT_OF_MEM;
+    }
+    slot_t *s = &slots[slot];
+
+    if (s->pending) {
+        ExecWaitForBuf(&s->out);
+        s->pending = false;
+    }
+
+    if (!ExecDspResponding()) {
+        return ei::EIDSP_NOT_SUPPORTED;
+    }
+
+    if (frame_size > n_fft) {
+        frame_size = n_fft;
+    }
+
+    /* Block floating point, the largest sample gets the full q15 range */
+    float max_abs = 0.0f;
+    for (size_t ix = 0; ix < frame_size; ix++) {
+        float v = fabsf(frame[ix]);
+        if (v > max_abs) {
+            max_abs = v;
+        }
+    }
+    frexpf(max_abs, &s->exponent);
+
+    float scale = ldexpf(1.0f, 15 - s->exponent);
+    for (size_t ix = 0; ix < frame_size; ix++) {
+        int32_t q = (int32_t)lrintf(frame[ix] * scale);
+        if (q > INT16_MAX) {
+            q = INT16_MAX;
+        }
+        else if (q < INT16_MIN) {
+            q = INT16_MIN;
+        }
+        s->in_buffer[ix] = (int16_t)q;
+    }
+    for (size_t ix = frame_size; ix < n_fft; ix++) {
+        s->in_buffer[ix] = 0;
+    }
+
+    if (Exec_fft_q15(EXEC_HW_ID_DSP, &s->in, &s->out, n_fft) != EXEC_STATUS_OK) {
+        return ei::EIDSP_NOT_SUPPORTED;
+    }
+    s->pending = true;
+
+    return ei::EIDSP_OK;
+}
+
+/**
+ * @brief      Wait for the FFT of a slot and compute its power spectrum,
+ *             |X|^2 / n_fft as processing::power_spectrum does
+ *
+ * @param[in]  slot             Slot given to start()
+ * @param      out_buffer       Output, n_fft / 2 + 1 bins
+ * @param[in]  out_buffer_size  Size of out_buffer
+ *
+ * @return     EIDSP_OK, or an EIDSP error (no FFT started, DSP timed out),
+ *             the caller computes the frame on the M3 then
+ */
+int ei_ecm3532_spectrum::power(size_t slot, float *out_buffer, size_t out_buffer_size)
+{
+    if (slot >= n_slots) {
+        return ei::EIDSP_OUT_OF_MEM;
+    }
+    if (out_buffer_size != n_fft / 2 + 1) {
+        return ei::EIDSP_MATRIX_SIZE_MISMATCH;
+    }
+    slot_t *s = &slots[slot];
+
+    if (!s->pending) {
+        return ei::EIDSP_NOT_SUPPORTED;
+    }
+    ExecWaitForBuf(&s->out);
+    s->pending = false;
+
+    /* the executor gave up waiting for the DSP, out_buffer is not valid */
+    if (!ExecDspResponding()) {
+        return ei::EIDSP_NOT_SUPPORTED;
+    }
+
+    /**
+     * The q15 rfft scales its output down by n_fft, as arm_rfft_q15, so
+     * X = y * n_fft * 2^(exponent - 15) and |X|^2 / n_fft folds into one
+     * scale. re^2 + im^2 is at most 2^31, it fits unsigned.
+     */
+    float scale = ldexpf((float)n_fft, 2 * s->exponent - 30);
+    const int16_t *bin = s->out_buffer;
+    for (size_t ix = 0; ix < out_buffer_size; ix++) {
+        int32_t re = bin[0];
+        int32_t im = bin[1];
+        uint32_t mag = (uint32_t)(re * re) + (uint32_t)(im * im);
+        out_buffer[ix] = (float)mag * scale;
+        bin += 2;
+    }
+
+    return ei::EIDSP_OK;
+}
+
+#endif /* CONFIG_EI_DSP_OFFLOAD */
@@ -0,0 +1,75 @@
+/* The Clear BSD License
+ *
+ * Copyright (c) 2025 EdgeImpulse Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the disclaimer
+ * below) provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ *   * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ *
+ *   * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from this
+ *   software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE GRANTED BY
+ * THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ * CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef EI_DSP_OFFLOAD
+#define EI_DSP_OFFLOAD
+
+/* Include ----------------------------------------------------------------- */
+#include <stddef.h>
+#include <stdint.h>
+
+/** Frames that can be on the DSP at the same time */
+#define EI_DSP_OFFLOAD_MAX_SLOTS    2
+
+/**
+ * Power spectrum of audio frames with the FFT on the DSP core.
+ *
+ * Each slot has a q15 input and output buffer, all in one arena. start()
+ * quantizes a frame with a block exponent and queues its FFT on the DSP,
+ * power() waits for it and scales the bins back, so the M3 can work on the
+ * previous frame while the DSP transforms the next one.
+ */
+class ei_ecm3532_spectrum {
+public:
+    static bool supported(size_t n_fft);
+
+    ei_ecm3532_spectrum(size_t fft_points, size_t max_slots);
+    ~ei_ecm3532_spectrum();
+
+    int start(size_t slot, const float *frame, size_t frame_size);
+    int power(size_t slot, float *out_buffer, size_t out_buffer_size);
+
+private:
+    struct slot_t;
+
+    bool plan_slots(size_t n);
+
+    size_t n_fft;
+    size_t n_slots;
+    slot_t *slots;
+    /* buffers of all slots, placed by the executor's memory planner */
+    void *arena;
+};
+
+#endif
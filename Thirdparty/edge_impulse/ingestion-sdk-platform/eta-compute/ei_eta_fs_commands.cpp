@@ -1,9 +1,15 @@
 
 /* Include ----------------------------------------------------------------- */
+#include <string.h>
+
 #include "ei_eta_fs_commands.h"
 #include "ei_device_eta_ecm3532.h"
 #include "eta_csp_spi.h"
 
+#include "FreeRTOS.h"
+#include "semphr.h"
+#include "task.h"
+
 #include "config.h"
 
 #define SERIAL_FLASH 0
@@ -24,6 +30,15 @@
 
 #define ETA_SPI_NUM (tSpiNum)CONFIG_SPI_FLASH_SPI_NUM
 
+/** Full stream pages that can wait while the flash is erasing */
+#define STREAM_N_PAGES          8
+/** How far the background erase may run ahead of the stream */
+#define ERASE_AHEAD_WINDOW      (MX25R_SECTOR_SIZE * 4)
+#define ERASE_AHEAD_TASK_STACK  256
+#define ERASE_AHEAD_TASK_PRIO   tskIDLE_PRIORITY
+/** Longest erase to wait for, a 64K block erase takes up to 3.5 s. */
+#define ERASE_TIMEOUT_MS        3500
+
 /* Private function prototypes --------------------------------------------- */
 static uint32_t flash_write(uint32_t address, const uint8_t *buffer, uint32_t bufferSize);
 static uint32_t flash_erase_sectors(uint32_t startAddress, uint32_t nSectors);
@@ -34,11 +49,38 @@ static void flash_erase_sector(uint32_t byteAddress);
 static void flash_erase_block(uint32_t byteAddress);
 static void flash_program_page(uint32_t byteAddress, uint8_t *page, uint32_t pageBytes);
 static uint32_t flash_read_data(uint32_t byteAddress, uint8_t *buffer, uint32_t readBytes);
+static uint32_t flash_start_program_page(uint32_t byteAddress, uint8_t *page, uint32_t pageBytes);
+static uint32_t flash_start_erase(uint32_t byteAddress, bool block);
+static bool flash_busy(void);
+static uint32_t flash_wait_while_erasing(void);
+static uint32_t stream_lock_create(void);
+static uint32_t stream_program_next(bool block, bool partial);
+static void erase_ahead_step(void);
+static void erase_ahead_task(void *arg);
 
 #if (SAMPLE_MEMORY == RAM)
 static uint8_t ram_memory[SIZE_RAM_BUFFER];
 #endif
 
+/* Private variables ------------------------------------------------------- */
+/** Sample data offset of the next streamed byte */
+static uint32_t stream_offset;
+
+#if (SAMPLE_MEMORY == SERIAL_FLASH)
+/** Write combining buffers for streamed sample data, indexed by page number */
+static uint8_t stream_pages[STREAM_N_PAGES][MX25R_PAGE_SIZE];
+/** Sample data offset of the first streamed byte not yet programmed */
+static uint32_t stream_prog_offset;
+/** Sample data below erase_front is erased (or being erased) */
+static uint32_t erase_front;
+/** Sample data up to erase_end should be erased ahead of the stream */
+static uint32_t erase_end;
+
+/** Serialises flash access between the stream writer and the erase task */
+static SemaphoreHandle_t flash_lock = NULL;
+static TaskHandle_t erase_ahead_task_handle = NULL;
+#endif
+
 /** 32-bit align write buffer size */
 #define WORD_ALIGN(a) ((a & 0x3) ? (a & ~0x3) + 0x4 : a)
 
@@ -162,6 +204,214 @@ int ei_eta_fs_write_samples(const void *sample_buffer, uint32_t address_offset,
 #endif
 }
 
+/**
+ * @brief      Erase the first lead_bytes of the sample data space and leave
+ *             the rest up to end_address to a low priority task, which
+ *             erases sector by sector ahead of the stream. Streamed pages
+ *             never get programmed beyond the erased part, if the erase
+ *             falls behind the stream write stalls until it caught up.
+ *
+ * @param[in]  end_address  End of the sample data that will be streamed
+ * @param[in]  lead_bytes   Bytes to erase before returning
+ *
+ * @return     ei_eta_ret_t
+ */
+int ei_eta_fs_erase_ahead_start(uint32_t end_address, uint32_t lead_bytes)
+{
+#if (SAMPLE_MEMORY == RAM)
+    return ETA_FS_CMD_OK;
+#elif (SAMPLE_MEMORY == SERIAL_FLASH)
+    uint32_t retVal = stream_lock_create();
+
+    if (retVal != ETA_FS_CMD_OK) {
+        return retVal;
+    }
+
+    if (erase_ahead_task_handle == NULL) {
+        if (xTaskCreate(erase_ahead_task, "Erase ahead", ERASE_AHEAD_TASK_STACK, NULL,
+                ERASE_AHEAD_TASK_PRIO, &erase_ahead_task_handle) != pdPASS) {
+            return ETA_FS_CMD_NOT_INIT;
+        }
+    }
+
+    /* Round up to whole sectors */
+    end_address = (end_address + MX25R_SECTOR_SIZE - 1) & ~(MX25R_SECTOR_SIZE - 1);
+    lead_bytes = (lead_bytes + MX25R_SECTOR_SIZE - 1) & ~(MX25R_SECTOR_SIZE - 1);
+    if (lead_bytes > end_address) {
+        lead_bytes = end_address;
+    }
+
+    xSemaphoreTake(flash_lock, portMAX_DELAY);
+
+    erase_front = 0;
+    erase_end = 0;
+
+    /* Lead in, with 64K block erases where aligned */
+    while (erase_front < lead_bytes && retVal == ETA_FS_CMD_OK) {
+        bool block = ((erase_front & (MX25R_BLOCK64_SIZE - 1)) == 0) &&
+            ((erase_front + MX25R_BLOCK64_SIZE) <= lead_bytes);
+
+        retVal = flash_start_erase(MX25R_BLOCK64_SIZE + erase_front, block);
+        erase_front += block ? MX25R_BLOCK64_SIZE : MX25R_SECTOR_SIZE;
+    }
+
+    if (retVal == ETA_FS_CMD_OK && flash_wait_while_erasing() == 0) {
+        retVal = ETA_FS_CMD_ERASE_ERROR;
+    }
+
+    if (retVal == ETA_FS_CMD_OK) {
+        erase_end = end_address;
+    }
+
+    xSemaphoreGive(flash_lock);
+
+    if (retVal == ETA_FS_CMD_OK) {
+        xTaskNotifyGive(erase_ahead_task_handle);
+    }
+
+    return retVal;
+#endif
+}
+
+/**
+ * @brief      Start streaming sample data at address_offset. Following
+ *             ei_eta_fs_stream_write() calls are collected per flash page,
+ *             so the flash is only programmed once per 256 bytes.
+ *
+ * @param[in]  address_offset  The address offset
+ *
+ * @return     ei_eta_ret_t
+ */
+int ei_eta_fs_stream_begin(uint32_t address_offset)
+{
+    stream_offset = address_offset;
+#if (SAMPLE_MEMORY == SERIAL_FLASH)
+    stream_prog_offset = address_offset;
+
+    return stream_lock_create();
+#else
+    return ETA_FS_CMD_OK;
+#endif
+}
+
+/**
+ * @brief      Append sample data to the stream. Full pages are handed to the
+ *             flash without waiting for the program cycle, while the flash
+ *             is busy (erasing) they wait in the page buffers. Only when all
+ *             page buffers are in use the write blocks.
+ *
+ * @param[in]  sample_buffer  The sample buffer
+ * @param[in]  n_bytes        The n bytes
+ *
+ * @return     ei_eta_ret_t
+ */
+int ei_eta_fs_stream_write(const void *sample_buffer, uint32_t n_bytes)
+{
+    const uint8_t *src = (const uint8_t *)sample_buffer;
+
+    if (sample_buffer == 0) {
+        return ETA_FS_CMD_NULL_POINTER;
+    }
+
+#if (SAMPLE_MEMORY == RAM)
+    if ((stream_offset + n_bytes) > SIZE_RAM_BUFFER) {
+        return ETA_FS_CMD_WRITE_ERROR;
+    }
+
+    memcpy(&ram_memory[stream_offset], src, n_bytes);
+    stream_offset += n_bytes;
+
+    return ETA_FS_CMD_OK;
+
+#elif (SAMPLE_MEMORY == SERIAL_FLASH)
+
+    if (flash_lock == NULL) {
+        return ETA_FS_CMD_NOT_INIT;
+    }
+
+    while (n_bytes) {
+        uint32_t page_offset = stream_offset & (MX25R_PAGE_SIZE - 1);
+        uint32_t chunk = MX25R_PAGE_SIZE - page_offset;
+        uint32_t retVal;
+
+        /* Starting a page in a buffer that is still waiting to be programmed */
+        if (page_offset == 0 &&
+            (stream_offset - (stream_prog_offset & ~(MX25R_PAGE_SIZE - 1))) >=
+                (STREAM_N_PAGES * MX25R_PAGE_SIZE)) {
+
+            xSemaphoreTake(flash_lock, portMAX_DELAY);
+            retVal = stream_program_next(true, false);
+            xSemaphoreGive(flash_lock);
+
+            if (retVal != ETA_FS_CMD_OK) {
+                return retVal;
+            }
+        }
+
+        if (chunk > n_bytes) {
+            chunk = n_bytes;
+        }
+
+        memcpy(&stream_pages[(stream_offset / MX25R_PAGE_SIZE) % STREAM_N_PAGES][page_offset],
+            src, chunk);
+        stream_offset += chunk;
+        src += chunk;
+        n_bytes -= chunk;
+
+        /* Page complete, program what we can and keep the erase going */
+        if ((stream_offset & (MX25R_PAGE_SIZE - 1)) == 0) {
+            xSemaphoreTake(flash_lock, portMAX_DELAY);
+            retVal = stream_program_next(false, false);
+            erase_ahead_step();
+            xSemaphoreGive(flash_lock);
+
+            if (retVal != ETA_FS_CMD_OK) {
+                return retVal;
+            }
+        }
+    }
+
+    return ETA_FS_CMD_OK;
+
+#endif
+}
+
+/**
+ * @brief      Program all streamed data and wait for the flash to finish.
+ *             Stops the background erase, streaming can continue after a
+ *             flush but only within the already erased sample data.
+ *
+ * @return     ei_eta_ret_t
+ */
+int ei_eta_fs_stream_flush(void)
+{
+#if (SAMPLE_MEMORY == RAM)
+    return ETA_FS_CMD_OK;
+#elif (SAMPLE_MEMORY == SERIAL_FLASH)
+    uint32_t retVal = ETA_FS_CMD_OK;
+
+    if (flash_lock == NULL) {
+        return ETA_FS_CMD_NOT_INIT;
+    }
+
+    xSemaphoreTake(flash_lock, portMAX_DELAY);
+
+    while (stream_prog_offset < stream_offset && retVal == ETA_FS_CMD_OK) {
+        retVal = stream_program_next(true, true);
+    }
+
+    erase_end = erase_front;
+
+    if (retVal == ETA_FS_CMD_OK && flash_wait_while_erasing() == 0) {
+        retVal = ETA_FS_CMD_WRITE_ERROR;
+    }
+
+    xSemaphoreGive(flash_lock);
+
+    return retVal;
+#endif
+}
+
 /**
  * @brief      Read sample data
  *
@@ -321,6 +571,217 @@ static uint32_t flash_write(uint32_t address, const uint8_t *buffer, uint32_t bu
     return ETA_FS_CMD_OK;
 }
 
+/**
+ * @brief      Program (part of) a single page without waiting for the program
+ *             cycle to finish. The data is clocked out before returning, so
+ *             the page buffer can be reused straight away.
+ *
+ * @param[in]  byteAddress  The byte address
+ * @param      page         The page data
+ * @param[in]  pageBytes    The page bytes, must not cross a page boundary
+ *
+ * @return     ei_eta_ret_t
+ */
+static uint32_t flash_start_program_page(uint32_t byteAddress, uint8_t *page, uint32_t pageBytes)
+{
+    int stat;
+    int retry = MX25R_RETRY;
+
+    /* Previous page might still be programming, or a sector erasing */
+    if (flash_wait_while_erasing() == 0)
+        return ETA_FS_CMD_WRITE_ERROR;
+
+    do {
+        flash_write_enable();
+        stat = flash_status_register();
+    } while (!(stat & MX25R_STAT_WEL) && --retry);
+
+    if (!retry) {
+        return ETA_FS_CMD_WRITE_ERROR;
+    }
+
+    flash_program_page(byteAddress, page, pageBytes);
+
+    return ETA_FS_CMD_OK;
+}
+
+/**
+ * @brief      Start erasing a sector or 64K block, without waiting for the
+ *             erase to finish
+ *
+ * @param[in]  byteAddress  The byte address
+ * @param[in]  block        Erase the 64K block instead of the sector
+ *
+ * @return     ei_eta_ret_t
+ */
+static uint32_t flash_start_erase(uint32_t byteAddress, bool block)
+{
+    int stat;
+    int retry = MX25R_RETRY;
+
+    if (flash_wait_while_erasing() == 0)
+        return ETA_FS_CMD_ERASE_ERROR;
+
+    do {
+        flash_write_enable();
+        stat = flash_status_register();
+    } while (!(stat & MX25R_STAT_WEL) && --retry);
+
+    if (!retry) {
+        return ETA_FS_CMD_ERASE_ERROR;
+    }
+
+    if (block) {
+        flash_erase_block(byteAddress);
+    }
+    else {
+        flash_erase_sector(byteAddress);
+    }
+
+    return ETA_FS_CMD_OK;
+}
+
+/**
+ * @brief      Check the WIP bit, without waiting
+ *
+ * @return     true if the flash is programming or erasing
+ */
+static bool flash_busy(void)
+{
+    return (flash_status_register() & MX25R_STAT_WIP) ? true : false;
+}
+
+/**
+ * @brief      Wait for an erase (or program) to finish, allows for the
+ *             longer erase times. The timeout is in ticks, not polls, so it
+ *             does not depend on the SPI clock. The erase task only calls
+ *             this with the flash idle, the tick count is frozen while it
+ *             has the scheduler suspended.
+ *
+ * @return     0 if the device is hanging
+ */
+static uint32_t flash_wait_while_erasing(void)
+{
+    TickType_t start = xTaskGetTickCount();
+    uint32_t retry;
+
+    do {
+        retry = flash_wait_while_busy();
+    } while (retry == 0 && (xTaskGetTickCount() - start) < pdMS_TO_TICKS(ERASE_TIMEOUT_MS));
+
+    return retry;
+}
+
+/**
+ * @brief      Create the flash lock on first use, streaming and erase ahead
+ *             both need it
+ *
+ * @return     ei_eta_ret_t
+ */
+static uint32_t stream_lock_create(void)
+{
+    if (flash_lock == NULL) {
+        flash_lock = xSemaphoreCreateMutex();
+        if (flash_lock == NULL) {
+            return ETA_FS_CMD_NOT_INIT;
+        }
+    }
+
+    return ETA_FS_CMD_OK;
+}
+
+/**
+ * @brief      Program the oldest streamed page that isn't programmed yet.
+ *             Data beyond the erase front is never programmed, a blocking
+ *             call erases up to it first (the stream overtook the erase).
+ *             Call with flash_lock taken.
+ *
+ * @param[in]  block    Wait for the flash, instead of returning when busy
+ * @param[in]  partial  Also program a partly filled page
+ *
+ * @return     ei_eta_ret_t
+ */
+static uint32_t stream_program_next(bool block, bool partial)
+{
+    uint32_t page_end = (stream_prog_offset & ~(MX25R_PAGE_SIZE - 1)) + MX25R_PAGE_SIZE;
+    uint32_t end = (page_end < stream_offset) ? page_end : stream_offset;
+    uint32_t retVal;
+
+    if (end <= stream_prog_offset || (!partial && end != page_end)) {
+        return ETA_FS_CMD_OK;
+    }
+
+    if (!block && (erase_front < end || flash_busy())) {
+        return ETA_FS_CMD_OK;
+    }
+
+    /* Watermark, stall until the erase caught up */
+    while (erase_front < end) {
+        retVal = flash_start_erase(MX25R_BLOCK64_SIZE + erase_front, false);
+        if (retVal != ETA_FS_CMD_OK) {
+            return retVal;
+        }
+        erase_front += MX25R_SECTOR_SIZE;
+    }
+
+    retVal = flash_start_program_page(
+        MX25R_BLOCK64_SIZE + stream_prog_offset,
+        &stream_pages[(stream_prog_offset / MX25R_PAGE_SIZE) % STREAM_N_PAGES]
+                     [stream_prog_offset & (MX25R_PAGE_SIZE - 1)],
+        end - stream_prog_offset);
+
+    if (retVal == ETA_FS_CMD_OK) {
+        stream_prog_offset = end;
+    }
+
+    return retVal;
+}
+
+/**
+ * @brief      Erase the next sector if the flash is idle and the erase isn't
+ *             too far ahead of the stream. Called right after
+ *             stream_program_next(), so programming pages goes first.
+ *             Call with flash_lock taken.
+ */
+static void erase_ahead_step(void)
+{
+    if (erase_front >= erase_end ||
+        erase_front >= (stream_offset + ERASE_AHEAD_WINDOW) ||
+        flash_busy()) {
+        return;
+    }
+
+    if (flash_start_erase(MX25R_BLOCK64_SIZE + erase_front, false) == ETA_FS_CMD_OK) {
+        erase_front += MX25R_SECTOR_SIZE;
+    }
+}
+
+/**
+ * @brief      Low priority task keeping the erase ahead of the stream, and
+ *             programming full pages, while the writer doesn't need the CPU
+ */
+static void erase_ahead_task(void *arg)
+{
+    (void)arg;
+
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        while (erase_front < erase_end) {
+            xSemaphoreTake(flash_lock, portMAX_DELAY);
+            /* The flash shares its SPI bus with the IMU, don't let the
+               sampling task preempt a transfer */
+            vTaskSuspendAll();
+            stream_program_next(false, false);
+            erase_ahead_step();
+            xTaskResumeAll();
+            xSemaphoreGive(flash_lock);
+
+            vTaskDelay(1);
+        }
+    }
+}
+
 /**
  * @brief      Erase mulitple flash sectors
  *
@@ -29,6 +29,9 @@ typedef enum
 #define MX25R_BLOCK64_SIZE		(MX25R_BLOCK32_SIZE * 2)/**!< 64K Block	 	 */
 #define MX25R_CHIP_SIZE			(MX25R_BLOCK64_SIZE * 128)/**!< 64Mb on chip */
 
+/** Sample data erased before sampling starts, the rest is erased while sampling */
+#define ETA_FS_ERASE_AHEAD_LEAD	(MX25R_SECTOR_SIZE * 2)
+
 /** MX25R Register defines */
 #define MX25R_PP				0x02		/**!< Program page				 */
 #define MX25R_READ				0x03		/**!< Read data command			 */
@@ -56,6 +59,10 @@ int ei_eta_fs_save_config(const uint32_t *config, uint32_t config_size);
 
 int ei_eta_fs_erase_sampledata(uint32_t start_block, uint32_t end_address);
 int ei_eta_fs_write_samples(const void *sample_buffer, uint32_t address_offset, uint32_t n_samples);
+int ei_eta_fs_erase_ahead_start(uint32_t end_address, uint32_t lead_bytes);
+int ei_eta_fs_stream_begin(uint32_t address_offset);
+int ei_eta_fs_stream_write(const void *sample_buffer, uint32_t n_bytes);
+int ei_eta_fs_stream_flush(void);
 int ei_eta_fs_read_sample_data(void *sample_buffer, uint32_t address_offset, uint32_t n_read_bytes);
 uint32_t ei_eta_fs_get_block_size(void);
 uint32_t ei_eta_fs_get_n_available_sample_blocks(void);
@@ -39,7 +39,7 @@
 
 // maximum number of commands
 #ifndef EI_AT_MAX_CMDS
-#define EI_AT_MAX_CMDS      36
+#define EI_AT_MAX_CMDS      40
 #endif // EI_AT_MAX_CMDS
 
 typedef struct {
@@ -302,6 +302,42 @@ static void at_start_snapshot_stream(char *width_s, char *height_s, char *baudra
     }
 }
 
+static void at_start_snapshot_stream_format(char *width_s, char *height_s, char *baudrate_s, char *format_s) {
+
+    if (!ei_config_get_context()->start_snapshot_stream_format) {
+        at_error_not_implemented();
+        return;
+    }
+
+    size_t width = (size_t)atoi(width_s);
+    size_t height = (size_t)atoi(height_s);
+
+    bool use_max_baudrate = false;
+    if (baudrate_s[0] == 'y') {
+       use_max_baudrate = true;
+    }
+
+    ei_snapshot_format_t format;
+    if (strcmp(format_s, "base64") == 0) {
+        format = EI_SNAPSHOT_FORMAT_BASE64;
+    }
+    else if (strcmp(format_s, "raw") == 0) {
+        format = EI_SNAPSHOT_FORMAT_RAW;
+    }
+    else if (strcmp(format_s, "rle") == 0) {
+        format = EI_SNAPSHOT_FORMAT_RLE;
+    }
+    else {
+        ei_printf("ERR: Invalid format '%s' (base64, raw or rle)\n", format_s);
+        return;
+    }
+
+    if (!ei_config_get_context()->start_snapshot_stream_format(width, height, use_max_baudrate, format)) {
+        ei_printf("ERR: Snapshot Stream failed\n");
+        return;
+    }
+}
+
 
 static void at_list_sensors() {
 
@@ -681,6 +717,8 @@ void ei_at_register_generic_cmds() {
     ei_at_cmd_register("SNAPSHOT?", "Lists snapshot settings", &at_get_snapshot);
     ei_at_cmd_register("SNAPSHOT=", "Take a snapshot (WIDTH,HEIGHT,USEMAXRATE?(y/n))", &at_take_snapshot);
     ei_at_cmd_register("SNAPSHOTSTREAM=", "Take a stream of snapshot stream (WIDTH,HEIGHT,USEMAXRATE?(y/n))", &at_start_snapshot_stream);
+    ei_at_cmd_register("SNAPSHOTSTREAM=", "Take a stream of snapshot stream (WIDTH,HEIGHT,USEMAXRATE?(y/n),FORMAT(base64/raw/rle))",
+        &at_start_snapshot_stream_format);
 #endif
     ei_at_cmd_register("LISTFILES", "Lists all files on the device", &at_list_files);
     ei_at_cmd_register("READFILE=", "Read a specific file (as base64) (FILENAME,USEMAXRATE?(y/n))", &at_read_file);
@@ -110,6 +110,7 @@ extern "C" {
 #define ETA_BSP_ICM20602_MISO       eGpioBit27
 #define ETA_BSP_ICM20602_SPI_CS     eGpioBit30
 #define ETA_BSP_ICM20602_SPI_CS_NUM eSpiChipSel0
+#define ETA_BSP_ICM20602_INT        eGpioBit25
 
 #define ETA_BSP_SPIFLASH_SPI_NUM  ETA_BSP_ICM20602_SPI_NUM
 #define ETA_BSP_SPIFLASHSPI_SPEED ETA_BSP_ICM20602_SPI_SPEED
@@ -222,6 +222,26 @@ tIcm20602Sample;
 #define ICM20602_SAMPLE_RATE_50HZ   0x13
 #define ICM20602_SAMPLE_RATE_20HZ   0x31
 
+//
+// FIFO.
+//
+#define ICM20602_CONFIG_FIFO_MODE     0x40 // Stop writing when the FIFO is full
+#define ICM20602_FIFO_EN_ACCEL        0x08
+#define ICM20602_FIFO_EN_GYRO         0x10
+#define ICM20602_USER_CTRL_FIFO_EN    0x40
+#define ICM20602_USER_CTRL_FIFO_RST   0x04
+#define ICM20602_INT_FIFO_OFLOW       0x10
+#define ICM20602_FIFO_WM_INT          0x40
+#define ICM20602_INT_PIN_LATCH_INT_EN 0x20 // INT held until cleared
+#define ICM20602_INT_PIN_INT_RD_CLEAR 0x10 // Any register read clears it
+#define ICM20602_FIFO_SIZE            1008
+
+//
+// Accel, temperature and gyro, same layout as the data registers.
+//
+#define ICM20602_FIFO_PACKET_SIZE     14
+#define ICM20602_FIFO_MAX_SAMPLES     (ICM20602_FIFO_SIZE / ICM20602_FIFO_PACKET_SIZE)
+
 /*******************************************************************************
  *
  * External function definitions.
@@ -231,6 +251,11 @@ extern void EtaDevicesIcm20602Init(tIcm20602Cfg *psCfg);
 extern uint8_t EtaDevicesIcm20602IDGet(void);
 extern void EtaDevicesIcm20602SampleGet(tIcm20602Sample *psSample);
 extern int EtaDevicesIcm20602Status(void);
+extern void EtaDevicesIcm20602FifoStart(uint8_t ui8SampleRateDiv,
+                                        uint16_t ui16WatermarkSamples);
+extern void EtaDevicesIcm20602FifoStop(void);
+extern int32_t EtaDevicesIcm20602FifoRead(tIcm20602Sample *psSamples,
+                                          uint32_t ui32MaxSamples);
 #ifdef __cplusplus
 }
 #endif
@@ -214,3 +214,166 @@ int EtaDevicesIcm20602Status(void)
     return stat8[0];
 }
 
+/***************************************************************************//**
+ *
+ * _Icm20602Unpack - Unpack a big endian data register / FIFO packet.
+ *
+ * @param pui8Bytes Accel, temperature and gyro bytes.
+ * @param psSample pointer to a sample structure to store the values.
+ *
+ ******************************************************************************/
+static void
+_Icm20602Unpack(const uint8_t *pui8Bytes, tIcm20602Sample *psSample)
+{
+    psSample->pi16Accel[0] = (pui8Bytes[0] << 8) | pui8Bytes[1];
+    psSample->pi16Accel[1] = (pui8Bytes[2] << 8) | pui8Bytes[3];
+    psSample->pi16Accel[2] = (pui8Bytes[4] << 8) | pui8Bytes[5];
+    psSample->pi16Gyro[0] = (pui8Bytes[8] << 8) | pui8Bytes[9];
+    psSample->pi16Gyro[1] = (pui8Bytes[10] << 8) | pui8Bytes[11];
+    psSample->pi16Gyro[2] = (pui8Bytes[12] << 8) | pui8Bytes[13];
+}
+
+/***************************************************************************//**
+ *
+ * EtaDevicesIcm20602FifoStart - Sample into the FIFO at the sensor clock.
+ *
+ * The INT pin is raised (latched) when the watermark is reached or the FIFO
+ * overflows, EtaDevicesIcm20602FifoRead() clears it.
+ *
+ * @param ui8SampleRateDiv Output data rate is 1kHz / (1 + ui8SampleRateDiv).
+ * @param ui16WatermarkSamples Samples in the FIFO before the INT pin is raised.
+ *
+ ******************************************************************************/
+void
+EtaDevicesIcm20602FifoStart(uint8_t ui8SampleRateDiv,
+                            uint16_t ui16WatermarkSamples)
+{
+    uint16_t ui16WatermarkBytes;
+
+    if(ui16WatermarkSamples == 0)
+    {
+        ui16WatermarkSamples = 1;
+    }
+    else if(ui16WatermarkSamples > ICM20602_FIFO_MAX_SAMPLES)
+    {
+        ui16WatermarkSamples = ICM20602_FIFO_MAX_SAMPLES;
+    }
+    ui16WatermarkBytes = ui16WatermarkSamples * ICM20602_FIFO_PACKET_SIZE;
+
+    //
+    // Stop the FIFO while reconfiguring.
+    //
+    _Icm20602Write(ICM20602_USER_CTRL, 0x00);
+    _Icm20602Write(ICM20602_FIFO_EN, 0x00);
+
+    //
+    // Output data rate, the gyro DLPF keeps the internal rate at 1kHz.
+    //
+    _Icm20602Write(ICM20602_SMPLRT_DIV, ui8SampleRateDiv);
+    _Icm20602Write(ICM20602_CONFIG,
+                   ICM20602_CONFIG_FIFO_MODE | ICM20602_GYRO_DLPF6_NBW8HZ);
+
+    //
+    // Watermark, a non zero threshold enables the watermark interrupt.
+    //
+    _Icm20602Write(ICM20602_FIFO_WM_TH1, (ui16WatermarkBytes >> 8) & 0x03);
+    _Icm20602Write(ICM20602_FIFO_WM_TH2, ui16WatermarkBytes & 0xFF);
+    _Icm20602Write(ICM20602_INT_ENABLE, ICM20602_INT_FIFO_OFLOW);
+
+    //
+    // Active high INT, held until EtaDevicesIcm20602FifoRead() reads the
+    // status. Without the latch it is a 50us pulse the GPIO can miss.
+    //
+    _Icm20602Write(ICM20602_INT_PIN_CFG,
+                   ICM20602_INT_PIN_LATCH_INT_EN |
+                   ICM20602_INT_PIN_INT_RD_CLEAR);
+
+    //
+    // Accel and gyro into the FIFO, reset and enable it.
+    //
+    _Icm20602Write(ICM20602_FIFO_EN,
+                   ICM20602_FIFO_EN_ACCEL | ICM20602_FIFO_EN_GYRO);
+    _Icm20602Write(ICM20602_USER_CTRL, ICM20602_USER_CTRL_FIFO_RST);
+    _Icm20602Write(ICM20602_USER_CTRL, ICM20602_USER_CTRL_FIFO_EN);
+}
+
+/***************************************************************************//**
+ *
+ * EtaDevicesIcm20602FifoStop - Stop sampling into the FIFO.
+ *
+ ******************************************************************************/
+void
+EtaDevicesIcm20602FifoStop(void)
+{
+    _Icm20602Write(ICM20602_USER_CTRL, 0x00);
+    _Icm20602Write(ICM20602_FIFO_EN, 0x00);
+    _Icm20602Write(ICM20602_INT_ENABLE, 0x00);
+    _Icm20602Write(ICM20602_INT_PIN_CFG, 0x00);
+    _Icm20602Write(ICM20602_FIFO_WM_TH1, 0x00);
+    _Icm20602Write(ICM20602_FIFO_WM_TH2, 0x00);
+    _Icm20602Write(ICM20602_CONFIG, ICM20602_GYRO_DLPF6_NBW8HZ);
+}
+
+/***************************************************************************//**
+ *
+ * EtaDevicesIcm20602FifoRead - Drain the FIFO in bursts.
+ *
+ * Also clears the (latched) interrupt status. On an overflow the FIFO is
+ * reset, the packets in it can't be trusted to be aligned anymore.
+ *
+ * @param psSamples pointer to the sample structures to store the values.
+ * @param ui32MaxSamples Number of sample structures.
+ *
+ * @return Number of samples read, -1 if the FIFO overflowed.
+ *
+ ******************************************************************************/
+int32_t
+EtaDevicesIcm20602FifoRead(tIcm20602Sample *psSamples, uint32_t ui32MaxSamples)
+{
+    uint8_t pui8Bytes[ICM20602_FIFO_PACKET_SIZE * 8];
+    uint32_t ui32Count, ui32Burst, ui32Idx, ui32Read;
+
+    //
+    // Reading the status clears the interrupts.
+    //
+    _Icm20602Read(ICM20602_FIFO_WM_INT_STATUS, pui8Bytes, 1);
+    _Icm20602Read(ICM20602_INT_STATUS, pui8Bytes, 1);
+
+    if(pui8Bytes[0] & ICM20602_INT_FIFO_OFLOW)
+    {
+        _Icm20602Write(ICM20602_USER_CTRL, ICM20602_USER_CTRL_FIFO_RST);
+        _Icm20602Write(ICM20602_USER_CTRL, ICM20602_USER_CTRL_FIFO_EN);
+        return(-1);
+    }
+
+    _Icm20602Read(ICM20602_FIFO_COUNTH, pui8Bytes, 2);
+    ui32Count = (((pui8Bytes[0] << 8) | pui8Bytes[1]) & 0x3FF) /
+                ICM20602_FIFO_PACKET_SIZE;
+    if(ui32Count > ui32MaxSamples)
+    {
+        ui32Count = ui32MaxSamples;
+    }
+
+    //
+    // FIFO_R_W doesn't auto increment, read up to 8 packets per transfer.
+    //
+    for(ui32Read = 0; ui32Read < ui32Count; ui32Read += ui32Burst)
+    {
+        ui32Burst = ui32Count - ui32Read;
+        if(ui32Burst > 8)
+        {
+            ui32Burst = 8;
+        }
+
+        _Icm20602Read(ICM20602_FIFO_R_W, pui8Bytes,
+                      ui32Burst * ICM20602_FIFO_PACKET_SIZE);
+
+        for(ui32Idx = 0; ui32Idx < ui32Burst; ui32Idx++)
+        {
+            _Icm20602Unpack(&pui8Bytes[ui32Idx * ICM20602_FIFO_PACKET_SIZE],
+                            &psSamples[ui32Read + ui32Idx]);
+        }
+    }
+
+    return((int32_t)ui32Count);
+}
@@ -0,0 +1,8 @@
+# Build the host replay of the HM0360 capture loop, run ./camera_replay
+EI=../../Thirdparty/edge_impulse
+DRV=../../Platform/ECM3532/M3/hw/drivers/hm0360
+gcc -O2 -Wall -Wextra -Wno-unused-parameter -Wno-type-limits -c -o eta_devices_hm0360.o -Istub -I../host_stub -I$DRV $DRV/eta_devices_hm0360.c
+g++ -O2 -Wall -Wextra -Wno-unused-parameter -o camera_replay -Istub -I../host_stub \
+    -I$DRV -I../../Applications/edge-impulse-ingestion/src/sensors \
+    -I$EI/ingestion-sdk-platform/eta-compute -I$EI/ingestion-sdk-c -I$EI \
+    camera_replay.cpp ../../Applications/edge-impulse-ingestion/src/sensors/ei_camera.cpp eta_devices_hm0360.o
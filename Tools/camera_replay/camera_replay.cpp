@@ -0,0 +1,522 @@
+/* The Clear BSD License
+ *
+ * Copyright (c) 2025 EdgeImpulse Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the disclaimer
+ * below) provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ *   * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ *
+ *   * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from this
+ *   software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE GRANTED BY
+ * THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ * CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+/*
+ * Host replay of the HM0360 capture loop. Builds the real camera driver and
+ * ei_camera.cpp against a model of the sensor: the driver reads HSYNC, VSYNC,
+ * PCLK and the pixel data from a simulated clock, every GPIO read takes one
+ * cycle, and the cycle count it checks the line period with is that clock.
+ * Interrupts taken in the line blanking are replayed as preemptions of a
+ * given length.
+ *
+ * Checks that
+ *  - a frame is captured pixel for pixel,
+ *  - a preemption that ends inside the blanking keeps the frame,
+ *  - a preemption into the next line, or over one or more whole lines, fails
+ *    the frame, on any row,
+ *  - the streaming crop, scale and lookup into the model input gives the same
+ *    output as capturing the frame and converting it afterwards.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <vector>
+
+#include "config.h"
+#include "ei_camera.h"
+#include "eta_devices_hm0360.h"
+#include "gpio_hal.h"
+#include "i2c_hal.h"
+#include "timer_hal.h"
+#include "print_util.h"
+#include "semphr.h"
+#include "task.h"
+#include "repl/at_base64.h"
+
+static int failures = 0;
+
+#define CHECK(cond) do { if (!(cond)) { printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); failures++; } } while (0)
+
+/* Sensor model ------------------------------------------------------------- */
+
+#define SENSOR_COLS         320     /* QVGA line, the driver keeps the first 256 */
+#define SENSOR_ROWS         CONFIG_IMAGE_ROW_COUNT
+#define PCLK_PERIOD         8       /* cycles, PCLK runs during the blanking too */
+#define LINE_ACTIVE         (SENSOR_COLS * PCLK_PERIOD)
+#define LINE_BLANK          640
+#define LINE_PERIOD         (LINE_ACTIVE + LINE_BLANK)
+#define FRAME_FRONT         1000    /* VSYNC high to the first line */
+#define FRAME_BACK          200     /* last line to VSYNC low */
+#define FRAME_ACTIVE        (FRAME_FRONT + (SENSOR_ROWS * LINE_PERIOD) + FRAME_BACK)
+#define FRAME_PERIOD        (FRAME_ACTIVE + 10000)
+#define IRQ_LATENCY         20
+
+#define FRAME_COLS          EI_CAMERA_RAW_FRAME_BUFFER_COLS
+#define FRAME_ROWS          EI_CAMERA_RAW_FRAME_BUFFER_ROWS
+
+extern "C" SemaphoreHandle_t xVSHSem;
+extern "C" SemaphoreHandle_t xVSLSem;
+
+static uint64_t sim_time = 0;
+static uint32_t pattern_seed = 0;
+
+/* preemption, taken at the first interrupt enable in the blanking of a line */
+static int32_t preempt_line = -1;
+static uint64_t preempt_cycles = 0;
+
+static uint8_t sensor_pixel(uint32_t x, uint32_t y)
+{
+    return (uint8_t)((x * 7) + (y * 13) + (pattern_seed * 29) + ((x * y) >> 3));
+}
+
+static int32_t sim_line(uint64_t t)
+{
+    uint64_t u = t % FRAME_PERIOD;
+
+    if ((u < FRAME_FRONT) || (u >= FRAME_FRONT + (SENSOR_ROWS * LINE_PERIOD))) {
+        return -1;
+    }
+    return (int32_t)((u - FRAME_FRONT) / LINE_PERIOD);
+}
+
+static uint32_t sim_gpio_at(uint64_t t)
+{
+    uint64_t u = t % FRAME_PERIOD;
+    uint32_t word = 0;
+
+    if (u < FRAME_ACTIVE) {
+        word |= 1u << CONFIG_HM0360_VSYNC_GPIO;
+    }
+
+    int32_t line = sim_line(t);
+    if (line >= 0) {
+        uint64_t v = (u - FRAME_FRONT) % LINE_PERIOD;
+        if (v < LINE_ACTIVE) {
+            word |= 1u << CONFIG_HM0360_HSYNC_GPIO;
+            word |= (uint32_t)sensor_pixel((uint32_t)(v / PCLK_PERIOD), (uint32_t)line) << CONFIG_HM0360_D0_PIN;
+        }
+    }
+
+    if ((t % PCLK_PERIOD) < (PCLK_PERIOD / 2)) {
+        word |= 1u << CONFIG_HM0360_PCLK_GPIO;
+    }
+
+    return word;
+}
+
+extern "C" int32_t sim_gpio_in(void)
+{
+    return (int32_t)sim_gpio_at(sim_time++);
+}
+
+extern "C" uint32_t sim_cycles(void)
+{
+    return (uint32_t)sim_time;
+}
+
+extern "C" void sim_irq_enable(void)
+{
+    if ((preempt_line >= 0) && (sim_line(sim_time) == preempt_line)) {
+        sim_time += preempt_cycles;
+        preempt_line = -1;
+    }
+}
+
+/* Wait for a VSYNC level, as the VSYNC interrupt does */
+static void sim_wait_vsync(bool high)
+{
+    while (((sim_gpio_at(sim_time) & (1u << CONFIG_HM0360_VSYNC_GPIO)) != 0) != high) {
+        sim_time++;
+    }
+    sim_time += IRQ_LATENCY;
+}
+
+/* Driver stubs ------------------------------------------------------------- */
+
+int32_t HalI2cRead(uint8_t ui8I2cNum, uint8_t ui8SlaveAddr, uint16_t ui16Offset,
+                uint8_t ui8OffsetLen, uint8_t *ui8RxBuf, uint32_t ui32RxLen,
+                tHalI2cCb fI2cCb, void *vPtr)
+{
+    memset(ui8RxBuf, 0, ui32RxLen);
+    return 0;
+}
+
+int32_t HalI2cWrite(uint8_t ui8I2cNum, uint8_t ui8SlaveAddr, uint16_t ui16Offset,
+                uint8_t ui8OffsetLen, uint8_t *ui8TxBuf, uint32_t ui32TxLen,
+                tHalI2cCb fI2cCb, void *vPtr)
+{
+    return 0;
+}
+
+int32_t HalTmrDelay(tHalTmrCh iTmrCh, uint32_t ui32Ticks)
+{
+    return 0;
+}
+
+int ecm35xx_printf(const char *format, ...)
+{
+    return 0;
+}
+
+int32_t HalGpioInInit(uint32_t ui32Gpio, tHalGpioPull iPull)
+{
+    return 0;
+}
+
+int32_t HalGpioOutInit(uint32_t ui32Gpio, bool bVal)
+{
+    return 0;
+}
+
+int HalGpioIntInit(uint32_t ui32Gpio, tHalGpioIRQ iGpioIrq, tHalGpioIntHandler fIntHandler,
+                    void *vArg, tHalGpioIntTrig iTrig, tHalGpioPull iPull)
+{
+    return 0;
+}
+
+void HalGpioIntEnable(tHalGpioIRQ iGpioIrq, uint32_t ui32Gpio)
+{
+}
+
+void HalGpioIntDisable(tHalGpioIRQ iGpioIrq, uint32_t ui32Gpio)
+{
+}
+
+void HalGpioIntClear(tHalGpioIRQ iGpioIrq, uint32_t ui32Gpio)
+{
+}
+
+/* FreeRTOS stand-in, the VSYNC semaphores wait for the modelled VSYNC */
+struct sim_semaphore {
+    int count;
+};
+
+SemaphoreHandle_t xSemaphoreCreateBinary(void)
+{
+    return new sim_semaphore();
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t ticks)
+{
+    if (sem == xVSLSem) {
+        sim_wait_vsync(false);
+        return pdTRUE;
+    }
+    if (sem == xVSHSem) {
+        sim_wait_vsync(true);
+        return pdTRUE;
+    }
+    if (sem->count == 0) {
+        return pdFALSE;
+    }
+    sem->count = 0;
+    return pdTRUE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t sem)
+{
+    sem->count = 1;
+    return pdTRUE;
+}
+
+BaseType_t xSemaphoreGiveFromISR(SemaphoreHandle_t sem, long *woken)
+{
+    sem->count = 1;
+    return pdTRUE;
+}
+
+BaseType_t xTaskCreate(TaskFunction_t fn, const char *name, uint16_t stack_depth,
+    void *arg, UBaseType_t priority, TaskHandle_t *handle)
+{
+    return pdFALSE;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task)
+{
+    return pdPASS;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear, TickType_t ticks)
+{
+    return 0;
+}
+
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task)
+{
+    return 0;
+}
+
+/* the capture suspends the scheduler for the frame, it has to resume it */
+static int scheduler_suspended = 0;
+
+void vTaskSuspendAll(void)
+{
+    scheduler_suspended++;
+}
+
+BaseType_t xTaskResumeAll(void)
+{
+    scheduler_suspended--;
+    return pdFALSE;
+}
+
+/* Device and porting stubs ------------------------------------------------- */
+
+EiDeviceEtaEcm3532::EiDeviceEtaEcm3532(void) { }
+int EiDeviceEtaEcm3532::get_id(uint8_t out_buffer[32], size_t *out_size) { *out_size = 0; return 0; }
+const char *EiDeviceEtaEcm3532::get_id_pointer(void) { return ""; }
+int EiDeviceEtaEcm3532::get_type(uint8_t out_buffer[32], size_t *out_size) { *out_size = 0; return 0; }
+const char *EiDeviceEtaEcm3532::get_type_pointer(void) { return ""; }
+bool EiDeviceEtaEcm3532::get_wifi_connection_status(void) { return false; }
+bool EiDeviceEtaEcm3532::get_wifi_present_status(void) { return false; }
+bool EiDeviceEtaEcm3532::get_sensor_list(const ei_device_sensor_t **sensor_list, size_t *sensor_list_size)
+{
+    *sensor_list = sensors;
+    *sensor_list_size = 0;
+    return false;
+}
+bool EiDeviceEtaEcm3532::get_snapshot_list(const ei_device_snapshot_resolutions_t **snapshot_list,
+    size_t *snapshot_list_size, const char **color_depth)
+{
+    snapshot_resolutions[0].width = FRAME_COLS;
+    snapshot_resolutions[0].height = FRAME_ROWS;
+    *snapshot_list = snapshot_resolutions;
+    *snapshot_list_size = 1;
+    *color_depth = "Grayscale";
+    return false;
+}
+/* Same list as the device */
+bool EiDeviceEtaEcm3532::get_resize_list(const ei_device_resize_resolutions_t **resize_list,
+    size_t *resize_list_size)
+{
+    resize_resolutions[0].width = 128;
+    resize_resolutions[0].height = 96;
+    resize_resolutions[1].width = 160;
+    resize_resolutions[1].height = 120;
+    resize_resolutions[2].width = 200;
+    resize_resolutions[2].height = 150;
+    resize_resolutions[3].width = 256;
+    resize_resolutions[3].height = 192;
+    *resize_list = resize_resolutions;
+    *resize_list_size = EI_DEVICE_N_RESIZE_RESOLUTIONS;
+    return false;
+}
+void EiDeviceEtaEcm3532::delay_ms(uint32_t milliseconds) { }
+void EiDeviceEtaEcm3532::setup_led_control(void) { }
+void EiDeviceEtaEcm3532::set_state(tEiState state) { }
+int EiDeviceEtaEcm3532::get_data_output_baudrate(ei_device_data_output_baudrate_t *baudrate) { return 0; }
+void EiDeviceEtaEcm3532::set_default_data_output_baudrate() { }
+void EiDeviceEtaEcm3532::set_max_data_output_baudrate() { }
+c_callback EiDeviceEtaEcm3532::get_id_function(void) { return NULL; }
+c_callback EiDeviceEtaEcm3532::get_type_function(void) { return NULL; }
+c_callback_status EiDeviceEtaEcm3532::get_wifi_connection_status_function(void) { return NULL; }
+c_callback_status EiDeviceEtaEcm3532::get_wifi_present_status_function(void) { return NULL; }
+c_callback_read_sample_buffer EiDeviceEtaEcm3532::get_read_sample_buffer_function(void) { return NULL; }
+
+EiDeviceEtaEcm3532 EiDevice;
+
+void ei_printf(const char *format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    vprintf(format, args);
+    va_end(args);
+}
+
+void ei_write_string(char *data, int length)
+{
+    fwrite(data, 1, length, stdout);
+}
+
+bool ei_user_invoke_stop(void)
+{
+    return false;
+}
+
+EI_IMPULSE_ERROR ei_sleep(int32_t time_ms)
+{
+    return EI_IMPULSE_OK;
+}
+
+uint64_t ei_read_timer_ms()
+{
+    return 0;
+}
+
+void *ei_malloc(size_t size)
+{
+    return malloc(size);
+}
+
+void ei_free(void *ptr)
+{
+    free(ptr);
+}
+
+/* Tests -------------------------------------------------------------------- */
+
+/* Capture one frame, with a preemption of cycles after line (if >= 0) */
+static uint32_t capture(uint8_t *frame, int32_t line, uint64_t cycles, tHm0360LineStats *stats)
+{
+    preempt_line = line;
+    preempt_cycles = cycles;
+    memset(frame, 0, FRAME_COLS * FRAME_ROWS);
+
+    uint32_t pixels = EtaDevicesHm0360OneFrameReadBlocking(frame);
+    EtaDevicesHm0360LineStatsGet(stats);
+    return pixels;
+}
+
+static bool frame_matches(const uint8_t *frame)
+{
+    for (uint32_t y = 0; y < FRAME_ROWS; y++) {
+        for (uint32_t x = 0; x < FRAME_COLS; x++) {
+            if (frame[y * FRAME_COLS + x] != sensor_pixel(x, y)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+static void test_capture(void)
+{
+    std::vector<uint8_t> frame(FRAME_COLS * FRAME_ROWS);
+    tHm0360LineStats stats;
+
+    pattern_seed = 1;
+    CHECK(capture(&frame[0], -1, 0, &stats) == FRAME_COLS * FRAME_ROWS);
+    CHECK(frame_matches(&frame[0]));
+    CHECK(stats.ui32Rows == FRAME_ROWS);
+    CHECK(stats.ui32LateRows == 0);
+    CHECK((stats.ui32LinePeriod >= LINE_PERIOD - 2) && (stats.ui32LinePeriod <= LINE_PERIOD + 2));
+
+    printf("capture: line period %u cycles, blanking %u..%u polls\n", (unsigned)stats.ui32LinePeriod,
+        (unsigned)stats.ui32MinBlank, (unsigned)stats.ui32MaxBlank);
+}
+
+static void test_preemption(void)
+{
+    static const struct {
+        const char *what;
+        int32_t line;
+        uint64_t cycles;
+        uint32_t late_rows;     /* 0: the frame is kept */
+    } cases[] = {
+        { "inside the blanking",        1,   LINE_BLANK / 2,                    0 },
+        { "inside the blanking, late",  230, LINE_BLANK / 2,                    0 },
+        { "into the next line",         10,  LINE_BLANK + (LINE_ACTIVE / 2),    1 },
+        { "one line, into blanking",    10,  LINE_PERIOD + (LINE_BLANK / 4),    1 },
+        { "one line, late row",         200, LINE_PERIOD + (LINE_BLANK / 4),    1 },
+        { "three lines",                50,  (3 * LINE_PERIOD) + (LINE_BLANK / 4), 3 },
+    };
+    std::vector<uint8_t> frame(FRAME_COLS * FRAME_ROWS);
+    tHm0360LineStats stats;
+
+    for (size_t ix = 0; ix < sizeof(cases) / sizeof(cases[0]); ix++) {
+        pattern_seed = (uint32_t)ix + 2;
+
+        uint32_t pixels = capture(&frame[0], cases[ix].line, cases[ix].cycles, &stats);
+        bool kept = (pixels == FRAME_COLS * FRAME_ROWS) && frame_matches(&frame[0]);
+
+        printf("preemption %s: %u cycles after line %d, %s, %u late rows\n", cases[ix].what,
+            (unsigned)cases[ix].cycles, (int)cases[ix].line, pixels ? "kept" : "failed",
+            (unsigned)stats.ui32LateRows);
+
+        CHECK(preempt_line < 0);
+        CHECK(scheduler_suspended == 0);
+        CHECK(stats.ui32LateRows == cases[ix].late_rows);
+        if (cases[ix].late_rows) {
+            CHECK(pixels == 0);
+        }
+        else {
+            CHECK(kept);
+        }
+    }
+}
+
+static void test_capture_to_lut(void)
+{
+    static const uint32_t sizes[][2] = {
+        { 96, 96 }, { 128, 96 }, { 160, 120 }, { 48, 48 }, { 200, 150 }, { 256, 192 }, { 240, 240 }, { 1, 1 }
+    };
+    std::vector<int8_t> streamed(FRAME_COLS * FRAME_ROWS * 3);
+    std::vector<int8_t> reference(FRAME_COLS * FRAME_ROWS * 3);
+    int8_t lut[256];
+    uint32_t n_checked = 0;
+
+    for (int v = 0; v < 256; v++) {
+        lut[v] = (int8_t)(v * 37 + 11);
+    }
+
+    pattern_seed = 7;
+
+    for (size_t ix = 0; ix < sizeof(sizes) / sizeof(sizes[0]); ix++) {
+        uint32_t w = sizes[ix][0], h = sizes[ix][1];
+
+        for (size_t channels = 1; channels <= 3; channels += 2) {
+            memset(&streamed[0], 0x55, streamed.size());
+            preempt_line = -1;
+            CHECK(ei_camera_capture_to_lut(w, h, &streamed[0], lut, channels));
+
+            CHECK(ei_camera_capture_frame());
+            CHECK(ei_camera_frame_to_lut(w, h, &reference[0], lut, channels));
+
+            CHECK(memcmp(&streamed[0], &reference[0], w * h * channels) == 0);
+            n_checked++;
+        }
+    }
+
+    /* a frame with lines missed is not handed to the model */
+    preempt_line = 100;
+    preempt_cycles = LINE_PERIOD + (LINE_BLANK / 4);
+    CHECK(!ei_camera_capture_to_lut(96, 96, &streamed[0], lut, 1));
+
+    printf("capture_to_lut: %u size and channel combinations checked\n", (unsigned)n_checked);
+}
+
+int main(void)
+{
+    CHECK(ei_camera_init());
+
+    test_capture();
+    test_preemption();
+    test_capture_to_lut();
+
+    printf("%s (%d failures)\n", failures ? "FAILED" : "OK", failures);
+    return failures ? 1 : 0;
+}
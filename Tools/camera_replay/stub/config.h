@@ -0,0 +1,39 @@
+/* Host build of the vision board configuration, GPIO, interrupt masking and
+ * cycle count of the camera driver replaced by the sensor model */
+#ifndef CAMERA_REPLAY_CONFIG_H
+#define CAMERA_REPLAY_CONFIG_H
+
+#include <stdint.h>
+
+#define CONFIG_AI_VISION_BOARD      1
+#define CONFIG_CAM_HM0360           1
+#define CONFIG_STREAMING_MODE       1
+#define CONFIG_QVGA_MODE            1
+#define CONFIG_HM0360_I2C_INSTANCE  1
+#define CONFIG_HM0360_I2C_ADDRESS   0x24
+#define CONFIG_HM0360_D0_PIN        16
+#define CONFIG_HM0360_HSYNC_GPIO    24
+#define CONFIG_HM0360_VSYNC_GPIO    30
+#define CONFIG_HM0360_PCLK_GPIO     31
+#define CONFIG_IMAGE_COLUMN_COUNT   256
+#define CONFIG_IMAGE_ROW_COUNT      240
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+int32_t sim_gpio_in(void);
+void sim_irq_enable(void);
+uint32_t sim_cycles(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#define HM0360_GPIO_IN()        sim_gpio_in()
+#define HM0360_IRQ_DISABLE()    do { } while (0)
+#define HM0360_IRQ_ENABLE()     sim_irq_enable()
+#define HM0360_CYCLES_ENABLE()  do { } while (0)
+#define HM0360_CYCLES()         sim_cycles()
+
+#endif
@@ -0,0 +1,7 @@
+# Build the host test of the camera pipeline, run ./camera_test
+# ei_camera.cpp passes the uint8_t frame buffer to the int8_t driver API, hence -fpermissive
+EI=../../Thirdparty/edge_impulse
+g++ -O2 -Wall -Wextra -Wno-unused-parameter -fpermissive -o camera_test -Istub -I../host_stub \
+    -I../../Platform/ECM3532/M3/hw/drivers/hm01b0 -I../../Applications/edge-impulse-ingestion/src/sensors \
+    -I$EI/ingestion-sdk-platform/eta-compute -I$EI/ingestion-sdk-c -I$EI \
+    camera_test.cpp ../../Applications/edge-impulse-ingestion/src/sensors/ei_camera.cpp
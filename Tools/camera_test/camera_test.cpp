@@ -0,0 +1,445 @@
+/* The Clear BSD License
+ *
+ * Copyright (c) 2025 EdgeImpulse Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the disclaimer
+ * below) provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ *   * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ *
+ *   * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from this
+ *   software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE GRANTED BY
+ * THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ * CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+
+/*
+ * Host test of the camera pipeline in ei_camera.cpp. Builds the real
+ * ei_camera.cpp against stubs of the sensor driver, GPIO and FreeRTOS, with
+ * test frames in place of the HM01B0 capture.
+ *
+ * Checks that ei_camera_frame_to_lut (fused resize, crop and lookup) gives
+ * bit for bit the same output as ei_camera_capture (resizeImage and
+ * cropImage) followed by ei_camera_cutout_get_data and the lookup, for
+ * every output size and both channel counts, and that the row by row
+ * ei_camera_capture_to_lut gives the same output again.
+ *
+ * Checks that the base64 snapshot output (single snapshots and the stream)
+ * is byte for byte what the old per-pixel float path wrote.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <vector>
+#include <string>
+
+#include "ei_camera.h"
+#include "eta_devices_hm01b0.h"
+#include "gpio_hal.h"
+#include "semphr.h"
+#include "task.h"
+#include "repl/at_base64.h"
+
+static int failures = 0;
+
+/* Serial output, collected while a test looks at it */
+static bool output_capture = false;
+static std::string output;
+
+/* Number of frames before the snapshot stream is stopped */
+static int stream_frames_left = 0;
+
+#define CHECK(cond) do { if (!(cond)) { printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); failures++; } } while (0)
+
+/* Test frames -------------------------------------------------------------- */
+
+#define FRAME_COLS  EI_CAMERA_RAW_FRAME_BUFFER_COLS
+#define FRAME_ROWS  EI_CAMERA_RAW_FRAME_BUFFER_ROWS
+
+static uint8_t test_frame[FRAME_COLS * FRAME_ROWS];
+
+static void make_frame(int kind, uint32_t seed)
+{
+    srand(seed);
+    for (uint32_t y = 0; y < FRAME_ROWS; y++) {
+        for (uint32_t x = 0; x < FRAME_COLS; x++) {
+            uint8_t v;
+            switch (kind) {
+            case 0: v = (uint8_t)rand(); break;
+            case 1: v = 255; break;
+            default: v = (uint8_t)((x + y * 3) ^ (y << 2)); break;
+            }
+            test_frame[y * FRAME_COLS + x] = v;
+        }
+    }
+}
+
+/* Replaces the sensor read, the capture "reads" the current test frame */
+uint32_t EtaDevicesHm01b0OneFrameReadBlocking(int8_t *pui8Frame)
+{
+    memcpy(pui8Frame, test_frame, sizeof(test_frame));
+    return 1;
+}
+
+uint32_t EtaDevicesHm01b0FrameRowsRead(int8_t *pi8Frame, tHm01b0RowCallback pfnRow, void *pvArg)
+{
+    for (uint32_t y = 0; y < FRAME_ROWS; y++) {
+        memcpy(&pi8Frame[y * FRAME_COLS], &test_frame[y * FRAME_COLS], FRAME_COLS);
+        pfnRow(y, &pi8Frame[y * FRAME_COLS], FRAME_COLS, pvArg);
+    }
+    return sizeof(test_frame);
+}
+
+void EtaDevicesHm01b0Init(void)
+{
+}
+
+void EtaCspGpioDriveHighSet(tGpioBit iBit)
+{
+    (void)iBit;
+}
+
+int32_t HalGpioInInit(uint32_t ui32Gpio, tHalGpioPull iPull)
+{
+    (void)ui32Gpio;
+    (void)iPull;
+    return 0;
+}
+
+int32_t HalGpioOutInit(uint32_t ui32Gpio, bool bVal)
+{
+    (void)ui32Gpio;
+    (void)bVal;
+    return 0;
+}
+
+/* Device and porting stubs ------------------------------------------------- */
+
+EiDeviceEtaEcm3532::EiDeviceEtaEcm3532(void) { }
+int EiDeviceEtaEcm3532::get_id(uint8_t out_buffer[32], size_t *out_size) { (void)out_buffer; *out_size = 0; return 0; }
+const char *EiDeviceEtaEcm3532::get_id_pointer(void) { return ""; }
+int EiDeviceEtaEcm3532::get_type(uint8_t out_buffer[32], size_t *out_size) { (void)out_buffer; *out_size = 0; return 0; }
+const char *EiDeviceEtaEcm3532::get_type_pointer(void) { return ""; }
+bool EiDeviceEtaEcm3532::get_wifi_connection_status(void) { return false; }
+bool EiDeviceEtaEcm3532::get_wifi_present_status(void) { return false; }
+bool EiDeviceEtaEcm3532::get_sensor_list(const ei_device_sensor_t **sensor_list, size_t *sensor_list_size)
+{
+    *sensor_list = sensors;
+    *sensor_list_size = 0;
+    return false;
+}
+/* Same list as the device, without a model */
+bool EiDeviceEtaEcm3532::get_snapshot_list(const ei_device_snapshot_resolutions_t **snapshot_list,
+    size_t *snapshot_list_size, const char **color_depth)
+{
+    snapshot_resolutions[0].width = FRAME_COLS;
+    snapshot_resolutions[0].height = FRAME_ROWS;
+    snapshot_resolutions[1].width = 128;
+    snapshot_resolutions[1].height = 96;
+    *snapshot_list = snapshot_resolutions;
+    *snapshot_list_size = EI_DEVICE_N_RESOLUTIONS;
+    *color_depth = "Grayscale";
+    return false;
+}
+/* Same list as the device */
+bool EiDeviceEtaEcm3532::get_resize_list(const ei_device_resize_resolutions_t **resize_list,
+    size_t *resize_list_size)
+{
+    resize_resolutions[0].width = 128;
+    resize_resolutions[0].height = 96;
+    resize_resolutions[1].width = 160;
+    resize_resolutions[1].height = 120;
+    resize_resolutions[2].width = 200;
+    resize_resolutions[2].height = 150;
+    resize_resolutions[3].width = 256;
+    resize_resolutions[3].height = 192;
+    *resize_list = resize_resolutions;
+    *resize_list_size = EI_DEVICE_N_RESIZE_RESOLUTIONS;
+    return false;
+}
+void EiDeviceEtaEcm3532::delay_ms(uint32_t milliseconds) { (void)milliseconds; }
+void EiDeviceEtaEcm3532::setup_led_control(void) { }
+void EiDeviceEtaEcm3532::set_state(tEiState state) { (void)state; }
+int EiDeviceEtaEcm3532::get_data_output_baudrate(ei_device_data_output_baudrate_t *baudrate) { (void)baudrate; return 0; }
+void EiDeviceEtaEcm3532::set_default_data_output_baudrate() { }
+void EiDeviceEtaEcm3532::set_max_data_output_baudrate() { }
+c_callback EiDeviceEtaEcm3532::get_id_function(void) { return NULL; }
+c_callback EiDeviceEtaEcm3532::get_type_function(void) { return NULL; }
+c_callback_status EiDeviceEtaEcm3532::get_wifi_connection_status_function(void) { return NULL; }
+c_callback_status EiDeviceEtaEcm3532::get_wifi_present_status_function(void) { return NULL; }
+c_callback_read_sample_buffer EiDeviceEtaEcm3532::get_read_sample_buffer_function(void) { return NULL; }
+
+EiDeviceEtaEcm3532 EiDevice;
+
+void ei_printf(const char *format, ...)
+{
+    char buf[256];
+    va_list args;
+    va_start(args, format);
+    vsnprintf(buf, sizeof(buf), format, args);
+    va_end(args);
+
+    if (output_capture) {
+        output += buf;
+    }
+    else {
+        fputs(buf, stdout);
+    }
+}
+
+void ei_write_string(char *data, int length)
+{
+    if (output_capture) {
+        output.append(data, length);
+    }
+    else {
+        fwrite(data, 1, length, stdout);
+    }
+}
+
+bool ei_user_invoke_stop(void)
+{
+    return --stream_frames_left <= 0;
+}
+
+EI_IMPULSE_ERROR ei_sleep(int32_t time_ms)
+{
+    (void)time_ms;
+    return EI_IMPULSE_OK;
+}
+
+uint64_t ei_read_timer_ms()
+{
+    return 0;
+}
+
+void *ei_malloc(size_t size)
+{
+    return malloc(size);
+}
+
+void ei_free(void *ptr)
+{
+    free(ptr);
+}
+
+/* FreeRTOS stand-in, the snapshot stream is not used here */
+struct sim_semaphore {
+    int count;
+};
+
+SemaphoreHandle_t xSemaphoreCreateBinary(void)
+{
+    return new sim_semaphore();
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t ticks)
+{
+    (void)ticks;
+    if (sem->count == 0) {
+        return pdFALSE;
+    }
+    sem->count = 0;
+    return pdTRUE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t sem)
+{
+    sem->count = 1;
+    return pdTRUE;
+}
+
+BaseType_t xTaskCreate(TaskFunction_t fn, const char *name, uint16_t stack_depth,
+    void *arg, UBaseType_t priority, TaskHandle_t *handle)
+{
+    (void)fn;
+    (void)name;
+    (void)stack_depth;
+    (void)arg;
+    (void)priority;
+    (void)handle;
+    return pdFALSE;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task)
+{
+    (void)task;
+    return pdPASS;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear, TickType_t ticks)
+{
+    (void)clear;
+    (void)ticks;
+    return 0;
+}
+
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task)
+{
+    (void)task;
+    return 0;
+}
+
+/* Tests -------------------------------------------------------------------- */
+
+static void test_frame_to_lut(void)
+{
+    static const uint32_t sizes[] = { 1, 32, 48, 64, 96, 120, 128, 150, 160, 192, 200, 240, 256 };
+    const size_t n_sizes = sizeof(sizes) / sizeof(sizes[0]);
+    std::vector<uint8_t> cutout(FRAME_COLS * FRAME_ROWS);
+    std::vector<float> signal(FRAME_COLS * FRAME_ROWS);
+    std::vector<int8_t> fused(FRAME_COLS * FRAME_ROWS * 3);
+    std::vector<int8_t> streamed(FRAME_COLS * FRAME_ROWS * 3);
+    int8_t lut[256];
+    uint32_t n_checked = 0;
+
+    /* Any table will do, the lookup is the same on both paths */
+    for (int v = 0; v < 256; v++) {
+        lut[v] = (int8_t)(v * 37 + 11);
+    }
+
+    CHECK(ei_camera_init());
+
+    for (int kind = 0; kind < 3; kind++) {
+        make_frame(kind, kind + 1);
+
+        for (size_t wx = 0; wx < n_sizes; wx++) {
+            for (size_t hx = 0; hx < n_sizes; hx++) {
+                uint32_t w = sizes[wx], h = sizes[hx];
+
+                if (h > FRAME_ROWS) {
+                    continue;
+                }
+
+                /* Reference, the old path */
+                CHECK(ei_camera_capture(w, h, &cutout[0]));
+                ei_camera_cutout_get_data(0, w * h, &signal[0]);
+
+                for (size_t channels = 1; channels <= 3; channels += 2) {
+                    CHECK(ei_camera_capture_frame());
+                    CHECK(ei_camera_frame_to_lut(w, h, &fused[0], lut, channels));
+                    CHECK(ei_camera_capture_to_lut(w, h, &streamed[0], lut, channels));
+                    CHECK(memcmp(&fused[0], &streamed[0], w * h * channels) == 0);
+
+                    uint32_t n_diff = 0;
+                    for (uint32_t ix = 0; ix < w * h; ix++) {
+                        int8_t expected = lut[(uint32_t)signal[ix] & 0xff];
+                        for (size_t c = 0; c < channels; c++) {
+                            if (fused[ix * channels + c] != expected) {
+                                n_diff++;
+                            }
+                        }
+                    }
+                    if (n_diff) {
+                        printf("frame %d, %ux%u, %u channels: %u values differ\n",
+                            kind, (unsigned)w, (unsigned)h, (unsigned)channels, (unsigned)n_diff);
+                    }
+                    CHECK(n_diff == 0);
+                    n_checked++;
+                }
+            }
+        }
+    }
+
+    printf("frame_to_lut: %u size, channel and frame combinations checked\n", (unsigned)n_checked);
+}
+
+/* Base64 of one snapshot the way the old path wrote it: the cutout read back
+ * as floats, 513 pixel chunks, OKs and line end through ei_printf */
+static std::string old_base64_snapshot(uint32_t w, uint32_t h)
+{
+    std::vector<uint8_t> cutout(FRAME_COLS * FRAME_ROWS);
+    std::vector<float> signal(w * h);
+    std::string out = "OK\r\n";
+    uint8_t per_pixel_buffer[513];
+    char base64_buffer[684];
+    size_t per_pixel_buffer_ix = 0;
+
+    CHECK(ei_camera_capture(w, h, &cutout[0]));
+    ei_camera_cutout_get_data(0, w * h, &signal[0]);
+
+    for (size_t px = 0; px < w * h; px++) {
+        per_pixel_buffer[per_pixel_buffer_ix++] = (uint8_t)((uint32_t)signal[px] >> 16 & 0xff);
+        if (per_pixel_buffer_ix >= 513) {
+            int r = base64_encode((const char *)per_pixel_buffer, per_pixel_buffer_ix,
+                base64_buffer, sizeof(base64_buffer));
+            out.append(base64_buffer, r);
+            per_pixel_buffer_ix = 0;
+        }
+    }
+    int r = base64_encode((const char *)per_pixel_buffer, per_pixel_buffer_ix,
+        base64_buffer, per_pixel_buffer_ix / 3 * 4 + 4);
+    out.append(base64_buffer, r);
+    out += "\r\n";
+    out += "OK\r\n";
+
+    return out;
+}
+
+static void test_snapshot_base64(void)
+{
+    static const uint32_t sizes[][2] = { { FRAME_COLS, FRAME_ROWS }, { 128, 96 } };
+    uint32_t n_checked = 0;
+
+    for (int kind = 0; kind < 3; kind++) {
+        make_frame(kind, kind + 11);
+
+        for (size_t ix = 0; ix < sizeof(sizes) / sizeof(sizes[0]); ix++) {
+            uint32_t w = sizes[ix][0], h = sizes[ix][1];
+            std::string expected = old_base64_snapshot(w, h);
+
+            /* single snapshot, finish_snapshot adds the last OK */
+            output.clear();
+            output_capture = true;
+            CHECK(ei_camera_take_snapshot_encode_and_output(w, h, false));
+            output_capture = false;
+            CHECK(output == expected + "OK\r\n");
+
+            /* stream of three frames, every frame as a single snapshot */
+            output.clear();
+            output_capture = true;
+            stream_frames_left = 3;
+            CHECK(ei_camera_start_snapshot_stream_encode_and_output(w, h, false));
+            output_capture = false;
+
+            std::string frames = "Starting snapshot stream...\r\n" + expected + expected + expected +
+                "Snapshot streaming stopped by user\r\n";
+            CHECK(output.compare(0, frames.size(), frames) == 0);
+            n_checked++;
+        }
+    }
+
+    printf("snapshot_base64: %u size and frame combinations checked\n", (unsigned)n_checked);
+}
+
+int main(void)
+{
+    test_frame_to_lut();
+    test_snapshot_base64();
+
+    printf("%s (%d failures)\n", failures ? "FAILED" : "OK", failures);
+    return failures ? 1 : 0;
+}
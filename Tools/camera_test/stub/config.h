@@ -0,0 +1,14 @@
+/* Host build of the vision board configuration */
+#ifndef CAMERA_TEST_CONFIG_H
+#define CAMERA_TEST_CONFIG_H
+
+#define CONFIG_AI_VISION_BOARD      1
+#define CONFIG_CAM_HM01B0           1
+#define CONFIG_HM01B0_D0_PIN        8
+#define CONFIG_HM01B0_PCLK_GPIO     16
+#define CONFIG_HM01B0_HSYNC_GPIO    17
+#define CONFIG_HM01B0_VSYNC_GPIO    18
+#define CONFIG_IMAGE_COLUMN_COUNT   256
+#define CONFIG_IMAGE_ROW_COUNT      240
+
+#endif
@@ -0,0 +1,20 @@
+# Build the host run_classifier benchmark with and without the persistent
+# TFLite runtime, run ./classifier_bench_persistent and ./classifier_bench_percall
+# The TFLite Micro runtime is built as is, the benchmark with -Wall -Wextra
+EI=../../Thirdparty/edge_impulse
+SDK=$EI/edge-impulse-sdk
+INC="-I$EI -I$SDK/third_party/flatbuffers/include -I$SDK/third_party/gemmlowp -I$SDK/third_party/ruy"
+DEFS="-DEIDSP_USE_CMSIS_DSP=0 -DTF_LITE_STATIC_MEMORY"
+mkdir -p obj
+gcc -O2 -c -o obj/common.o $SDK/tensorflow/lite/c/common.c $INC
+for f in $(find $SDK/tensorflow -name '*.cc' -not -path '*/kernels/*' -not -name 'test_helpers.cc') \
+    $SDK/tensorflow/lite/kernels/kernel_util_lite.cc $SDK/tensorflow/lite/kernels/internal/quantization_util.cc \
+    $(ls $SDK/tensorflow/lite/micro/kernels/*.cc | grep -v -e mli_ -e scratch_buf -e kernel_runner); do
+    g++ -O2 -c -o obj/$(basename $f .cc).o $f $DEFS $INC || exit 1
+done
+SRC="classifier_bench.cpp $EI/tflite-model/trained_model_compiled.cpp \
+    $SDK/porting/posix/ei_classifier_porting.cpp $SDK/porting/posix/debug_log.cpp \
+    $SDK/dsp/memory.cpp $SDK/dsp/kissfft/kiss_fft.cpp $SDK/dsp/kissfft/kiss_fftr.cpp \
+    $SDK/dsp/dct/fast-dct-fft.cpp"
+g++ -O2 -Wall -Wextra $DEFS $INC -DEI_CLASSIFIER_PERSISTENT_TFLITE=1 -o classifier_bench_persistent $SRC obj/*.o -lm
+g++ -O2 -Wall -Wextra $DEFS $INC -DEI_CLASSIFIER_PERSISTENT_TFLITE=0 -o classifier_bench_percall $SRC obj/*.o -lm
@@ -0,0 +1,101 @@
+/* The Clear BSD License
+ *
+ * Copyright (c) 2025 EdgeImpulse Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the disclaimer
+ * below) provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ *   * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ *
+ *   * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from this
+ *   software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE GRANTED BY
+ * THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ * CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+/*
+ * Host benchmark of run_classifier() on the deployed impulse, to compare
+ * builds with and without EI_CLASSIFIER_PERSISTENT_TFLITE. Prints the mean
+ * TFLite setup (arena allocation, model init), DSP and invoke time over a
+ * number of inferences on a synthetic accelerometer window, and a checksum
+ * of the results so both builds can be compared for identical output.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#include "edge-impulse-sdk/classifier/ei_run_classifier.h"
+
+static float window[EI_CLASSIFIER_DSP_INPUT_FRAME_SIZE];
+
+static int get_data(size_t offset, size_t length, float *out_ptr)
+{
+    memcpy(out_ptr, window + offset, length * sizeof(float));
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    int runs = argc > 1 ? atoi(argv[1]) : 1000;
+
+    for (size_t ix = 0; ix < EI_CLASSIFIER_RAW_SAMPLE_COUNT; ix++) {
+        float t = (float)ix / EI_CLASSIFIER_FREQUENCY;
+        for (size_t ax = 0; ax < EI_CLASSIFIER_RAW_SAMPLES_PER_FRAME; ax++) {
+            window[ix * EI_CLASSIFIER_RAW_SAMPLES_PER_FRAME + ax] =
+                (ax == 2 ? 9.81f : 0.f) + 2.f * sinf(2.f * (float)M_PI * (3.f + ax) * t);
+        }
+    }
+
+    ei::signal_t signal;
+    signal.total_length = EI_CLASSIFIER_DSP_INPUT_FRAME_SIZE;
+    signal.get_data = &get_data;
+
+    double setup_us = 0, dsp_us = 0, classification_us = 0, checksum = 0;
+
+    for (int r = 0; r < runs; r++) {
+        ei_impulse_result_t result = { };
+        EI_IMPULSE_ERROR err = run_classifier(&signal, &result, false);
+        if (err != EI_IMPULSE_OK) {
+            printf("ERR: run_classifier failed (%d)\n", err);
+            return 1;
+        }
+        setup_us += result.timing.setup_us;
+        dsp_us += result.timing.dsp_us;
+        classification_us += result.timing.classification_us;
+        for (size_t ix = 0; ix < EI_CLASSIFIER_LABEL_COUNT; ix++) {
+            checksum += result.classification[ix].value;
+        }
+    }
+
+#if EI_CLASSIFIER_PERSISTENT_TFLITE == 1
+    run_classifier_deinit();
+#endif
+
+    printf("persistent TFLite: %d, %d runs\n", EI_CLASSIFIER_PERSISTENT_TFLITE, runs);
+    printf("mean setup %.2f us, dsp %.2f us, classification %.2f us\n",
+        setup_us / runs, dsp_us / runs, classification_us / runs);
+    printf("result checksum %.6f\n", checksum);
+
+    return 0;
+}
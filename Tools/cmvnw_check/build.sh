@@ -0,0 +1,6 @@
+# Build the host check of the sliding-window cmvnw against the per-window reference, run ./cmvnw_check
+EI=../../Thirdparty/edge_impulse
+SDK=$EI/edge-impulse-sdk
+g++ -O2 -Wall -Wextra -Wno-unused-function -o cmvnw_check -DEIDSP_USE_CMSIS_DSP=0 \
+    -I$EI cmvnw_check.cpp $SDK/dsp/memory.cpp $SDK/dsp/kissfft/kiss_fft.cpp \
+    $SDK/dsp/kissfft/kiss_fftr.cpp -lm
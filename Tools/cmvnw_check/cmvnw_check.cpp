@@ -0,0 +1,247 @@
+/* The Clear BSD License
+ *
+ * Copyright (c) 2025 EdgeImpulse Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the disclaimer
+ * below) provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ *   * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ *
+ *   * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from this
+ *   software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE GRANTED BY
+ * THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ * CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+
+/*
+ * Host check of the sliding-window cepstral mean and variance normalization
+ * (speechpy::processing::cmvnw) against the per-window mean_axis0 /
+ * std_axis0 reference it replaced. Runs long MFCC-like inputs, including
+ * columns with a large mean and little variation, where running float sums
+ * drift and sum_sq / n - mean^2 cancels.
+ *
+ * Usage: cmvnw_check [rows]
+ * Build with build.sh.
+ */
+
+#include "edge-impulse-sdk/dsp/speechpy/speechpy.hpp"
+
+#include <math.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+using namespace ei;
+
+static int failures = 0;
+
+#define CHECK(cond) do { if (!(cond)) { printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); failures++; } } while (0)
+
+/* Host porting ------------------------------------------------------------ */
+void *ei_malloc(size_t size) { return malloc(size); }
+void *ei_calloc(size_t nitems, size_t size) { return calloc(nitems, size); }
+void ei_free(void *ptr) { free(ptr); }
+
+void ei_printf(const char *format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    vprintf(format, args);
+    va_end(args);
+}
+
+void ei_printf_float(float f) { printf("%f", f); }
+
+/* Reference --------------------------------------------------------------- */
+/* cmvnw as it was before the running sums: mean_axis0 / std_axis0 per window */
+static void cmvnw_reference(matrix_t *features, uint16_t win_size, bool variance_normalization)
+{
+    uint16_t pad_size = (win_size - 1) / 2;
+    matrix_t vec_pad(features->rows + (pad_size * 2), features->cols);
+    matrix_t stat(features->cols, 1);
+
+    numpy::pad_1d_symmetric(features, &vec_pad, pad_size, pad_size);
+    for (size_t ix = 0; ix < features->rows; ix++) {
+        matrix_t window(win_size, vec_pad.cols, vec_pad.buffer + (ix * vec_pad.cols));
+        numpy::mean_axis0(&window, &stat);
+        for (size_t col = 0; col < features->cols; col++) {
+            features->buffer[(ix * features->cols) + col] -= stat.buffer[col];
+        }
+    }
+
+    if (!variance_normalization) {
+        return;
+    }
+
+    numpy::pad_1d_symmetric(features, &vec_pad, pad_size, pad_size);
+    for (size_t ix = 0; ix < features->rows; ix++) {
+        matrix_t window(win_size, vec_pad.cols, vec_pad.buffer + (ix * vec_pad.cols));
+        numpy::std_axis0(&window, &stat);
+        for (size_t col = 0; col < features->cols; col++) {
+            features->buffer[(ix * features->cols) + col] /= (stat.buffer[col] + 1e-10);
+        }
+    }
+}
+
+/* Same windows in double, the ground truth for both */
+static void cmvnw_double(const matrix_t *features, double *out, uint16_t win_size, bool variance_normalization)
+{
+    const size_t rows = features->rows, cols = features->cols;
+    const uint16_t pad_size = (win_size - 1) / 2;
+    /* rows of the padded window, from numpy::pad_1d_symmetric on the row numbers */
+    matrix_t row_ix(rows, 1), padded_ix(rows + (pad_size * 2), 1);
+    for (size_t row = 0; row < rows; row++) {
+        row_ix.buffer[row] = (float)row;
+    }
+    numpy::pad_1d_symmetric(&row_ix, &padded_ix, pad_size, pad_size);
+    auto at = [&](const double *m, size_t padded_row, size_t col) {
+        return m[((size_t)padded_ix.buffer[padded_row] * cols) + col];
+    };
+    double *in = (double *)malloc(rows * cols * sizeof(double));
+
+    for (size_t ix = 0; ix < rows * cols; ix++) {
+        in[ix] = features->buffer[ix];
+    }
+    for (size_t pass = 0; pass < (variance_normalization ? 2 : 1); pass++) {
+        for (size_t row = 0; row < rows; row++) {
+            for (size_t col = 0; col < cols; col++) {
+                double sum = 0, sum_dev = 0;
+                for (size_t w = 0; w < win_size; w++) {
+                    sum += at(in, row + w, col);
+                }
+                double mean = sum / win_size;
+                if (pass == 0) {
+                    out[(row * cols) + col] = in[(row * cols) + col] - mean;
+                    continue;
+                }
+                for (size_t w = 0; w < win_size; w++) {
+                    double dev = at(in, row + w, col) - mean;
+                    sum_dev += dev * dev;
+                }
+                out[(row * cols) + col] = in[(row * cols) + col] / (sqrt(sum_dev / win_size) + 1e-10);
+            }
+        }
+        memcpy(in, out, rows * cols * sizeof(double));
+    }
+    free(in);
+}
+
+/* Inputs ------------------------------------------------------------------ */
+#define COLS        13
+#define COL_QUIET   11  /* large mean, small variation */
+#define COL_FLAT    12  /* one value */
+
+static float frand(void)
+{
+    return (float)rand() / (float)RAND_MAX - 0.5f;
+}
+
+/* MFCC-like: c0 around -300 drifting slowly, the rest noise of decreasing size */
+static void make_features(matrix_t *features)
+{
+    for (size_t row = 0; row < features->rows; row++) {
+        float *out = features->buffer + (row * COLS);
+
+        out[0] = -300.f + 40.f * sinf(row * 0.003f) + 10.f * frand();
+        for (size_t col = 1; col < COL_QUIET; col++) {
+            out[col] = 20.f * frand() / col + 5.f * sinf(row * 0.01f * col);
+        }
+        out[COL_QUIET] = 1000.f + 0.05f * frand();
+        out[COL_FLAT] = 123.456f;
+    }
+}
+
+/* Tests ------------------------------------------------------------------- */
+static void test_window(size_t rows, uint16_t win_size, bool variance_normalization)
+{
+    matrix_t features(rows, COLS);
+    matrix_t reference(rows, COLS);
+
+    srand(win_size);
+    make_features(&features);
+    memcpy(reference.buffer, features.buffer, rows * COLS * sizeof(float));
+
+    CHECK(speechpy::processing::cmvnw(&features, win_size, variance_normalization) == EIDSP_OK);
+    cmvnw_reference(&reference, win_size, variance_normalization);
+
+    double *truth = (double *)malloc(rows * COLS * sizeof(double));
+    matrix_t input(rows, COLS);
+    srand(win_size);
+    make_features(&input);
+    cmvnw_double(&input, truth, win_size, variance_normalization);
+
+    /* per column, errors relative to the spread of the true column */
+    double worst = 0;
+    for (size_t col = 0; col < COL_FLAT; col++) {
+        double spread = 0, err = 0, err_ref = 0, err_truth = 0;
+        for (size_t row = 0; row < rows; row++) {
+            double out = features.buffer[(row * COLS) + col];
+            double ref = reference.buffer[(row * COLS) + col];
+            double exact = truth[(row * COLS) + col];
+            spread = fmax(spread, fabs(exact));
+            err = fmax(err, fabs(out - ref));
+            err_truth = fmax(err_truth, fabs(out - exact));
+            err_ref = fmax(err_ref, fabs(ref - exact));
+        }
+        if (col == COL_QUIET) {
+            /* float sums over the window lose the variation of this column,
+               the reference is off too: be at least as close to the truth */
+            printf("  quiet column: error %g, reference error %g, of %g\n", err_truth, err_ref, spread);
+            CHECK(err_truth <= err_ref);
+            continue;
+        }
+        if (err > 1e-4 * spread) {
+            printf("  column %zu: error %g of %g\n", col, err, spread);
+        }
+        CHECK(err <= 1e-4 * spread);
+        CHECK(err_truth <= 1e-4 * spread);
+        worst = fmax(worst, err / spread);
+    }
+    free(truth);
+
+    /* the reference leaves float rounding of the mean over 1e-10 here */
+    size_t flat_nonzero = 0;
+    for (size_t row = 0; row < rows; row++) {
+        flat_nonzero += features.buffer[(row * COLS) + COL_FLAT] != 0.f;
+    }
+    CHECK(flat_nonzero == 0);
+
+    printf("rows %zu, win %u%s: largest relative error %g\n", rows, win_size,
+        variance_normalization ? ", variance" : "", worst);
+}
+
+int main(int argc, char **argv)
+{
+    size_t rows = argc > 1 ? atoi(argv[1]) : 20000;
+
+    test_window(rows, 101, false);
+    test_window(rows, 101, true);
+    test_window(rows, 301, false);
+    test_window(rows, 301, true);
+    test_window(400, 301, true);
+    test_window(50, 301, true);
+
+    printf(failures ? "FAILED (%d)\n" : "OK\n", failures);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,160 @@
+#!/usr/bin/env python
+#
+# Decode the binary inference result records sent by AT+RUNIMPULSE=BIN and
+# AT+RUNIMPULSECONT=BIN.
+#
+# Record layout, little endian (see ei_run_impulse.cpp):
+#   "EIRS" | version u8 | label count u8 | flags u8 | top label u8 |
+#   sequence u32 | dsp us u32 | classification us u32 | anomaly us u32 |
+#   anomaly f32 | label count x score u16 | CRC-32 u32
+#
+# Usage:
+#   decode_results.py /dev/ttyUSB0 [--baud 115200] [--start] [--cont]
+#   decode_results.py capture.bin
+#
+# With --start the RUNIMPULSE command is sent to the device first. Text
+# printed by the device is passed through, records are printed one per line.
+
+import argparse
+import os
+import struct
+import sys
+import zlib
+
+MAGIC = b'EIRS'
+VERSION = 1
+HEADER = struct.Struct('<BBBBIIIIf')
+HEADER_SIZE = len(MAGIC) + HEADER.size
+FLAG_ANOMALY = 0x01
+LABELS_PREFIX = b'Binary results: '
+
+
+def parse_labels(line):
+    # "Binary results: N bytes per record, labels: a,b,c"
+    ix = line.find(b'labels: ')
+    if ix < 0:
+        return None
+    return line[ix + len(b'labels: '):].strip().decode('utf-8', 'replace').split(',')
+
+
+class Decoder:
+    def __init__(self, labels=None, out=sys.stdout):
+        self.buf = b''
+        self.line = b''
+        self.labels = labels
+        self.out = out
+        self.last_sequence = None
+        self.records = 0
+        self.crc_errors = 0
+        self.dropped = 0
+
+    def feed(self, data):
+        self.buf += data
+        while True:
+            ix = self.buf.find(MAGIC)
+            if ix < 0:
+                # keep a possible partial magic at the end
+                keep = len(MAGIC) - 1
+                self.text(self.buf[:-keep] if len(self.buf) > keep else b'')
+                self.buf = self.buf[-keep:] if len(self.buf) > keep else self.buf
+                return
+            if ix > 0:
+                self.text(self.buf[:ix])
+                self.buf = self.buf[ix:]
+            if len(self.buf) < HEADER_SIZE:
+                return
+            if self.buf[4] != VERSION:
+                self.skip()
+                continue
+            label_count = self.buf[5]
+            size = HEADER_SIZE + 2 * label_count + 4
+            if len(self.buf) < size:
+                return
+            record = self.buf[:size]
+            crc, = struct.unpack_from('<I', record, size - 4)
+            if zlib.crc32(record[len(MAGIC):size - 4]) & 0xffffffff != crc:
+                # not a record after all, skip the magic and resync
+                self.crc_errors += 1
+                self.skip()
+                continue
+            self.record(record, label_count)
+            self.buf = self.buf[size:]
+
+    def skip(self):
+        self.text(self.buf[:1])
+        self.buf = self.buf[1:]
+
+    def finish(self):
+        # whatever is left can't be a complete record
+        while self.buf.find(MAGIC) >= 0:
+            self.skip()
+            self.feed(b'')
+        self.text(self.buf)
+        self.buf = b''
+
+    def text(self, data):
+        if not data:
+            return
+        lines = (self.line + data).split(b'\n')
+        self.line = lines.pop()
+        for line in lines:
+            if line.startswith(LABELS_PREFIX) and self.labels is None:
+                self.labels = parse_labels(line)
+        self.out.write(data.decode('utf-8', 'replace'))
+        self.out.flush()
+
+    def record(self, record, label_count):
+        (version, _, flags, top, sequence, dsp_us, classification_us,
+         anomaly_us, anomaly) = HEADER.unpack_from(record, len(MAGIC))
+        scores = struct.unpack_from('<%dH' % label_count, record, HEADER_SIZE)
+
+        if self.last_sequence is not None and sequence > self.last_sequence + 1:
+            self.dropped += sequence - self.last_sequence - 1
+        self.last_sequence = sequence
+        self.records += 1
+
+        labels = self.labels if self.labels and len(self.labels) == label_count \
+            else [str(ix) for ix in range(label_count)]
+        line = '#%u dsp %u us, nn %u us' % (sequence, dsp_us, classification_us)
+        if flags & FLAG_ANOMALY:
+            line += ', anomaly %u us' % anomaly_us
+        line += ' | top: %s | ' % labels[top]
+        line += ', '.join('%s: %.5f' % (labels[ix], scores[ix] / 65535.0) for ix in range(label_count))
+        if flags & FLAG_ANOMALY:
+            line += ' | anomaly: %.5f' % anomaly
+        self.out.write(line + '\n')
+        self.out.flush()
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Decode binary inference results')
+    parser.add_argument('source', help='serial port or capture file')
+    parser.add_argument('--baud', type=int, default=115200)
+    parser.add_argument('--labels', help='comma separated labels, if the device header was missed')
+    parser.add_argument('--start', action='store_true', help='send AT+RUNIMPULSE=BIN first')
+    parser.add_argument('--cont', action='store_true', help='with --start, run in continuous mode')
+    args = parser.parse_args()
+
+    decoder = Decoder(args.labels.split(',') if args.labels else None)
+
+    try:
+        if os.path.isfile(args.source):
+            with open(args.source, 'rb') as f:
+                decoder.feed(f.read())
+                decoder.finish()
+        else:
+            import serial
+            port = serial.Serial(args.source, args.baud, timeout=0.1)
+            if args.start:
+                port.write(b'AT+RUNIMPULSECONT=BIN\r\n' if args.cont else b'AT+RUNIMPULSE=BIN\r\n')
+            while True:
+                decoder.feed(port.read(4096))
+    except KeyboardInterrupt:
+        pass
+
+    sys.stderr.write('\n%d records, %d dropped, %d CRC errors\n' %
+                     (decoder.records, decoder.dropped, decoder.crc_errors))
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,241 @@
+/* The Clear BSD License
+ *
+ * Copyright (c) 2025 EdgeImpulse Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the disclaimer
+ * below) provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ *   * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ *
+ *   * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from this
+ *   software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE GRANTED BY
+ * THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ * CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+/*
+ * Host accuracy report of the fixed-point (i16) MFE and MFCC blocks against
+ * the float blocks. Runs synthetic microphone windows (tones, noise and
+ * silence at levels from quiet to clipping, as int16 samples) through both,
+ * and prints per block the SNR of the fixed-point features, their largest
+ * error, and how often the quantized int8 model input differs.
+ *
+ * Usage: audio_accuracy [windows] [input scale]
+ * The input scale is the value of one int16 step the float blocks see,
+ * 1 / 32768 as the microphone converts its q15 samples by default.
+ * Build with build.sh.
+ */
+
+#include "model-parameters/model_metadata.h"
+#include "edge-impulse-sdk/classifier/ei_run_dsp.h"
+
+#include <math.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define AUDIO_FREQUENCY     16000
+#define AUDIO_SAMPLES       16000
+
+/* Settings of the Edge Impulse Studio audio blocks */
+static ei_dsp_config_mfe_t mfe_config = { 4, 1, 0.02f, 0.01f, 40, 256, 0, 0, 101, -52 };
+static ei_dsp_config_mfcc_t mfcc_config = { 2, 1, 13, 0.02f, 0.02f, 32, 256, 101, 300, 0, 0.98f, 1 };
+
+static int16_t raw_window[AUDIO_SAMPLES];
+static float input_scale = 1.f / 32768.f;
+
+/* Host porting ------------------------------------------------------------ */
+void *ei_malloc(size_t size) { return malloc(size); }
+void *ei_calloc(size_t nitems, size_t size) { return calloc(nitems, size); }
+void ei_free(void *ptr) { free(ptr); }
+
+void ei_printf(const char *format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    vprintf(format, args);
+    va_end(args);
+}
+
+void ei_printf_float(float f) { printf("%f", f); }
+
+/* Signals ----------------------------------------------------------------- */
+static int get_float_data(size_t offset, size_t length, float *out_ptr)
+{
+    for (size_t ix = 0; ix < length; ix++) {
+        out_ptr[ix] = (float)raw_window[offset + ix] * input_scale;
+    }
+    return 0;
+}
+
+static int get_i16_data(size_t offset, size_t length, int16_t *out_ptr)
+{
+    memcpy(out_ptr, raw_window + offset, length * sizeof(int16_t));
+    return 0;
+}
+
+static float uniform(float lo, float hi)
+{
+    return lo + (hi - lo) * (float)rand() / (float)RAND_MAX;
+}
+
+/* A window of up to 4 tones and noise, at a level of -60 dBFS up to
+   clipping, with a stretch of silence in some */
+static void make_window(void)
+{
+    const float fs = AUDIO_FREQUENCY;
+
+    float level = 32768.f * powf(10.f, uniform(-60.f, 6.f) / 20.f);
+    float amplitude[4], freq[4], phase[4];
+    int tones = rand() % 5;
+    for (int t = 0; t < tones; t++) {
+        amplitude[t] = uniform(0.1f, 1.f);
+        freq[t] = uniform(50.f, fs / 2.f);
+        phase[t] = uniform(0.f, 6.28f);
+    }
+    float noise = uniform(0.f, 0.5f);
+    size_t silence_start = rand() % 2 ? rand() % AUDIO_SAMPLES : AUDIO_SAMPLES;
+    size_t silence_end = silence_start + rand() % (AUDIO_SAMPLES / 4);
+
+    for (size_t ix = 0; ix < AUDIO_SAMPLES; ix++) {
+        if (ix >= silence_start && ix < silence_end) {
+            raw_window[ix] = 0;
+            continue;
+        }
+        float v = noise * uniform(-1.f, 1.f);
+        for (int t = 0; t < tones; t++) {
+            v += amplitude[t] * sinf(6.2832f * freq[t] * (float)ix / fs + phase[t]);
+        }
+        long q = lrintf(v * level);
+        q = q > 32767 ? 32767 : (q < -32768 ? -32768 : q);
+        raw_window[ix] = (int16_t)q;
+    }
+}
+
+static int quantize(float value, float scale, int zero_point)
+{
+    long q = lrintf(value / scale) + zero_point;
+    return q > 127 ? 127 : (q < -128 ? -128 : (int)q);
+}
+
+typedef int (*extract_fn_t)(ei::signal_t *, ei::matrix_t *, void *, const float);
+typedef int (*extract_i16_fn_t)(ei::signal_i16_t *, ei::matrix_i32_t *, void *, const float);
+
+/* Compare one block over `windows` windows, int8 inputs with scale / zero_point */
+static int report(const char *name, extract_fn_t extract_fn, extract_i16_fn_t extract_i16_fn,
+    void *config, size_t n_features, int windows, float scale, int zero_point)
+{
+    const float one = (float)(1L << EIDSP_I32_FEATURE_FRAC_BITS);
+
+    ei::matrix_t float_features(1, n_features);
+    ei::matrix_i32_t fixed_features(1, n_features);
+    EIDSP_i8 *fixed_int8 = (EIDSP_i8 *)malloc(n_features);
+
+    fixed_multiplier_t multiplier;
+    ei::numpy::fixed_multiplier_init(1.f / (scale * one), &multiplier);
+
+    double total_signal = 0, total_error = 0, max_error = 0;
+    size_t int8_diff = 0;
+    int max_int8_diff = 0;
+
+    srand(1);
+
+    for (int w = 0; w < windows; w++) {
+        make_window();
+
+        ei::signal_t signal;
+        signal.total_length = AUDIO_SAMPLES;
+        signal.get_data = &get_float_data;
+        ei::signal_i16_t signal_i16;
+        signal_i16.total_length = AUDIO_SAMPLES;
+        signal_i16.get_data = &get_i16_data;
+
+        float_features.rows = 1;
+        float_features.cols = n_features;
+        fixed_features.rows = 1;
+        fixed_features.cols = n_features;
+
+        if (extract_fn(&signal, &float_features, config, AUDIO_FREQUENCY) != 0 ||
+            extract_i16_fn(&signal_i16, &fixed_features, config, AUDIO_FREQUENCY) != 0) {
+            printf("ERR: %s failed\n", name);
+            return 1;
+        }
+
+        ei::numpy::quantize_i32_to_i8(&fixed_features, fixed_int8, &multiplier, zero_point);
+
+        for (size_t ix = 0; ix < n_features; ix++) {
+            double f = float_features.buffer[ix];
+            double e = (double)fixed_features.buffer[ix] / one - f;
+
+            total_signal += f * f;
+            total_error += e * e;
+            if (fabs(e) > max_error) {
+                max_error = fabs(e);
+            }
+
+            int d = abs(quantize((float)f, scale, zero_point) - fixed_int8[ix]);
+            if (d) {
+                int8_diff++;
+            }
+            if (d > max_int8_diff) {
+                max_int8_diff = d;
+            }
+        }
+    }
+
+    printf("%-5s  %8.1f   %9.6f   %5.2f%%      %d\n", name,
+        total_error > 0 ? 10.0 * log10(total_signal / total_error) : INFINITY, max_error,
+        100.0 * int8_diff / ((double)windows * n_features), max_int8_diff);
+
+    free(fixed_int8);
+
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    int windows = argc > 1 ? atoi(argv[1]) : 50;
+    input_scale = argc > 2 ? atof(argv[2]) : input_scale;
+
+    ei_dsp_set_i16_sample_scale(input_scale);
+
+    ei::matrix_size_t mfe_size = ei::speechpy::feature::calculate_mfe_buffer_size(AUDIO_SAMPLES, AUDIO_FREQUENCY,
+        mfe_config.frame_length, mfe_config.frame_stride, mfe_config.num_filters, mfe_config.implementation_version);
+    ei::matrix_size_t mfcc_size = ei::speechpy::feature::calculate_mfcc_buffer_size(AUDIO_SAMPLES, AUDIO_FREQUENCY,
+        mfcc_config.frame_length, mfcc_config.frame_stride, mfcc_config.num_cepstral, mfcc_config.implementation_version);
+
+    printf("%d windows of %d samples, input scale %g, features with %d fractional bits\n\n",
+        windows, AUDIO_SAMPLES, input_scale, EIDSP_I32_FEATURE_FRAC_BITS);
+    printf("block  SNR (dB)   max error   int8 differs   by at most\n");
+
+    // int8 inputs as the Studio quantizes them: MFE features are 0..1,
+    // normalized MFCC features mostly within +-4
+    if (report("MFE", &extract_mfe_features, &extract_mfe_features, &mfe_config,
+            mfe_size.rows * mfe_size.cols, windows, 1.f / 256.f, -128) != 0 ||
+        report("MFCC", &extract_mfcc_features, &extract_mfcc_features, &mfcc_config,
+            mfcc_size.rows * mfcc_size.cols, windows, 4.f / 128.f, 0) != 0) {
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,10 @@
+# Build the host accuracy reports of the fixed-point DSP blocks, run
+# ./dsp_accuracy (the deployed impulse) and ./audio_accuracy (MFE and MFCC)
+# On the host the integer FFT runs through kissfft instead of CMSIS-DSP
+EI=../../Thirdparty/edge_impulse
+SDK=$EI/edge-impulse-sdk
+SOURCES="$SDK/dsp/memory.cpp $SDK/dsp/kissfft/kiss_fft.cpp $SDK/dsp/kissfft/kiss_fftr.cpp $SDK/dsp/dct/fast-dct-fft.cpp"
+g++ -O2 -Wall -Wextra -o dsp_accuracy -DEIDSP_USE_CMSIS_DSP=0 \
+    -I$EI dsp_accuracy.cpp $SOURCES -lm
+g++ -O2 -Wall -Wextra -o audio_accuracy -DEIDSP_USE_CMSIS_DSP=0 \
+    -I$EI audio_accuracy.cpp $SOURCES -lm
@@ -0,0 +1,224 @@
+/* The Clear BSD License
+ *
+ * Copyright (c) 2025 EdgeImpulse Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the disclaimer
+ * below) provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ *   * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ *
+ *   * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from this
+ *   software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE GRANTED BY
+ * THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ * CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+/*
+ * Host accuracy report of the fixed-point (i16) DSP blocks of the deployed
+ * impulse against the float blocks. Runs synthetic accelerometer windows
+ * (gravity, a few vibrations and noise, as int16 sensor samples) through
+ * both, and prints per feature the SNR of the fixed-point features, their
+ * largest error, and how often the quantized int8 model input differs.
+ *
+ * Usage: dsp_accuracy [windows] [input scale] [input zero point]
+ * The input quantization defaults to the one of the deployed model.
+ * Build with build.sh.
+ */
+
+#include "model-parameters/model_metadata.h"
+#include "model-parameters/dsp_blocks.h"
+
+#include <math.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+/* Sensor: +-2g full scale, m/s2 per LSB */
+#define ACC_SCALE   (2.f / 32768.f * 9.80665f)
+
+static int16_t raw_window[EI_CLASSIFIER_RAW_SAMPLE_COUNT * EI_CLASSIFIER_RAW_SAMPLES_PER_FRAME];
+
+/* Host porting ------------------------------------------------------------ */
+void *ei_malloc(size_t size) { return malloc(size); }
+void *ei_calloc(size_t nitems, size_t size) { return calloc(nitems, size); }
+void ei_free(void *ptr) { free(ptr); }
+
+void ei_printf(const char *format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    vprintf(format, args);
+    va_end(args);
+}
+
+void ei_printf_float(float f) { printf("%f", f); }
+
+/* Signals ----------------------------------------------------------------- */
+static int get_float_data(size_t offset, size_t length, float *out_ptr)
+{
+    for (size_t ix = 0; ix < length; ix++) {
+        out_ptr[ix] = (float)raw_window[offset + ix] * ACC_SCALE;
+    }
+    return 0;
+}
+
+static int get_i16_data(size_t offset, size_t length, int16_t *out_ptr)
+{
+    memcpy(out_ptr, raw_window + offset, length * sizeof(int16_t));
+    return 0;
+}
+
+static float uniform(float lo, float hi)
+{
+    return lo + (hi - lo) * (float)rand() / (float)RAND_MAX;
+}
+
+/* A window of up to 3 vibrations per axis on top of gravity and noise */
+static void make_window(void)
+{
+    const float fs = EI_CLASSIFIER_FREQUENCY;
+
+    for (size_t ax = 0; ax < EI_CLASSIFIER_RAW_SAMPLES_PER_FRAME; ax++) {
+        float offset = uniform(-9.81f, 9.81f);
+        float amplitude[3], freq[3], phase[3];
+        int tones = rand() % 4;
+        for (int t = 0; t < tones; t++) {
+            amplitude[t] = uniform(0.05f, 6.f);
+            freq[t] = uniform(0.2f, fs / 2.f);
+            phase[t] = uniform(0.f, 6.28f);
+        }
+        float noise = uniform(0.f, 0.3f);
+
+        for (size_t ix = 0; ix < EI_CLASSIFIER_RAW_SAMPLE_COUNT; ix++) {
+            float v = offset + noise * uniform(-1.f, 1.f);
+            for (int t = 0; t < tones; t++) {
+                v += amplitude[t] * sinf(6.2832f * freq[t] * (float)ix / fs + phase[t]);
+            }
+            long q = lrintf(v / ACC_SCALE);
+            q = q > 32767 ? 32767 : (q < -32768 ? -32768 : q);
+            raw_window[ix * EI_CLASSIFIER_RAW_SAMPLES_PER_FRAME + ax] = (int16_t)q;
+        }
+    }
+}
+
+static int quantize(float value, float scale, int zero_point)
+{
+    long q = lrintf(value / scale) + zero_point;
+    return q > 127 ? 127 : (q < -128 ? -128 : (int)q);
+}
+
+int main(int argc, char **argv)
+{
+    int windows = argc > 1 ? atoi(argv[1]) : 200;
+    float input_scale = argc > 2 ? atof(argv[2]) : EI_CLASSIFIER_TFLITE_INPUT_SCALE;
+    int input_zero_point = argc > 3 ? atoi(argv[3]) : EI_CLASSIFIER_TFLITE_INPUT_ZEROPOINT;
+
+    const size_t n_features = EI_CLASSIFIER_NN_INPUT_FRAME_SIZE;
+    const float one = (float)(1L << EIDSP_I32_FEATURE_FRAC_BITS);
+
+    double *signal_power = (double *)calloc(n_features, sizeof(double));
+    double *error_power = (double *)calloc(n_features, sizeof(double));
+    double *max_error = (double *)calloc(n_features, sizeof(double));
+    int *int8_diff = (int *)calloc(n_features, sizeof(int));
+    int max_int8_diff = 0;
+    double total_signal = 0, total_error = 0;
+
+    ei::matrix_t float_features(1, n_features);
+    ei::matrix_i32_t fixed_features(1, n_features);
+    EIDSP_i8 *fixed_int8 = (EIDSP_i8 *)malloc(n_features);
+
+    fixed_multiplier_t multiplier;
+    ei::numpy::fixed_multiplier_init(1.f / (input_scale * one), &multiplier);
+
+    ei_dsp_set_i16_sample_scale(ACC_SCALE);
+
+    srand(1);
+
+    for (int w = 0; w < windows; w++) {
+        make_window();
+
+        size_t out_ix = 0;
+        for (size_t bx = 0; bx < ei_dsp_blocks_size; bx++) {
+            ei_model_dsp_t block = ei_dsp_blocks[bx];
+            ei_model_dsp_i16_t block_i16 = ei_dsp_blocks_i16[bx];
+
+            ei::signal_t signal;
+            signal.total_length = EI_CLASSIFIER_RAW_SAMPLE_COUNT * block.axes_size;
+            signal.get_data = &get_float_data;
+            ei::signal_i16_t signal_i16;
+            signal_i16.total_length = signal.total_length;
+            signal_i16.get_data = &get_i16_data;
+
+            ei::matrix_t fm(1, block.n_output_features, float_features.buffer + out_ix);
+            ei::matrix_i32_t im(1, block.n_output_features, fixed_features.buffer + out_ix);
+
+            if (block.extract_fn(&signal, &fm, block.config, EI_CLASSIFIER_FREQUENCY) != 0 ||
+                block_i16.extract_fn(&signal_i16, &im, block_i16.config, EI_CLASSIFIER_FREQUENCY) != 0) {
+                printf("ERR: DSP block %d failed\n", (int)bx);
+                return 1;
+            }
+            out_ix += block.n_output_features;
+        }
+
+        ei::numpy::quantize_i32_to_i8(&fixed_features, fixed_int8, &multiplier, input_zero_point);
+
+        for (size_t ix = 0; ix < n_features; ix++) {
+            double f = float_features.buffer[ix];
+            double e = (double)fixed_features.buffer[ix] / one - f;
+
+            signal_power[ix] += f * f;
+            error_power[ix] += e * e;
+            total_signal += f * f;
+            total_error += e * e;
+            if (fabs(e) > max_error[ix]) {
+                max_error[ix] = fabs(e);
+            }
+
+            int d = abs(quantize((float)f, input_scale, input_zero_point) - fixed_int8[ix]);
+            if (d) {
+                int8_diff[ix]++;
+            }
+            if (d > max_int8_diff) {
+                max_int8_diff = d;
+            }
+        }
+    }
+
+    printf("%d windows, features with %d fractional bits\n\n", windows, EIDSP_I32_FEATURE_FRAC_BITS);
+    printf("feature    SNR (dB)   max error   int8 differs\n");
+    for (size_t ix = 0; ix < n_features; ix++) {
+        if (error_power[ix] == 0) {
+            printf("%7d    %8s   %9.6f   %5.1f%%\n", (int)ix, "exact", max_error[ix],
+                100.0 * int8_diff[ix] / windows);
+        }
+        else {
+            printf("%7d    %8.1f   %9.6f   %5.1f%%\n", (int)ix,
+                10.0 * log10(signal_power[ix] / error_power[ix]), max_error[ix],
+                100.0 * int8_diff[ix] / windows);
+        }
+    }
+    printf("\nall        %8.1f dB, int8 inputs off by at most %d\n",
+        total_error > 0 ? 10.0 * log10(total_signal / total_error) : INFINITY, max_int8_diff);
+
+    return 0;
+}
@@ -0,0 +1,13 @@
+# Build the host test of the executor scheduler, run ./executor_sim
+# The executor hands buffer addresses to the DSP as 32 bit, the test keeps them below 4 GB
+P=../../Platform/ECM3532
+E=$P/M3/framework/executor
+INC="-Istub -I$E/include/pub -I$E/include/priv -I../host_stub -I$P/Common/executor/inc \
+    -I$P/Common/framework/inc -I$P/M3/framework/rpc/include -I$P/M3/NN_kernels/include -I$P/M3/util/include"
+gcc -O2 -Wall -Wno-unused-variable -Wno-unused-function -Wno-pointer-to-int-cast -Wno-int-to-pointer-cast \
+    -D__ARM_ARCH_7M__ -c $INC $E/src/executor.c $E/src/executor_plan.c $E/src/executor_pool.c \
+    $E/src/executor_proxy.c $E/src/CHWq7_to_HWCq7.c $E/src/HWCq7_to_CHWq7_with_pad.c $E/src/reorder_conv2d_kernel.c
+g++ -O2 -Wall -Wextra -pthread -D__ARM_ARCH_7M__ -o executor_sim $INC executor_sim.cpp \
+    executor.o executor_plan.o executor_pool.o executor_proxy.o CHWq7_to_HWCq7.o HWCq7_to_CHWq7_with_pad.o \
+    reorder_conv2d_kernel.o
+rm -f *.o
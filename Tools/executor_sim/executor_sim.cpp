@@ -0,0 +1,577 @@
+/* The Clear BSD License
+ *
+ * Copyright (c) 2025 EdgeImpulse Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the disclaimer
+ * below) provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ *   * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ *
+ *   * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from this
+ *   software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE GRANTED BY
+ * THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ * CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+/*
+ * Host test of the executor scheduler. Builds the real executor.c,
+ * executor_plan.c, executor_pool.c and executor_proxy.c against a threaded
+ * FreeRTOS stand-in and a model of the DSP. The DSP model answers each FFT
+ * after a delay and only then reads its input and writes its output, while
+ * the M3 task runs its works right away, so works complete out of submission
+ * order. The FFT model does not transform, it copies each input sample to
+ * the real part of the output so a late read of a clobbered input shows.
+ * Most tests bind a memory plan in which a later M3 work reuses the arena
+ * bytes of an FFT operand. The last one stops the DSP model answering.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <sys/mman.h>
+#include <deque>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <atomic>
+
+extern "C" {
+#include "config.h"
+#include "executor_public.h"
+#include "executor_common.h"
+#include "executor_op.h"
+#include "module_common.h"
+#include "shmem.h"
+#include "rpc.h"
+}
+
+#include "semphr.h"
+#include "task.h"
+
+/* Time the DSP model takes for a work */
+#define DSP_WORK_MS             30
+#define FFT_LENGTH              64
+
+static int failures = 0;
+
+#define CHECK(cond) do { if (!(cond)) { printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); failures++; } } while (0)
+
+/* Order in which the DSP model and the M3 kernels touched the buffers */
+static std::atomic<int> event_seq;
+static std::atomic<int> dsp_done_seq;
+static std::atomic<int> relu_seq;
+static std::atomic<int> conv_seq;
+
+/* FreeRTOS stand-in -------------------------------------------------------- */
+
+struct sim_semaphore {
+    std::mutex m;
+    std::condition_variable cv;
+    UBaseType_t count;
+    UBaseType_t max;
+};
+
+struct sim_queue {
+    std::mutex m;
+    std::condition_variable cv;
+    std::deque<std::vector<uint8_t> > items;
+    UBaseType_t item_size;
+};
+
+/* Never destroyed, the executor tasks are still blocked on their queues at exit */
+static std::recursive_mutex &critical = *new std::recursive_mutex;
+
+static SemaphoreHandle_t sim_semaphore_create(UBaseType_t max, UBaseType_t count)
+{
+    sim_semaphore *sem = new sim_semaphore;
+    sem->max = max;
+    sem->count = count;
+    return sem;
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinary(void)
+{
+    return sim_semaphore_create(1, 0);
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void)
+{
+    return sim_semaphore_create(1, 1);
+}
+
+SemaphoreHandle_t xSemaphoreCreateCounting(UBaseType_t max_count, UBaseType_t initial_count)
+{
+    return sim_semaphore_create(max_count, initial_count);
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t ticks)
+{
+    std::unique_lock<std::mutex> lock(sem->m);
+    if (ticks == portMAX_DELAY) {
+        sem->cv.wait(lock, [sem] { return sem->count > 0; });
+    }
+    else if (!sem->cv.wait_for(lock, std::chrono::milliseconds(ticks), [sem] { return sem->count > 0; })) {
+        return pdFALSE;
+    }
+    sem->count--;
+    return pdTRUE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t sem)
+{
+    std::lock_guard<std::mutex> lock(sem->m);
+    if (sem->count == sem->max) {
+        return pdFALSE;
+    }
+    sem->count++;
+    sem->cv.notify_one();
+    return pdTRUE;
+}
+
+BaseType_t xSemaphoreGiveFromISR(SemaphoreHandle_t sem, BaseType_t *woken)
+{
+    *woken = pdFALSE;
+    return xSemaphoreGive(sem);
+}
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t item_size)
+{
+    (void)length;
+    sim_queue *queue = new sim_queue;
+    queue->item_size = item_size;
+    return queue;
+}
+
+BaseType_t xQueueSendToBack(QueueHandle_t queue, const void *item, TickType_t ticks)
+{
+    (void)ticks;
+    const uint8_t *bytes = (const uint8_t *)item;
+    std::lock_guard<std::mutex> lock(queue->m);
+    queue->items.push_back(std::vector<uint8_t>(bytes, bytes + queue->item_size));
+    queue->cv.notify_one();
+    return pdPASS;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t queue, void *item, TickType_t ticks)
+{
+    (void)ticks;
+    std::unique_lock<std::mutex> lock(queue->m);
+    queue->cv.wait(lock, [queue] { return !queue->items.empty(); });
+    memcpy(item, queue->items.front().data(), queue->item_size);
+    queue->items.pop_front();
+    return pdTRUE;
+}
+
+/* Every task runs on its own thread, as the M3 and DSP tasks would on
+ * their own cores */
+BaseType_t xTaskCreate(TaskFunction_t fn, const char *name, uint16_t stack_depth,
+    void *arg, UBaseType_t priority, TaskHandle_t *handle)
+{
+    (void)name;
+    (void)stack_depth;
+    (void)priority;
+    std::thread(fn, arg).detach();
+    if (handle) {
+        *handle = NULL;
+    }
+    return pdPASS;
+}
+
+void vPortEnterCritical(void)
+{
+    critical.lock();
+}
+
+void vPortExitCritical(void)
+{
+    critical.unlock();
+}
+
+void *pvPortMalloc(size_t size)
+{
+    return malloc(size);
+}
+
+void vPortFree(void *ptr)
+{
+    free(ptr);
+}
+
+int ecm35xx_printf(const char *fmt, ...)
+{
+    va_list args;
+    va_start(args, fmt);
+    int len = vprintf(fmt, args);
+    va_end(args);
+    return len;
+}
+
+/* DSP model ---------------------------------------------------------------- */
+
+static tnotifyEventIsrCb dsp_response_cb;
+static uint8_t dsp_response_header;
+/* Set to drop every work without a response, as a hung DSP would */
+static std::atomic<bool> dsp_hung;
+static std::atomic<int> dsp_submits;
+
+static std::mutex &dsp_lock = *new std::mutex;
+static std::condition_variable &dsp_cv = *new std::condition_variable;
+static std::deque<std::pair<uint8_t, tExecutorRpcWork *> > &dsp_works =
+    *new std::deque<std::pair<uint8_t, tExecutorRpcWork *> >;
+
+static int16_t *dsp_addr(const dspShmemBuf *buf)
+{
+    return (int16_t *)(uintptr_t)(((uint32_t)buf->ahbAddrHi << 16) | buf->ahbAddrLo);
+}
+
+/* One work at a time, the buffers are touched only when it is done */
+static void dsp_thread(void)
+{
+    while (1) {
+        std::unique_lock<std::mutex> lock(dsp_lock);
+        dsp_cv.wait(lock, [] { return !dsp_works.empty(); });
+        std::pair<uint8_t, tExecutorRpcWork *> work = dsp_works.front();
+        dsp_works.pop_front();
+        lock.unlock();
+        if (dsp_hung) {
+            continue;
+        }
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(DSP_WORK_MS));
+
+        tExecutorRpcWork *rwork = work.second;
+        if (work.first == EXEC_OP_DSP_MATH_FFT) {
+            int16_t *in = dsp_addr(&rwork->inbuf);
+            int16_t *out = dsp_addr(&rwork->outbuf);
+            for (uint16_t i = 0; i < rwork->params.fft_opt.fft_length; i++) {
+                out[2 * i] = in[i];
+                out[2 * i + 1] = 0;
+            }
+        }
+        rwork->status = 0;
+        dsp_done_seq = ++event_seq;
+        dsp_response_cb(dsp_response_header, 0);
+    }
+}
+
+int rpcSubmitWork(uint8_t moduleId, uint8_t operation, void *params)
+{
+    (void)moduleId;
+    dsp_submits++;
+    std::lock_guard<std::mutex> lock(dsp_lock);
+    dsp_works.push_back(std::make_pair(operation, (tExecutorRpcWork *)params));
+    dsp_cv.notify_one();
+    return 0;
+}
+
+void rpcRegisterEventIsrCb(uint8_t eventHeaderMask, tnotifyEventIsrCb cbFn)
+{
+    if (GET_EVT_RSP(eventHeaderMask) == RPC_RESPONSE) {
+        dsp_response_header = eventHeaderMask;
+        dsp_response_cb = cbFn;
+    }
+}
+
+void rpcRegisterEventCb(uint8_t eventHeaderMask, tnotifyEventCb cbFn)
+{
+    (void)eventHeaderMask;
+    (void)cbFn;
+}
+
+void *SharedMemAlloc(uint32_t size)
+{
+    return malloc(size);
+}
+
+void SharedMemFree(void *mem)
+{
+    free(mem);
+}
+
+/* M3 kernels --------------------------------------------------------------- */
+
+extern "C" void eta_relu_q7(q7_t *data, uint16_t size)
+{
+    relu_seq = ++event_seq;
+    for (uint16_t i = 0; i < size; i++) {
+        if (data[i] < 0) {
+            data[i] = 0;
+        }
+    }
+}
+
+extern "C" eta_rc eta_conv2d_q7(const q7_t *in_array, const q7_t *wt, const q7_t *bias,
+                                q7_t *out_array, q7_t *buff_in, const conv2d_opt opt)
+{
+    (void)in_array;
+    (void)wt;
+    (void)bias;
+    (void)buff_in;
+    conv_seq = ++event_seq;
+    memset(out_array, 1, opt.out_rows * opt.out_cols * opt.num_filt);
+    return ETA_STATUS_OK;
+}
+
+/* Tests -------------------------------------------------------------------- */
+
+/* The executor hands 32 bit addresses to the DSP */
+static int8_t *arena_alloc(uint32_t size)
+{
+    void *mem = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_32BIT, -1, 0);
+    if (mem == MAP_FAILED) {
+        printf("no memory below 4 GB\n");
+        exit(1);
+    }
+    return (int8_t *)mem;
+}
+
+static ExecOperand_t operand(uint32_t num_elements, uint32_t basetype_size)
+{
+    ExecOperand_t opd;
+    memset(&opd, 0, sizeof(opd));
+    opd.origin = OPD_ORIG_IO;
+    opd.accessType = OPD_ACCESS_TYPE_RW;
+    opd.memType = OPD_MEM_TYPE_M3_LOCAL;
+    opd.basetypeSize = basetype_size;
+    opd.numElements = num_elements;
+    return opd;
+}
+
+static void fill_samples(int16_t *samples)
+{
+    for (int i = 0; i < FFT_LENGTH; i++) {
+        samples[i] = (int16_t)((i * 37) % 200 - 100);
+    }
+}
+
+static void reset_events(void)
+{
+    event_seq = 0;
+    dsp_done_seq = 0;
+    relu_seq = 0;
+    conv_seq = 0;
+}
+
+/* The relu reuses the bytes of the FFT input, it may only run once the DSP
+ * read them (write after read across operands) */
+static void test_reuse_of_input(void)
+{
+    ExecOperand_t x = operand(FFT_LENGTH, OPD_BASE_SIZE_BYTES_2);
+    ExecOperand_t y = operand(2 * FFT_LENGTH, OPD_BASE_SIZE_BYTES_2);
+    ExecOperand_t z = operand(2 * FFT_LENGTH, OPD_BASE_SIZE_BYTES_1);
+    ExecPlanBuf_t plan[] = { EXEC_PLAN_BUF(x), EXEC_PLAN_BUF(y), EXEC_PLAN_BUF(z) };
+    uint16_t num = sizeof(plan) / sizeof(plan[0]);
+    uint32_t size;
+    int16_t expected[FFT_LENGTH];
+
+    ExecPlanUse(plan, num, &x, 0);
+    ExecPlanUse(plan, num, &y, 0);
+    ExecPlanUse(plan, num, &z, 1);
+    ExecPlanUse(plan, num, &y, 2);
+    CHECK(ExecPlanMemory(plan, num, &size) == EXEC_STATUS_OK);
+    CHECK(ExecBindPlan(plan, num, arena_alloc(size)) == EXEC_STATUS_OK);
+    CHECK(ExecGetBufAddr(&z) == ExecGetBufAddr(&x));
+
+    fill_samples(expected);
+    memcpy(ExecGetBufAddr(&x), expected, sizeof(expected));
+    reset_events();
+    Exec_fft_q15(EXEC_HW_ID_DSP, &x, &y, FFT_LENGTH);
+    Exec_relu_q7(EXEC_HW_ID_M3, &z, 2 * FFT_LENGTH);
+    ExecWaitForCompletion();
+
+    CHECK(relu_seq > dsp_done_seq);
+    int16_t *out = (int16_t *)ExecGetBufAddr(&y);
+    int bad = 0;
+    for (int i = 0; i < FFT_LENGTH; i++) {
+        bad += (out[2 * i] != expected[i]);
+    }
+    CHECK(bad == 0);
+}
+
+/* The relu reuses the bytes of the FFT output once that is dead, it has to
+ * wait for the DSP write (write after write across operands) */
+static void test_reuse_of_output(void)
+{
+    ExecOperand_t x = operand(FFT_LENGTH, OPD_BASE_SIZE_BYTES_2);
+    ExecOperand_t y = operand(2 * FFT_LENGTH, OPD_BASE_SIZE_BYTES_2);
+    ExecOperand_t z = operand(4 * FFT_LENGTH, OPD_BASE_SIZE_BYTES_1);
+    ExecPlanBuf_t plan[] = { EXEC_PLAN_BUF(x), EXEC_PLAN_BUF(y), EXEC_PLAN_BUF(z) };
+    uint16_t num = sizeof(plan) / sizeof(plan[0]);
+    uint32_t size;
+    int16_t samples[FFT_LENGTH];
+
+    ExecPlanUse(plan, num, &x, 0);
+    ExecPlanUse(plan, num, &y, 0);
+    ExecPlanUse(plan, num, &z, 1);
+    CHECK(ExecPlanMemory(plan, num, &size) == EXEC_STATUS_OK);
+    CHECK(ExecBindPlan(plan, num, arena_alloc(size)) == EXEC_STATUS_OK);
+    CHECK(ExecGetBufAddr(&z) == ExecGetBufAddr(&y));
+
+    fill_samples(samples);
+    memcpy(ExecGetBufAddr(&x), samples, sizeof(samples));
+    memset(ExecGetBufAddr(&y), 0, 4 * FFT_LENGTH);
+    reset_events();
+    Exec_fft_q15(EXEC_HW_ID_DSP, &x, &y, FFT_LENGTH);
+    Exec_relu_q7(EXEC_HW_ID_M3, &z, 4 * FFT_LENGTH);
+    ExecWaitForCompletion();
+
+    /* the relu result of the DSP output, not the DSP output over it */
+    CHECK(relu_seq > dsp_done_seq);
+    int16_t out[2 * FFT_LENGTH];
+    for (int i = 0; i < FFT_LENGTH; i++) {
+        out[2 * i] = samples[i];
+        out[2 * i + 1] = 0;
+    }
+    int8_t *expected = (int8_t *)out;
+    int8_t *result = (int8_t *)ExecGetBufAddr(&z);
+    int bad = 0;
+    for (int i = 0; i < 4 * FFT_LENGTH; i++) {
+        bad += (result[i] != (expected[i] < 0 ? 0 : expected[i]));
+    }
+    CHECK(bad == 0);
+}
+
+/* Operands alive at the same time get their own bytes, the M3 work does
+ * not wait for the DSP */
+static void test_no_reuse(void)
+{
+    ExecOperand_t x = operand(FFT_LENGTH, OPD_BASE_SIZE_BYTES_2);
+    ExecOperand_t y = operand(2 * FFT_LENGTH, OPD_BASE_SIZE_BYTES_2);
+    ExecOperand_t z = operand(2 * FFT_LENGTH, OPD_BASE_SIZE_BYTES_1);
+    ExecPlanBuf_t plan[] = { EXEC_PLAN_BUF(x), EXEC_PLAN_BUF(y), EXEC_PLAN_BUF(z) };
+    uint16_t num = sizeof(plan) / sizeof(plan[0]);
+    uint32_t size;
+    int16_t samples[FFT_LENGTH];
+
+    ExecPlanUse(plan, num, &x, 0);
+    ExecPlanUse(plan, num, &y, 0);
+    ExecPlanUse(plan, num, &z, 0);
+    CHECK(ExecPlanMemory(plan, num, &size) == EXEC_STATUS_OK);
+    CHECK(ExecBindPlan(plan, num, arena_alloc(size)) == EXEC_STATUS_OK);
+
+    fill_samples(samples);
+    memcpy(ExecGetBufAddr(&x), samples, sizeof(samples));
+    reset_events();
+    Exec_fft_q15(EXEC_HW_ID_DSP, &x, &y, FFT_LENGTH);
+    Exec_relu_q7(EXEC_HW_ID_M3, &z, 2 * FFT_LENGTH);
+    ExecWaitForCompletion();
+
+    CHECK(relu_seq < dsp_done_seq);
+}
+
+/* Every task waiting for the FFT output or for the executor to go idle
+ * is woken, not only the first one */
+static void test_waiters(void)
+{
+    ExecOperand_t x = operand(FFT_LENGTH, OPD_BASE_SIZE_BYTES_2);
+    ExecOperand_t y = operand(2 * FFT_LENGTH, OPD_BASE_SIZE_BYTES_2);
+    ExecPlanBuf_t plan[] = { EXEC_PLAN_BUF(x), EXEC_PLAN_BUF(y) };
+    uint16_t num = sizeof(plan) / sizeof(plan[0]);
+    uint32_t size;
+    std::atomic<int> woken(0);
+
+    ExecPlanUse(plan, num, &x, 0);
+    ExecPlanUse(plan, num, &y, 0);
+    CHECK(ExecPlanMemory(plan, num, &size) == EXEC_STATUS_OK);
+    CHECK(ExecBindPlan(plan, num, arena_alloc(size)) == EXEC_STATUS_OK);
+
+    Exec_fft_q15(EXEC_HW_ID_DSP, &x, &y, FFT_LENGTH);
+    for (int i = 0; i < 2; i++) {
+        std::thread([&woken] { ExecWaitForCompletion(); woken++; }).detach();
+        std::thread([&woken, &y] { ExecWaitForBuf(&y); woken++; }).detach();
+    }
+    for (int ms = 0; (ms < 1000) && (woken < 4); ms++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    CHECK(woken == 4);
+}
+
+/* A conv2d the DSP never answers times out and runs on the M3 instead, the
+ * FFT behind it completes without going to the DSP */
+static void test_dsp_down(void)
+{
+    conv2d_opt opt;
+    memset(&opt, 0, sizeof(opt));
+    opt.in_rows = 8;
+    opt.in_cols = 8;
+    opt.in_depth = 1;
+    opt.num_filt = 1;
+    opt.filt_rows = 3;
+    opt.filt_cols = 3;
+    opt.row_stride = 1;
+    opt.col_stride = 1;
+    opt.out_rows = 6;
+    opt.out_cols = 6;
+    opt.act_max = 127;
+    ExecOperand_t in = operand(64, OPD_BASE_SIZE_BYTES_1);
+    ExecOperand_t wt = operand(9, OPD_BASE_SIZE_BYTES_1);
+    ExecOperand_t bias = operand(1, OPD_BASE_SIZE_BYTES_1);
+    ExecOperand_t out = operand(36, OPD_BASE_SIZE_BYTES_1);
+    ExecOperand_t scratch = operand(64, OPD_BASE_SIZE_BYTES_1);
+    ExecOperand_t x = operand(FFT_LENGTH, OPD_BASE_SIZE_BYTES_2);
+    ExecOperand_t y = operand(2 * FFT_LENGTH, OPD_BASE_SIZE_BYTES_2);
+    ExecPlanBuf_t plan[] = { EXEC_PLAN_BUF(in), EXEC_PLAN_BUF(wt), EXEC_PLAN_BUF(bias),
+                             EXEC_PLAN_BUF(out), EXEC_PLAN_BUF(scratch),
+                             EXEC_PLAN_BUF(x), EXEC_PLAN_BUF(y) };
+    uint16_t num = sizeof(plan) / sizeof(plan[0]);
+    uint32_t size;
+
+    for (uint16_t i = 0; i < num; i++) {
+        ExecPlanUse(plan, num, plan[i].opd, 0);
+    }
+    CHECK(ExecPlanMemory(plan, num, &size) == EXEC_STATUS_OK);
+    CHECK(ExecBindPlan(plan, num, arena_alloc(size)) == EXEC_STATUS_OK);
+
+    memset(ExecGetBufAddr(&out), 0, 36);
+    reset_events();
+    dsp_hung = true;
+    dsp_submits = 0;
+    Exec_conv2d_q7(EXEC_HW_ID_DSP, &in, &wt, &bias, &out, &scratch, &opt);
+    Exec_fft_q15(EXEC_HW_ID_DSP, &x, &y, FFT_LENGTH);
+    ExecWaitForCompletion();
+
+    CHECK(!ExecDspResponding());
+    CHECK(conv_seq != 0);
+    CHECK(((int8_t *)ExecGetBufAddr(&out))[35] == 1);
+    CHECK(dsp_submits == 1);
+}
+
+int main(void)
+{
+    std::thread(dsp_thread).detach();
+    CHECK(ExecInit() == EXEC_STATUS_OK);
+
+    test_reuse_of_input();
+    test_reuse_of_output();
+    test_no_reuse();
+    /* a waiter never woken stays blocked */
+    test_waiters();
+    /* last, the DSP is not used again */
+    test_dsp_down();
+
+    printf(failures ? "FAILED (%d)\n" : "OK\n", failures);
+    return failures ? 1 : 0;
+}
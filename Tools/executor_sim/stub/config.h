@@ -0,0 +1,11 @@
+#ifndef EXECUTOR_SIM_CONFIG_H
+#define EXECUTOR_SIM_CONFIG_H
+
+#define CONFIG_EXECUTOR             1
+#define CONFIG_OP_DSP_FFT_Q15       1
+#define CONFIG_OP_M3_RELU_Q7        1
+#define CONFIG_OP_M3_CONV2D_Q7      1
+#define CONFIG_EXEC_DSP_RESP_TIMEOUT_MS 200
+#define CONFIG_SHM_LENGTH           4096
+
+#endif
@@ -0,0 +1,5 @@
+# Build the host simulation of the erase-ahead sample stream, run ./flash_stream_sim [erase time scale]
+EI=../../Thirdparty/edge_impulse
+g++ -O2 -Wall -Wextra -Wno-unused-parameter -pthread -o flash_stream_sim -Istub -I../host_stub \
+    -I$EI/ingestion-sdk-platform/eta-compute -I$EI/ingestion-sdk-c \
+    flash_stream_sim.cpp $EI/ingestion-sdk-platform/eta-compute/ei_eta_fs_commands.cpp
@@ -0,0 +1,416 @@
+/* The Clear BSD License
+ *
+ * Copyright (c) 2025 EdgeImpulse Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the disclaimer
+ * below) provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ *   * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ *
+ *   * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from this
+ *   software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE GRANTED BY
+ * THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ * CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+
+/*
+ * Host simulation of the erase-ahead sample stream. Builds the real
+ * ei_eta_fs_commands.cpp against a model of the MX25R serial flash and a
+ * single core FreeRTOS stand-in: the writer has priority, the erase ahead
+ * task only runs while the writer sleeps between samples. The flash model
+ * flags every page programmed outside an erased area, every command sent
+ * while the flash is busy and every program or erase without write enable.
+ * Each stream is read back after the flush and compared.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+
+#include "ei_eta_fs_commands.h"
+#include "eta_csp_spi.h"
+#include "semphr.h"
+#include "task.h"
+
+typedef std::chrono::steady_clock sim_clock;
+
+/* Typical MX25R timings, erase times are scaled with the first argument */
+#define T_PAGE_PROGRAM_US       850
+#define T_SECTOR_ERASE_US       40000
+#define T_BLOCK_ERASE_US        400000
+/* SPI byte time, about 4 MHz */
+#define T_SPI_BYTE_NS           2000
+
+static int failures = 0;
+
+#define CHECK(cond) do { if (!(cond)) { printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); failures++; } } while (0)
+
+/* Single core, held by whoever is running */
+static std::mutex cpu;
+
+/* MX25R model -------------------------------------------------------------- */
+
+static struct {
+    std::vector<uint8_t> mem;
+    /* byte erased and not programmed since */
+    std::vector<uint8_t> erased;
+    sim_clock::time_point busy_until;
+    bool wel;
+    bool pp_pending;
+    uint32_t pp_address;
+    double erase_scale;
+    uint32_t n_programs;
+    uint32_t n_erases;
+    uint32_t violations;
+} flash;
+
+static void violation(const char *what, uint32_t address)
+{
+    if (flash.violations++ < 10) {
+        printf("FLASH %s at 0x%06x\n", what, (unsigned)address);
+    }
+}
+
+static bool flash_is_busy(void)
+{
+    return sim_clock::now() < flash.busy_until;
+}
+
+static void flash_start(uint32_t us)
+{
+    flash.busy_until = sim_clock::now() + std::chrono::microseconds(us);
+    flash.wel = false;
+}
+
+static bool flash_command_ok(const char *what, uint32_t address, bool needs_wel)
+{
+    if (flash_is_busy()) {
+        violation(what, address);
+        return false;
+    }
+    if (needs_wel && !flash.wel) {
+        violation(what, address);
+        return false;
+    }
+    return true;
+}
+
+static void flash_erase(uint32_t address, uint32_t size, uint32_t us)
+{
+    if (!flash_command_ok("erase while busy or not write enabled", address, true)) {
+        return;
+    }
+    address &= ~(size - 1);
+    memset(&flash.mem[address], 0xff, size);
+    memset(&flash.erased[address], 1, size);
+    flash.n_erases++;
+    flash_start((uint32_t)(us * flash.erase_scale));
+}
+
+static void flash_program(uint32_t address, const uint8_t *data, uint32_t n_bytes)
+{
+    if (!flash_command_ok("program while busy or not write enabled", address, true)) {
+        return;
+    }
+    for (uint32_t i = 0; i < n_bytes; i++) {
+        /* wraps within the page, like the device */
+        uint32_t a = (address & ~(MX25R_PAGE_SIZE - 1)) | ((address + i) & (MX25R_PAGE_SIZE - 1));
+        if (!flash.erased[a]) {
+            violation("program outside the erased area", a);
+        }
+        flash.mem[a] &= data[i];
+        flash.erased[a] = 0;
+    }
+    flash.n_programs++;
+    flash_start(T_PAGE_PROGRAM_US);
+}
+
+static uint32_t spi_address(const uint8_t *tx)
+{
+    return ((uint32_t)tx[1] << 16) | ((uint32_t)tx[2] << 8) | tx[3];
+}
+
+tEtaStatus EtaCspSpiTransferPoll(tSpiNum iNum, uint8_t *pui8TxData,
+                                 uint32_t ui32TxLen,
+                                 uint8_t *pui8RxData, uint32_t ui32RxLen,
+                                 tSpiChipSel spiChipSel,
+                                 tSpiSequence iSpiSequence)
+{
+    (void)iNum;
+    (void)spiChipSel;
+
+    /* The transfer takes CPU time, the driver polls */
+    sim_clock::time_point done = sim_clock::now() +
+        std::chrono::nanoseconds((uint64_t)(ui32TxLen + ui32RxLen) * T_SPI_BYTE_NS);
+    while (sim_clock::now() < done) { }
+
+    if (iSpiSequence == eSpiSequenceLastOnly) {
+        if (flash.pp_pending) {
+            flash.pp_pending = false;
+            flash_program(flash.pp_address, pui8TxData, ui32TxLen);
+        }
+        return eEtaSuccess;
+    }
+
+    switch (pui8TxData[0]) {
+    case MX25R_WREN:
+        if (flash_command_ok("write enable while busy", 0, false)) {
+            flash.wel = true;
+        }
+        break;
+    case MX25R_RDSR:
+        pui8RxData[0] = (flash_is_busy() ? MX25R_STAT_WIP : 0) | (flash.wel ? MX25R_STAT_WEL : 0);
+        break;
+    case MX25R_SE:
+        flash_erase(spi_address(pui8TxData), MX25R_SECTOR_SIZE, T_SECTOR_ERASE_US);
+        break;
+    case MX25R_BE:
+        flash_erase(spi_address(pui8TxData), MX25R_BLOCK64_SIZE, T_BLOCK_ERASE_US);
+        break;
+    case MX25R_PP:
+        if (iSpiSequence == eSpiSequenceFirstOnly) {
+            flash.pp_pending = true;
+            flash.pp_address = spi_address(pui8TxData);
+        }
+        else {
+            flash_program(spi_address(pui8TxData), pui8TxData + 4, ui32TxLen - 4);
+        }
+        break;
+    case MX25R_READ:
+        if (flash_command_ok("read while busy", spi_address(pui8TxData), false)) {
+            memcpy(pui8RxData, &flash.mem[spi_address(pui8TxData)], ui32RxLen);
+        }
+        break;
+    default:
+        violation("unknown command", pui8TxData[0]);
+        break;
+    }
+
+    return eEtaSuccess;
+}
+
+/* FreeRTOS stand-in -------------------------------------------------------- */
+
+struct sim_semaphore {
+    std::mutex m;
+};
+
+struct sim_task {
+    std::thread thread;
+};
+
+/* Never destroyed, the task is still waiting on it at exit */
+static std::mutex &notify_lock = *new std::mutex;
+static std::condition_variable &notify_cv = *new std::condition_variable;
+static uint32_t notify_count;
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void)
+{
+    return new sim_semaphore;
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t ticks)
+{
+    (void)ticks;
+    sem->m.lock();
+    return pdTRUE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t sem)
+{
+    sem->m.unlock();
+    return pdTRUE;
+}
+
+/* Only one task, the erase ahead task */
+BaseType_t xTaskCreate(TaskFunction_t fn, const char *name, uint16_t stack_depth,
+    void *arg, UBaseType_t priority, TaskHandle_t *handle)
+{
+    (void)name;
+    (void)stack_depth;
+    (void)priority;
+
+    sim_task *task = new sim_task;
+    task->thread = std::thread([fn, arg]() {
+        cpu.lock();
+        fn(arg);
+    });
+    task->thread.detach();
+    *handle = task;
+    return pdPASS;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task)
+{
+    (void)task;
+    std::lock_guard<std::mutex> lock(notify_lock);
+    notify_count++;
+    notify_cv.notify_one();
+    return pdPASS;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear, TickType_t ticks)
+{
+    (void)ticks;
+    cpu.unlock();
+
+    std::unique_lock<std::mutex> lock(notify_lock);
+    notify_cv.wait(lock, [] { return notify_count > 0; });
+    uint32_t count = notify_count;
+    notify_count = clear ? 0 : count - 1;
+    lock.unlock();
+
+    cpu.lock();
+    return count;
+}
+
+void vTaskDelay(TickType_t ticks)
+{
+    cpu.unlock();
+    std::this_thread::sleep_for(std::chrono::milliseconds(ticks));
+    cpu.lock();
+}
+
+TickType_t xTaskGetTickCount(void)
+{
+    return (TickType_t)std::chrono::duration_cast<std::chrono::milliseconds>(
+        sim_clock::now().time_since_epoch()).count();
+}
+
+/* The task holds the CPU until it delays, nothing to suspend */
+void vTaskSuspendAll(void)
+{
+}
+
+BaseType_t xTaskResumeAll(void)
+{
+    return pdFALSE;
+}
+
+/* Streams ------------------------------------------------------------------ */
+
+typedef struct {
+    const char *name;
+    uint32_t write_bytes;
+    uint32_t writes_per_s;
+    uint32_t seconds;
+    uint32_t lead_bytes;
+} stream_t;
+
+#define HEADER_BYTES 64
+
+static uint8_t stream_byte(uint32_t seed, uint32_t ix)
+{
+    return (uint8_t)(seed + ix * 7 + (ix >> 8));
+}
+
+static void run_stream(const stream_t *s, uint32_t seed)
+{
+    uint32_t n_writes = s->writes_per_s * s->seconds;
+    uint32_t total = HEADER_BYTES + n_writes * s->write_bytes;
+    std::vector<uint8_t> buf(total);
+    /* Time spent in stream_write, what the sampler's buffering has to cover.
+       Host wake-up jitter is not part of it. */
+    double max_call_ms = 0;
+
+    for (uint32_t ix = 0; ix < total; ix++) {
+        buf[ix] = stream_byte(seed, ix);
+    }
+
+    flash.n_programs = 0;
+    flash.n_erases = 0;
+    flash.violations = 0;
+
+    sim_clock::time_point t = sim_clock::now();
+    CHECK(ei_eta_fs_erase_ahead_start(total + ei_eta_fs_get_block_size(), s->lead_bytes) == ETA_FS_CMD_OK);
+    double start_ms = std::chrono::duration<double, std::milli>(sim_clock::now() - t).count();
+
+    CHECK(ei_eta_fs_write_samples(&buf[0], 0, HEADER_BYTES) == ETA_FS_CMD_OK);
+    CHECK(ei_eta_fs_stream_begin(HEADER_BYTES) == ETA_FS_CMD_OK);
+
+    sim_clock::time_point begin = sim_clock::now();
+    std::chrono::nanoseconds period(1000000000ull / s->writes_per_s);
+
+    for (uint32_t i = 0; i < n_writes; i++) {
+        sim_clock::time_point due = begin + period * i;
+
+        cpu.unlock();
+        std::this_thread::sleep_until(due);
+        cpu.lock();
+
+        sim_clock::time_point call = sim_clock::now();
+        CHECK(ei_eta_fs_stream_write(&buf[HEADER_BYTES + i * s->write_bytes], s->write_bytes) == ETA_FS_CMD_OK);
+        sim_clock::time_point end = sim_clock::now();
+
+        double call_ms = std::chrono::duration<double, std::milli>(end - call).count();
+        if (call_ms > max_call_ms) max_call_ms = call_ms;
+
+    }
+
+    CHECK(ei_eta_fs_stream_flush() == ETA_FS_CMD_OK);
+
+    std::vector<uint8_t> read(total);
+    CHECK(ei_eta_fs_read_sample_data(&read[0], 0, total) == ETA_FS_CMD_OK);
+    CHECK(memcmp(&read[0], &buf[0], total) == 0);
+    CHECK(flash.violations == 0);
+
+    printf("%-12s %7u bytes, start %6.1f ms, longest write %5.1f ms, "
+        "%3u erases, %4u programs, %u violations\n",
+        s->name, (unsigned)total, start_ms, max_call_ms,
+        (unsigned)flash.n_erases, (unsigned)flash.n_programs, (unsigned)flash.violations);
+}
+
+int main(int argc, char **argv)
+{
+    static const stream_t streams[] = {
+        /* ~15 CBOR bytes per 3-axis sample */
+        { "IMU 100 Hz", 15, 100, 5, ETA_FS_ERASE_AHEAD_LEAD },
+        { "IMU 1 kHz", 15, 1000, 3, ETA_FS_ERASE_AHEAD_LEAD },
+        /* 16 ms PCM frames */
+        { "Audio 16 kHz", 512, 16000 / 256, 3, MX25R_BLOCK64_SIZE },
+    };
+
+    flash.erase_scale = (argc > 1) ? atof(argv[1]) : 1.0;
+    flash.mem.assign(MX25R_CHIP_SIZE, 0xa5);
+    flash.erased.assign(MX25R_CHIP_SIZE, 0);
+
+    cpu.lock();
+
+    /* Streaming without stream_begin() has no flash lock */
+    uint8_t word[4] = { 0 };
+    CHECK(ei_eta_fs_stream_write(word, sizeof(word)) == ETA_FS_CMD_NOT_INIT);
+
+    printf("Erase times x%.1f\n", flash.erase_scale);
+    for (size_t ix = 0; ix < sizeof(streams) / sizeof(streams[0]); ix++) {
+        run_stream(&streams[ix], (uint32_t)ix * 31 + 1);
+    }
+
+    printf("%s (%d failures)\n", failures ? "FAILED" : "OK", failures);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,7 @@
+#ifndef FLASH_STREAM_SIM_CONFIG_H
+#define FLASH_STREAM_SIM_CONFIG_H
+
+#define CONFIG_AI_VISION_BOARD      0
+#define CONFIG_SPI_FLASH_SPI_NUM    1
+
+#endif
@@ -0,0 +1,3 @@
+# Build the host test of the PDM frame ring, run ./frame_ring_test
+g++ -O2 -Wall -Wextra -pthread -o frame_ring_test \
+    -I../../Applications/edge-impulse-ingestion/src/sensors frame_ring_test.cpp
@@ -0,0 +1,195 @@
+/* The Clear BSD License
+ *
+ * Copyright (c) 2025 EdgeImpulse Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the disclaimer
+ * below) provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ *   * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ *
+ *   * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from this
+ *   software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE GRANTED BY
+ * THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ * CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+/*
+ * Host test of the PDM frame ring (ei_frame_ring.h). Checks ordering, the
+ * full-ring drop and the high-water mark on a single thread, then runs a
+ * producer thread at a fixed frame rate against a consumer with random
+ * stalls, and checks that every frame arrives once, in order, and that the
+ * gaps in the sequence match the dropped-frame count.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <thread>
+#include <chrono>
+#include <atomic>
+
+#include "ei_frame_ring.h"
+
+static int failures = 0;
+
+#define CHECK(cond) do { if (!(cond)) { printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); failures++; } } while (0)
+
+static ei_frame_ring_t ring;
+
+static void push_seq(uint32_t seq)
+{
+    int16_t frame[EI_FRAME_RING_SAMPLES];
+    for (size_t ix = 0; ix < EI_FRAME_RING_SAMPLES; ix++) {
+        frame[ix] = (int16_t)(seq + ix);
+    }
+    ei_frame_ring_push(&ring, frame, sizeof(frame));
+}
+
+static bool frame_ok(const int16_t *frame, uint16_t n_bytes, uint32_t *seq)
+{
+    *seq = (uint16_t)frame[0];
+    for (size_t ix = 0; ix < EI_FRAME_RING_SAMPLES; ix++) {
+        if (frame[ix] != (int16_t)(*seq + ix)) {
+            return false;
+        }
+    }
+    return n_bytes == EI_FRAME_RING_SAMPLES * sizeof(int16_t);
+}
+
+static void test_single_thread(void)
+{
+    ei_frame_ring_reset(&ring);
+
+    /* the pool takes exactly EI_FRAME_RING_COUNT frames, the next is dropped */
+    for (uint32_t seq = 0; seq < EI_FRAME_RING_COUNT + 1; seq++) {
+        push_seq(seq);
+    }
+    CHECK(ei_frame_ring_ready(&ring) == EI_FRAME_RING_COUNT);
+    CHECK(ring.overruns == 1);
+    CHECK(ring.high_water == EI_FRAME_RING_COUNT);
+
+    for (uint32_t expect = 0; expect < EI_FRAME_RING_COUNT; expect++) {
+        uint16_t n_bytes;
+        uint32_t seq;
+        const int16_t *frame = ei_frame_ring_front(&ring, &n_bytes);
+        CHECK(frame_ok(frame, n_bytes, &seq));
+        CHECK(seq == expect);
+        ei_frame_ring_pop(&ring);
+    }
+    CHECK(ei_frame_ring_ready(&ring) == 0);
+
+    /* indexes keep running across the wrap, oversized frames are truncated */
+    int16_t big[EI_FRAME_RING_SAMPLES * 2] = { 0 };
+    CHECK(ei_frame_ring_push(&ring, big, sizeof(big)));
+    uint16_t n_bytes;
+    ei_frame_ring_front(&ring, &n_bytes);
+    CHECK(n_bytes == sizeof(ring.pool[0]));
+
+    /* flush keeps the statistics, reset clears them */
+    ei_frame_ring_flush(&ring);
+    CHECK(ring.head == ring.tail && ring.high_water == EI_FRAME_RING_COUNT && ring.overruns == 1);
+    ei_frame_ring_reset(&ring);
+    CHECK(ring.high_water == 0 && ring.overruns == 0);
+}
+
+static void test_threads(uint32_t n_frames, uint32_t frame_us, uint32_t max_stall_us)
+{
+    std::atomic<bool> done(false);
+    uint32_t received = 0, gaps = 0, max_ready = 0;
+    uint32_t last = 0xffffffff;
+    bool order_ok = true, data_ok = true;
+
+    ei_frame_ring_reset(&ring);
+
+    std::thread producer([&]() {
+        auto next = std::chrono::steady_clock::now();
+        for (uint32_t seq = 0; seq < n_frames; seq++) {
+            push_seq(seq);
+            next += std::chrono::microseconds(frame_us);
+            std::this_thread::sleep_until(next);
+        }
+        done = true;
+    });
+
+    srand(1);
+    while (!done || ei_frame_ring_ready(&ring) != 0) {
+        uint32_t n_ready = ei_frame_ring_ready(&ring);
+        if (n_ready > max_ready) {
+            max_ready = n_ready;
+        }
+        if (n_ready == 0) {
+            std::this_thread::sleep_for(std::chrono::microseconds(50));
+            continue;
+        }
+
+        uint16_t n_bytes;
+        uint32_t seq;
+        const int16_t *frame = ei_frame_ring_front(&ring, &n_bytes);
+        if (!frame_ok(frame, n_bytes, &seq)) {
+            data_ok = false;
+        }
+        ei_frame_ring_pop(&ring);
+
+        /* sequence numbers are 16 bit in the frame */
+        uint32_t expect = (uint16_t)(last + 1);
+        if (last != 0xffffffff && seq != expect) {
+            if ((uint16_t)(seq - expect) > 0x8000) {
+                order_ok = false;
+            }
+            gaps += (uint16_t)(seq - expect);
+        }
+        last = seq;
+        received++;
+
+        if (max_stall_us && (rand() % 64) == 0) {
+            std::this_thread::sleep_for(std::chrono::microseconds(rand() % max_stall_us));
+        }
+    }
+    producer.join();
+
+    printf("%6u frames, stalls up to %6u us: received %6u, dropped %5u, high-water %2u of %d\n",
+        n_frames, max_stall_us, received, ring.overruns, ring.high_water, EI_FRAME_RING_COUNT);
+
+    CHECK(data_ok);
+    CHECK(order_ok);
+    CHECK(received + ring.overruns == n_frames);
+    CHECK(gaps == ring.overruns);
+    CHECK(ring.high_water == max_ready);
+    CHECK(ring.high_water <= EI_FRAME_RING_COUNT);
+    /* frames are only dropped from a full ring */
+    CHECK(ring.overruns == 0 || ring.high_water == EI_FRAME_RING_COUNT);
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t n_frames = argc > 1 ? atoi(argv[1]) : 4000;
+
+    test_single_thread();
+
+    /* 16 ms frames scaled down to 200 us, stalls short of and beyond the ring */
+    test_threads(n_frames, 200, 0);
+    test_threads(n_frames, 200, 200 * (EI_FRAME_RING_COUNT / 4));
+    test_threads(n_frames, 200, 200 * EI_FRAME_RING_COUNT * 3);
+
+    printf(failures ? "FAILED (%d)\n" : "OK\n", failures);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,37 @@
+/* Host stand-in for FreeRTOS, shared by the host harnesses in Tools/. Each
+ * harness implements the functions it uses on top of threads */
+#ifndef HOST_STUB_FREERTOS_H
+#define HOST_STUB_FREERTOS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef long BaseType_t;
+typedef unsigned long UBaseType_t;
+typedef uint32_t TickType_t;
+
+#define pdTRUE              1
+#define pdFALSE             0
+#define pdPASS              1
+#define portMAX_DELAY       ((TickType_t)0xffffffffUL)
+#define tskIDLE_PRIORITY    0
+/* 1 ms ticks */
+#define pdMS_TO_TICKS(ms)   ((TickType_t)(ms))
+
+#define portYIELD_FROM_ISR(x)   (void)(x)
+
+void *pvPortMalloc(size_t size);
+void vPortFree(void *ptr);
+BaseType_t xPortIsInsideInterrupt(void);
+void vPortEnterCritical(void);
+void vPortExitCritical(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
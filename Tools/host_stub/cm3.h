@@ -0,0 +1 @@
+/* Nothing from the Cortex-M3 core header is needed on the host */
@@ -0,0 +1,23 @@
+/* LEDs of the board */
+#ifndef HOST_STUB_ETA_BSP_H
+#define HOST_STUB_ETA_BSP_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define ETA_BSP_LED0    0
+#define ETA_BSP_LED1    1
+#define ETA_BSP_LED2    2
+#define ETA_BSP_LED3    3
+#define ETA_BSP_LED4    4
+
+void EtaBspLedSet(int led);
+void EtaBspLedsClearAll(void);
+void EtaBspLedsSetAll(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,23 @@
+/* Host stand-in for the CSP, only what the camera driver headers use */
+#ifndef HOST_STUB_ETA_CSP_INC_H
+#define HOST_STUB_ETA_CSP_INC_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    eGpioBit0 = 0, eGpioBit1, eGpioBit2, eGpioBit3, eGpioBit4, eGpioBit5, eGpioBit6, eGpioBit7,
+    eGpioBit24 = 24,
+} tGpioBit;
+
+void EtaCspGpioDriveHighSet(tGpioBit iBit);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
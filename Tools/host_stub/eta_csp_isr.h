@@ -0,0 +1 @@
+/* Nothing from eta_csp_isr.h is used on the host */
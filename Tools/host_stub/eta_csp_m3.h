@@ -0,0 +1,20 @@
+/* Only the flash info of the M3 CSP is used by the harnesses */
+#ifndef HOST_STUB_ETA_CSP_M3_H
+#define HOST_STUB_ETA_CSP_M3_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define ETA_CSP_FLASH_PAGE_SIZE_BYTES   4096
+#define ETA_CSP_FLASH_PAGE_SIZE_WORDS   (ETA_CSP_FLASH_PAGE_SIZE_BYTES / 4)
+
+void EtaCspFlashInfoGet(uint32_t address, uint8_t *buf, uint32_t size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
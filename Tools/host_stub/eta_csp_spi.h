@@ -0,0 +1,31 @@
+/* Host stand-in for the SPI CSP, flash_stream_sim models the MX25R behind it */
+#ifndef HOST_STUB_ETA_CSP_SPI_H
+#define HOST_STUB_ETA_CSP_SPI_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum { eEtaSuccess = 0, eEtaFailure = 1 } tEtaStatus;
+typedef enum { eSpi0 = 0, eSpi1 = 1 } tSpiNum;
+typedef enum { eSpiChipSel0 = 0, eSpiChipSel1, eSpiChipSel2, eSpiChipSel3 } tSpiChipSel;
+typedef enum {
+    eSpiSequenceMiddle = 0,
+    eSpiSequenceFirstOnly = 1,
+    eSpiSequenceLastOnly = 2,
+    eSpiSequenceFirstLast = 3,
+} tSpiSequence;
+
+tEtaStatus EtaCspSpiTransferPoll(tSpiNum iNum, uint8_t *pui8TxData,
+                                 uint32_t ui32TxLen,
+                                 uint8_t *pui8RxData, uint32_t ui32RxLen,
+                                 tSpiChipSel spiChipSel,
+                                 tSpiSequence iSpiSequence);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,17 @@
+/* Only the delay of the timer CSP is declared */
+#ifndef HOST_STUB_ETA_CSP_TIMER_H
+#define HOST_STUB_ETA_CSP_TIMER_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void EtaCspTimerDelayMs(uint32_t ms);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
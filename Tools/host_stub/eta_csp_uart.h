@@ -0,0 +1,38 @@
+/* UART of the CSP, uart_tx_sim models it: 16 byte TX FIFO, one byte out per bit time x 10 */
+#ifndef HOST_STUB_ETA_CSP_UART_H
+#define HOST_STUB_ETA_CSP_UART_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    eUartBaud115200 = 115200,
+    eUartBaud921600 = 921600,
+} tUartBaud;
+
+typedef enum {
+    eUartFlowControlNone,
+} tUartFlowControl;
+
+typedef int tUartNum;
+
+typedef struct {
+    int num;
+} tUart;
+
+void EtaCspUartInit(tUart *uart, tUartNum num, tUartBaud baud, tUartFlowControl flow);
+void EtaCspUartBaudSet(tUart *uart, tUartBaud baud);
+void EtaCspUartPutc(tUart *uart, char c);
+void EtaCspUartPuts(tUart *uart, char *s);
+void EtaCspUartTxWait(tUart *uart);
+uint32_t EtaCspUartRxFifoDepthGet(tUart *uart);
+char EtaCspUartGetc(tUart *uart, int wait);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
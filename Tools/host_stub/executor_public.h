@@ -0,0 +1 @@
+/* Nothing from executor_public.h is used on the host */
@@ -0,0 +1,41 @@
+#ifndef HOST_STUB_GPIO_HAL_H
+#define HOST_STUB_GPIO_HAL_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    HalGpioPullNone = 0,
+    HalGpioPullUp = 1,
+    HalGpioPullDown = 2
+} tHalGpioPull;
+
+typedef enum {
+    HalGpioTrigLow = 0,
+    HalGpioTrigHigh = 1
+} tHalGpioIntTrig;
+
+typedef enum {
+    HalGpioIRQ0 = 0,
+    HalGpioIRQ1 = 1,
+} tHalGpioIRQ;
+
+typedef void (*tHalGpioIntHandler)(void *pArg);
+
+int32_t HalGpioInInit(uint32_t ui32Gpio, tHalGpioPull iPull);
+int32_t HalGpioOutInit(uint32_t ui32Gpio, bool bVal);
+int HalGpioIntInit(uint32_t ui32Gpio, tHalGpioIRQ iGpioIrq, tHalGpioIntHandler fIntHandler,
+                    void *vArg, tHalGpioIntTrig iTrig, tHalGpioPull iPull);
+void HalGpioIntEnable(tHalGpioIRQ iGpioIrq, uint32_t ui32Gpio);
+void HalGpioIntDisable(tHalGpioIRQ iGpioIrq, uint32_t ui32Gpio);
+void HalGpioIntClear(tHalGpioIRQ iGpioIrq, uint32_t ui32Gpio);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
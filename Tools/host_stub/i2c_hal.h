@@ -0,0 +1,23 @@
+#ifndef HOST_STUB_I2C_HAL_H
+#define HOST_STUB_I2C_HAL_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef void (*tHalI2cCb)(void *);
+
+int32_t HalI2cRead(uint8_t ui8I2cNum, uint8_t ui8SlaveAddr, uint16_t ui16Offset,
+                uint8_t ui8OffsetLen, uint8_t *ui8RxBuf, uint32_t ui32RxLen,
+                tHalI2cCb fI2cCb, void *vPtr);
+int32_t HalI2cWrite(uint8_t ui8I2cNum, uint8_t ui8SlaveAddr, uint16_t ui16Offset,
+                uint8_t ui8OffsetLen, uint8_t *ui8TxBuf, uint32_t ui32TxLen,
+                tHalI2cCb fI2cCb, void *vPtr);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,14 @@
+#ifndef HOST_STUB_PRINT_UTIL_H
+#define HOST_STUB_PRINT_UTIL_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+int ecm35xx_printf(const char *format, ...);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,34 @@
+#ifndef HOST_STUB_TASK_H
+#define HOST_STUB_TASK_H
+
+#include "FreeRTOS.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct sim_task *TaskHandle_t;
+typedef void (*TaskFunction_t)(void *);
+
+#define taskSCHEDULER_NOT_STARTED   1
+#define taskSCHEDULER_RUNNING       2
+
+#define taskENTER_CRITICAL()        vPortEnterCritical()
+#define taskEXIT_CRITICAL()         vPortExitCritical()
+
+BaseType_t xTaskCreate(TaskFunction_t fn, const char *name, uint16_t stack_depth,
+    void *arg, UBaseType_t priority, TaskHandle_t *handle);
+BaseType_t xTaskNotifyGive(TaskHandle_t task);
+uint32_t ulTaskNotifyTake(BaseType_t clear, TickType_t ticks);
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task);
+void vTaskDelay(TickType_t ticks);
+TickType_t xTaskGetTickCount(void);
+BaseType_t xTaskGetSchedulerState(void);
+void vTaskSuspendAll(void);
+BaseType_t xTaskResumeAll(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
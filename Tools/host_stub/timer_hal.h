@@ -0,0 +1,33 @@
+#ifndef HOST_STUB_TIMER_HAL_H
+#define HOST_STUB_TIMER_HAL_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    HalTmrOneShot = 0,
+    HalTmrPeriodic,
+} tHalTmrType;
+
+typedef enum {
+    HalTmrCh0 = 0,
+    HalTmrCh1,
+    HalTmrCh2,
+} tHalTmrCh;
+
+typedef struct sim_tmr tHalTmr;
+typedef void (*tHalTmrCb)(void *vArg);
+
+tHalTmr *HalTmrCreate(tHalTmrCh iTmrCh, tHalTmrType iTmrType, uint32_t ui32TmrPeriod,
+    tHalTmrCb fTmrCb, void *vArg);
+int32_t HalTmrStart(tHalTmr *sHalTmr);
+int32_t HalTmrDelay(tHalTmrCh iTmrCh, uint32_t ui32Ticks);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
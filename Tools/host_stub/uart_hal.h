@@ -0,0 +1,20 @@
+#ifndef HOST_STUB_UART_HAL_H
+#define HOST_STUB_UART_HAL_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef uint32_t (*tHalUartTxFillCb)(uint8_t *pui8Buf, uint32_t ui32Max,
+                                     void *vArg);
+
+int32_t HalUartTxFillStart(uint8_t ui8Port, tHalUartTxFillCb fTxFillCb,
+                           void *vCbArg);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,6 @@
+# Build the host simulation of the serial TX ring, run ./uart_tx_sim
+EI=../../Thirdparty/edge_impulse
+g++ -O2 -Wall -Wextra -Wno-unused-parameter -pthread -ffunction-sections -Wl,--gc-sections \
+    -o uart_tx_sim -Istub -I../host_stub -I$EI -I$EI/ingestion-sdk-platform/eta-compute -I$EI/ingestion-sdk-c \
+    -I$EI/repl -I../../Applications/edge-impulse-ingestion/src/sensors \
+    uart_tx_sim.cpp $EI/ingestion-sdk-platform/eta-compute/ei_device_eta_ecm3532.cpp
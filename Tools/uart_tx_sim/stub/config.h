@@ -0,0 +1,28 @@
+/* Host build of the sensor board configuration, interrupt masking of the
+ * serial TX ring replaced by the UART model in uart_tx_sim.cpp */
+#ifndef UART_TX_SIM_CONFIG_H
+#define UART_TX_SIM_CONFIG_H
+
+#include <stdint.h>
+
+#define CONFIG_AI_SENSOR_BOARD      1
+#define CONFIG_DEBUG_UART           0
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+uint32_t sim_primask_get(void);
+void sim_primask_set(uint32_t primask);
+void sim_irq_disable(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#define EI_TX_PRIMASK_GET(v)    ((v) = sim_primask_get())
+#define EI_TX_BASEPRI_GET(v)    ((v) = 0)
+#define EI_TX_PRIMASK_SET(v)    sim_primask_set(v)
+#define EI_TX_IRQ_DISABLE()     sim_irq_disable()
+
+#endif
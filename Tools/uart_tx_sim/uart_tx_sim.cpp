@@ -0,0 +1,657 @@
+/* The Clear BSD License
+ *
+ * Copyright (c) 2025 EdgeImpulse Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the disclaimer
+ * below) provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ *   * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ *
+ *   * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from this
+ *   software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE GRANTED BY
+ * THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ * CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+/*
+ * Host simulation of the serial TX ring. Builds the real
+ * ei_device_eta_ecm3532.cpp against a model of the debug UART: a 16 byte TX
+ * FIFO shifted out at a fixed byte rate and a TX interrupt that refills it
+ * from the fill callback below the low water mark, like uart_hal.c. Threads
+ * stand in for tasks, ISRs and code running with interrupts masked, all at
+ * the same time, which is harsher than the single core. Masking interrupts
+ * and running the UART interrupt both hold the irq lock, a masked UART
+ * interrupt stays pending until the mask is lifted.
+ *
+ * Every message carries its writer and sequence number, the wire is checked
+ * for each message delivered exactly once and in one piece, per writer
+ * order, and the drop count of the non blocking writes.
+ *
+ * ei_format_float is checked bit exact against snprintf("%.*f") for every
+ * decimal count, on random floats, round half to even ties, denormals and
+ * the special values.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <deque>
+#include <vector>
+#include <algorithm>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+
+#include "ei_device_eta_ecm3532.h"
+#include "ei_eta_fs_commands.h"
+#include "ei_inertialsensor.h"
+#include "ei_microphone.h"
+#include "eta_csp_timer.h"
+#include "eta_csp_uart.h"
+#include "uart_hal.h"
+#include "semphr.h"
+#include "task.h"
+
+typedef std::chrono::steady_clock sim_clock;
+
+#define UART_TX_FIFO_SIZE       16
+#define UART_TX_FIFO_LWM        8
+/* About 4 Mbaud, fast enough to keep the run short, slow enough to fill the ring */
+#define UART_BYTE_NS            2500
+
+static int failures = 0;
+
+#define CHECK(cond) do { if (!(cond)) { printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); failures++; } } while (0)
+
+/* Interrupt masking ----------------------------------------------------------- */
+
+/* Held while interrupts are masked or the UART interrupt runs */
+static std::recursive_mutex irq;
+static thread_local uint32_t primask = 0;
+static thread_local bool in_isr = false;
+
+uint32_t sim_primask_get(void)
+{
+    return primask;
+}
+
+void sim_irq_disable(void)
+{
+    if (!primask) {
+        irq.lock();
+        primask = 1;
+    }
+}
+
+void sim_primask_set(uint32_t value)
+{
+    if (value) {
+        sim_irq_disable();
+    }
+    else if (primask) {
+        primask = 0;
+        irq.unlock();
+    }
+}
+
+/* taskENTER_CRITICAL / taskEXIT_CRITICAL mask interrupts, as on the M3 */
+void vPortEnterCritical(void)
+{
+    sim_irq_disable();
+}
+
+void vPortExitCritical(void)
+{
+    sim_primask_set(0);
+}
+
+/* UART model ------------------------------------------------------------------ */
+
+static struct {
+    std::mutex lock;
+    std::deque<uint8_t> fifo;
+    std::string wire;
+    /* set by HalUartTxFillStart, cleared when the fill callback returns 0 */
+    tHalUartTxFillCb fill;
+    void *fill_arg;
+    std::atomic<bool> running;
+    uint32_t interrupts;
+    uint32_t masked;
+} uart;
+
+static void uart_fifo_push(const uint8_t *buf, uint32_t count)
+{
+    std::lock_guard<std::mutex> guard(uart.lock);
+    for (uint32_t i = 0; i < count; i++) {
+        if (uart.fifo.size() >= UART_TX_FIFO_SIZE) {
+            printf("UART TX FIFO overrun\n");
+            failures++;
+            return;
+        }
+        uart.fifo.push_back(buf[i]);
+    }
+}
+
+static uint32_t uart_fifo_space(void)
+{
+    std::lock_guard<std::mutex> guard(uart.lock);
+    return UART_TX_FIFO_SIZE - (uint32_t)uart.fifo.size();
+}
+
+/* TX interrupt of uart_hal.c, called with the irq lock held */
+static void uart_tx_isr(void)
+{
+    uint8_t buf[UART_TX_FIFO_SIZE];
+    uint32_t space = uart_fifo_space();
+
+    if (!uart.fill || space < UART_TX_FIFO_SIZE - UART_TX_FIFO_LWM) {
+        return;
+    }
+
+    in_isr = true;
+    uint32_t count = uart.fill(buf, space, uart.fill_arg);
+    in_isr = false;
+    uart.interrupts++;
+
+    if (count) {
+        uart_fifo_push(buf, count);
+    }
+    else {
+        uart.fill = NULL;
+    }
+}
+
+/* Shift register and interrupt line */
+static void uart_thread(void)
+{
+    sim_clock::time_point last = sim_clock::now();
+
+    while (uart.running) {
+        std::this_thread::sleep_for(std::chrono::microseconds(20));
+
+        sim_clock::time_point now = sim_clock::now();
+        uint64_t bytes = std::chrono::duration_cast<std::chrono::nanoseconds>(now - last).count() / UART_BYTE_NS;
+        if (bytes == 0) {
+            continue;
+        }
+        last = now;
+
+        {
+            std::lock_guard<std::mutex> guard(uart.lock);
+            while (bytes-- && !uart.fifo.empty()) {
+                uart.wire.push_back((char)uart.fifo.front());
+                uart.fifo.pop_front();
+            }
+        }
+
+        if (irq.try_lock()) {
+            uart_tx_isr();
+            irq.unlock();
+        }
+        else {
+            uart.masked++;
+        }
+    }
+}
+
+void EtaCspUartInit(tUart *dev, tUartNum num, tUartBaud baud, tUartFlowControl flow)
+{
+    dev->num = num;
+}
+
+void EtaCspUartPutc(tUart *dev, char c)
+{
+    uint8_t byte = (uint8_t)c;
+
+    while (uart_fifo_space() == 0) {
+        std::this_thread::yield();
+    }
+    uart_fifo_push(&byte, 1);
+}
+
+void EtaCspUartTxWait(tUart *dev)
+{
+    for (;;) {
+        {
+            std::lock_guard<std::mutex> guard(uart.lock);
+            if (uart.fifo.empty()) {
+                return;
+            }
+        }
+        std::this_thread::yield();
+    }
+}
+
+/* The UART interrupt is disabled in the NVIC while the FIFO is primed */
+int32_t HalUartTxFillStart(uint8_t port, tHalUartTxFillCb fill, void *arg)
+{
+    std::lock_guard<std::recursive_mutex> guard(irq);
+
+    if (uart.fill) {
+        return 0;
+    }
+
+    uint8_t buf[UART_TX_FIFO_SIZE];
+    uint32_t space = uart_fifo_space();
+    uint32_t count = space ? fill(buf, space, arg) : 0;
+
+    if (count) {
+        uart_fifo_push(buf, count);
+    }
+    if (count || !space) {
+        uart.fill = fill;
+        uart.fill_arg = arg;
+    }
+
+    return 0;
+}
+
+/* FreeRTOS stand-in ----------------------------------------------------------- */
+
+struct sim_semaphore {
+    std::mutex lock;
+};
+
+static std::atomic<BaseType_t> scheduler_state(taskSCHEDULER_NOT_STARTED);
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void)
+{
+    return new sim_semaphore;
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t ticks)
+{
+    if (ticks == portMAX_DELAY) {
+        sem->lock.lock();
+        return pdTRUE;
+    }
+
+    return sem->lock.try_lock() ? pdTRUE : pdFALSE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t sem)
+{
+    sem->lock.unlock();
+    return pdTRUE;
+}
+
+BaseType_t xTaskGetSchedulerState(void)
+{
+    return scheduler_state;
+}
+
+BaseType_t xPortIsInsideInterrupt(void)
+{
+    return in_isr;
+}
+
+void vTaskDelay(TickType_t ticks)
+{
+    std::this_thread::sleep_for(std::chrono::milliseconds(ticks));
+}
+
+/* Kept by the device vtable, not called --------------------------------------- */
+
+uint32_t ei_eta_fs_get_block_size(void) { return 0; }
+uint32_t ei_eta_fs_get_n_available_sample_blocks(void) { return 0; }
+bool ei_inertial_setup_data_sampling(void) { return false; }
+bool ei_microphone_sample_start(void) { return false; }
+void EtaCspTimerDelayMs(uint32_t ms) { }
+
+/* Writers --------------------------------------------------------------------- */
+
+typedef enum {
+    WRITER_TASK,            /* ei_printf, blocking */
+    WRITER_TASK_NB,         /* ei_write, drops what does not fit */
+    WRITER_ISR,             /* ei_write from an interrupt handler */
+    WRITER_MASKED,          /* ei_printf with interrupts masked */
+} writer_type_t;
+
+typedef struct {
+    writer_type_t type;
+    int id;
+    int count;
+    /* length of each message, the ring is 2048 bytes */
+    int length;
+    /* messages ei_write queued in full */
+    std::vector<bool> sent;
+    size_t bytes_queued;
+} writer_t;
+
+/* "<id:seq:" + filler + ">\n", filler depends on id and seq */
+static std::string make_message(int id, int seq, int length)
+{
+    char head[32];
+    int n = snprintf(head, sizeof(head), "<%d:%d:", id, seq);
+    std::string msg(head, n);
+
+    while ((int)msg.size() < length - 2) {
+        msg.push_back((char)('a' + (id * 7 + seq + msg.size()) % 26));
+    }
+    msg += ">\n";
+
+    return msg;
+}
+
+static void writer_thread(writer_t *w)
+{
+    for (int seq = 0; seq < w->count; seq++) {
+        std::string msg = make_message(w->id, seq, w->length);
+
+        switch (w->type) {
+        case WRITER_TASK:
+            ei_printf("%s", msg.c_str());
+            break;
+        case WRITER_TASK_NB:
+        case WRITER_ISR: {
+            in_isr = (w->type == WRITER_ISR);
+            size_t queued = ei_write(msg.data(), msg.size());
+            in_isr = false;
+            w->sent[seq] = (queued == msg.size());
+            w->bytes_queued += queued;
+            break;
+        }
+        case WRITER_MASKED:
+            sim_irq_disable();
+            ei_printf("%s", msg.c_str());
+            sim_primask_set(0);
+            break;
+        }
+
+        if (seq % 16 == 0) {
+            std::this_thread::yield();
+        }
+    }
+}
+
+static size_t count_occurrences(const std::string &wire, const std::string &msg)
+{
+    size_t n = 0;
+
+    for (size_t pos = wire.find(msg); pos != std::string::npos; pos = wire.find(msg, pos + 1)) {
+        n++;
+    }
+
+    return n;
+}
+
+/* ei_format_float ------------------------------------------------------------ */
+
+static uint32_t format_float_seed = 12345;
+
+static uint32_t format_float_rand(void)
+{
+    /* xorshift32, reproducible */
+    format_float_seed ^= format_float_seed << 13;
+    format_float_seed ^= format_float_seed >> 17;
+    format_float_seed ^= format_float_seed << 5;
+    return format_float_seed;
+}
+
+/* Returns 1 on a mismatch, prints the first few */
+static int format_float_check(float f, int decimals)
+{
+    static int printed = 0;
+    char ref[512], out[EI_FORMAT_FLOAT_MAX_SIZE];
+
+    int ref_length = snprintf(ref, sizeof(ref), "%.*f", decimals, (double)f);
+    int length = ei_format_float(out, sizeof(out), f, decimals);
+
+    if (length == ref_length && strcmp(out, ref) == 0) {
+        return 0;
+    }
+    if (printed++ < 10) {
+        uint32_t bits;
+        memcpy(&bits, &f, sizeof(bits));
+        printf("ei_format_float(0x%08x, %d): \"%s\", snprintf: \"%s\"\n",
+            (unsigned)bits, decimals, length >= 0 ? out : "(-1)", ref);
+    }
+    return 1;
+}
+
+static float float_from_bits(uint32_t bits)
+{
+    float f;
+    memcpy(&f, &bits, sizeof(f));
+    return f;
+}
+
+static void test_format_float(void)
+{
+    int mismatches = 0;
+    uint32_t checked = 0;
+
+    for (int decimals = 0; decimals <= EI_FORMAT_FLOAT_MAX_DECIMALS; decimals++) {
+        /* Random bit patterns, all exponents, both signs */
+        for (int i = 0; i < 200000; i++) {
+            mismatches += format_float_check(float_from_bits(format_float_rand()), decimals);
+        }
+        /* Values a classifier prints, 0 .. 1 and small magnitudes */
+        for (int i = 0; i < 200000; i++) {
+            float f = (float)(format_float_rand() & 0xffffff) / (float)0x1000000;
+            mismatches += format_float_check((i & 1) ? -f : f, decimals);
+        }
+        /* Every float with a short mantissa around the rounding point: the
+         * ties k / 2^n + 5 * 10^-(decimals + 1) */
+        for (int n = 1; n <= 24; n++) {
+            for (uint32_t k = 0; k < 64; k++) {
+                float tie = (float)k / (float)(1 << n);
+                uint32_t bits;
+                memcpy(&bits, &tie, sizeof(bits));
+                for (int d = -2; d <= 2; d++) {
+                    mismatches += format_float_check(float_from_bits(bits + d), decimals);
+                }
+            }
+        }
+        checked += 400000 + 24 * 64 * 5;
+    }
+
+    /* Exact ties round half to even, like the C library */
+    static const float ties[] = { 0.5f, 1.5f, 2.5f, 0.125f, 0.375f, 0.0625f, 1048576.5f };
+    for (size_t i = 0; i < sizeof(ties) / sizeof(ties[0]); i++) {
+        for (int decimals = 0; decimals <= 4; decimals++) {
+            mismatches += format_float_check(ties[i], decimals);
+            mismatches += format_float_check(-ties[i], decimals);
+        }
+    }
+
+    /* Denormals, zero, limits and specials */
+    static const uint32_t specials[] = {
+        0x00000000, 0x80000000, 0x00000001, 0x007fffff, 0x00800000,
+        0x7f7fffff, 0xff7fffff, 0x5f000000, 0x5effffff, 0x4b800000,
+        0x7f800000, 0xff800000, 0x7fc00000, 0xffc00000,
+    };
+    for (size_t i = 0; i < sizeof(specials) / sizeof(specials[0]); i++) {
+        for (int decimals = 0; decimals <= EI_FORMAT_FLOAT_MAX_DECIMALS; decimals++) {
+            mismatches += format_float_check(float_from_bits(specials[i]), decimals);
+        }
+    }
+
+    CHECK(mismatches == 0);
+
+    /* Decimals are clamped, a short buffer is refused */
+    char buf[EI_FORMAT_FLOAT_MAX_SIZE];
+    CHECK(ei_format_float(buf, sizeof(buf), 1.25f, -3) == 1 && strcmp(buf, "1") == 0);
+    CHECK(ei_format_float(buf, sizeof(buf), 0.5f, 20) == 11 && strcmp(buf, "0.500000000") == 0);
+    CHECK(ei_format_float(buf, 5, 0.5f, 3) == 5 - 5 - 1);
+    CHECK(ei_format_float(buf, 6, 0.5f, 3) == 5 && strcmp(buf, "0.500") == 0);
+
+    printf("ei_format_float  %7u values, %d differ from snprintf\n", (unsigned)checked, mismatches);
+}
+
+static std::string wire_take(void)
+{
+    std::lock_guard<std::mutex> guard(uart.lock);
+    std::string wire;
+    wire.swap(uart.wire);
+    return wire;
+}
+
+static void run_writers(const char *name, std::vector<writer_t> &writers)
+{
+    ei_write_stats_t before, after;
+    std::vector<std::thread> threads;
+    size_t total = 0, queued = 0;
+
+    ei_write_get_stats(&before);
+
+    for (writer_t &w : writers) {
+        w.sent.assign(w.count, true);
+        w.bytes_queued = 0;
+        total += (size_t)w.count * w.length;
+    }
+    for (writer_t &w : writers) {
+        threads.emplace_back(writer_thread, &w);
+    }
+    for (std::thread &t : threads) {
+        t.join();
+    }
+
+    ei_write_flush();
+    ei_write_get_stats(&after);
+    std::string wire = wire_take();
+
+    int lost = 0, duplicated = 0, reordered = 0, dropped_msgs = 0;
+
+    /* Direct writes go out in one piece, possibly in the middle of a ring
+     * message. Cut them out, what is left has to be the ring messages. */
+    std::vector<std::pair<size_t, size_t> > cuts;
+    for (writer_t &w : writers) {
+        if (w.type != WRITER_ISR && w.type != WRITER_MASKED) {
+            continue;
+        }
+        size_t last = 0;
+        for (int seq = 0; seq < w.count; seq++) {
+            std::string msg = make_message(w.id, seq, w.length);
+            size_t n = count_occurrences(wire, msg);
+            size_t pos = wire.find(msg);
+            lost += (n == 0);
+            duplicated += (n > 1);
+            if (n == 1) {
+                reordered += (pos < last);
+                last = pos;
+                cuts.push_back(std::make_pair(pos, msg.size()));
+            }
+        }
+        queued += (size_t)w.count * w.length;
+    }
+    size_t wire_size = wire.size();
+    std::sort(cuts.begin(), cuts.end());
+    for (size_t i = cuts.size(); i-- > 0; ) {
+        wire.erase(cuts[i].first, cuts[i].second);
+    }
+
+    for (writer_t &w : writers) {
+        if (w.type == WRITER_ISR || w.type == WRITER_MASKED) {
+            continue;
+        }
+        size_t last = 0;
+        for (int seq = 0; seq < w.count; seq++) {
+            if (!w.sent[seq]) {
+                dropped_msgs++;
+                continue;
+            }
+            std::string msg = make_message(w.id, seq, w.length);
+            size_t n = count_occurrences(wire, msg);
+            size_t pos = wire.find(msg);
+            lost += (n == 0);
+            duplicated += (n > 1);
+            if (n == 1) {
+                reordered += (pos < last);
+                last = pos;
+            }
+        }
+        queued += (w.type == WRITER_TASK_NB) ? w.bytes_queued : (size_t)w.count * w.length;
+    }
+
+    CHECK(lost == 0);
+    CHECK(duplicated == 0);
+    CHECK(reordered == 0);
+    CHECK(wire_size == queued);
+    CHECK(after.dropped - before.dropped == total - queued);
+    CHECK(after.high_water <= after.size);
+
+    printf("%-16s %7u bytes, %4d lost, %d duplicated, %d out of order, "
+        "%4d dropped, high water %4u\n",
+        name, (unsigned)wire_size, lost, duplicated, reordered,
+        dropped_msgs, (unsigned)after.high_water);
+}
+
+int main(void)
+{
+    test_format_float();
+
+    uart.running = true;
+    std::thread hw(uart_thread);
+
+    ei_serial_setup();
+
+    /* Before the scheduler runs nothing goes through the ring */
+    ei_printf("boot %d\n", 42);
+    ei_write_flush();
+    ei_write_stats_t stats;
+    ei_write_get_stats(&stats);
+    CHECK(wire_take() == "boot 42\n");
+    CHECK(stats.high_water == 0);
+
+    scheduler_state = taskSCHEDULER_RUNNING;
+
+    std::vector<writer_t> tasks = {
+        { WRITER_TASK, 0, 400, 90, {}, 0 },
+        { WRITER_TASK, 1, 100, 700, {}, 0 },
+        { WRITER_TASK, 2, 2000, 12, {}, 0 },
+    };
+    run_writers("tasks", tasks);
+
+    std::vector<writer_t> mixed = {
+        { WRITER_TASK, 0, 400, 90, {}, 0 },
+        { WRITER_TASK, 1, 100, 700, {}, 0 },
+        { WRITER_ISR, 2, 300, 20, {}, 0 },
+        { WRITER_MASKED, 3, 200, 40, {}, 0 },
+    };
+    run_writers("tasks, ISR", mixed);
+
+    std::vector<writer_t> nonblocking = {
+        { WRITER_TASK_NB, 0, 600, 150, {}, 0 },
+        { WRITER_TASK_NB, 1, 600, 70, {}, 0 },
+        { WRITER_TASK, 2, 200, 60, {}, 0 },
+        { WRITER_ISR, 3, 200, 20, {}, 0 },
+    };
+    run_writers("non blocking", nonblocking);
+
+    /* Flush with interrupts masked only waits for the FIFO */
+    sim_irq_disable();
+    ei_printf("masked\n");
+    ei_write_flush();
+    sim_primask_set(0);
+    CHECK(wire_take() == "masked\n");
+
+    uart.running = false;
+    hw.join();
+
+    printf("%u TX interrupts, %u while masked\n", (unsigned)uart.interrupts, (unsigned)uart.masked);
+    printf("%s (%d failures)\n", failures ? "FAILED" : "OK", failures);
+    return failures ? 1 : 0;
+}